@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2019-2025 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#include "common/task_queue.h"
+#include "common/types.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+static void CheckParallelFor(TaskQueue& queue, u32 count)
+{
+  std::vector<std::atomic<u32>> calls(count);
+  queue.ParallelFor(count, [&calls](u32 index) { calls[index].fetch_add(1, std::memory_order_relaxed); });
+  for (u32 i = 0; i < count; i++)
+    ASSERT_EQ(calls[i].load(), 1u) << "index " << i;
+}
+
+TEST(TaskQueue, ParallelFor)
+{
+  for (const u32 workers : {0u, 1u, 4u})
+  {
+    TaskQueue queue;
+    queue.SetWorkerCount(workers);
+    for (const u32 count : {0u, 1u, 2u, 7u, 100u})
+      CheckParallelFor(queue, count);
+  }
+}
+
+TEST(TaskQueue, ParallelForFromTask)
+{
+  // With a single worker, the task itself has to run every index, otherwise it would wait forever.
+  for (const u32 workers : {1u, 2u})
+  {
+    TaskQueue queue;
+    queue.SetWorkerCount(workers);
+
+    std::atomic_bool done{false};
+    queue.SubmitTask([&queue, &done]() {
+      CheckParallelFor(queue, 16);
+      done.store(true);
+    });
+    queue.WaitForAll();
+    ASSERT_TRUE(done.load());
+  }
+}
@@ -16,6 +16,7 @@
 #if defined(_WIN32)
 #include "windows_headers.h"
 #include <Psapi.h>
+#include <io.h>
 #elif defined(__APPLE__)
 #ifdef __aarch64__
 #include <pthread.h> // pthread_jit_write_protect_np()
@@ -30,9 +31,12 @@
 #include <sys/sysctl.h>
 #else
 #include <cerrno>
+#include <ctime>
 #include <dlfcn.h>
 #include <fcntl.h>
+#include <sys/file.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -110,6 +114,38 @@ void MemMap::DeleteSharedMemory(const char* name)
   // Automatically freed on close.
 }
 
+void MemMap::DeleteSharedMemory(const char* name, void* handle)
+{
+}
+
+std::string MemMap::GetGlobalFileMappingName(const char* name)
+{
+  return name;
+}
+
+void* MemMap::OpenOrCreateSharedMemory(const char* name, size_t size, bool* created, Error* error)
+{
+  const std::wstring mapping_name = StringUtil::UTF8StringToWideString(name);
+  const HANDLE mapping =
+    CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                       static_cast<DWORD>(size), mapping_name.c_str());
+  if (!mapping)
+  {
+    Error::SetWin32(error, "CreateFileMappingW() failed: ", GetLastError());
+    return nullptr;
+  }
+
+  // The size of an existing mapping is fixed when it is created, so it can be mapped straight away.
+  *created = (GetLastError() != ERROR_ALREADY_EXISTS);
+  return static_cast<void*>(mapping);
+}
+
+bool MemMap::TryLockSharedMemory(void* handle, bool exclusive)
+{
+  // Mappings are released with their last handle, so there's nothing to track.
+  return false;
+}
+
 void* MemMap::MapSharedMemory(void* handle, size_t offset, void* baseaddr, size_t size, PageProtect mode)
 {
   void* ret = MapViewOfFileEx(static_cast<HANDLE>(handle), FILE_MAP_READ | FILE_MAP_WRITE,
@@ -420,6 +456,27 @@ void MemMap::DeleteSharedMemory(const char* name)
 {
 }
 
+void MemMap::DeleteSharedMemory(const char* name, void* handle)
+{
+}
+
+std::string MemMap::GetGlobalFileMappingName(const char* name)
+{
+  return name;
+}
+
+void* MemMap::OpenOrCreateSharedMemory(const char* name, size_t size, bool* created, Error* error)
+{
+  // Memory entries are anonymous, so there's no way to find one created by another process.
+  Error::SetStringView(error, "Named shared memory is not supported on this platform.");
+  return nullptr;
+}
+
+bool MemMap::TryLockSharedMemory(void* handle, bool exclusive)
+{
+  return false;
+}
+
 void* MemMap::MapSharedMemory(void* handle, size_t offset, void* baseaddr, size_t size, PageProtect mode)
 {
   mach_vm_address_t ptr = reinterpret_cast<mach_vm_address_t>(baseaddr);
@@ -732,8 +789,140 @@ void MemMap::DeleteSharedMemory(const char* name)
   shm_unlink(name);
 }
 
+static bool IsSameSharedMemory(const char* name, int fd)
+{
+  const int name_fd = shm_open(name, O_RDONLY, 0);
+  if (name_fd < 0)
+    return false;
+
+  struct stat fd_sd, name_sd;
+  const bool result = (fstat(fd, &fd_sd) == 0 && fstat(name_fd, &name_sd) == 0 && fd_sd.st_dev == name_sd.st_dev &&
+                       fd_sd.st_ino == name_sd.st_ino);
+  close(name_fd);
+  return result;
+}
+
+void MemMap::DeleteSharedMemory(const char* name, void* handle)
+{
+  if (IsSameSharedMemory(name, static_cast<int>(reinterpret_cast<intptr_t>(handle))))
+    shm_unlink(name);
+}
+
+void* MemMap::OpenOrCreateSharedMemory(const char* name, size_t size, bool* created, Error* error)
+{
+  // An empty object which is still unlocked after this long belongs to a creator which died before locking it.
+  static constexpr std::time_t STALE_EMPTY_OBJECT_AGE = 10;
+
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd >= 0)
+  {
+    // Lock before resizing, so anyone who sees the full size also sees that it's being filled.
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+      Error::SetErrno(error, "flock() failed: ", errno);
+      close(fd);
+      shm_unlink(name);
+      return nullptr;
+    }
+
+#ifdef __linux__
+    const int res = fallocate(fd, 0, 0, static_cast<off_t>(size));
+#else
+    const int res = ftruncate(fd, static_cast<off_t>(size));
+#endif
+    if (res < 0)
+    {
+      Error::SetErrno(error, TinyString::from_format("Failed to resize shared memory to {} bytes: ", size), errno);
+      close(fd);
+      shm_unlink(name);
+      return nullptr;
+    }
+
+    *created = true;
+    return reinterpret_cast<void*>(static_cast<intptr_t>(fd));
+  }
+  else if (errno != EEXIST)
+  {
+    Error::SetErrno(error, "shm_open() failed: ", errno);
+    return nullptr;
+  }
+
+  fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+  {
+    Error::SetErrno(error, "shm_open() failed: ", errno);
+    return nullptr;
+  }
+
+  // The creator resizes the object after creating it, and touching pages past the end would raise SIGBUS.
+  struct stat sd;
+  if (fstat(fd, &sd) != 0)
+  {
+    Error::SetErrno(error, "fstat() failed: ", errno);
+    close(fd);
+    return nullptr;
+  }
+  else if (sd.st_size == 0)
+  {
+    // The creator hasn't locked and resized it yet. Locking it here would make the creator fail, so leave it alone
+    // unless it's been empty for too long to still be starting up.
+    Error::SetStringView(error, "Shared memory is being created by another process.");
+    if ((std::time(nullptr) - sd.st_ctime) >= STALE_EMPTY_OBJECT_AGE && flock(fd, LOCK_EX | LOCK_NB) == 0)
+      DeleteSharedMemory(name, reinterpret_cast<void*>(static_cast<intptr_t>(fd)));
+    close(fd);
+    return nullptr;
+  }
+  else if (static_cast<u64>(sd.st_size) != size)
+  {
+    // The creator locks before resizing, so if it isn't locked, the creator exited first. Remove it so the next
+    // attempt can create it again, unless someone else already has.
+    Error::SetStringFmt(error, "Shared memory is {} bytes, expected {}.", static_cast<u64>(sd.st_size), size);
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0)
+      DeleteSharedMemory(name, reinterpret_cast<void*>(static_cast<intptr_t>(fd)));
+    close(fd);
+    return nullptr;
+  }
+
+  *created = false;
+  return reinterpret_cast<void*>(static_cast<intptr_t>(fd));
+}
+
+bool MemMap::TryLockSharedMemory(void* handle, bool exclusive)
+{
+  // Converting an existing lock is allowed, which is how the creator gives up its exclusive lock.
+  const int fd = static_cast<int>(reinterpret_cast<intptr_t>(handle));
+  return (flock(fd, (exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB) == 0);
+}
+
+#else
+
+void MemMap::DeleteSharedMemory(const char* name, void* handle)
+{
+}
+
+void* MemMap::OpenOrCreateSharedMemory(const char* name, size_t size, bool* created, Error* error)
+{
+  Error::SetStringView(error, "Named shared memory is not supported on this platform.");
+  return nullptr;
+}
+
+bool MemMap::TryLockSharedMemory(void* handle, bool exclusive)
+{
+  return false;
+}
+
 #endif
 
+std::string MemMap::GetGlobalFileMappingName(const char* name)
+{
+#if defined(__FreeBSD__)
+  // FreeBSD's shm_open(3) requires name to be absolute
+  return fmt::format("/tmp/{}", name);
+#else
+  return fmt::format("/{}", name);
+#endif
+}
+
 void* MemMap::MapSharedMemory(void* handle, size_t offset, void* baseaddr, size_t size, PageProtect mode)
 {
   const int flags = (baseaddr != nullptr) ? (MAP_SHARED | MAP_FIXED) : MAP_SHARED;
@@ -969,3 +1158,139 @@ void* MemMap::AllocateJITMemory(size_t size)
 
   return ptr;
 }
+
+#ifdef _WIN32
+
+const void* MemMap::MapFileReadOnly(std::FILE* fp, size_t size, Error* error)
+{
+  const HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(fp)));
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    Error::SetStringView(error, "Invalid file handle.");
+    return nullptr;
+  }
+
+  const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+  {
+    Error::SetWin32(error, "CreateFileMappingW() failed: ", GetLastError());
+    return nullptr;
+  }
+
+  // view holds a reference to the mapping, so we can close it straight away
+  const void* ret = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+  if (!ret)
+    Error::SetWin32(error, "MapViewOfFile() failed: ", GetLastError());
+
+  CloseHandle(mapping);
+  return ret;
+}
+
+void MemMap::UnmapFile(const void* ptr, size_t size)
+{
+  if (!UnmapViewOfFile(ptr))
+    Panic("Failed to unmap file");
+}
+
+void MemMap::AdviseSequentialAccess(const void* ptr, size_t size)
+{
+  // No equivalent, the cache manager detects sequential access on its own.
+}
+
+void MemMap::AdviseWillNeed(const void* ptr, size_t size)
+{
+  WIN32_MEMORY_RANGE_ENTRY range = {const_cast<void*>(ptr), size};
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+void* MemMap::ReserveMemory(size_t size)
+{
+  return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+void MemMap::ReleaseMemory(void* ptr, size_t size)
+{
+  if (!VirtualFree(ptr, 0, MEM_RELEASE))
+    Panic("Failed to release memory");
+}
+
+bool MemMap::CommitMemory(void* ptr, size_t size)
+{
+  return (VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr);
+}
+
+void MemMap::DecommitMemory(void* ptr, size_t size)
+{
+  if (!VirtualFree(ptr, size, MEM_DECOMMIT))
+    Panic("Failed to decommit memory");
+}
+
+#else
+
+const void* MemMap::MapFileReadOnly(std::FILE* fp, size_t size, Error* error)
+{
+  void* ret = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileno(fp), 0);
+  if (ret == MAP_FAILED)
+  {
+    Error::SetErrno(error, "mmap() failed: ", errno);
+    return nullptr;
+  }
+
+  return ret;
+}
+
+void MemMap::UnmapFile(const void* ptr, size_t size)
+{
+  if (munmap(const_cast<void*>(ptr), size) != 0)
+    Panic("Failed to unmap file");
+}
+
+void MemMap::AdviseSequentialAccess(const void* ptr, size_t size)
+{
+  madvise(const_cast<void*>(ptr), size, MADV_SEQUENTIAL);
+}
+
+void MemMap::AdviseWillNeed(const void* ptr, size_t size)
+{
+  // madvise() requires a page-aligned start address.
+  const uintptr_t start = Common::AlignDownPow2(reinterpret_cast<uintptr_t>(ptr), HOST_PAGE_SIZE);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(ptr) + size;
+  madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+}
+
+void* MemMap::ReserveMemory(size_t size)
+{
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#endif
+
+  void* ret = mmap(nullptr, size, PROT_NONE, flags, -1, 0);
+  return (ret != MAP_FAILED) ? ret : nullptr;
+}
+
+void MemMap::ReleaseMemory(void* ptr, size_t size)
+{
+  if (munmap(ptr, size) != 0)
+    Panic("Failed to release memory");
+}
+
+bool MemMap::CommitMemory(void* ptr, size_t size)
+{
+  // Anonymous pages are only backed on first touch, so this just needs to make them accessible.
+  return (mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0);
+}
+
+void MemMap::DecommitMemory(void* ptr, size_t size)
+{
+  // Replacing the pages with a fresh inaccessible mapping releases the backing memory, and zeroes them.
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#endif
+
+  if (mmap(ptr, size, PROT_NONE, flags, -1, 0) == MAP_FAILED)
+    Panic("Failed to decommit memory");
+}
+
+#endif
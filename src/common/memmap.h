@@ -5,6 +5,7 @@
 
 #include "types.h"
 
+#include <cstdio>
 #include <map>
 #include <string>
 
@@ -56,12 +57,51 @@ u32 GetRuntimePageSize();
 
 std::string GetFileMappingName(const char* prefix);
 void* CreateSharedMemory(const char* name, size_t size, Error* error);
+
+/// Returns a shared memory name which is the same in every process, unlike GetFileMappingName().
+std::string GetGlobalFileMappingName(const char* name);
+
+/// Creates a named shared memory object which other processes can open, or opens the existing object with that name.
+/// created is set if this call created the object, in which case it is zero-filled, writable, and locked exclusively
+/// (see TryLockSharedMemory()). Otherwise, the object is opened read-only, and must be mapped with
+/// PageProtect::ReadOnly. On Windows, the object is released when the last handle is closed, elsewhere it persists
+/// until DeleteSharedMemory() is called.
+void* OpenOrCreateSharedMemory(const char* name, size_t size, bool* created, Error* error);
+
+/// Takes or converts an advisory lock on a named shared memory object without blocking. Locks are released when the
+/// handle is closed, including when the process dies, so they tell whether other processes are still using an object
+/// which would otherwise outlive them. Returns false if another process holds a conflicting lock, or on platforms
+/// where objects are already released with their last handle.
+bool TryLockSharedMemory(void* handle, bool exclusive);
 void DeleteSharedMemory(const char* name);
+
+/// Removes the name only if it still refers to the object open in handle, so an object which another process has
+/// already removed and created again is left alone.
+void DeleteSharedMemory(const char* name, void* handle);
 void DestroySharedMemory(void* ptr);
 void* MapSharedMemory(void* handle, size_t offset, void* baseaddr, size_t size, PageProtect mode);
 void UnmapSharedMemory(void* baseaddr, size_t size);
 bool MemProtect(void* baseaddr, size_t size, PageProtect mode);
 
+/// Maps the first size bytes of an open file into the address space as read-only.
+/// The mapping remains valid after the file is closed, and must be released with UnmapFile().
+const void* MapFileReadOnly(std::FILE* fp, size_t size, Error* error);
+void UnmapFile(const void* ptr, size_t size);
+
+/// Hints to the host that a mapped file region will be accessed sequentially/soon.
+void AdviseSequentialAccess(const void* ptr, size_t size);
+void AdviseWillNeed(const void* ptr, size_t size);
+
+/// Reserves address space without any backing memory. Regions must be committed before they are accessed.
+void* ReserveMemory(size_t size);
+void ReleaseMemory(void* ptr, size_t size);
+
+/// Commits a reserved region as read/write. Newly-committed memory is zeroed.
+bool CommitMemory(void* ptr, size_t size);
+
+/// Returns a committed region to the host, leaving it reserved.
+void DecommitMemory(void* ptr, size_t size);
+
 /// Returns the base address for the current process.
 const void* GetBaseAddress();
 
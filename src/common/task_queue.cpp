@@ -4,6 +4,9 @@
 #include "task_queue.h"
 #include "assert.h"
 
+#include <algorithm>
+#include <memory>
+
 TaskQueue::TaskQueue() = default;
 
 TaskQueue::~TaskQueue()
@@ -54,6 +57,53 @@ void TaskQueue::WaitForAll()
   WaitForAll(lock);
 }
 
+void TaskQueue::ParallelFor(u32 count, const std::function<void(u32)>& func)
+{
+  if (count == 0)
+    return;
+
+  // Helper tasks can start after we've returned, so the state is shared. They won't touch func by then, since every
+  // index has already been claimed.
+  struct ParallelForState
+  {
+    const std::function<void(u32)>* func;
+    u32 count;
+    std::atomic<u32> next_index{0};
+    u32 completed = 0;
+    std::mutex mutex;
+    std::condition_variable done_cv;
+  };
+
+  const std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+  state->func = &func;
+  state->count = count;
+
+  static constexpr auto run = [](ParallelForState& st) {
+    u32 index;
+    while ((index = st.next_index.fetch_add(1, std::memory_order_relaxed)) < st.count)
+    {
+      (*st.func)(index);
+
+      std::unique_lock lock(st.mutex);
+      if (++st.completed == st.count)
+        st.done_cv.notify_one();
+    }
+  };
+
+  u32 num_helpers;
+  {
+    std::unique_lock lock(m_mutex);
+    num_helpers = std::min(count - 1, static_cast<u32>(m_threads.size()));
+  }
+  for (u32 i = 0; i < num_helpers; i++)
+    SubmitTask([state]() { run(*state); });
+
+  run(*state);
+
+  std::unique_lock lock(state->mutex);
+  state->done_cv.wait(lock, [&state]() { return (state->completed == state->count); });
+}
+
 void TaskQueue::WaitForAll(std::unique_lock<std::mutex>& lock)
 {
   // while we're waiting, execute work on the calling thread
@@ -35,6 +35,13 @@ public:
   /// Waits for all submitted tasks to complete execution.
   void WaitForAll();
 
+  /// Calls func for each index in [0, count) on the worker threads and the calling thread, and waits for every call
+  /// to return. Unlike WaitForAll(), this can be called from within a task, since the calling thread runs any indices
+  /// which have not been picked up by a worker.
+  /// @param count The number of indices.
+  /// @param func The function to call with each index.
+  void ParallelFor(u32 count, const std::function<void(u32)>& func);
+
 private:
   /// Waits for all submitted tasks to complete execution.
   /// This is a helper function that assumes a lock is already held.
@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#include "core/gpu_sw.h"
+#include "core/gpu_types.h"
+
+#include <gtest/gtest.h>
+
+// Page 0 is x 0-63, y 0-255 in 16-bit mode.
+static constexpr GSVector4i PAGE0_RECT = GetTextureRect(0, GPUTextureMode::Direct16Bit);
+static constexpr GSVector4i PAGE1_RECT = GetTextureRect(1, GPUTextureMode::Direct16Bit);
+static constexpr GSVector4i INSIDE_PAGE0 = GSVector4i::cxpr(16, 16, 32, 32);
+static constexpr GSVector4i OUTSIDE_PAGES = GSVector4i::cxpr(512, 300, 600, 400);
+
+TEST(GPU_SW, QueueEmpty)
+{
+  EXPECT_FALSE(GPU_SW::ConflictsWithQueue(INSIDE_PAGE0, PAGE1_RECT, GSVector4i::zero(), GSVector4i::zero()));
+  EXPECT_FALSE(GPU_SW::ConflictsWithQueue(OUTSIDE_PAGES, GSVector4i::zero(), GSVector4i::zero(), GSVector4i::zero()));
+}
+
+TEST(GPU_SW, TextureOverlapsQueuedDraw)
+{
+  // Queued untextured primitive draws into page 0, then a primitive samples from it.
+  EXPECT_TRUE(GPU_SW::ConflictsWithQueue(OUTSIDE_PAGES, PAGE0_RECT, INSIDE_PAGE0, GSVector4i::zero()));
+  EXPECT_FALSE(GPU_SW::ConflictsWithQueue(OUTSIDE_PAGES, PAGE1_RECT, INSIDE_PAGE0, GSVector4i::zero()));
+}
+
+TEST(GPU_SW, DrawOverlapsQueuedTexture)
+{
+  // Queued primitive samples from page 0, then an untextured primitive draws into it.
+  EXPECT_TRUE(GPU_SW::ConflictsWithQueue(INSIDE_PAGE0, GSVector4i::zero(), OUTSIDE_PAGES, PAGE0_RECT));
+
+  // Drawing elsewhere, or sampling the same page, can still be queued.
+  EXPECT_FALSE(GPU_SW::ConflictsWithQueue(OUTSIDE_PAGES, GSVector4i::zero(), OUTSIDE_PAGES, PAGE0_RECT));
+  EXPECT_FALSE(GPU_SW::ConflictsWithQueue(OUTSIDE_PAGES, PAGE0_RECT, OUTSIDE_PAGES, PAGE0_RECT));
+}
@@ -0,0 +1,150 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#include "core/gte_batch.h"
+
+#include "common/bitutils.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace {
+struct Result
+{
+  std::array<s32, 3> mac;
+  std::array<s32, 3> ir;
+  u32 flags;
+};
+} // namespace
+
+// Reference implementation, matching GTE::MulMatVec()/GTE::RTPS() with 64-bit accumulators.
+static void CheckMACOverflow_Scalar(u32 index, s64 value, u32* flags)
+{
+  if (value < -INT64_C(0x80000000000))
+    *flags |= 1u << (GTE::Batch::FLAG_MAC1_UNDERFLOW_BIT - index);
+  else if (value > INT64_C(0x7FFFFFFFFFF))
+    *flags |= 1u << (GTE::Batch::FLAG_MAC1_OVERFLOW_BIT - index);
+}
+
+static s64 SignExtendMACResult_Scalar(u32 index, s64 value, u32* flags)
+{
+  CheckMACOverflow_Scalar(index, value, flags);
+  return SignExtendN<44>(value);
+}
+
+static s32 TruncateIR_Scalar(u32 index, s32 value, bool lm, u32* flags)
+{
+  const s32 min = lm ? 0 : GTE::Batch::IR_MIN_VALUE;
+  if (value < min || value > GTE::Batch::IR_MAX_VALUE)
+    *flags |= 1u << (GTE::Batch::FLAG_IR1_SATURATED_BIT - index);
+  return std::clamp(value, min, GTE::Batch::IR_MAX_VALUE);
+}
+
+static Result MulMatVec_Scalar(const s16 M[3][3], const s32 T[3], const s16 V[3], u8 shift, bool lm, bool rtp)
+{
+  Result res = {};
+  for (u32 i = 0; i < 3; i++)
+  {
+    s64 value = SignExtendMACResult_Scalar(i, (s64(T[i]) << 12) + (s64(M[i][0]) * s64(V[0])), &res.flags);
+    value = SignExtendMACResult_Scalar(i, value + (s64(M[i][1]) * s64(V[1])), &res.flags);
+    value += s64(M[i][2]) * s64(V[2]);
+    CheckMACOverflow_Scalar(i, value, &res.flags);
+    res.mac[i] = static_cast<s32>(value >> shift);
+
+    if (rtp && i == 2)
+    {
+      // IR3 flag comes from MAC3 SAR 12 regardless of sf/lm, value from MAC3.
+      TruncateIR_Scalar(i, static_cast<s32>(value >> 12), false, &res.flags);
+      res.ir[i] = std::clamp(res.mac[i], lm ? 0 : GTE::Batch::IR_MIN_VALUE, GTE::Batch::IR_MAX_VALUE);
+    }
+    else
+    {
+      res.ir[i] = TruncateIR_Scalar(i, res.mac[i], lm, &res.flags);
+    }
+  }
+
+  return res;
+}
+
+static Result MulMatVec_Vector(const s16 M[3][3], const s32 T[3], const s16 V[3], u8 shift, bool lm, bool rtp)
+{
+  const GTE::Batch::Accumulator acc =
+    GTE::Batch::MulMatVec(GTE::Batch::LoadMatrix(&M[0][0]), GTE::Batch::LoadVector(T[0], T[1], T[2]),
+                          GTE::Batch::LoadVector(V[0], V[1], V[2]));
+
+  Result res;
+  res.flags = GTE::Batch::GetMACFlags(acc);
+
+  const GSVector4i mac = GTE::Batch::GetMAC(acc, shift);
+  GSVector4i ir;
+  if (rtp)
+  {
+    const s32 ir_min = lm ? 0 : GTE::Batch::IR_MIN_VALUE;
+    ir = GTE::Batch::SaturateIR(mac, GSVector4i::cxpr(ir_min), mac.blend32<4>(acc.hi),
+                                GSVector4i(ir_min, ir_min, GTE::Batch::IR_MIN_VALUE, 0), &res.flags);
+  }
+  else
+  {
+    ir = GTE::Batch::SaturateIR(mac, lm, &res.flags);
+  }
+
+  res.mac = {mac.extract32<0>(), mac.extract32<1>(), mac.extract32<2>()};
+  res.ir = {ir.extract32<0>(), ir.extract32<1>(), ir.extract32<2>()};
+  return res;
+}
+
+template<typename T, typename R>
+static T RandomBiased(R& rng, T min, T max)
+{
+  // Extremes are where the overflow/saturation edge cases live, so pick them more often.
+  switch (std::uniform_int_distribution<u32>(0, 7)(rng))
+  {
+    case 0:
+      return min;
+    case 1:
+      return max;
+    case 2:
+      return 0;
+    case 3:
+      return static_cast<T>(std::uniform_int_distribution<s32>(-16, 16)(rng));
+    default:
+      return std::uniform_int_distribution<T>(min, max)(rng);
+  }
+}
+
+TEST(GTEBatch, MulMatVec)
+{
+  std::mt19937 rng(0x47544542u);
+
+  for (u32 iter = 0; iter < 500000; iter++)
+  {
+    s16 M[3][3];
+    s32 T[3];
+    s16 V[3];
+    for (u32 i = 0; i < 3; i++)
+    {
+      for (u32 j = 0; j < 3; j++)
+        M[i][j] = RandomBiased<s16>(rng, INT16_MIN, INT16_MAX);
+      T[i] = RandomBiased<s32>(rng, INT32_MIN, INT32_MAX);
+      V[i] = RandomBiased<s16>(rng, INT16_MIN, INT16_MAX);
+    }
+
+    for (const u8 shift : {u8(0), u8(12)})
+    {
+      for (const bool lm : {false, true})
+      {
+        for (const bool rtp : {false, true})
+        {
+          const Result rs = MulMatVec_Scalar(M, T, V, shift, lm, rtp);
+          const Result rv = MulMatVec_Vector(M, T, V, shift, lm, rtp);
+          ASSERT_EQ(rs.mac, rv.mac) << "iteration " << iter << " shift " << u32(shift) << " lm " << lm;
+          ASSERT_EQ(rs.ir, rv.ir) << "iteration " << iter << " shift " << u32(shift) << " lm " << lm;
+          ASSERT_EQ(rs.flags, rv.flags) << "iteration " << iter << " shift " << u32(shift) << " lm " << lm;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,659 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#include "core/cpu_core.h"
+#include "core/gte.h"
+
+#include "common/bitutils.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+// Reference implementation, the scalar 64-bit GTE from before the matrix products were vectorized.
+// Only covers the instructions which go through GTE::Batch, with PGXP, freecam and widescreen disabled.
+namespace GTEReference {
+
+using GTE::Instruction;
+
+static constexpr s64 MAC0_MIN_VALUE = -(INT64_C(1) << 31);
+static constexpr s64 MAC0_MAX_VALUE = (INT64_C(1) << 31) - 1;
+static constexpr s64 MAC123_MIN_VALUE = -(INT64_C(1) << 43);
+static constexpr s64 MAC123_MAX_VALUE = (INT64_C(1) << 43) - 1;
+static constexpr s32 IR0_MIN_VALUE = 0x0000;
+static constexpr s32 IR0_MAX_VALUE = 0x1000;
+static constexpr s32 IR123_MIN_VALUE = -(INT64_C(1) << 15);
+static constexpr s32 IR123_MAX_VALUE = (INT64_C(1) << 15) - 1;
+
+static GTE::Regs s_regs;
+
+template<u32 index>
+static void CheckMACOverflow(s64 value)
+{
+  constexpr s64 MIN_VALUE = (index == 0) ? MAC0_MIN_VALUE : MAC123_MIN_VALUE;
+  constexpr s64 MAX_VALUE = (index == 0) ? MAC0_MAX_VALUE : MAC123_MAX_VALUE;
+  if (value < MIN_VALUE)
+  {
+    if constexpr (index == 0)
+      s_regs.FLAG.mac0_underflow = true;
+    else if constexpr (index == 1)
+      s_regs.FLAG.mac1_underflow = true;
+    else if constexpr (index == 2)
+      s_regs.FLAG.mac2_underflow = true;
+    else if constexpr (index == 3)
+      s_regs.FLAG.mac3_underflow = true;
+  }
+  else if (value > MAX_VALUE)
+  {
+    if constexpr (index == 0)
+      s_regs.FLAG.mac0_overflow = true;
+    else if constexpr (index == 1)
+      s_regs.FLAG.mac1_overflow = true;
+    else if constexpr (index == 2)
+      s_regs.FLAG.mac2_overflow = true;
+    else if constexpr (index == 3)
+      s_regs.FLAG.mac3_overflow = true;
+  }
+}
+
+template<u32 index>
+static s64 SignExtendMACResult(s64 value)
+{
+  CheckMACOverflow<index>(value);
+  return SignExtendN < index == 0 ? 31 : 44 > (value);
+}
+
+template<u32 index>
+static void TruncateAndSetMAC(s64 value, u8 shift)
+{
+  CheckMACOverflow<index>(value);
+
+  // shift should be done before storing to avoid losing precision
+  value >>= shift;
+
+  s_regs.dr32[24 + index] = Truncate32(static_cast<u64>(value));
+}
+
+template<u32 index>
+static void TruncateAndSetIR(s32 value, bool lm)
+{
+  constexpr s32 MIN_VALUE = (index == 0) ? IR0_MIN_VALUE : IR123_MIN_VALUE;
+  constexpr s32 MAX_VALUE = (index == 0) ? IR0_MAX_VALUE : IR123_MAX_VALUE;
+  const s32 actual_min_value = lm ? 0 : MIN_VALUE;
+  if (value < actual_min_value)
+  {
+    value = actual_min_value;
+    if constexpr (index == 0)
+      s_regs.FLAG.ir0_saturated = true;
+    else if constexpr (index == 1)
+      s_regs.FLAG.ir1_saturated = true;
+    else if constexpr (index == 2)
+      s_regs.FLAG.ir2_saturated = true;
+    else if constexpr (index == 3)
+      s_regs.FLAG.ir3_saturated = true;
+  }
+  else if (value > MAX_VALUE)
+  {
+    value = MAX_VALUE;
+    if constexpr (index == 0)
+      s_regs.FLAG.ir0_saturated = true;
+    else if constexpr (index == 1)
+      s_regs.FLAG.ir1_saturated = true;
+    else if constexpr (index == 2)
+      s_regs.FLAG.ir2_saturated = true;
+    else if constexpr (index == 3)
+      s_regs.FLAG.ir3_saturated = true;
+  }
+
+  // store sign-extended 16-bit value as 32-bit
+  s_regs.dr32[8 + index] = value;
+}
+
+template<u32 index>
+static void TruncateAndSetMACAndIR(s64 value, u8 shift, bool lm)
+{
+  CheckMACOverflow<index>(value);
+
+  // shift should be done before storing to avoid losing precision
+  value >>= shift;
+
+  // set MAC
+  const s32 value32 = static_cast<s32>(value);
+  s_regs.dr32[24 + index] = value32;
+
+  // set IR
+  TruncateAndSetIR<index>(value32, lm);
+}
+
+template<u32 index>
+static u32 TruncateRGB(s32 value)
+{
+  if (value < 0 || value > 0xFF)
+  {
+    if constexpr (index == 0)
+      s_regs.FLAG.color_r_saturated = true;
+    else if constexpr (index == 1)
+      s_regs.FLAG.color_g_saturated = true;
+    else
+      s_regs.FLAG.color_b_saturated = true;
+
+    return (value < 0) ? 0 : 0xFF;
+  }
+
+  return static_cast<u32>(value);
+}
+
+static void PushSXY(s32 x, s32 y)
+{
+  if (x < -1024)
+  {
+    s_regs.FLAG.sx2_saturated = true;
+    x = -1024;
+  }
+  else if (x > 1023)
+  {
+    s_regs.FLAG.sx2_saturated = true;
+    x = 1023;
+  }
+
+  if (y < -1024)
+  {
+    s_regs.FLAG.sy2_saturated = true;
+    y = -1024;
+  }
+  else if (y > 1023)
+  {
+    s_regs.FLAG.sy2_saturated = true;
+    y = 1023;
+  }
+
+  s_regs.dr32[12] = s_regs.dr32[13]; // SXY0 <- SXY1
+  s_regs.dr32[13] = s_regs.dr32[14]; // SXY1 <- SXY2
+  s_regs.dr32[14] = (static_cast<u32>(x) & 0xFFFFu) | (static_cast<u32>(y) << 16);
+}
+
+static void PushSZ(s32 value)
+{
+  if (value < 0)
+  {
+    s_regs.FLAG.sz1_otz_saturated = true;
+    value = 0;
+  }
+  else if (value > 0xFFFF)
+  {
+    s_regs.FLAG.sz1_otz_saturated = true;
+    value = 0xFFFF;
+  }
+
+  s_regs.dr32[16] = s_regs.dr32[17];           // SZ0 <- SZ1
+  s_regs.dr32[17] = s_regs.dr32[18];           // SZ1 <- SZ2
+  s_regs.dr32[18] = s_regs.dr32[19];           // SZ2 <- SZ3
+  s_regs.dr32[19] = static_cast<u32>(value); // SZ3 <- value
+}
+
+static void PushRGBFromMAC()
+{
+  // Note: SHR 4 used instead of /16 as the results are different.
+  const u32 r = TruncateRGB<0>(static_cast<u32>(s_regs.MAC1 >> 4));
+  const u32 g = TruncateRGB<1>(static_cast<u32>(s_regs.MAC2 >> 4));
+  const u32 b = TruncateRGB<2>(static_cast<u32>(s_regs.MAC3 >> 4));
+  const u32 c = ZeroExtend32(s_regs.RGBC[3]);
+
+  s_regs.dr32[20] = s_regs.dr32[21];                        // RGB0 <- RGB1
+  s_regs.dr32[21] = s_regs.dr32[22];                        // RGB1 <- RGB2
+  s_regs.dr32[22] = r | (g << 8) | (b << 16) | (c << 24); // RGB2 <- Value
+}
+
+static u32 UNRDivide(u32 lhs, u32 rhs)
+{
+  if (rhs * 2 <= lhs)
+  {
+    s_regs.FLAG.divide_overflow = true;
+    return 0x1FFFF;
+  }
+
+  const u32 shift = (rhs == 0) ? 16 : CountLeadingZeros(static_cast<u16>(rhs));
+  lhs <<= shift;
+  rhs <<= shift;
+
+  static constexpr std::array<u8, 257> unr_table = {{
+    0xFF, 0xFD, 0xFB, 0xF9, 0xF7, 0xF5, 0xF3, 0xF1, 0xEF, 0xEE, 0xEC, 0xEA, 0xE8, 0xE6, 0xE4, 0xE3, //
+    0xE1, 0xDF, 0xDD, 0xDC, 0xDA, 0xD8, 0xD6, 0xD5, 0xD3, 0xD1, 0xD0, 0xCE, 0xCD, 0xCB, 0xC9, 0xC8, //  00h..3Fh
+    0xC6, 0xC5, 0xC3, 0xC1, 0xC0, 0xBE, 0xBD, 0xBB, 0xBA, 0xB8, 0xB7, 0xB5, 0xB4, 0xB2, 0xB1, 0xB0, //
+    0xAE, 0xAD, 0xAB, 0xAA, 0xA9, 0xA7, 0xA6, 0xA4, 0xA3, 0xA2, 0xA0, 0x9F, 0x9E, 0x9C, 0x9B, 0x9A, //
+    0x99, 0x97, 0x96, 0x95, 0x94, 0x92, 0x91, 0x90, 0x8F, 0x8D, 0x8C, 0x8B, 0x8A, 0x89, 0x87, 0x86, //
+    0x85, 0x84, 0x83, 0x82, 0x81, 0x7F, 0x7E, 0x7D, 0x7C, 0x7B, 0x7A, 0x79, 0x78, 0x77, 0x75, 0x74, //  40h..7Fh
+    0x73, 0x72, 0x71, 0x70, 0x6F, 0x6E, 0x6D, 0x6C, 0x6B, 0x6A, 0x69, 0x68, 0x67, 0x66, 0x65, 0x64, //
+    0x63, 0x62, 0x61, 0x60, 0x5F, 0x5E, 0x5D, 0x5D, 0x5C, 0x5B, 0x5A, 0x59, 0x58, 0x57, 0x56, 0x55, //
+    0x54, 0x53, 0x53, 0x52, 0x51, 0x50, 0x4F, 0x4E, 0x4D, 0x4D, 0x4C, 0x4B, 0x4A, 0x49, 0x48, 0x48, //
+    0x47, 0x46, 0x45, 0x44, 0x43, 0x43, 0x42, 0x41, 0x40, 0x3F, 0x3F, 0x3E, 0x3D, 0x3C, 0x3C, 0x3B, //  80h..BFh
+    0x3A, 0x39, 0x39, 0x38, 0x37, 0x36, 0x36, 0x35, 0x34, 0x33, 0x33, 0x32, 0x31, 0x31, 0x30, 0x2F, //
+    0x2E, 0x2E, 0x2D, 0x2C, 0x2C, 0x2B, 0x2A, 0x2A, 0x29, 0x28, 0x28, 0x27, 0x26, 0x26, 0x25, 0x24, //
+    0x24, 0x23, 0x22, 0x22, 0x21, 0x20, 0x20, 0x1F, 0x1E, 0x1E, 0x1D, 0x1D, 0x1C, 0x1B, 0x1B, 0x1A, //
+    0x19, 0x19, 0x18, 0x18, 0x17, 0x16, 0x16, 0x15, 0x15, 0x14, 0x14, 0x13, 0x12, 0x12, 0x11, 0x11, //  C0h..FFh
+    0x10, 0x0F, 0x0F, 0x0E, 0x0E, 0x0D, 0x0D, 0x0C, 0x0C, 0x0B, 0x0A, 0x0A, 0x09, 0x09, 0x08, 0x08, //
+    0x07, 0x07, 0x06, 0x06, 0x05, 0x05, 0x04, 0x04, 0x03, 0x03, 0x02, 0x02, 0x01, 0x01, 0x00, 0x00, //
+    0x00 // <-- one extra table entry (for "(d-7FC0h)/80h"=100h)
+  }};
+
+  const u32 divisor = rhs | 0x8000;
+  const s32 x = static_cast<s32>(0x101 + ZeroExtend32(unr_table[((divisor & 0x7FFF) + 0x40) >> 7]));
+  const s32 d = ((static_cast<s32>(ZeroExtend32(divisor)) * -x) + 0x80) >> 8;
+  const u32 recip = static_cast<u32>(((x * (0x20000 + d)) + 0x80) >> 8);
+
+  const u32 result = Truncate32((ZeroExtend64(lhs) * ZeroExtend64(recip) + u64(0x8000)) >> 16);
+
+  // The min(1FFFFh) limit is needed for cases like FE3Fh/7F20h, F015h/780Bh, etc. (these do produce UNR result 20000h,
+  // and are saturated to 1FFFFh, but without setting overflow FLAG bits).
+  return std::min<u32>(0x1FFFF, result);
+}
+
+static void MulMatVec(const s16* M_, const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
+{
+#define M(i, j) M_[((i) * 3) + (j)]
+#define dot3(i)                                                                                                        \
+  TruncateAndSetMACAndIR<i + 1>(SignExtendMACResult<i + 1>((s64(M(i, 0)) * s64(Vx)) + (s64(M(i, 1)) * s64(Vy))) +      \
+                                  (s64(M(i, 2)) * s64(Vz)),                                                            \
+                                shift, lm)
+
+  dot3(0);
+  dot3(1);
+  dot3(2);
+
+#undef dot3
+#undef M
+}
+
+static void MulMatVec(const s16* M_, const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
+{
+#define M(i, j) M_[((i) * 3) + (j)]
+#define dot3(i)                                                                                                        \
+  TruncateAndSetMACAndIR<i + 1>(                                                                                       \
+    SignExtendMACResult<i + 1>(SignExtendMACResult<i + 1>((s64(T[i]) << 12) + (s64(M(i, 0)) * s64(Vx))) +              \
+                               (s64(M(i, 1)) * s64(Vy))) +                                                             \
+      (s64(M(i, 2)) * s64(Vz)),                                                                                        \
+    shift, lm)
+
+  dot3(0);
+  dot3(1);
+  dot3(2);
+
+#undef dot3
+#undef M
+}
+
+static void MulMatVecBuggy(const s16* M_, const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
+{
+#define M(i, j) M_[((i) * 3) + (j)]
+#define dot3(i)                                                                                                        \
+  do                                                                                                                   \
+  {                                                                                                                    \
+    TruncateAndSetIR<i + 1>(static_cast<s32>(SignExtendMACResult<i + 1>(SignExtendMACResult<i + 1>(                    \
+                                               (s64(T[i]) << 12) + (s64(M(i, 0)) * s64(Vx)))) >>                       \
+                                             shift),                                                                   \
+                            false);                                                                                    \
+    TruncateAndSetMACAndIR<i + 1>(SignExtendMACResult<i + 1>((s64(M(i, 1)) * s64(Vy))) + (s64(M(i, 2)) * s64(Vz)),     \
+                                  shift, lm);                                                                          \
+  } while (0)
+
+  dot3(0);
+  dot3(1);
+  dot3(2);
+
+#undef dot3
+#undef M
+}
+
+static void Execute_MVMVA(Instruction inst)
+{
+  s_regs.FLAG.Clear();
+
+  static constexpr const s16* M_lookup[4] = {&s_regs.RT[0][0], &s_regs.LLM[0][0], &s_regs.LCM[0][0], nullptr};
+  static constexpr const s16* V_lookup[4][3] = {
+    {&s_regs.V0[0], &s_regs.V0[1], &s_regs.V0[2]},
+    {&s_regs.V1[0], &s_regs.V1[1], &s_regs.V1[2]},
+    {&s_regs.V2[0], &s_regs.V2[1], &s_regs.V2[2]},
+    {&s_regs.IR1, &s_regs.IR2, &s_regs.IR3},
+  };
+  static constexpr const s32 zero_T[3] = {};
+  static constexpr const s32* T_lookup[4] = {s_regs.TR, s_regs.BK, s_regs.FC, zero_T};
+
+  const s16* M = M_lookup[inst.mvmva_multiply_matrix];
+  const s16* const* const V = V_lookup[inst.mvmva_multiply_vector];
+  const s32* const T = T_lookup[inst.mvmva_translation_vector];
+  s16 buggy_M[3][3];
+
+  if (!M)
+  {
+    // buggy
+    buggy_M[0][0] = -static_cast<s16>(ZeroExtend16(s_regs.RGBC[0]) << 4);
+    buggy_M[0][1] = static_cast<s16>(ZeroExtend16(s_regs.RGBC[0]) << 4);
+    buggy_M[0][2] = s_regs.IR0;
+    buggy_M[1][0] = s_regs.RT[0][2];
+    buggy_M[1][1] = s_regs.RT[0][2];
+    buggy_M[1][2] = s_regs.RT[0][2];
+    buggy_M[2][0] = s_regs.RT[1][1];
+    buggy_M[2][1] = s_regs.RT[1][1];
+    buggy_M[2][2] = s_regs.RT[1][1];
+    M = &buggy_M[0][0];
+  }
+
+  const s16 Vx = *V[0];
+  const s16 Vy = *V[1];
+  const s16 Vz = *V[2];
+  if (inst.mvmva_translation_vector != 2)
+    MulMatVec(M, T, Vx, Vy, Vz, inst.GetShift(), inst.lm);
+  else
+    MulMatVecBuggy(M, T, Vx, Vy, Vz, inst.GetShift(), inst.lm);
+
+  s_regs.FLAG.UpdateError();
+}
+
+static void RTPS(const s16 V[3], u8 shift, bool lm, bool last)
+{
+#define dot3(i)                                                                                                        \
+  SignExtendMACResult<i + 1>(                                                                                          \
+    SignExtendMACResult<i + 1>((s64(s_regs.TR[i]) << 12) + (s64(s_regs.RT[i][0]) * s64(V[0]))) +                       \
+    (s64(s_regs.RT[i][1]) * s64(V[1]))) +                                                                              \
+    (s64(s_regs.RT[i][2]) * s64(V[2]))
+
+  // IR1 = MAC1 = (TRX*1000h + RT11*VX0 + RT12*VY0 + RT13*VZ0) SAR (sf*12)
+  // IR2 = MAC2 = (TRY*1000h + RT21*VX0 + RT22*VY0 + RT23*VZ0) SAR (sf*12)
+  // IR3 = MAC3 = (TRZ*1000h + RT31*VX0 + RT32*VY0 + RT33*VZ0) SAR (sf*12)
+  s64 x = dot3(0);
+  s64 y = dot3(1);
+  s64 z = dot3(2);
+
+  TruncateAndSetMAC<1>(x, shift);
+  TruncateAndSetMAC<2>(y, shift);
+  TruncateAndSetMAC<3>(z, shift);
+  TruncateAndSetIR<1>(s_regs.MAC1, lm);
+  TruncateAndSetIR<2>(s_regs.MAC2, lm);
+
+  // The command does saturate IR1,IR2,IR3 to -8000h..+7FFFh (regardless of lm bit). When using RTP with sf=0, then the
+  // IR3 saturation flag (FLAG.22) gets set <only> if "MAC3 SAR 12" exceeds -8000h..+7FFFh (although IR3 is saturated
+  // when "MAC3" exceeds -8000h..+7FFFh).
+  TruncateAndSetIR<3>(s32(z >> 12), false);
+  s_regs.dr32[11] = std::clamp(s_regs.MAC3, lm ? 0 : IR123_MIN_VALUE, IR123_MAX_VALUE);
+#undef dot3
+
+  // SZ3 = MAC3 SAR ((1-sf)*12)                           ;ScreenZ FIFO 0..+FFFFh
+  PushSZ(s32(z >> 12));
+
+  // MAC0=(((H*20000h/SZ3)+1)/2)*IR1+OFX, SX2=MAC0/10000h ;ScrX FIFO -400h..+3FFh
+  // MAC0=(((H*20000h/SZ3)+1)/2)*IR2+OFY, SY2=MAC0/10000h ;ScrY FIFO -400h..+3FFh
+  const s64 result = static_cast<s64>(ZeroExtend64(UNRDivide(s_regs.H, s_regs.SZ3)));
+
+  // 4:3, widescreen hack off.
+  const s64 Sx = s64(result) * s64(s_regs.IR1) + s64(s_regs.OFX);
+  const s64 Sy = s64(result) * s64(s_regs.IR2) + s64(s_regs.OFY);
+  CheckMACOverflow<0>(Sx);
+  CheckMACOverflow<0>(Sy);
+  PushSXY(s32(Sx >> 16), s32(Sy >> 16));
+
+  if (last)
+  {
+    // MAC0=(((H*20000h/SZ3)+1)/2)*DQA+DQB, IR0=MAC0/1000h  ;Depth cueing 0..+1000h
+    const s64 Sz = s64(result) * s64(s_regs.DQA) + s64(s_regs.DQB);
+    TruncateAndSetMAC<0>(Sz, 0);
+    TruncateAndSetIR<0>(s32(Sz >> 12), true);
+  }
+}
+
+static void InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3, u8 shift, bool lm)
+{
+  // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
+  //   [IR1,IR2,IR3] = (([RFC,GFC,BFC] SHL 12) - [MAC1,MAC2,MAC3]) SAR (sf*12)
+  TruncateAndSetMACAndIR<1>((s64(s_regs.FC[0]) << 12) - in_MAC1, shift, false);
+  TruncateAndSetMACAndIR<2>((s64(s_regs.FC[1]) << 12) - in_MAC2, shift, false);
+  TruncateAndSetMACAndIR<3>((s64(s_regs.FC[2]) << 12) - in_MAC3, shift, false);
+
+  //   [MAC1,MAC2,MAC3] = (([IR1,IR2,IR3] * IR0) + [MAC1,MAC2,MAC3])
+  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
+  TruncateAndSetMACAndIR<1>(s64(s32(s_regs.IR1) * s32(s_regs.IR0)) + in_MAC1, shift, lm);
+  TruncateAndSetMACAndIR<2>(s64(s32(s_regs.IR2) * s32(s_regs.IR0)) + in_MAC2, shift, lm);
+  TruncateAndSetMACAndIR<3>(s64(s32(s_regs.IR3) * s32(s_regs.IR0)) + in_MAC3, shift, lm);
+}
+
+static void NCS(const s16 V[3], u8 shift, bool lm)
+{
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
+  MulMatVec(&s_regs.LLM[0][0], V[0], V[1], V[2], shift, lm);
+
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
+  MulMatVec(&s_regs.LCM[0][0], s_regs.BK, s_regs.IR1, s_regs.IR2, s_regs.IR3, shift, lm);
+
+  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
+  PushRGBFromMAC();
+}
+
+static void NCCS(const s16 V[3], u8 shift, bool lm)
+{
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
+  MulMatVec(&s_regs.LLM[0][0], V[0], V[1], V[2], shift, lm);
+
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
+  MulMatVec(&s_regs.LCM[0][0], s_regs.BK, s_regs.IR1, s_regs.IR2, s_regs.IR3, shift, lm);
+
+  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
+  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)       ;<--- for NCDx/NCCx
+  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(s_regs.RGBC[0])) * s32(s_regs.IR1)) << 4, shift, lm);
+  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(s_regs.RGBC[1])) * s32(s_regs.IR2)) << 4, shift, lm);
+  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(s_regs.RGBC[2])) * s32(s_regs.IR3)) << 4, shift, lm);
+
+  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
+  PushRGBFromMAC();
+}
+
+static void NCDS(const s16 V[3], u8 shift, bool lm)
+{
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
+  MulMatVec(&s_regs.LLM[0][0], V[0], V[1], V[2], shift, lm);
+
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
+  MulMatVec(&s_regs.LCM[0][0], s_regs.BK, s_regs.IR1, s_regs.IR2, s_regs.IR3, shift, lm);
+
+  // No need to assign these to MAC[1-3], as it'll never overflow.
+  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
+  const s32 in_MAC1 = (s32(ZeroExtend32(s_regs.RGBC[0])) * s32(s_regs.IR1)) << 4;
+  const s32 in_MAC2 = (s32(ZeroExtend32(s_regs.RGBC[1])) * s32(s_regs.IR2)) << 4;
+  const s32 in_MAC3 = (s32(ZeroExtend32(s_regs.RGBC[2])) * s32(s_regs.IR3)) << 4;
+
+  // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for NCDx only
+  InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+
+  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
+  PushRGBFromMAC();
+}
+
+static void Execute_CC(Instruction inst)
+{
+  s_regs.FLAG.Clear();
+
+  const u8 shift = inst.GetShift();
+  const bool lm = inst.lm;
+
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
+  MulMatVec(&s_regs.LCM[0][0], s_regs.BK, s_regs.IR1, s_regs.IR2, s_regs.IR3, shift, lm);
+
+  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4
+  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
+  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(s_regs.RGBC[0])) * s32(s_regs.IR1)) << 4, shift, lm);
+  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(s_regs.RGBC[1])) * s32(s_regs.IR2)) << 4, shift, lm);
+  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(s_regs.RGBC[2])) * s32(s_regs.IR3)) << 4, shift, lm);
+
+  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
+  PushRGBFromMAC();
+
+  s_regs.FLAG.UpdateError();
+}
+
+static void Execute_CDP(Instruction inst)
+{
+  s_regs.FLAG.Clear();
+
+  const u8 shift = inst.GetShift();
+  const bool lm = inst.lm;
+
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
+  MulMatVec(&s_regs.LCM[0][0], s_regs.BK, s_regs.IR1, s_regs.IR2, s_regs.IR3, shift, lm);
+
+  // No need to assign these to MAC[1-3], as it'll never overflow.
+  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4
+  const s32 in_MAC1 = (s32(ZeroExtend32(s_regs.RGBC[0])) * s32(s_regs.IR1)) << 4;
+  const s32 in_MAC2 = (s32(ZeroExtend32(s_regs.RGBC[1])) * s32(s_regs.IR2)) << 4;
+  const s32 in_MAC3 = (s32(ZeroExtend32(s_regs.RGBC[2])) * s32(s_regs.IR3)) << 4;
+
+  // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for CDP only
+  // [MAC1, MAC2, MAC3] = [MAC1, MAC2, MAC3] SAR(sf * 12)
+  InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+
+  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
+  PushRGBFromMAC();
+
+  s_regs.FLAG.UpdateError();
+}
+
+static void Execute_RTPS(Instruction inst)
+{
+  RTPS(s_regs.V0, inst.GetShift(), inst.lm, true);
+}
+
+static void Execute_RTPT(Instruction inst)
+{
+  RTPS(s_regs.V0, inst.GetShift(), inst.lm, false);
+  RTPS(s_regs.V1, inst.GetShift(), inst.lm, false);
+  RTPS(s_regs.V2, inst.GetShift(), inst.lm, true);
+}
+
+template<void (*Func)(const s16[3], u8, bool)>
+static void Execute_Single(Instruction inst)
+{
+  Func(s_regs.V0, inst.GetShift(), inst.lm);
+}
+
+template<void (*Func)(const s16[3], u8, bool)>
+static void Execute_Triple(Instruction inst)
+{
+  Func(s_regs.V0, inst.GetShift(), inst.lm);
+  Func(s_regs.V1, inst.GetShift(), inst.lm);
+  Func(s_regs.V2, inst.GetShift(), inst.lm);
+}
+
+static void ExecuteInstruction(u32 inst_bits)
+{
+  const Instruction inst{inst_bits};
+  s_regs.FLAG.Clear();
+
+  // clang-format off
+  switch (inst.command)
+  {
+    case 0x01: Execute_RTPS(inst); break;
+    case 0x12: Execute_MVMVA(inst); break;
+    case 0x13: Execute_Single<NCDS>(inst); break;
+    case 0x14: Execute_CDP(inst); break;
+    case 0x16: Execute_Triple<NCDS>(inst); break;
+    case 0x1B: Execute_Single<NCCS>(inst); break;
+    case 0x1C: Execute_CC(inst); break;
+    case 0x1E: Execute_Single<NCS>(inst); break;
+    case 0x20: Execute_Triple<NCS>(inst); break;
+    case 0x30: Execute_RTPT(inst); break;
+    case 0x3F: Execute_Triple<NCCS>(inst); break;
+
+    default:
+      FAIL() << "Unhandled instruction " << inst_bits;
+  }
+  // clang-format on
+
+  s_regs.FLAG.UpdateError();
+}
+
+} // namespace GTEReference
+
+namespace {
+class GTETest : public ::testing::Test
+{
+protected:
+  // Mix of small values, which stay in range through the whole pipeline, and arbitrary/extreme values which
+  // overflow and saturate at different stages.
+  u32 RandomValue()
+  {
+    switch (m_rng() % 4)
+    {
+      case 0:
+        return m_rng();
+      case 1:
+        return (static_cast<u32>(static_cast<s32>(m_rng() % 0x2001) - 0x1000) & 0xFFFFu) |
+               (static_cast<u32>(static_cast<s32>(m_rng() % 0x2001) - 0x1000) << 16);
+      case 2:
+        return (m_rng() & 1) ? 0x7FFF7FFFu : 0x80008000u;
+      default:
+        return m_rng() & 0x00FF00FFu;
+    }
+  }
+
+  void RandomizeRegisters()
+  {
+    GTE::Reset();
+    for (u32 i = 0; i < GTE::NUM_REGS; i++)
+      GTE::WriteRegister(i, RandomValue());
+
+    // Keep the canonical values written through WriteRegister(), e.g. sign-extended halfwords.
+    std::copy(std::begin(CPU::g_state.gte_regs.r32), std::end(CPU::g_state.gte_regs.r32), GTEReference::s_regs.r32);
+  }
+
+  void ExecuteAndCompare(u32 inst_bits)
+  {
+    RandomizeRegisters();
+
+    GTE::ExecuteInstruction(inst_bits);
+    GTEReference::ExecuteInstruction(inst_bits);
+
+    const GTE::Regs& regs = CPU::g_state.gte_regs;
+    for (u32 i = 0; i < GTE::NUM_REGS; i++)
+    {
+      ASSERT_EQ(regs.r32[i], GTEReference::s_regs.r32[i])
+        << "Register " << i << " differs for instruction " << std::hex << inst_bits;
+    }
+  }
+
+  std::mt19937 m_rng{0x6E7E};
+};
+
+class GTEInstructionTest : public GTETest, public ::testing::WithParamInterface<u32>
+{
+};
+} // namespace
+
+static constexpr u32 ITERATIONS = 2000;
+static constexpr u32 SF_BIT = 1u << 19;
+static constexpr u32 LM_BIT = 1u << 10;
+
+TEST_P(GTEInstructionTest, MatchesReference)
+{
+  for (u32 flags : {0u, SF_BIT, LM_BIT, SF_BIT | LM_BIT})
+  {
+    for (u32 i = 0; i < ITERATIONS; i++)
+      ExecuteAndCompare(GetParam() | flags);
+  }
+}
+
+TEST_F(GTETest, MVMVAMatchesReference)
+{
+  for (u32 flags : {0u, SF_BIT, LM_BIT, SF_BIT | LM_BIT})
+  {
+    // Every matrix/vector/translation combination, including the buggy FC and garbage matrix cases.
+    for (u32 mvmva = 0; mvmva < 64; mvmva++)
+    {
+      for (u32 i = 0; i < (ITERATIONS / 16); i++)
+        ExecuteAndCompare(0x12u | (mvmva << 13) | flags);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(GTE, GTEInstructionTest,
+                         ::testing::Values(0x01u /* RTPS */, 0x30u /* RTPT */, 0x1Eu /* NCS */, 0x20u /* NCT */,
+                                           0x1Bu /* NCCS */, 0x3Fu /* NCCT */, 0x13u /* NCDS */, 0x16u /* NCDT */,
+                                           0x1Cu /* CC */, 0x14u /* CDP */));
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#include "common/bitutils.h"
+#include "common/gsvector.h"
+
+#include <cpuinfo.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace MDECIDCT {
+#include "core/mdec_idct.inl"
+}
+
+using IDCTBlocksFunction = void (*)(s16* blocks, u32 count, const s16* matrix);
+
+#ifdef CPU_ARCH_SSE
+namespace MDEC::AVX2 {
+extern const IDCTBlocksFunction IDCTBlocksPtr;
+} // namespace MDEC::AVX2
+#endif
+
+static s16 IDCTRow_Scalar(const s16* blk, const s16* idct_matrix)
+{
+  // Same as the hardware-accurate scalar implementation: two 32-bit partial sums, added as 64-bit.
+  s32 sum0 = 0;
+  s32 sum1 = 0;
+  for (u32 i = 0; i < 4; i++)
+  {
+    sum0 = static_cast<s32>(static_cast<u32>(sum0) + static_cast<u32>(s32(blk[i]) * s32(idct_matrix[i])));
+    sum1 = static_cast<s32>(static_cast<u32>(sum1) + static_cast<u32>(s32(blk[i + 4]) * s32(idct_matrix[i + 4])));
+  }
+
+  return static_cast<s16>(((static_cast<s64>(sum0) + static_cast<s64>(sum1)) + 0x20000) >> 18);
+}
+
+static void IDCT_Scalar(s16* blk, const s16* scale_table)
+{
+  std::array<s16, 64> temp;
+  for (u32 x = 0; x < 8; x++)
+  {
+    for (u32 y = 0; y < 8; y++)
+      temp[y * 8 + x] = IDCTRow_Scalar(&blk[x * 8], &scale_table[y * 8]);
+  }
+  for (u32 x = 0; x < 8; x++)
+  {
+    for (u32 y = 0; y < 8; y++)
+    {
+      const s32 sum = IDCTRow_Scalar(&temp[x * 8], &scale_table[y * 8]);
+      blk[x * 8 + y] = static_cast<s16>(std::clamp(SignExtendN<9, s32>(sum), -128, 127));
+    }
+  }
+}
+
+static void CheckBlocks(IDCTBlocksFunction func, const std::array<s16, 64>& scale_table,
+                        const std::array<std::array<s16, 64>, 6>& input)
+{
+  alignas(32) std::array<s16, MDECIDCT::IDCT_MATRIX_SIZE> matrix;
+  MDECIDCT::BuildIDCTMatrix(matrix.data(), scale_table.data());
+
+  alignas(32) std::array<std::array<s16, 64>, 6> blocks_scalar = input;
+  alignas(32) std::array<std::array<s16, 64>, 6> blocks_vector = input;
+  for (std::array<s16, 64>& blk : blocks_scalar)
+    IDCT_Scalar(blk.data(), scale_table.data());
+  func(blocks_vector[0].data(), static_cast<u32>(blocks_vector.size()), matrix.data());
+
+  ASSERT_EQ(blocks_scalar, blocks_vector);
+}
+
+static void CheckRandomBlocks(IDCTBlocksFunction func)
+{
+  std::mt19937 rng(0x4D444543u);
+
+  // Coefficients are clamped to -0x4000..0x3FFF after dequantization.
+  std::uniform_int_distribution<s32> coeff_dist(-0x4000, 0x3FFF);
+  std::uniform_int_distribution<s32> scale_dist(INT16_MIN, INT16_MAX);
+  std::uniform_int_distribution<u32> mode_dist(0, 3);
+
+  for (u32 iter = 0; iter < 20000; iter++)
+  {
+    std::array<s16, 64> scale_table;
+    std::array<std::array<s16, 64>, 6> blocks;
+
+    // Mix of random tables, and extreme values which overflow the 32-bit partial sums.
+    const u32 mode = mode_dist(rng);
+    for (s16& v : scale_table)
+    {
+      v = static_cast<s16>((mode == 0) ? ((scale_dist(rng) & 1) ? INT16_MIN : INT16_MAX) : scale_dist(rng));
+    }
+    for (std::array<s16, 64>& blk : blocks)
+    {
+      for (s16& v : blk)
+      {
+        switch (mode)
+        {
+          case 0:
+            v = static_cast<s16>((coeff_dist(rng) & 1) ? -0x4000 : 0x3FFF);
+            break;
+          case 1:
+            // Sparse, like real data.
+            v = static_cast<s16>(((coeff_dist(rng) & 7) == 0) ? coeff_dist(rng) : 0);
+            break;
+          default:
+            v = static_cast<s16>(coeff_dist(rng));
+            break;
+        }
+      }
+    }
+
+    ASSERT_NO_FATAL_FAILURE(CheckBlocks(func, scale_table, blocks)) << "iteration " << iter;
+  }
+}
+
+TEST(MDEC, IDCT)
+{
+  CheckRandomBlocks(&MDECIDCT::IDCTBlocks);
+}
+
+#ifdef CPU_ARCH_SSE
+
+TEST(MDEC, IDCTAVX2)
+{
+  if (!cpuinfo_initialize() || !cpuinfo_has_x86_avx2())
+    GTEST_SKIP() << "AVX2 is not supported on this CPU";
+
+  CheckRandomBlocks(MDEC::AVX2::IDCTBlocksPtr);
+}
+
+#endif
@@ -152,6 +152,11 @@ static u8** s_fastmem_lut = nullptr;
 
 static bool s_kernel_initialize_hook_run = false;
 
+static std::bitset<RAM_8MB_CODE_PAGE_COUNT> s_ram_dirty_bits{};
+static std::array<u32, RAM_8MB_CODE_PAGE_COUNT> s_ram_page_generations = {};
+static u32 s_ram_generation = 0;
+static bool s_ram_dirty_page_tracking = false;
+
 static bool AllocateMemoryMap(bool export_shared_memory, Error* error);
 static void ReleaseMemoryMap();
 static void SetRAMSize(bool enable_8mb_ram);
@@ -163,7 +168,9 @@ static void MapFastmemViews();
 static void UnmapFastmemViews();
 static u8* GetLUTFastmemPointer(u32 address, u8* ram_ptr);
 
-static void SetRAMPageWritable(u32 page_index, bool writable);
+static void SetRAMPagesWritable(u32 page_index, u32 page_count, bool writable);
+static bool ShouldProtectRAMPage(u32 page_index);
+static void UpdateRAMPageProtection();
 
 static void KernelInitializedHook();
 static bool SideloadEXE(const std::string& path, Error* error);
@@ -368,6 +375,11 @@ bool Bus::ReallocateMemoryMap(bool export_shared_memory, Error* error)
     UpdateMappedRAMSize();
     std::memcpy(g_unprotected_ram, ram_backup.data(), RAM_8MB_SIZE);
     std::memcpy(g_bios, bios_backup.data(), BIOS_SIZE);
+
+    // New mapping is not write-protected.
+    if (s_ram_dirty_page_tracking)
+      s_ram_dirty_bits.set();
+
     MapFastmemViews();
   }
 
@@ -394,6 +406,10 @@ void Bus::SetRAMSize(bool enable_8mb_ram)
   g_ram_size = enable_8mb_ram ? RAM_8MB_SIZE : RAM_2MB_SIZE;
   g_ram_mask = enable_8mb_ram ? RAM_8MB_MASK : RAM_2MB_MASK;
 
+  // Newly-accessible pages won't be protected.
+  if (s_ram_dirty_page_tracking)
+    s_ram_dirty_bits.set();
+
 #ifndef __ANDROID__
   Exports::RAM_SIZE = g_ram_size;
   Exports::RAM_MASK = g_ram_mask;
@@ -433,7 +449,7 @@ void Bus::Reset()
   }
 }
 
-bool Bus::DoState(StateWrapper& sw)
+bool Bus::DoState(StateWrapper& sw, bool include_ram)
 {
   u32 ram_size = g_ram_size;
   sw.DoEx(&ram_size, 52, static_cast<u32>(RAM_2MB_SIZE));
@@ -449,7 +465,20 @@ bool Bus::DoState(StateWrapper& sw)
   sw.Do(&g_bios_access_time);
   sw.Do(&g_cdrom_access_time);
   sw.Do(&g_spu_access_time);
-  sw.DoBytes(g_ram, g_ram_size);
+  // Code pages can still be write-protected when memory states are loaded.
+  if (include_ram)
+  {
+    sw.DoBytes(g_unprotected_ram, g_ram_size);
+
+    // Nothing was flagged by the write, so treat every page as modified. Otherwise memory states which were saved
+    // before this load would still match the current generations and be restored incrementally from stale pages.
+    if (sw.IsReading() && s_ram_dirty_page_tracking)
+    {
+      const u32 page_count = g_ram_size >> HOST_PAGE_SHIFT;
+      for (u32 i = 0; i < page_count; i++)
+        s_ram_dirty_bits[i] = true;
+    }
+  }
 
   if (sw.GetVersion() < 58) [[unlikely]]
   {
@@ -568,11 +597,11 @@ void Bus::MapFastmemViews()
         return;
       }
 
-      // mark all pages with code as non-writable
+      // mark all pages with code or tracked for writes as non-writable
       const u32 page_count = g_ram_size >> HOST_PAGE_SHIFT;
       for (u32 i = 0; i < page_count; i++)
       {
-        if (g_ram_code_bits[i])
+        if (ShouldProtectRAMPage(i))
         {
           u8* page_address = map_address + (i << HOST_PAGE_SHIFT);
           if (!MemMap::MemProtect(page_address, HOST_PAGE_SIZE, PageProtect::ReadOnly)) [[unlikely]]
@@ -711,7 +740,7 @@ void Bus::SetRAMCodePage(u32 index)
 
   // protect fastmem pages
   g_ram_code_bits[index] = true;
-  SetRAMPageWritable(index, false);
+  SetRAMPagesWritable(index, 1, false);
 }
 
 void Bus::ClearRAMCodePage(u32 index)
@@ -719,17 +748,18 @@ void Bus::ClearRAMCodePage(u32 index)
   if (!g_ram_code_bits[index])
     return;
 
-  // unprotect fastmem pages
+  // unprotect fastmem pages, unless we're still waiting for the first write
   g_ram_code_bits[index] = false;
-  SetRAMPageWritable(index, true);
+  if (!ShouldProtectRAMPage(index))
+    SetRAMPagesWritable(index, 1, true);
 }
 
-void Bus::SetRAMPageWritable(u32 page_index, bool writable)
+void Bus::SetRAMPagesWritable(u32 page_index, u32 page_count, bool writable)
 {
-  if (!MemMap::MemProtect(&g_ram[page_index << HOST_PAGE_SHIFT], HOST_PAGE_SIZE,
+  if (!MemMap::MemProtect(&g_ram[page_index << HOST_PAGE_SHIFT], page_count << HOST_PAGE_SHIFT,
                           writable ? PageProtect::ReadWrite : PageProtect::ReadOnly)) [[unlikely]]
   {
-    ERROR_LOG("Failed to set RAM host page {} ({}) to {}", page_index,
+    ERROR_LOG("Failed to set RAM host pages {}-{} ({}) to {}", page_index, page_index + page_count - 1,
               reinterpret_cast<const void*>(&g_ram[page_index * HOST_PAGE_SIZE]),
               writable ? "read-write" : "read-only");
   }
@@ -743,7 +773,7 @@ void Bus::SetRAMPageWritable(u32 page_index, bool writable)
     for (const auto& it : s_fastmem_ram_views)
     {
       u8* page_address = it.first + (page_index << HOST_PAGE_SHIFT);
-      if (!MemMap::MemProtect(page_address, HOST_PAGE_SIZE, protect)) [[unlikely]]
+      if (!MemMap::MemProtect(page_address, page_count << HOST_PAGE_SHIFT, protect)) [[unlikely]]
       {
         ERROR_LOG("Failed to {} code page {} (0x{:08X}) @ {}", writable ? "unprotect" : "protect", page_index,
                   page_index << HOST_PAGE_SHIFT, static_cast<void*>(page_address));
@@ -759,6 +789,13 @@ void Bus::ClearRAMCodePageFlags()
 {
   g_ram_code_bits.reset();
 
+  if (s_ram_dirty_page_tracking)
+  {
+    // Clean pages still need to be protected.
+    UpdateRAMPageProtection();
+    return;
+  }
+
   if (!MemMap::MemProtect(g_ram, RAM_8MB_SIZE, PageProtect::ReadWrite))
     ERROR_LOG("Failed to restore RAM protection to read-write.");
 
@@ -775,6 +812,102 @@ void Bus::ClearRAMCodePageFlags()
 #endif
 }
 
+bool Bus::ShouldProtectRAMPage(u32 page_index)
+{
+  return (g_ram_code_bits[page_index] || (s_ram_dirty_page_tracking && !s_ram_dirty_bits[page_index]));
+}
+
+void Bus::UpdateRAMPageProtection()
+{
+  // Coalesce runs of pages to reduce the number of protection calls.
+  const u32 page_count = g_ram_size >> HOST_PAGE_SHIFT;
+  u32 run_start = 0;
+  bool run_protected = ShouldProtectRAMPage(0);
+  for (u32 i = 1; i <= page_count; i++)
+  {
+    const bool page_protected = (i < page_count) ? ShouldProtectRAMPage(i) : !run_protected;
+    if (page_protected == run_protected)
+      continue;
+
+    SetRAMPagesWritable(run_start, i - run_start, !run_protected);
+    run_start = i;
+    run_protected = page_protected;
+  }
+}
+
+void Bus::SetRAMDirtyPageTracking(bool enabled)
+{
+  if (s_ram_dirty_page_tracking == enabled)
+    return;
+
+  DEV_LOG("{} RAM dirty page tracking", enabled ? "Enabling" : "Disabling");
+  s_ram_dirty_page_tracking = enabled;
+  s_ram_dirty_bits.reset();
+
+  // Fresh generation, so that nothing matches any previously-saved pages.
+  s_ram_generation++;
+  s_ram_page_generations.fill(s_ram_generation);
+
+  if (g_ram_size > 0)
+    UpdateRAMPageProtection();
+}
+
+bool Bus::IsTrackingRAMDirtyPages()
+{
+  return s_ram_dirty_page_tracking;
+}
+
+void Bus::SetRAMPageDirty(u32 index)
+{
+  if (!s_ram_dirty_page_tracking)
+    return;
+
+  s_ram_dirty_bits[index] = true;
+
+  // Code pages stay protected until their blocks are invalidated.
+  if (!g_ram_code_bits[index])
+    SetRAMPagesWritable(index, 1, true);
+}
+
+std::span<u32> Bus::UpdateRAMPageGenerations()
+{
+  const u32 page_count = g_ram_size >> HOST_PAGE_SHIFT;
+  if (s_ram_dirty_bits.none())
+    return std::span<u32>(s_ram_page_generations.data(), page_count);
+
+  s_ram_generation++;
+
+  u32 run_start = 0;
+  u32 run_length = 0;
+  for (u32 i = 0; i < page_count; i++)
+  {
+    if (s_ram_dirty_bits[i])
+    {
+      s_ram_page_generations[i] = s_ram_generation;
+      s_ram_dirty_bits[i] = false;
+
+      // Code pages are already protected.
+      if (!g_ram_code_bits[i])
+      {
+        if (run_length == 0)
+          run_start = i;
+        run_length++;
+        continue;
+      }
+    }
+
+    if (run_length > 0)
+    {
+      SetRAMPagesWritable(run_start, run_length, false);
+      run_length = 0;
+    }
+  }
+  if (run_length > 0)
+    SetRAMPagesWritable(run_start, run_length, false);
+
+  return std::span<u32>(s_ram_page_generations.data(), page_count);
+}
+
 bool Bus::IsCodePageAddress(PhysicalMemoryAddress address)
 {
   return IsRAMAddress(address) ? g_ram_code_bits[(address & g_ram_mask) >> HOST_PAGE_SHIFT] : false;
@@ -126,7 +126,7 @@ void CleanupMemoryMap();
 void Initialize();
 void Shutdown();
 void Reset();
-bool DoState(StateWrapper& sw);
+bool DoState(StateWrapper& sw, bool include_ram);
 
 using MemoryReadHandler = u32 (*)(VirtualMemoryAddress address);
 using MemoryWriteHandler = void (*)(VirtualMemoryAddress, u32);
@@ -187,6 +187,18 @@ bool IsCodePageAddress(PhysicalMemoryAddress address);
 /// Returns true if the range specified overlaps with a code page.
 bool HasCodePagesInRange(PhysicalMemoryAddress start_address, u32 size);
 
+/// Enables write tracking of RAM pages for incremental memory save states. Clean pages are write-protected, and the
+/// first write after UpdateRAMPageGenerations() flags them as dirty through the page fault handler.
+void SetRAMDirtyPageTracking(bool enabled);
+bool IsTrackingRAMDirtyPages();
+
+/// Flags a RAM page as written since the last generation update.
+void SetRAMPageDirty(u32 index);
+
+/// Assigns a new generation to all pages written since the last call, and write-protects them again.
+/// Pages with matching generations are guaranteed to have the same contents.
+std::span<u32> UpdateRAMPageGenerations();
+
 /// Returns the number of cycles stolen by DMA RAM access.
 ALWAYS_INLINE TickCount GetDMARAMTickCount(u32 word_count)
 {
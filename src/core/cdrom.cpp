@@ -1012,7 +1012,7 @@ bool CDROM::PrecacheMedia()
   }
 
   LoadingScreenProgressCallback callback;
-  if (!s_reader.Precache(&callback))
+  if (!s_reader.Precache(&callback, g_settings.cdrom_share_preloaded_image, g_settings.cdrom_compress_preloaded_image))
   {
     Host::AddOSDMessage(TRANSLATE_STR("OSDMessage", "Precaching CD image failed, it may be unreliable."),
                         Host::OSD_ERROR_DURATION);
@@ -2,7 +2,10 @@
 // SPDX-License-Identifier: CC-BY-NC-ND-4.0
 
 #include "cdrom_async_reader.h"
+#include "performance_counters.h"
+
 #include "common/assert.h"
+#include "common/error.h"
 #include "common/log.h"
 #include "common/timer.h"
 LOG_CHANNEL(CDROMAsyncReader);
@@ -60,7 +63,7 @@ std::unique_ptr<CDImage> CDROMAsyncReader::RemoveMedia()
   return std::move(m_media);
 }
 
-bool CDROMAsyncReader::Precache(ProgressCallback* callback)
+bool CDROMAsyncReader::Precache(ProgressCallback* callback, bool shared, bool compressed)
 {
   WaitForIdle();
 
@@ -70,33 +73,47 @@ bool CDROMAsyncReader::Precache(ProgressCallback* callback)
   else if (m_media->IsPrecached())
     return true;
 
+  // Shared copies are always decoded, so they take priority over the image's own precaching.
+  if (shared)
+  {
+    Error error;
+    std::unique_ptr<CDImage> shared_image = CDImage::CreateSharedMemoryImage(m_media.get(), callback, &error);
+    if (shared_image)
+      return ReplaceWithMemoryImage(std::move(shared_image));
+
+    WARNING_LOG("Failed to share precached image, using a private copy: {}", error.GetDescription());
+  }
+
   const CDImage::PrecacheResult res = m_media->Precache(callback);
   if (res == CDImage::PrecacheResult::Unsupported)
   {
     // fall back to copy precaching
-    std::unique_ptr<CDImage> memory_image = CDImage::CreateMemoryImage(m_media.get(), callback);
+    std::unique_ptr<CDImage> memory_image = compressed ?
+                                              CDImage::CreateCompressedMemoryImage(m_media.get(), callback) :
+                                              CDImage::CreateMemoryImage(m_media.get(), callback);
     if (memory_image)
-    {
-      const CDImage::LBA lba = m_media->GetPositionOnDisc();
-      if (!memory_image->Seek(lba)) [[unlikely]]
-      {
-        ERROR_LOG("Failed to seek to LBA {} in memory image", lba);
-        return false;
-      }
-
-      m_media.reset();
-      m_media = std::move(memory_image);
-      return true;
-    }
+      return ReplaceWithMemoryImage(std::move(memory_image));
     else
-    {
       return false;
-    }
   }
 
   return (res == CDImage::PrecacheResult::Success);
 }
 
+bool CDROMAsyncReader::ReplaceWithMemoryImage(std::unique_ptr<CDImage> memory_image)
+{
+  const CDImage::LBA lba = m_media->GetPositionOnDisc();
+  if (!memory_image->Seek(lba)) [[unlikely]]
+  {
+    ERROR_LOG("Failed to seek to LBA {} in memory image", lba);
+    return false;
+  }
+
+  m_media.reset();
+  m_media = std::move(memory_image);
+  return true;
+}
+
 void CDROMAsyncReader::QueueReadSector(CDImage::LBA lba)
 {
   if (!IsUsingThread())
@@ -105,6 +122,16 @@ void CDROMAsyncReader::QueueReadSector(CDImage::LBA lba)
     return;
   }
 
+  // Mapped images are read directly from the page cache, so the round trip through the thread costs more than the
+  // read itself. The host takes care of readahead through access hints instead. Nothing kicks the thread on this
+  // path, so once any seek queued before the media change completes, it stays idle.
+  if (m_media->IsMemoryMapped())
+  {
+    WaitForIdle();
+    ReadSectorNonThreaded(lba);
+    return;
+  }
+
   const u32 buffer_count = m_buffer_count.load();
   if (buffer_count > 0)
   {
@@ -169,6 +196,7 @@ bool CDROMAsyncReader::InternalReadSectorUncached(CDImage::LBA lba, CDImage::Sub
     return false;
   }
 
+  const PerformanceCounters::ProfileScope profile(PerformanceCounters::ProfileSection::CDROMReads);
   if (!m_media->ReadRawSector(data, subq)) [[unlikely]]
   {
     WARNING_LOG("Read of LBA {} failed", lba);
@@ -238,7 +266,10 @@ bool CDROMAsyncReader::ReadSectorIntoBuffer(std::unique_lock<std::mutex>& lock)
 
   TRACE_LOG("Reading LBA {}...", buffer.lba);
 
-  buffer.result = m_media->ReadRawSector(buffer.data.data(), &buffer.subq);
+  {
+    const PerformanceCounters::ProfileScope profile(PerformanceCounters::ProfileSection::CDROMReads);
+    buffer.result = m_media->ReadRawSector(buffer.data.data(), &buffer.subq);
+  }
   if (buffer.result) [[likely]]
   {
     const double read_time = timer.GetTimeMilliseconds();
@@ -261,7 +292,9 @@ void CDROMAsyncReader::ReadSectorNonThreaded(CDImage::LBA lba)
 {
   Timer timer;
 
-  m_buffers.resize(1);
+  // keep the readahead slots if the thread is running, we only need the first
+  if (m_buffers.empty())
+    m_buffers.resize(1);
   m_seek_error.store(false);
   EmptyBuffers();
 
@@ -277,7 +310,10 @@ void CDROMAsyncReader::ReadSectorNonThreaded(CDImage::LBA lba)
 
   TRACE_LOG("Reading LBA {}...", buffer.lba);
 
-  buffer.result = m_media->ReadRawSector(buffer.data.data(), &buffer.subq);
+  {
+    const PerformanceCounters::ProfileScope profile(PerformanceCounters::ProfileSection::CDROMReads);
+    buffer.result = m_media->ReadRawSector(buffer.data.data(), &buffer.subq);
+  }
   if (buffer.result) [[likely]]
   {
     const double read_time = timer.GetTimeMilliseconds();
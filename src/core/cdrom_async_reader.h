@@ -46,8 +46,10 @@ public:
   void SetMedia(std::unique_ptr<CDImage> media);
   std::unique_ptr<CDImage> RemoveMedia();
 
-  /// Precaches image, either to memory, or using the underlying image precache.
-  bool Precache(ProgressCallback* callback);
+  /// Precaches image, either to memory, or using the underlying image precache. If shared is set, the image is
+  /// decoded to memory which is shared with other processes using the same image, where possible. If compressed is
+  /// set, images which can't precache themselves are kept compressed in memory.
+  bool Precache(ProgressCallback* callback, bool shared, bool compressed);
 
   void QueueReadSector(CDImage::LBA lba);
 
@@ -63,6 +65,7 @@ private:
   void ReadSectorNonThreaded(CDImage::LBA lba);
   bool InternalReadSectorUncached(CDImage::LBA lba, CDImage::SubChannelQ* subq, SectorBuffer* data);
   void CancelReadahead();
+  bool ReplaceWithMemoryImage(std::unique_ptr<CDImage> memory_image);
 
   void WorkerThreadEntryPoint();
 
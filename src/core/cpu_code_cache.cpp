@@ -6,6 +6,7 @@
 #include "cpu_core.h"
 #include "cpu_core_private.h"
 #include "cpu_disasm.h"
+#include "cpu_trace.h"
 #include "host.h"
 #include "settings.h"
 #include "system.h"
@@ -15,10 +16,13 @@
 
 #include "common/align.h"
 #include "common/assert.h"
+#include "common/binary_reader_writer.h"
 #include "common/error.h"
+#include "common/file_system.h"
 #include "common/intrin.h"
 #include "common/log.h"
 #include "common/memmap.h"
+#include "common/path.h"
 
 LOG_CHANNEL(CodeCache);
 
@@ -32,6 +36,9 @@ LOG_CHANNEL(CodeCache);
 #include "cpu_recompiler.h"
 #endif
 
+#include "fmt/format.h"
+#include "xxhash.h"
+
 #include <map>
 #include <unordered_set>
 #include <zlib.h>
@@ -52,6 +59,13 @@ static constexpr u32 RECOMPILE_FRAMES_FOR_INTERPRETER_FALLBACK = 15;
 static constexpr u32 INVALIDATE_COUNT_FOR_MANUAL_PROTECTION = 4;
 static constexpr u32 INVALIDATE_FRAMES_FOR_MANUAL_PROTECTION = 60;
 
+// Blocks ending in a conditional branch are recompiled as superblocks after this many executions.
+// Superblocks continue through the not-taken side of each branch, up to the instruction/segment limit.
+// They're opt-in (CPU/RecompilerSuperblocks) until the x64/arm64 speedup has been measured and the regtest
+// hashes confirmed unchanged, the extra side exits and dispatcher round-trips can easily cost more than they save.
+static constexpr u32 SUPERBLOCK_EXECUTION_THRESHOLD = 256;
+static constexpr u32 MAX_SUPERBLOCK_INSTRUCTIONS = 64;
+
 static void AllocateLUTs();
 static void DeallocateLUTs();
 static void ResetCodeLUT();
@@ -66,16 +80,29 @@ static bool IsBlockCodeCurrent(const Block* block);
 static bool RevalidateBlock(Block* block);
 static PageProtectionMode GetProtectionModeForPC(u32 pc);
 static PageProtectionMode GetProtectionModeForBlock(const Block* block);
-static bool ReadBlockInstructions(u32 start_pc, BlockInstructionList* instructions, BlockMetadata* metadata);
+static bool ReadBlockInstructions(u32 start_pc, BlockInstructionList* instructions, BlockMetadata* metadata,
+                                  bool superblock = false);
+static bool AreSuperblocksEnabled();
+static bool CanContinueSuperblock(const BlockInstructionInfoPair& branch, const Instruction delay_slot);
+static bool IsIdleLoopBlock(u32 start_pc, const BlockInstructionList& instructions);
+static bool IsIdleLoopFixedPoint(const Block* block);
 static void FillBlockRegInfo(Block* block);
 static void CopyRegInfo(InstructionInfo* dst, const InstructionInfo* src);
 static void SetRegAccess(InstructionInfo* inst, Reg reg, bool write);
 static void AddBlockToPageList(Block* block);
 static void RemoveBlockFromPageList(Block* block);
+static void InvalidatePageBlockList(PageProtectionInfo& ppi, BlockState new_state);
+
+static std::string GetBlockAnalysisCachePath(std::string_view serial);
+static void LoadBlockAnalysisCache();
+static void SaveBlockAnalysisCache();
+static u64 GetBlockCodeHash(u32 pc, const void* code, u32 size);
+static void RecordBlockDescriptor(const Block* block);
+static void RestartBlockPrecompile();
 
 static Block* CreateCachedInterpreterBlock(u32 pc);
 [[noreturn]] static void ExecuteCachedInterpreter();
-template<PGXPMode pgxp_mode>
+template<PGXPMode pgxp_mode, bool trace>
 [[noreturn]] static void ExecuteCachedInterpreterImpl();
 
 // Fast map provides lookup from PC to function
@@ -87,6 +114,10 @@ static std::unique_ptr<Block*[]> s_lut_block_pointers;
 static PageProtectionArray s_page_protection = {};
 static std::vector<Block*> s_blocks;
 
+// Code pages saved by BeginRAMRestore(), so EndRAMRestore() can tell which ones the state load changed.
+static std::vector<u32> s_ram_restore_pages;
+static std::vector<u8> s_ram_restore_backup;
+
 // for compiling - reuse to avoid allocations
 static BlockInstructionList s_block_instructions;
 
@@ -100,6 +131,57 @@ static PageFaultHandler::HandlerResult HandleFastmemException(void* exception_pc
 static void BackpatchLoadStore(void* host_pc, const LoadstoreBackpatchInfo& info);
 static void RemoveBackpatchInfoForRange(const void* host_code, u32 size);
 
+namespace {
+struct IdleLoopState
+{
+  static constexpr u32 INVALID_PC = 0xFFFFFFFFu;
+
+  u32 pc = INVALID_PC;
+  u32 pending_ticks = 0;
+  u32 downcount = 0;
+  u32 iteration_ticks = 0;
+  GlobalTicks global_ticks = 0;
+};
+} // namespace
+
+// Idle loops longer than this are unlikely to be pure polling loops.
+static constexpr u32 MAX_IDLE_LOOP_INSTRUCTIONS = 16;
+
+static IdleLoopState s_idle_loop;
+
+namespace {
+struct BlockDescriptor
+{
+  u32 pc;
+  u32 size;
+  u64 hash;
+};
+
+struct BlockAnalysisCache
+{
+  std::string serial;
+  std::vector<BlockDescriptor> descriptors;
+  std::unordered_set<u64> known_hashes;
+  u32 precompile_cursor = 0;
+  u32 precompile_delay = 0;
+  bool precompile_found_any = false;
+  bool dirty = false;
+};
+} // namespace
+
+// Descriptors are keyed by a hash of the code seeded with the PC, so overlays at the same address are kept separately.
+static constexpr u32 BLOCK_ANALYSIS_CACHE_SIGNATURE = 0x43424B42; // BKBC
+static constexpr u32 BLOCK_ANALYSIS_CACHE_VERSION = 1;
+static constexpr u32 MAX_BLOCK_ANALYSIS_CACHE_DESCRIPTORS = 128 * 1024;
+
+// Per-frame budget for precompiling. Checking a descriptor is only a hash of its code, compiling is much slower.
+// A pass which finds nothing to compile waits a second before retrying, to pick up code the game loads later.
+static constexpr u32 PRECOMPILE_CHECKS_PER_FRAME = 1024;
+static constexpr u32 PRECOMPILE_BLOCKS_PER_FRAME = 64;
+static constexpr u32 PRECOMPILE_RETRY_DELAY_FRAMES = 60;
+
+static BlockAnalysisCache s_block_analysis_cache;
+
 static BlockLinkMap s_block_links;
 static std::map<const void*, LoadstoreBackpatchInfo> s_fastmem_backpatch_info;
 static std::unordered_set<u32> s_fastmem_faulting_pcs;
@@ -209,6 +291,8 @@ void CPU::CodeCache::ProcessShutdown()
 void CPU::CodeCache::Reset()
 {
   ClearBlocks();
+  s_idle_loop = {};
+  RestartBlockPrecompile();
 
   if (IsUsingRecompiler())
   {
@@ -221,6 +305,7 @@ void CPU::CodeCache::Reset()
 void CPU::CodeCache::Shutdown()
 {
   ClearBlocks();
+  GameChanged({});
 }
 
 void CPU::CodeCache::Execute()
@@ -392,6 +477,13 @@ CPU::CodeCache::Block* CPU::CodeCache::CreateBlock(u32 pc, const BlockInstructio
     recompile_frame = block->compile_frame;
     recompile_count = block->compile_count;
 
+    // promoting to a superblock isn't a "real" recompile, don't let it push us towards the interpreter fallback
+    if ((metadata.flags & BlockFlags::IsSuperblock) != BlockFlags::None && !block->HasFlag(BlockFlags::IsSuperblock) &&
+        recompile_count > 0)
+    {
+      recompile_count--;
+    }
+
     // if it has the same number of instructions, we can reuse it
     if (block->size != size)
     {
@@ -428,6 +520,7 @@ CPU::CodeCache::Block* CPU::CodeCache::CreateBlock(u32 pc, const BlockInstructio
   block->icache_line_count = metadata.icache_line_count;
   block->host_code_size = 0;
   block->compile_frame = recompile_frame;
+  block->execution_count = 0;
   block->compile_count = recompile_count + 1;
 
   // copy instructions/info
@@ -589,6 +682,11 @@ void CPU::CodeCache::InvalidateBlocksWithPageIndex(u32 index)
     new_block_state = BlockState::NeedsRecompile;
   }
 
+  InvalidatePageBlockList(ppi, new_block_state);
+}
+
+void CPU::CodeCache::InvalidatePageBlockList(PageProtectionInfo& ppi, BlockState new_state)
+{
   if (!ppi.first_block_in_page)
     return;
 
@@ -597,7 +695,7 @@ void CPU::CodeCache::InvalidateBlocksWithPageIndex(u32 index)
   Block* block = ppi.first_block_in_page;
   while (block)
   {
-    InvalidateBlock(block, new_block_state);
+    InvalidateBlock(block, new_state);
     block = std::exchange(block->next_block_in_page, nullptr);
   }
 
@@ -607,6 +705,54 @@ void CPU::CodeCache::InvalidateBlocksWithPageIndex(u32 index)
   MemMap::EndCodeWrite();
 }
 
+void CPU::CodeCache::InvalidateRestoredRAMPage(u32 index)
+{
+  DebugAssert(index < Bus::RAM_8MB_CODE_PAGE_COUNT);
+  Bus::ClearRAMCodePage(index);
+
+  // Not counted towards switching to manual protection, the game didn't write to the page itself.
+  InvalidatePageBlockList(s_page_protection[index], BlockState::Invalidated);
+  RestartBlockPrecompile();
+}
+
+void CPU::CodeCache::BeginRAMRestore()
+{
+  // Only pages with write-protected blocks need checking. Manually-protected blocks compare their code on entry,
+  // and anything that's already invalidated gets revalidated against the new RAM anyway.
+  s_ram_restore_pages.clear();
+  const u32 page_count = Bus::g_ram_size >> HOST_PAGE_SHIFT;
+  for (u32 i = 0; i < page_count; i++)
+  {
+    if (Bus::IsRAMCodePage(i))
+      s_ram_restore_pages.push_back(i);
+  }
+
+  s_ram_restore_backup.resize(s_ram_restore_pages.size() * HOST_PAGE_SIZE);
+  u8* backup_ptr = s_ram_restore_backup.data();
+  for (const u32 page : s_ram_restore_pages)
+  {
+    std::memcpy(backup_ptr, Bus::g_unprotected_ram + (page << HOST_PAGE_SHIFT), HOST_PAGE_SIZE);
+    backup_ptr += HOST_PAGE_SIZE;
+  }
+}
+
+void CPU::CodeCache::EndRAMRestore()
+{
+  const u8* backup_ptr = s_ram_restore_backup.data();
+  for (const u32 page : s_ram_restore_pages)
+  {
+    if (std::memcmp(backup_ptr, Bus::g_unprotected_ram + (page << HOST_PAGE_SHIFT), HOST_PAGE_SIZE) != 0)
+    {
+      DEBUG_LOG("Code page {} changed in restored RAM, invalidating.", page);
+      InvalidateRestoredRAMPage(page);
+    }
+
+    backup_ptr += HOST_PAGE_SIZE;
+  }
+
+  s_ram_restore_pages.clear();
+}
+
 CPU::CodeCache::PageProtectionMode CPU::CodeCache::GetProtectionModeForPC(u32 pc)
 {
   if (!AddressInRAM(pc))
@@ -659,6 +805,9 @@ void CPU::CodeCache::InvalidateAllRAMBlocks()
 
   MemMap::EndCodeWrite();
   Bus::ClearRAMCodePageFlags();
+
+  // Everything in RAM needs recompiling now, try to get the code back ahead of time.
+  RestartBlockPrecompile();
 }
 
 void CPU::CodeCache::ClearBlocks()
@@ -696,8 +845,13 @@ PageFaultHandler::HandlerResult PageFaultHandler::HandlePageFault(void* exceptio
     DebugAssert(is_write);
     const u32 guest_address = static_cast<u32>(static_cast<const u8*>(fault_address) - Bus::g_ram);
     const u32 page_index = Bus::GetRAMCodePageIndex(guest_address);
-    DEV_LOG("Page fault on protected RAM @ 0x{:08X} (page #{}), invalidating code cache.", guest_address, page_index);
-    CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+    Bus::SetRAMPageDirty(page_index);
+    if (Bus::IsRAMCodePage(page_index) || !Bus::IsTrackingRAMDirtyPages())
+    {
+      DEV_LOG("Page fault on protected RAM @ 0x{:08X} (page #{}), invalidating code cache.", guest_address,
+              page_index);
+      CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+    }
     return PageFaultHandler::HandlerResult::ContinueExecution;
   }
 
@@ -715,7 +869,7 @@ CPU::CodeCache::Block* CPU::CodeCache::CreateCachedInterpreterBlock(u32 pc)
   return CreateBlock(pc, s_block_instructions, metadata);
 }
 
-template<PGXPMode pgxp_mode>
+template<PGXPMode pgxp_mode, bool trace>
 [[noreturn]] void CPU::CodeCache::ExecuteCachedInterpreterImpl()
 {
 #define CHECK_DOWNCOUNT()                                                                                              \
@@ -771,6 +925,9 @@ template<PGXPMode pgxp_mode>
       }
 
       DebugAssert(!(HasPendingInterrupt()));
+      if (block->HasFlag(BlockFlags::IsIdleLoop))
+        TrySkipIdleLoop(block);
+
       if (block->HasFlag(BlockFlags::IsUsingICache))
       {
         CheckAndUpdateICacheTags(block->icache_line_count);
@@ -786,7 +943,7 @@ template<PGXPMode pgxp_mode>
         AddPendingTicks(block->uncached_fetch_ticks);
       }
 
-      InterpretCachedBlock<pgxp_mode>(block);
+      InterpretCachedBlock<pgxp_mode, trace>(block);
 
       CHECK_DOWNCOUNT();
 
@@ -797,7 +954,7 @@ template<PGXPMode pgxp_mode>
         continue;
 
     interpret_block:
-      InterpretUncachedBlock<pgxp_mode>();
+      InterpretUncachedBlock<pgxp_mode, trace>();
       CHECK_DOWNCOUNT();
       continue;
     }
@@ -808,17 +965,295 @@ template<PGXPMode pgxp_mode>
 
 [[noreturn]] void CPU::CodeCache::ExecuteCachedInterpreter()
 {
+  const bool trace = Trace::IsActive();
   if (g_settings.gpu_pgxp_enable)
   {
     if (g_settings.gpu_pgxp_cpu)
-      ExecuteCachedInterpreterImpl<PGXPMode::CPU>();
+    {
+      trace ? ExecuteCachedInterpreterImpl<PGXPMode::CPU, true>() :
+              ExecuteCachedInterpreterImpl<PGXPMode::CPU, false>();
+    }
     else
-      ExecuteCachedInterpreterImpl<PGXPMode::Memory>();
+    {
+      trace ? ExecuteCachedInterpreterImpl<PGXPMode::Memory, true>() :
+              ExecuteCachedInterpreterImpl<PGXPMode::Memory, false>();
+    }
   }
   else
   {
-    ExecuteCachedInterpreterImpl<PGXPMode::Disabled>();
+    trace ? ExecuteCachedInterpreterImpl<PGXPMode::Disabled, true>() :
+            ExecuteCachedInterpreterImpl<PGXPMode::Disabled, false>();
+  }
+}
+
+bool CPU::CodeCache::IsIdleLoopBlock(u32 start_pc, const BlockInstructionList& instructions)
+{
+  // We're looking for a small block which branches back to itself, and only reads memory/computes on registers.
+  // Anything with side effects (stores, coprocessor access, mult/div, overflow traps) disqualifies it.
+  const size_t count = instructions.size();
+  if (count < 2 || count > MAX_IDLE_LOOP_INSTRUCTIONS)
+    return false;
+
+  const Instruction branch = instructions[count - 2].first;
+  const Instruction delay_slot = instructions[count - 1].first;
+  const u32 branch_pc = start_pc + static_cast<u32>((count - 2) * sizeof(Instruction));
+  if (!IsDirectBranchInstruction(branch) || IsCallInstruction(branch) ||
+      (branch.op == InstructionOp::b && (static_cast<u8>(branch.i.rt.GetValue()) & 0x1E) == 0x10) ||
+      GetDirectBranchTarget(branch, branch_pc) != start_pc || IsMemoryLoadInstruction(delay_slot))
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    if (i == (count - 2))
+      continue;
+
+    const Instruction inst = instructions[i].first;
+    switch (inst.op)
+    {
+      case InstructionOp::addiu:
+      case InstructionOp::slti:
+      case InstructionOp::sltiu:
+      case InstructionOp::andi:
+      case InstructionOp::ori:
+      case InstructionOp::xori:
+      case InstructionOp::lui:
+      case InstructionOp::lb:
+      case InstructionOp::lbu:
+      case InstructionOp::lh:
+      case InstructionOp::lhu:
+      case InstructionOp::lw:
+        continue;
+
+      case InstructionOp::funct:
+      {
+        switch (inst.r.funct)
+        {
+          case InstructionFunct::sll:
+          case InstructionFunct::srl:
+          case InstructionFunct::sra:
+          case InstructionFunct::sllv:
+          case InstructionFunct::srlv:
+          case InstructionFunct::srav:
+          case InstructionFunct::addu:
+          case InstructionFunct::subu:
+          case InstructionFunct::and_:
+          case InstructionFunct::or_:
+          case InstructionFunct::xor_:
+          case InstructionFunct::nor:
+          case InstructionFunct::slt:
+          case InstructionFunct::sltu:
+            continue;
+
+          default:
+            return false;
+        }
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool CPU::CodeCache::IsIdleLoopFixedPoint(const Block* block)
+{
+  // Evaluate one iteration of the loop against a copy of the register file, following the interpreter's load delay
+  // semantics. If we end up back at the start with exactly the same registers, then the next iteration will do the
+  // same thing again, and so on, until an event changes memory or raises an interrupt.
+  u32 regs[static_cast<u8>(Reg::count) + 1];
+  std::memcpy(regs, g_state.regs.r, sizeof(regs));
+
+  Reg load_delay_reg = Reg::count;
+  u32 load_delay_value = 0;
+  Reg next_load_delay_reg = Reg::count;
+  u32 next_load_delay_value = 0;
+  u32 next_pc = block->pc + block->size * sizeof(Instruction);
+
+  const auto write_reg = [&](Reg rd, u32 value) {
+    regs[static_cast<u8>(rd)] = value;
+    load_delay_reg = (rd == load_delay_reg) ? Reg::count : load_delay_reg;
+    regs[0] = 0;
+  };
+  const auto write_reg_delayed = [&](Reg rd, u32 value) {
+    if (rd == Reg::zero)
+      return;
+
+    if (load_delay_reg == rd)
+      load_delay_reg = Reg::count;
+
+    next_load_delay_reg = rd;
+    next_load_delay_value = value;
+  };
+
+  const Instruction* instruction = block->Instructions();
+  u32 pc = block->pc;
+  for (u32 i = 0; i < block->size; i++, instruction++, pc += sizeof(Instruction))
+  {
+    const Instruction inst = *instruction;
+    const u32 rs = regs[static_cast<u8>(inst.i.rs.GetValue())];
+    const u32 rt = regs[static_cast<u8>(inst.i.rt.GetValue())];
+
+    switch (inst.op)
+    {
+      case InstructionOp::funct:
+      {
+        const Reg rd = inst.r.rd;
+        const u32 shamt = inst.r.shamt;
+        switch (inst.r.funct)
+        {
+            // clang-format off
+          case InstructionFunct::sll: write_reg(rd, rt << shamt); break;
+          case InstructionFunct::srl: write_reg(rd, rt >> shamt); break;
+          case InstructionFunct::sra: write_reg(rd, static_cast<u32>(static_cast<s32>(rt) >> shamt)); break;
+          case InstructionFunct::sllv: write_reg(rd, rt << (rs & 0x1F)); break;
+          case InstructionFunct::srlv: write_reg(rd, rt >> (rs & 0x1F)); break;
+          case InstructionFunct::srav: write_reg(rd, static_cast<u32>(static_cast<s32>(rt) >> (rs & 0x1F))); break;
+          case InstructionFunct::addu: write_reg(rd, rs + rt); break;
+          case InstructionFunct::subu: write_reg(rd, rs - rt); break;
+          case InstructionFunct::and_: write_reg(rd, rs & rt); break;
+          case InstructionFunct::or_: write_reg(rd, rs | rt); break;
+          case InstructionFunct::xor_: write_reg(rd, rs ^ rt); break;
+          case InstructionFunct::nor: write_reg(rd, ~(rs | rt)); break;
+          case InstructionFunct::slt: write_reg(rd, BoolToUInt32(static_cast<s32>(rs) < static_cast<s32>(rt))); break;
+          case InstructionFunct::sltu: write_reg(rd, BoolToUInt32(rs < rt)); break;
+          default: return false;
+            // clang-format on
+        }
+      }
+      break;
+
+        // clang-format off
+      case InstructionOp::addiu: write_reg(inst.i.rt, rs + inst.i.imm_sext32()); break;
+      case InstructionOp::slti: write_reg(inst.i.rt, BoolToUInt32(static_cast<s32>(rs) < static_cast<s32>(inst.i.imm_sext32()))); break;
+      case InstructionOp::sltiu: write_reg(inst.i.rt, BoolToUInt32(rs < inst.i.imm_sext32())); break;
+      case InstructionOp::andi: write_reg(inst.i.rt, rs & inst.i.imm_zext32()); break;
+      case InstructionOp::ori: write_reg(inst.i.rt, rs | inst.i.imm_zext32()); break;
+      case InstructionOp::xori: write_reg(inst.i.rt, rs ^ inst.i.imm_zext32()); break;
+      case InstructionOp::lui: write_reg(inst.i.rt, inst.i.imm_zext32() << 16); break;
+        // clang-format on
+
+      case InstructionOp::lb:
+      case InstructionOp::lbu:
+      {
+        // Only RAM/scratchpad/BIOS are side-effect free to read.
+        u8 value;
+        if (!SafeReadMemoryByte(rs + inst.i.imm_sext32(), &value))
+          return false;
+
+        write_reg_delayed(inst.i.rt, (inst.op == InstructionOp::lb) ? SignExtend32(value) : ZeroExtend32(value));
+      }
+      break;
+
+      case InstructionOp::lh:
+      case InstructionOp::lhu:
+      {
+        const VirtualMemoryAddress addr = rs + inst.i.imm_sext32();
+        u16 value;
+        if ((addr & 1) != 0 || !SafeReadMemoryHalfWord(addr, &value))
+          return false;
+
+        write_reg_delayed(inst.i.rt, (inst.op == InstructionOp::lh) ? SignExtend32(value) : ZeroExtend32(value));
+      }
+      break;
+
+      case InstructionOp::lw:
+      {
+        const VirtualMemoryAddress addr = rs + inst.i.imm_sext32();
+        u32 value;
+        if ((addr & 3) != 0 || !SafeReadMemoryWord(addr, &value))
+          return false;
+
+        write_reg_delayed(inst.i.rt, value);
+      }
+      break;
+
+      case InstructionOp::j:
+        next_pc = GetDirectBranchTarget(inst, pc);
+        break;
+
+      case InstructionOp::b:
+      {
+        const bool bgez = ConvertToBoolUnchecked(static_cast<u8>(inst.i.rt.GetValue()) & u8(1));
+        if ((static_cast<s32>(rs) < 0) ^ bgez)
+          next_pc = GetDirectBranchTarget(inst, pc);
+      }
+      break;
+
+        // clang-format off
+      case InstructionOp::beq: if (rs == rt) next_pc = GetDirectBranchTarget(inst, pc); break;
+      case InstructionOp::bne: if (rs != rt) next_pc = GetDirectBranchTarget(inst, pc); break;
+      case InstructionOp::blez: if (static_cast<s32>(rs) <= 0) next_pc = GetDirectBranchTarget(inst, pc); break;
+      case InstructionOp::bgtz: if (static_cast<s32>(rs) > 0) next_pc = GetDirectBranchTarget(inst, pc); break;
+        // clang-format on
+
+      default:
+        return false;
+    }
+
+    // UpdateLoadDelay()
+    regs[static_cast<u8>(load_delay_reg)] = load_delay_value;
+    load_delay_reg = next_load_delay_reg;
+    load_delay_value = next_load_delay_value;
+    next_load_delay_reg = Reg::count;
+  }
+
+  return (next_pc == block->pc && load_delay_reg == Reg::count &&
+          std::memcmp(regs, g_state.regs.r, sizeof(u32) * static_cast<u8>(Reg::hi)) == 0);
+}
+
+void CPU::CodeCache::TrySkipIdleLoop(const Block* block)
+{
+  // Can't skip if something is about to happen, or the loop is reading through an isolated cache.
+  if (HasPendingInterrupt() || g_state.pending_ticks >= g_state.downcount || g_state.cop0_regs.sr.Isc ||
+      g_state.load_delay_reg != Reg::count || g_state.next_load_delay_reg != Reg::count ||
+      !IsIdleLoopFixedPoint(block))
+  {
+    s_idle_loop.pc = IdleLoopState::INVALID_PC;
+    return;
+  }
+
+  // Measure the cost of an iteration by watching consecutive entries within the same event slice. We need the same
+  // cost twice in a row, because the first iteration can include icache fills.
+  const GlobalTicks global_ticks = TimingEvents::GetGlobalTickCounter();
+  if (s_idle_loop.pc != block->pc || s_idle_loop.global_ticks != global_ticks ||
+      s_idle_loop.downcount != g_state.downcount || g_state.pending_ticks <= s_idle_loop.pending_ticks)
+  {
+    s_idle_loop.pc = block->pc;
+    s_idle_loop.pending_ticks = g_state.pending_ticks;
+    s_idle_loop.downcount = g_state.downcount;
+    s_idle_loop.iteration_ticks = 0;
+    s_idle_loop.global_ticks = global_ticks;
+    return;
+  }
+
+  const u32 iteration_ticks = g_state.pending_ticks - s_idle_loop.pending_ticks;
+  if (iteration_ticks != s_idle_loop.iteration_ticks)
+  {
+    s_idle_loop.pending_ticks = g_state.pending_ticks;
+    s_idle_loop.iteration_ticks = iteration_ticks;
+    return;
+  }
+
+  // Leave the last iteration to actually execute, so we end up exactly where we would have without skipping.
+  const u32 iterations = (g_state.downcount - g_state.pending_ticks + iteration_ticks - 1) / iteration_ticks;
+  if (iterations > 1)
+  {
+    DEBUG_LOG("Skipping {} iterations of idle loop at 0x{:08X}", iterations - 1, block->pc);
+    g_state.pending_ticks += (iterations - 1) * iteration_ticks;
   }
+
+  s_idle_loop.pc = IdleLoopState::INVALID_PC;
+}
+
+void CPU::CodeCache::TrySkipIdleLoopAtPC()
+{
+  const Block* block = LookupBlock(g_state.pc);
+  if (block && block->HasFlag(BlockFlags::IsIdleLoop))
+    TrySkipIdleLoop(block);
 }
 
 void CPU::CodeCache::LogCurrentState()
@@ -851,7 +1286,8 @@ void CPU::CodeCache::LogCurrentState()
 // MARK: - Block Compilation: Shared Code
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool CPU::CodeCache::ReadBlockInstructions(u32 start_pc, BlockInstructionList* instructions, BlockMetadata* metadata)
+bool CPU::CodeCache::ReadBlockInstructions(u32 start_pc, BlockInstructionList* instructions, BlockMetadata* metadata,
+                                           bool superblock)
 {
   // TODO: Jump to other block if it exists at this pc?
 
@@ -860,6 +1296,7 @@ bool CPU::CodeCache::ReadBlockInstructions(u32 start_pc, BlockInstructionList* i
   const bool dynamic_fetch_ticks = (!use_icache && Bus::GetMemoryAccessTimePtr(start_pc & PHYSICAL_MEMORY_ADDRESS_MASK,
                                                                                MemoryAccessSize::Word) != nullptr);
   u32 pc = start_pc;
+  u32 superblock_segments = 1;
   bool is_branch_delay_slot = false;
   bool is_load_delay_slot = false;
 
@@ -975,7 +1412,21 @@ bool CPU::CodeCache::ReadBlockInstructions(u32 start_pc, BlockInstructionList* i
     // if we're in a branch delay slot, the block is now done
     // except if this is a branch in a branch delay slot, then we grab the one after that, and so on...
     if (is_branch_delay_slot && !info.is_branch_instruction)
-      break;
+    {
+      // superblocks keep going through the not-taken path
+      if (!superblock || superblock_segments == MAX_SUPERBLOCK_SEGMENTS ||
+          instructions->size() >= MAX_SUPERBLOCK_INSTRUCTIONS ||
+          !CanContinueSuperblock(instructions->at(instructions->size() - 2), instruction))
+      {
+        break;
+      }
+
+      metadata->flags |= BlockFlags::IsSuperblock;
+      superblock_segments++;
+      is_branch_delay_slot = false;
+      is_load_delay_slot = false;
+      continue;
+    }
 
     // if this is a branch, we grab the next instruction (delay slot), and then exit
     is_branch_delay_slot = info.is_branch_instruction;
@@ -996,6 +1447,20 @@ bool CPU::CodeCache::ReadBlockInstructions(u32 start_pc, BlockInstructionList* i
 
   instructions->back().second.is_last_instruction = true;
 
+  if (g_settings.cpu_idle_loop_skipping && IsIdleLoopBlock(start_pc, *instructions))
+  {
+    DEV_LOG("Block 0x{:08X} is an idle loop", start_pc);
+    metadata->flags |= BlockFlags::IsIdleLoop;
+  }
+  else if (!superblock && instructions->size() >= 2 && AreSuperblocksEnabled() && use_icache &&
+           !g_settings.cpu_recompiler_icache && protection != PageProtectionMode::ManualCheck &&
+           (protection != PageProtectionMode::WriteProtected || Bus::GetRAMCodePageIndex(pc) == last_page) &&
+           CanContinueSuperblock(instructions->at(instructions->size() - 2), instructions->back().first))
+  {
+    // Fetch ticks are charged at block entry, so we can only stitch blocks when there's no icache emulation.
+    metadata->flags |= BlockFlags::IsSuperblockCandidate;
+  }
+
 #if defined(_DEBUG) || defined(_DEVEL)
   SmallString disasm;
   u32 disasm_pc = start_pc;
@@ -1014,6 +1479,27 @@ bool CPU::CodeCache::ReadBlockInstructions(u32 start_pc, BlockInstructionList* i
   return true;
 }
 
+bool CPU::CodeCache::AreSuperblocksEnabled()
+{
+#ifdef ENABLE_RECOMPILER
+  return (Recompiler::SUPPORTS_SUPERBLOCKS && g_settings.cpu_recompiler_superblocks && IsUsingRecompiler() &&
+          !g_settings.bios_tty_logging);
+#else
+  return false;
+#endif
+}
+
+bool CPU::CodeCache::CanContinueSuperblock(const BlockInstructionInfoPair& branch, const Instruction delay_slot)
+{
+  // Only the not-taken path of conditional branches can be continued. The delay slot has to be a nop, otherwise
+  // the backend would need to compile it on both paths, and the taken path lives in far code.
+  const Instruction inst = branch.first;
+  return (branch.second.is_direct_branch_instruction && !branch.second.is_unconditional_branch_instruction &&
+          !IsCallInstruction(inst) &&
+          (inst.op != InstructionOp::b || (static_cast<u8>(inst.i.rt.GetValue()) & u8(0x1E)) != u8(0x10)) &&
+          delay_slot.bits == 0);
+}
+
 void CPU::CodeCache::CopyRegInfo(InstructionInfo* dst, const InstructionInfo* src)
 {
   std::memcpy(dst->reg_flags, src->reg_flags, sizeof(dst->reg_flags));
@@ -1288,10 +1774,13 @@ void CPU::CodeCache::CompileOrRevalidateBlock(u32 start_pc)
   MemMap::BeginCodeWrite();
 
   Block* block = LookupBlock(start_pc);
+  bool superblock = false;
   if (block)
   {
     // we should only be here if the block got invalidated
     DebugAssert(block->state != BlockState::Valid);
+    superblock = (block->HasFlag(BlockFlags::IsSuperblock) || block->execution_count >= SUPERBLOCK_EXECUTION_THRESHOLD);
+
     if (RevalidateBlock(block))
     {
       DebugAssert(block->host_code);
@@ -1310,7 +1799,7 @@ void CPU::CodeCache::CompileOrRevalidateBlock(u32 start_pc)
   }
 
   BlockMetadata metadata = {};
-  if (!ReadBlockInstructions(start_pc, &s_block_instructions, &metadata))
+  if (!ReadBlockInstructions(start_pc, &s_block_instructions, &metadata, superblock && AreSuperblocksEnabled()))
   {
     ERROR_LOG("Failed to read block at 0x{:08X}, falling back to uncached interpreter", start_pc);
     SetCodeLUT(start_pc, g_interpret_block);
@@ -1324,9 +1813,11 @@ void CPU::CodeCache::CompileOrRevalidateBlock(u32 start_pc)
   const u32 block_size = static_cast<u32>(s_block_instructions.size());
   const u32 free_code_space = GetFreeCodeSpace();
   const u32 free_far_code_space = GetFreeFarCodeSpace();
+  const u32 far_code_reserve =
+    Recompiler::MIN_CODE_RESERVE_FOR_BLOCK *
+    (((metadata.flags & BlockFlags::IsSuperblock) != BlockFlags::None) ? MAX_SUPERBLOCK_SEGMENTS : 1);
   if (free_code_space < (block_size * Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION) ||
-      free_code_space < Recompiler::MIN_CODE_RESERVE_FOR_BLOCK ||
-      free_far_code_space < Recompiler::MIN_CODE_RESERVE_FOR_BLOCK)
+      free_code_space < Recompiler::MIN_CODE_RESERVE_FOR_BLOCK || free_far_code_space < far_code_reserve)
   {
     ERROR_LOG("Out of code space while compiling {:08X}. Resetting code cache.", start_pc);
     CodeCache::Reset();
@@ -1345,6 +1836,22 @@ void CPU::CodeCache::CompileOrRevalidateBlock(u32 start_pc)
   SetCodeLUT(start_pc, block->host_code);
   BacklinkBlocks(start_pc, block->host_code);
   MemMap::EndCodeWrite();
+
+  RecordBlockDescriptor(block);
+}
+
+void CPU::CodeCache::RecordBlockExecution()
+{
+  Block* block = LookupBlock(g_state.pc);
+  if (!block || block->state != BlockState::Valid || ++block->execution_count < SUPERBLOCK_EXECUTION_THRESHOLD)
+    return;
+
+  // We're still executing the old code, but that's fine, it stays around until the next code buffer reset.
+  DEV_LOG("Block 0x{:08X} is hot, recompiling as superblock", block->pc);
+  MemMap::BeginCodeWrite();
+  RemoveBlockFromPageList(block);
+  InvalidateBlock(block, BlockState::NeedsRecompile);
+  MemMap::EndCodeWrite();
 }
 
 void CPU::CodeCache::DiscardAndRecompileBlock(u32 start_pc)
@@ -1360,6 +1867,217 @@ void CPU::CodeCache::DiscardAndRecompileBlock(u32 start_pc)
   MemMap::EndCodeWrite();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MARK: - Block Analysis Cache
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string CPU::CodeCache::GetBlockAnalysisCachePath(std::string_view serial)
+{
+  return Path::Combine(EmuFolders::Cache, fmt::format("{}.blocks", Path::SanitizeFileName(serial)));
+}
+
+void CPU::CodeCache::GameChanged(std::string_view serial)
+{
+  if (s_block_analysis_cache.serial == serial)
+    return;
+
+  SaveBlockAnalysisCache();
+  s_block_analysis_cache = {};
+  s_block_analysis_cache.serial = serial;
+  LoadBlockAnalysisCache();
+}
+
+void CPU::CodeCache::LoadBlockAnalysisCache()
+{
+  if (s_block_analysis_cache.serial.empty())
+    return;
+
+  const std::string path = GetBlockAnalysisCachePath(s_block_analysis_cache.serial);
+  if (!FileSystem::FileExists(path.c_str()))
+    return;
+
+  Error error;
+  std::optional<DynamicHeapArray<u8>> data = FileSystem::ReadBinaryFile(path.c_str(), &error);
+  if (!data.has_value())
+  {
+    WARNING_LOG("Failed to read block analysis cache: {}", error.GetDescription());
+    return;
+  }
+
+  BinarySpanReader reader(data->cspan());
+  u32 signature, version, count;
+  if (!reader.ReadU32(&signature) || !reader.ReadU32(&version) || !reader.ReadU32(&count) ||
+      signature != BLOCK_ANALYSIS_CACHE_SIGNATURE || version != BLOCK_ANALYSIS_CACHE_VERSION ||
+      count > MAX_BLOCK_ANALYSIS_CACHE_DESCRIPTORS)
+  {
+    WARNING_LOG("Block analysis cache header is corrupted or version mismatch.");
+    return;
+  }
+
+  s_block_analysis_cache.descriptors.reserve(count);
+  s_block_analysis_cache.known_hashes.reserve(count);
+  for (u32 i = 0; i < count; i++)
+  {
+    BlockDescriptor desc;
+    if (!reader.ReadU32(&desc.pc) || !reader.ReadU32(&desc.size) || !reader.ReadU64(&desc.hash))
+    {
+      WARNING_LOG("Block analysis cache is truncated.");
+      s_block_analysis_cache.descriptors.clear();
+      s_block_analysis_cache.known_hashes.clear();
+      return;
+    }
+
+    if (!AddressInRAM(desc.pc) || desc.size == 0 || desc.size > (Bus::RAM_8MB_SIZE / sizeof(Instruction)) ||
+        (VirtualAddressToPhysical(desc.pc) + (desc.size * sizeof(Instruction))) > Bus::RAM_8MB_SIZE ||
+        !s_block_analysis_cache.known_hashes.insert(desc.hash).second)
+    {
+      continue;
+    }
+
+    s_block_analysis_cache.descriptors.push_back(desc);
+  }
+
+  INFO_LOG("Loaded {} block descriptors for {}.", s_block_analysis_cache.descriptors.size(),
+           s_block_analysis_cache.serial);
+  RestartBlockPrecompile();
+}
+
+void CPU::CodeCache::SaveBlockAnalysisCache()
+{
+  if (s_block_analysis_cache.serial.empty() || !s_block_analysis_cache.dirty)
+    return;
+
+  Error error;
+  FileSystem::AtomicRenamedFile file =
+    FileSystem::CreateAtomicRenamedFile(GetBlockAnalysisCachePath(s_block_analysis_cache.serial), &error);
+  if (!file)
+  {
+    ERROR_LOG("Failed to open block analysis cache for writing: {}", error.GetDescription());
+    return;
+  }
+
+  BinaryFileWriter writer(file.get());
+  writer.WriteU32(BLOCK_ANALYSIS_CACHE_SIGNATURE);
+  writer.WriteU32(BLOCK_ANALYSIS_CACHE_VERSION);
+  writer.WriteU32(static_cast<u32>(s_block_analysis_cache.descriptors.size()));
+  for (const BlockDescriptor& desc : s_block_analysis_cache.descriptors)
+  {
+    writer.WriteU32(desc.pc);
+    writer.WriteU32(desc.size);
+    writer.WriteU64(desc.hash);
+  }
+
+  if (!writer.Flush(&error) || !FileSystem::CommitAtomicRenamedFile(file, &error))
+  {
+    ERROR_LOG("Failed to write block analysis cache: {}", error.GetDescription());
+    FileSystem::DiscardAtomicRenamedFile(file);
+    return;
+  }
+
+  DEV_LOG("Saved {} block descriptors for {}.", s_block_analysis_cache.descriptors.size(),
+          s_block_analysis_cache.serial);
+  s_block_analysis_cache.dirty = false;
+}
+
+u64 CPU::CodeCache::GetBlockCodeHash(u32 pc, const void* code, u32 size)
+{
+  return XXH64(code, size * sizeof(Instruction), pc);
+}
+
+void CPU::CodeCache::RecordBlockDescriptor(const Block* block)
+{
+  // BIOS code is the same for every game, and compiles the same way every boot.
+  if (s_block_analysis_cache.serial.empty() || !AddressInRAM(block->pc) ||
+      s_block_analysis_cache.descriptors.size() >= MAX_BLOCK_ANALYSIS_CACHE_DESCRIPTORS)
+  {
+    return;
+  }
+
+  // Superblocks are recorded by their first segment, they get promoted again once they're hot.
+  u32 size = block->size;
+  if (block->HasFlag(BlockFlags::IsSuperblock))
+  {
+    const InstructionInfo* info = block->InstructionsInfo();
+    for (size = 0; size < block->size; size++)
+    {
+      if (info[size].is_branch_instruction)
+      {
+        size += 2;
+        break;
+      }
+    }
+  }
+
+  const u64 hash = GetBlockCodeHash(block->pc, block->Instructions(), size);
+  if (!s_block_analysis_cache.known_hashes.insert(hash).second)
+    return;
+
+  s_block_analysis_cache.descriptors.push_back(BlockDescriptor{block->pc, size, hash});
+  s_block_analysis_cache.dirty = true;
+}
+
+void CPU::CodeCache::RestartBlockPrecompile()
+{
+  s_block_analysis_cache.precompile_cursor = 0;
+  s_block_analysis_cache.precompile_delay = 0;
+  s_block_analysis_cache.precompile_found_any = false;
+}
+
+void CPU::CodeCache::PrecompileCachedBlocks()
+{
+  BlockAnalysisCache& bac = s_block_analysis_cache;
+  if (bac.descriptors.empty() || !IsUsingRecompiler())
+    return;
+
+  if (bac.precompile_delay > 0)
+  {
+    bac.precompile_delay--;
+    return;
+  }
+
+  // Don't let precompiling fill the code buffer, a reset from here would throw away what the game actually needs.
+  const u32 min_free_code_space = s_code_size / 4;
+  const u32 min_free_far_code_space = s_far_code_size / 4;
+
+  u32 checks_remaining = PRECOMPILE_CHECKS_PER_FRAME;
+  u32 compiles_remaining = PRECOMPILE_BLOCKS_PER_FRAME;
+  for (; bac.precompile_cursor < bac.descriptors.size() && checks_remaining > 0 && compiles_remaining > 0;
+       bac.precompile_cursor++, checks_remaining--)
+  {
+    const BlockDescriptor& desc = bac.descriptors[bac.precompile_cursor];
+    const PhysicalMemoryAddress phys_addr = VirtualAddressToPhysical(desc.pc);
+    if ((phys_addr + (desc.size * sizeof(Instruction))) > Bus::g_ram_size)
+      continue;
+
+    const Block* block = LookupBlock(desc.pc);
+    if ((block && block->state == BlockState::Valid) ||
+        GetBlockCodeHash(desc.pc, Bus::g_ram + phys_addr, desc.size) != desc.hash)
+    {
+      continue;
+    }
+
+    if (GetFreeCodeSpace() < min_free_code_space || GetFreeFarCodeSpace() < min_free_far_code_space)
+    {
+      DEV_LOG("Stopping block precompile, code buffer is getting full.");
+      bac.precompile_cursor = static_cast<u32>(bac.descriptors.size());
+      return;
+    }
+
+    DEBUG_LOG("Precompiling block 0x{:08X}", desc.pc);
+    CompileOrRevalidateBlock(desc.pc);
+    bac.precompile_found_any = true;
+    compiles_remaining--;
+  }
+
+  if (bac.precompile_cursor == bac.descriptors.size())
+  {
+    bac.precompile_cursor = 0;
+    if (!bac.precompile_found_any)
+      bac.precompile_delay = PRECOMPILE_RETRY_DELAY_FRAMES;
+    bac.precompile_found_any = false;
+  }
+}
+
 const void* CPU::CodeCache::CreateBlockLink(Block* block, void* code, u32 newpc)
 {
   // self-linking should be handled by the caller
@@ -1526,16 +2244,25 @@ void CPU::CodeCache::AlignCode(u32 alignment)
 
 const void* CPU::CodeCache::GetInterpretUncachedBlockFunction()
 {
+  // The code cache is reset when tracing starts or stops, so this is re-queried.
+  const bool trace = Trace::IsActive();
   if (g_settings.gpu_pgxp_enable)
   {
     if (g_settings.gpu_pgxp_cpu)
-      return reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::CPU>);
+    {
+      return trace ? reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::CPU, true>) :
+                     reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::CPU, false>);
+    }
     else
-      return reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::Memory>);
+    {
+      return trace ? reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::Memory, true>) :
+                     reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::Memory, false>);
+    }
   }
   else
   {
-    return reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::Disabled>);
+    return trace ? reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::Disabled, true>) :
+                   reinterpret_cast<const void*>(InterpretUncachedBlock<PGXPMode::Disabled, false>);
   }
 }
 
@@ -1676,8 +2403,13 @@ PageFaultHandler::HandlerResult CPU::CodeCache::HandleFastmemException(void* exc
         AddressInRAM(guest_address))
     {
       DebugAssert(is_write);
-      DEV_LOG("Ignoring fault due to RAM write @ 0x{:08X}", guest_address);
-      InvalidateBlocksWithPageIndex(Bus::GetRAMCodePageIndex(guest_address));
+      const u32 page_index = Bus::GetRAMCodePageIndex(guest_address);
+      Bus::SetRAMPageDirty(page_index);
+      if (Bus::IsRAMCodePage(page_index) || !Bus::IsTrackingRAMDirtyPages())
+      {
+        DEV_LOG("Ignoring fault due to RAM write @ 0x{:08X}", guest_address);
+        InvalidateBlocksWithPageIndex(page_index);
+      }
       return PageFaultHandler::HandlerResult::ContinueExecution;
     }
   }
@@ -6,6 +6,8 @@
 #include "bus.h"
 #include "cpu_types.h"
 
+#include <string_view>
+
 class Error;
 
 namespace CPU::CodeCache {
@@ -37,4 +39,19 @@ void InvalidateBlocksWithPageIndex(u32 page_index);
 /// Invalidates all blocks in the cache.
 void InvalidateAllRAMBlocks();
 
+/// Invalidates blocks in a RAM page whose contents were replaced by a state load.
+void InvalidateRestoredRAMPage(u32 page_index);
+
+/// Saves the contents of code pages before RAM is replaced by a state load.
+void BeginRAMRestore();
+
+/// Invalidates blocks in code pages which were changed by the state load since BeginRAMRestore().
+void EndRAMRestore();
+
+/// Saves the block analysis cache for the previous game, and loads it for the new game.
+void GameChanged(std::string_view serial);
+
+/// Compiles a few blocks recorded in previous sessions whose code is now present in RAM. Call once per frame.
+void PrecompileCachedBlocks();
+
 } // namespace CPU::CodeCache
@@ -21,7 +21,9 @@ enum : u32
   LUT_TABLE_SIZE = 0x10000 / sizeof(u32), // 16384, one for each PC
   LUT_TABLE_SHIFT = 16,
 
-  MAX_BLOCK_EXIT_LINKS = 2,
+  // Superblocks have a taken exit for each segment, plus both exits of the final branch.
+  MAX_SUPERBLOCK_SEGMENTS = 4,
+  MAX_BLOCK_EXIT_LINKS = MAX_SUPERBLOCK_SEGMENTS + 1,
 };
 
 using CodeLUT = const void**;
@@ -89,6 +91,9 @@ enum class BlockFlags : u8
   BranchDelaySpansPages = (1 << 2),
   IsUsingICache = (1 << 3),
   NeedsDynamicFetchTicks = (1 << 4),
+  IsIdleLoop = (1 << 5),
+  IsSuperblockCandidate = (1 << 6),
+  IsSuperblock = (1 << 7),
 };
 IMPLEMENT_ENUM_CLASS_BITWISE_OPERATORS(BlockFlags);
 
@@ -128,6 +133,7 @@ struct alignas(16) Block
 
   u32 host_code_size;
   u32 compile_frame;
+  u32 execution_count;
   u8 compile_count;
 
   // followed by Instruction * size, InstructionRegInfo * size
@@ -205,14 +211,23 @@ struct PageProtectionInfo
 };
 static_assert(sizeof(PageProtectionInfo) == (sizeof(Block*) * 2 + 8));
 
-template<PGXPMode pgxp_mode>
+template<PGXPMode pgxp_mode, bool trace>
 void InterpretCachedBlock(const Block* block);
 
-template<PGXPMode pgxp_mode>
+template<PGXPMode pgxp_mode, bool trace>
 void InterpretUncachedBlock();
 
 void LogCurrentState();
 
+/// Skips the remaining iterations of an idle loop up to the next timing event, if it is provably not making progress.
+void TrySkipIdleLoop(const Block* block);
+
+/// Same as above, but looks the block up from the current PC. Called from recompiled block prologues.
+void TrySkipIdleLoopAtPC();
+
+/// Counts executions of superblock candidates, and queues them for recompilation once they're hot.
+void RecordBlockExecution();
+
 #if defined(_DEBUG) || defined(_DEVEL) || false
 // Enable disassembly of host assembly code.
 #define ENABLE_HOST_DISASSEMBLY 1
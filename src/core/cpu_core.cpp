@@ -7,6 +7,7 @@
 #include "cpu_core_private.h"
 #include "cpu_disasm.h"
 #include "cpu_pgxp.h"
+#include "cpu_trace.h"
 #include "gte.h"
 #include "host.h"
 #include "pcdrv.h"
@@ -2059,7 +2060,8 @@ bool CPU::UpdateDebugDispatcherFlag()
 
   const bool use_debug_dispatcher =
     has_any_breakpoints || has_cop0_breakpoints || s_trace_to_log ||
-    (g_settings.cpu_execution_mode == CPUExecutionMode::Interpreter && g_settings.bios_tty_logging);
+    (g_settings.cpu_execution_mode == CPUExecutionMode::Interpreter &&
+     (g_settings.bios_tty_logging || Trace::IsActive()));
   if (use_debug_dispatcher == g_state.using_debug_dispatcher)
     return false;
 
@@ -2475,6 +2477,8 @@ template<PGXPMode pgxp_mode, bool debug>
       {
         if (s_trace_to_log)
           LogInstruction(g_state.current_instruction.bits, g_state.current_instruction_pc, true);
+        if (Trace::IsActive())
+          Trace::RecordInstruction();
 
         // handle all mirrors of the syscall trampoline
         const u32 masked_pc = (g_state.current_instruction_pc & PHYSICAL_MEMORY_ADDRESS_MASK);
@@ -2573,7 +2577,7 @@ void CPU::SetSingleStepFlag()
     System::InterruptExecution();
 }
 
-template<PGXPMode pgxp_mode>
+template<PGXPMode pgxp_mode, bool trace>
 void CPU::CodeCache::InterpretCachedBlock(const Block* block)
 {
   // set up the state so we've already fetched the instruction
@@ -2600,6 +2604,9 @@ void CPU::CodeCache::InterpretCachedBlock(const Block* block)
     g_state.pc = g_state.npc;
     g_state.npc += 4;
 
+    if constexpr (trace)
+      Trace::RecordInstruction();
+
     // execute the instruction we previously fetched
     ExecuteInstruction<pgxp_mode, false>();
 
@@ -2617,11 +2624,14 @@ void CPU::CodeCache::InterpretCachedBlock(const Block* block)
   g_state.next_instruction_is_branch_delay_slot = false;
 }
 
-template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::Disabled>(const Block* block);
-template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::Memory>(const Block* block);
-template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::CPU>(const Block* block);
+template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::Disabled, false>(const Block* block);
+template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::Memory, false>(const Block* block);
+template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::CPU, false>(const Block* block);
+template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::Disabled, true>(const Block* block);
+template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::Memory, true>(const Block* block);
+template void CPU::CodeCache::InterpretCachedBlock<PGXPMode::CPU, true>(const Block* block);
 
-template<PGXPMode pgxp_mode>
+template<PGXPMode pgxp_mode, bool trace>
 void CPU::CodeCache::InterpretUncachedBlock()
 {
   g_state.npc = g_state.pc;
@@ -2656,6 +2666,9 @@ void CPU::CodeCache::InterpretUncachedBlock()
       g_state.pc = g_state.npc;
     }
 
+    if constexpr (trace)
+      Trace::RecordInstruction();
+
     // execute the instruction we previously fetched
     ExecuteInstruction<pgxp_mode, false>();
 
@@ -2678,9 +2691,12 @@ void CPU::CodeCache::InterpretUncachedBlock()
   }
 }
 
-template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::Disabled>();
-template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::Memory>();
-template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::CPU>();
+template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::Disabled, false>();
+template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::Memory, false>();
+template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::CPU, false>();
+template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::Disabled, true>();
+template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::Memory, true>();
+template void CPU::CodeCache::InterpretUncachedBlock<PGXPMode::CPU, true>();
 
 bool CPU::RecompilerThunks::InterpretInstruction()
 {
@@ -3080,6 +3096,7 @@ ALWAYS_INLINE bool CPU::DoSafeMemoryAccess(VirtualMemoryAddress address, u32& va
         if (g_unprotected_ram[offset] != Truncate8(value))
         {
           g_unprotected_ram[offset] = Truncate8(value);
+          Bus::SetRAMPageDirty(page_index);
           if (g_ram_code_bits[page_index])
             CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
         }
@@ -3092,6 +3109,7 @@ ALWAYS_INLINE bool CPU::DoSafeMemoryAccess(VirtualMemoryAddress address, u32& va
         if (old_value != new_value)
         {
           std::memcpy(&g_unprotected_ram[offset], &new_value, sizeof(u16));
+          Bus::SetRAMPageDirty(page_index);
           if (g_ram_code_bits[page_index])
             CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
         }
@@ -3103,6 +3121,7 @@ ALWAYS_INLINE bool CPU::DoSafeMemoryAccess(VirtualMemoryAddress address, u32& va
         if (old_value != value)
         {
           std::memcpy(&g_unprotected_ram[offset], &value, sizeof(u32));
+          Bus::SetRAMPageDirty(page_index);
           if (g_ram_code_bits[page_index])
             CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
         }
@@ -42,7 +42,8 @@ struct GTEInstructionTable
 } // namespace
 
 static void FormatInstruction(SmallStringBase* dest, const Instruction inst, u32 pc, const char* format);
-static void FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, const char* format);
+static void FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, const char* format,
+                          const DisassemblyValues& values);
 
 template<typename T>
 static void FormatCopInstruction(SmallStringBase* dest, u32 pc, const Instruction inst,
@@ -50,7 +51,8 @@ static void FormatCopInstruction(SmallStringBase* dest, u32 pc, const Instructio
 
 template<typename T>
 static void FormatCopComment(SmallStringBase* dest, u32 pc, const Instruction inst,
-                             const std::pair<T, const char*>* table, size_t table_size, T table_key);
+                             const std::pair<T, const char*>* table, size_t table_size, T table_key,
+                             const DisassemblyValues& values);
 
 static void FormatGTEInstruction(SmallStringBase* dest, u32 pc, const Instruction inst);
 
@@ -386,9 +388,11 @@ void CPU::FormatInstruction(SmallStringBase* dest, const Instruction inst, u32 p
   }
 }
 
-void CPU::FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, const char* format)
+void CPU::FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, const char* format,
+                        const DisassemblyValues& values)
 {
-  const CPU::Registers* regs = &CPU::g_state.regs;
+  const CPU::Registers* regs = values.regs;
+  const GTE::Regs* gte_regs = values.gte_regs;
 
   const char* str = format;
   while (*str != '\0')
@@ -447,20 +451,29 @@ void CPU::FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, c
       if (inst.op == InstructionOp::lb || inst.op == InstructionOp::lbu)
       {
         u8 data = 0;
-        CPU::SafeReadMemoryByte(address, &data);
+        if (values.load_value)
+          data = Truncate8(*values.load_value);
+        else
+          CPU::SafeReadMemoryByte(address, &data);
         dest->append_format("addr=0x{:08x}[0x{:02x}]", address, data);
       }
       else if (inst.op == InstructionOp::lh || inst.op == InstructionOp::lhu)
       {
         u16 data = 0;
-        CPU::SafeReadMemoryHalfWord(address, &data);
+        if (values.load_value)
+          data = Truncate16(*values.load_value);
+        else
+          CPU::SafeReadMemoryHalfWord(address, &data);
         dest->append_format("addr=0x{:08x}[0x{:04x}]", address, data);
       }
       else if (inst.op == InstructionOp::lw || (inst.op >= InstructionOp::lwc0 && inst.op <= InstructionOp::lwc3) ||
                inst.op == InstructionOp::lwl || inst.op == InstructionOp::lwr)
       {
         u32 data = 0;
-        CPU::SafeReadMemoryWord(address, &data);
+        if (values.load_value)
+          data = *values.load_value;
+        else
+          CPU::SafeReadMemoryWord(address, &data);
         dest->append_format("addr=0x{:08x}[0x{:08x}]", address, data);
       }
       else
@@ -484,7 +497,7 @@ void CPU::FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, c
       {
         dest->append_format("{}{}=0x{:08x}", dest->empty() ? "" : ", ",
                             GetGTERegisterName(static_cast<u8>(inst.r.rd.GetValue()) + 32),
-                            g_state.gte_regs.cr32[static_cast<u8>(inst.r.rd.GetValue())]);
+                            gte_regs->cr32[static_cast<u8>(inst.r.rd.GetValue())]);
       }
       str += 6;
     }
@@ -494,7 +507,7 @@ void CPU::FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, c
       {
         dest->append_format("{}{}=0x{:08x}", dest->empty() ? "" : ", ",
                             GetGTERegisterName(static_cast<u8>(inst.r.rd.GetValue())),
-                            g_state.gte_regs.dr32[static_cast<u8>(inst.r.rd.GetValue())]);
+                            gte_regs->dr32[static_cast<u8>(inst.r.rd.GetValue())]);
       }
 
       str += 5;
@@ -505,7 +518,7 @@ void CPU::FormatComment(SmallStringBase* dest, const Instruction inst, u32 pc, c
       {
         dest->append_format("{}{}=0x{:08x}", dest->empty() ? "" : ", ",
                             GetGTERegisterName(static_cast<u8>(inst.r.rt.GetValue())),
-                            g_state.gte_regs.dr32[static_cast<u8>(inst.r.rt.GetValue())]);
+                            gte_regs->dr32[static_cast<u8>(inst.r.rt.GetValue())]);
       }
 
       str += 5;
@@ -539,13 +552,14 @@ void CPU::FormatCopInstruction(SmallStringBase* dest, u32 pc, const Instruction
 
 template<typename T>
 void CPU::FormatCopComment(SmallStringBase* dest, u32 pc, const Instruction inst,
-                           const std::pair<T, const char*>* table, size_t table_size, T table_key)
+                           const std::pair<T, const char*>* table, size_t table_size, T table_key,
+                           const DisassemblyValues& values)
 {
   for (size_t i = 0; i < table_size; i++)
   {
     if (table[i].first == table_key)
     {
-      FormatComment(dest, inst, pc, table[i].second);
+      FormatComment(dest, inst, pc, table[i].second, values);
       return;
     }
   }
@@ -636,12 +650,17 @@ void CPU::DisassembleInstruction(SmallStringBase* dest, u32 pc, u32 bits)
 }
 
 void CPU::DisassembleInstructionComment(SmallStringBase* dest, u32 pc, u32 bits)
+{
+  DisassembleInstructionComment(dest, pc, bits, DisassemblyValues{&g_state.regs, &g_state.gte_regs, nullptr});
+}
+
+void CPU::DisassembleInstructionComment(SmallStringBase* dest, u32 pc, u32 bits, const DisassemblyValues& values)
 {
   const Instruction inst{bits};
   switch (inst.op)
   {
     case InstructionOp::funct:
-      FormatComment(dest, inst, pc, s_special_table[static_cast<u8>(inst.r.funct.GetValue())]);
+      FormatComment(dest, inst, pc, s_special_table[static_cast<u8>(inst.r.funct.GetValue())], values);
       return;
 
     case InstructionOp::cop0:
@@ -651,7 +670,8 @@ void CPU::DisassembleInstructionComment(SmallStringBase* dest, u32 pc, u32 bits)
     {
       if (inst.cop.IsCommonInstruction())
       {
-        FormatCopComment(dest, pc, inst, s_cop_common_table.data(), s_cop_common_table.size(), inst.cop.CommonOp());
+        FormatCopComment(dest, pc, inst, s_cop_common_table.data(), s_cop_common_table.size(), inst.cop.CommonOp(),
+                         values);
       }
       else
       {
@@ -659,7 +679,7 @@ void CPU::DisassembleInstructionComment(SmallStringBase* dest, u32 pc, u32 bits)
         {
           case InstructionOp::cop0:
           {
-            FormatCopComment(dest, pc, inst, s_cop0_table.data(), s_cop0_table.size(), inst.cop.Cop0Op());
+            FormatCopComment(dest, pc, inst, s_cop0_table.data(), s_cop0_table.size(), inst.cop.Cop0Op(), values);
           }
           break;
 
@@ -686,14 +706,14 @@ void CPU::DisassembleInstructionComment(SmallStringBase* dest, u32 pc, u32 bits)
       const bool bgez = ConvertToBoolUnchecked(rt & u8(1));
       const bool link = ConvertToBoolUnchecked((rt >> 4) & u8(1));
       if (link)
-        FormatComment(dest, inst, pc, bgez ? "bgezal $rs, $rel" : "bltzal $rs, $rel");
+        FormatComment(dest, inst, pc, bgez ? "bgezal $rs, $rel" : "bltzal $rs, $rel", values);
       else
-        FormatComment(dest, inst, pc, bgez ? "bgez $rs, $rel" : "bltz $rs, $rel");
+        FormatComment(dest, inst, pc, bgez ? "bgez $rs, $rel" : "bltz $rs, $rel", values);
     }
     break;
 
     default:
-      FormatComment(dest, inst, pc, s_base_table[static_cast<u8>(inst.op.GetValue())]);
+      FormatComment(dest, inst, pc, s_base_table[static_cast<u8>(inst.op.GetValue())], values);
       break;
   }
 }
@@ -6,10 +6,25 @@
 
 class SmallStringBase;
 
+namespace GTE {
+union Regs;
+}
+
 namespace CPU {
 
+/// Values shown in instruction comments, so that comments can be rendered for state other than the current CPU state.
+struct DisassemblyValues
+{
+  const Registers* regs;
+  const GTE::Regs* gte_regs;
+
+  /// Value at the address of load instructions, or nullptr to read it from memory.
+  const u32* load_value;
+};
+
 void DisassembleInstruction(SmallStringBase* dest, u32 pc, u32 bits);
 void DisassembleInstructionComment(SmallStringBase* dest, u32 pc, u32 bits);
+void DisassembleInstructionComment(SmallStringBase* dest, u32 pc, u32 bits, const DisassemblyValues& values);
 
 const char* GetGTERegisterName(u32 index);
 
@@ -16,7 +16,9 @@
 
 #include "common/assert.h"
 #include "common/log.h"
+#include "common/memmap.h"
 
+#include <bitset>
 #include <climits>
 #include <cmath>
 
@@ -80,7 +82,69 @@ static PGXPValue& GetSXY1();
 static PGXPValue& GetSXY2();
 static PGXPValue& PushSXY();
 
+namespace {
+
+/// Shadow memory which is reserved up front, and committed in chunks on first write. Chunks which have never been
+/// written read as zero, so only the parts of memory which the game actually uses take up space.
+template<u32 num_values>
+class SparseValueArray
+{
+public:
+  static constexpr u32 CHUNK_SHIFT = 12;
+  static constexpr u32 CHUNK_VALUES = 1u << CHUNK_SHIFT;
+  static constexpr u32 NUM_CHUNKS = (num_values + CHUNK_VALUES - 1) / CHUNK_VALUES;
+  static constexpr size_t CHUNK_SIZE = CHUNK_VALUES * sizeof(PGXPValue);
+  static constexpr size_t RESERVE_SIZE = NUM_CHUNKS * CHUNK_SIZE;
+
+  ALWAYS_INLINE bool IsAllocated() const { return (m_base != nullptr); }
+  ALWAYS_INLINE bool IsChunkCommitted(u32 chunk) const { return m_committed[chunk]; }
+  ALWAYS_INLINE PGXPValue* GetChunkPointer(u32 chunk) const { return m_base + (chunk << CHUNK_SHIFT); }
+  ALWAYS_INLINE u32 GetChunkIndex(const PGXPValue* ptr) const
+  {
+    return static_cast<u32>(ptr - m_base) >> CHUNK_SHIFT;
+  }
+
+  /// Returns nullptr if the chunk has never been written.
+  ALWAYS_INLINE PGXPValue* LookupForRead(u32 index) const
+  {
+    return m_committed[index >> CHUNK_SHIFT] ? &m_base[index] : nullptr;
+  }
+
+  ALWAYS_INLINE PGXPValue* LookupForWrite(u32 index)
+  {
+    const u32 chunk = index >> CHUNK_SHIFT;
+    if (!m_committed[chunk]) [[unlikely]]
+      CommitChunk(chunk);
+
+    return &m_base[index];
+  }
+
+  bool Allocate();
+  void Release();
+  void CommitChunk(u32 chunk);
+  void DecommitChunk(u32 chunk);
+  void DecommitAll();
+
+private:
+  PGXPValue* m_base = nullptr;
+
+  // Chunks can only be committed individually when they are a multiple of the host page size. Otherwise, everything
+  // is committed up front, and decommitting clears the chunk instead.
+  bool m_sparse = false;
+
+  std::bitset<NUM_CHUNKS> m_committed;
+};
+
+} // namespace
+
+using MemArray = SparseValueArray<PGXP_MEM_SIZE>;
+using VertexCacheArray = SparseValueArray<VERTEX_CACHE_SIZE>;
+
 static PGXPValue* GetPtr(u32 addr);
+static PGXPValue* GetWritePtr(u32 addr);
+static void SetMemChunkDirty(const PGXPValue* ptr);
+static void UpdateMemChunkGenerations();
+static void ResetMemChunkGenerations();
 static const PGXPValue& ValidateAndLoadMem(u32 addr, u32 value);
 static void ValidateAndLoadMem16(PGXPValue& dest, u32 addr, u32 value, bool sign);
 
@@ -119,8 +183,17 @@ static void LogValueStr(SmallStringBase& str, const char* name, u32 rval, const
 
 static constexpr const PGXPValue INVALID_VALUE = {};
 
-static PGXPValue* s_mem = nullptr;
-static PGXPValue* s_vertex_cache = nullptr;
+static MemArray s_mem;
+static VertexCacheArray s_vertex_cache;
+
+// Chunks written since the last memory save state, and the generation of their contents. Generation zero means the
+// chunk has never been written, and is not committed.
+static std::bitset<MemArray::NUM_CHUNKS> s_mem_dirty_chunks;
+static std::array<u32, MemArray::NUM_CHUNKS> s_mem_chunk_generations = {};
+static u32 s_mem_generation = 0;
+
+// Buffer holding the contents of each chunk at its current generation, if it has been saved to a memory state.
+static std::array<std::shared_ptr<const PGXPValue[]>, MemArray::NUM_CHUNKS> s_mem_chunk_snapshots;
 
 #ifdef LOG_VALUES
 static std::FILE* s_log;
@@ -133,25 +206,17 @@ void CPU::PGXP::Initialize()
   std::memset(g_state.pgxp_cop0, 0, sizeof(g_state.pgxp_cop0));
   std::memset(g_state.pgxp_gte, 0, sizeof(g_state.pgxp_gte));
 
-  if (!s_mem)
-  {
-    s_mem = static_cast<PGXPValue*>(std::calloc(PGXP_MEM_SIZE, sizeof(PGXPValue)));
-    if (!s_mem)
-      Panic("Failed to allocate PGXP memory");
-  }
+  if (!s_mem.IsAllocated() && !s_mem.Allocate())
+    Panic("Failed to allocate PGXP memory");
 
-  if (g_settings.gpu_pgxp_vertex_cache && !s_vertex_cache)
+  if (g_settings.gpu_pgxp_vertex_cache && !s_vertex_cache.IsAllocated() && !s_vertex_cache.Allocate())
   {
-    s_vertex_cache = static_cast<PGXPValue*>(std::calloc(VERTEX_CACHE_SIZE, sizeof(PGXPValue)));
-    if (!s_vertex_cache)
-    {
-      ERROR_LOG("Failed to allocate memory for vertex cache, disabling.");
-      g_settings.gpu_pgxp_vertex_cache = false;
-    }
+    ERROR_LOG("Failed to allocate memory for vertex cache, disabling.");
+    g_settings.gpu_pgxp_vertex_cache = false;
   }
 
-  if (s_vertex_cache)
-    std::memset(s_vertex_cache, 0, sizeof(PGXPValue) * VERTEX_CACHE_SIZE);
+  if (s_vertex_cache.IsAllocated())
+    s_vertex_cache.DecommitAll();
 }
 
 void CPU::PGXP::Reset()
@@ -160,29 +225,185 @@ void CPU::PGXP::Reset()
   std::memset(g_state.pgxp_cop0, 0, sizeof(g_state.pgxp_cop0));
   std::memset(g_state.pgxp_gte, 0, sizeof(g_state.pgxp_gte));
 
-  if (s_mem)
-    std::memset(s_mem, 0, sizeof(PGXPValue) * PGXP_MEM_SIZE);
+  // Only the chunks which have been written need to be cleared.
+  if (s_mem.IsAllocated())
+    s_mem.DecommitAll();
+  ResetMemChunkGenerations();
 
-  if (g_settings.gpu_pgxp_vertex_cache && s_vertex_cache)
-    std::memset(s_vertex_cache, 0, sizeof(PGXPValue) * VERTEX_CACHE_SIZE);
+  if (g_settings.gpu_pgxp_vertex_cache && s_vertex_cache.IsAllocated())
+    s_vertex_cache.DecommitAll();
 }
 
 void CPU::PGXP::Shutdown()
 {
-  if (s_vertex_cache)
+  s_vertex_cache.Release();
+  s_mem.Release();
+  ResetMemChunkGenerations();
+
+  std::memset(g_state.pgxp_gte, 0, sizeof(g_state.pgxp_gte));
+  std::memset(g_state.pgxp_gpr, 0, sizeof(g_state.pgxp_gpr));
+  std::memset(g_state.pgxp_cop0, 0, sizeof(g_state.pgxp_cop0));
+}
+
+template<u32 num_values>
+bool CPU::PGXP::SparseValueArray<num_values>::Allocate()
+{
+  m_base = static_cast<PGXPValue*>(MemMap::ReserveMemory(RESERVE_SIZE));
+  if (!m_base)
+    return false;
+
+  m_sparse = ((CHUNK_SIZE % HOST_PAGE_SIZE) == 0);
+  if (!m_sparse && !MemMap::CommitMemory(m_base, RESERVE_SIZE))
   {
-    std::free(s_vertex_cache);
-    s_vertex_cache = nullptr;
+    MemMap::ReleaseMemory(m_base, RESERVE_SIZE);
+    m_base = nullptr;
+    return false;
   }
-  if (s_mem)
+
+  m_committed.reset();
+  return true;
+}
+
+template<u32 num_values>
+void CPU::PGXP::SparseValueArray<num_values>::Release()
+{
+  if (!m_base)
+    return;
+
+  MemMap::ReleaseMemory(m_base, RESERVE_SIZE);
+  m_base = nullptr;
+  m_committed.reset();
+}
+
+template<u32 num_values>
+void CPU::PGXP::SparseValueArray<num_values>::CommitChunk(u32 chunk)
+{
+  DebugAssert(!m_committed[chunk]);
+  if (m_sparse && !MemMap::CommitMemory(GetChunkPointer(chunk), CHUNK_SIZE))
+    Panic("Failed to commit PGXP memory");
+
+  m_committed[chunk] = true;
+}
+
+template<u32 num_values>
+void CPU::PGXP::SparseValueArray<num_values>::DecommitChunk(u32 chunk)
+{
+  if (!m_committed[chunk])
+    return;
+
+  if (m_sparse)
+    MemMap::DecommitMemory(GetChunkPointer(chunk), CHUNK_SIZE);
+  else
+    std::memset(GetChunkPointer(chunk), 0, CHUNK_SIZE);
+
+  m_committed[chunk] = false;
+}
+
+template<u32 num_values>
+void CPU::PGXP::SparseValueArray<num_values>::DecommitAll()
+{
+  if (m_committed.none())
+    return;
+
+  for (u32 i = 0; i < NUM_CHUNKS; i++)
+    DecommitChunk(i);
+}
+
+void CPU::PGXP::SetMemChunkDirty(const PGXPValue* ptr)
+{
+  s_mem_dirty_chunks[s_mem.GetChunkIndex(ptr)] = true;
+}
+
+void CPU::PGXP::UpdateMemChunkGenerations()
+{
+  if (s_mem_dirty_chunks.none())
+    return;
+
+  s_mem_generation++;
+  for (u32 i = 0; i < MemArray::NUM_CHUNKS; i++)
   {
-    std::free(s_mem);
-    s_mem = nullptr;
+    if (s_mem_dirty_chunks[i])
+    {
+      s_mem_chunk_generations[i] = s_mem_generation;
+      s_mem_chunk_snapshots[i].reset();
+    }
   }
 
-  std::memset(g_state.pgxp_gte, 0, sizeof(g_state.pgxp_gte));
-  std::memset(g_state.pgxp_gpr, 0, sizeof(g_state.pgxp_gpr));
-  std::memset(g_state.pgxp_cop0, 0, sizeof(g_state.pgxp_cop0));
+  s_mem_dirty_chunks.reset();
+}
+
+void CPU::PGXP::ResetMemChunkGenerations()
+{
+  s_mem_dirty_chunks.reset();
+  s_mem_chunk_generations.fill(0);
+  s_mem_chunk_snapshots.fill({});
+}
+
+void CPU::PGXP::DoMemoryState(MemoryStateData& data, bool reading)
+{
+  if (reading)
+  {
+    std::memcpy(g_state.pgxp_gpr, data.gpr, sizeof(g_state.pgxp_gpr));
+    std::memcpy(g_state.pgxp_cop0, data.cop0, sizeof(g_state.pgxp_cop0));
+    std::memcpy(g_state.pgxp_gte, data.gte, sizeof(g_state.pgxp_gte));
+  }
+  else
+  {
+    std::memcpy(data.gpr, g_state.pgxp_gpr, sizeof(g_state.pgxp_gpr));
+    std::memcpy(data.cop0, g_state.pgxp_cop0, sizeof(g_state.pgxp_cop0));
+    std::memcpy(data.gte, g_state.pgxp_gte, sizeof(g_state.pgxp_gte));
+  }
+
+  // States which were saved with PGXP disabled have no chunks, i.e. empty memory.
+  if (data.chunk_generations.size() != MemArray::NUM_CHUNKS)
+  {
+    data.chunks.resize(MemArray::NUM_CHUNKS);
+    data.chunk_generations.resize(MemArray::NUM_CHUNKS);
+    std::fill(data.chunk_generations.begin(), data.chunk_generations.end(), 0u);
+  }
+
+  UpdateMemChunkGenerations();
+
+  for (u32 i = 0; i < MemArray::NUM_CHUNKS; i++)
+  {
+    if (data.chunk_generations[i] == s_mem_chunk_generations[i])
+      continue;
+
+    if (reading)
+    {
+      if (data.chunk_generations[i] == 0)
+      {
+        s_mem.DecommitChunk(i);
+      }
+      else
+      {
+        if (!s_mem.IsChunkCommitted(i))
+          s_mem.CommitChunk(i);
+        std::memcpy(s_mem.GetChunkPointer(i), data.chunks[i].get(), MemArray::CHUNK_SIZE);
+      }
+
+      s_mem_chunk_generations[i] = data.chunk_generations[i];
+      s_mem_chunk_snapshots[i] = data.chunks[i];
+    }
+    else
+    {
+      if (s_mem_chunk_generations[i] != 0 && !s_mem_chunk_snapshots[i])
+      {
+        std::shared_ptr<PGXPValue[]> snapshot(new PGXPValue[MemArray::CHUNK_VALUES]);
+        std::memcpy(snapshot.get(), s_mem.GetChunkPointer(i), MemArray::CHUNK_SIZE);
+        s_mem_chunk_snapshots[i] = std::move(snapshot);
+      }
+
+      data.chunks[i] = s_mem_chunk_snapshots[i];
+      data.chunk_generations[i] = s_mem_chunk_generations[i];
+    }
+  }
+}
+
+void CPU::PGXP::FreeMemoryState(MemoryStateData& data)
+{
+  data.chunks = {};
+  data.chunk_generations = {};
 }
 
 ALWAYS_INLINE_RELEASE double CPU::PGXP::f16Sign(double val)
@@ -268,22 +489,48 @@ ALWAYS_INLINE_RELEASE CPU::PGXPValue* CPU::PGXP::GetPtr(u32 addr)
 #endif
 
   if ((addr & SCRATCHPAD_ADDR_MASK) == SCRATCHPAD_ADDR)
-    return &s_mem[PGXP_MEM_SCRATCH_OFFSET + ((addr & SCRATCHPAD_OFFSET_MASK) >> 2)];
+    return s_mem.LookupForRead(PGXP_MEM_SCRATCH_OFFSET + ((addr & SCRATCHPAD_OFFSET_MASK) >> 2));
 
   const u32 paddr = (addr & PHYSICAL_MEMORY_ADDRESS_MASK);
   if (paddr < Bus::RAM_MIRROR_END)
-    return &s_mem[(paddr & Bus::g_ram_mask) >> 2];
+    return s_mem.LookupForRead((paddr & Bus::g_ram_mask) >> 2);
   else
     return nullptr;
 }
 
+ALWAYS_INLINE_RELEASE CPU::PGXPValue* CPU::PGXP::GetWritePtr(u32 addr)
+{
+  u32 index;
+  if ((addr & SCRATCHPAD_ADDR_MASK) == SCRATCHPAD_ADDR)
+  {
+    index = PGXP_MEM_SCRATCH_OFFSET + ((addr & SCRATCHPAD_OFFSET_MASK) >> 2);
+  }
+  else
+  {
+    const u32 paddr = (addr & PHYSICAL_MEMORY_ADDRESS_MASK);
+    if (paddr >= Bus::RAM_MIRROR_END)
+      return nullptr;
+
+    index = (paddr & Bus::g_ram_mask) >> 2;
+  }
+
+  s_mem_dirty_chunks[index >> MemArray::CHUNK_SHIFT] = true;
+  return s_mem.LookupForWrite(index);
+}
+
 ALWAYS_INLINE_RELEASE const CPU::PGXPValue& CPU::PGXP::ValidateAndLoadMem(u32 addr, u32 value)
 {
+  // Never-written memory is the same as an invalid value.
   PGXPValue* pMem = GetPtr(addr);
   if (!pMem) [[unlikely]]
     return INVALID_VALUE;
 
-  pMem->Validate(value);
+  if (pMem->value != value && pMem->flags != 0)
+  {
+    pMem->flags = 0;
+    SetMemChunkDirty(pMem);
+  }
+
   return *pMem;
 }
 
@@ -300,9 +547,14 @@ ALWAYS_INLINE_RELEASE void CPU::PGXP::ValidateAndLoadMem16(PGXPValue& dest, u32
   const bool hiword = ((addr & 2) != 0);
 
   // only validate the component we're interested in
-  pMem->flags = hiword ?
-                  ((Truncate16(pMem->value >> 16) == Truncate16(value)) ? pMem->flags : (pMem->flags & ~VALID_Y)) :
-                  ((Truncate16(pMem->value) == Truncate16(value)) ? pMem->flags : (pMem->flags & ~VALID_X));
+  const u32 flags =
+    hiword ? ((Truncate16(pMem->value >> 16) == Truncate16(value)) ? pMem->flags : (pMem->flags & ~VALID_Y)) :
+             ((Truncate16(pMem->value) == Truncate16(value)) ? pMem->flags : (pMem->flags & ~VALID_X));
+  if (pMem->flags != flags)
+  {
+    pMem->flags = flags;
+    SetMemChunkDirty(pMem);
+  }
 
   // copy whole value
   dest = *pMem;
@@ -331,7 +583,7 @@ ALWAYS_INLINE_RELEASE void CPU::PGXP::ValidateAndLoadMem16(PGXPValue& dest, u32
 
 ALWAYS_INLINE_RELEASE void CPU::PGXP::WriteMem(u32 addr, const PGXPValue& value)
 {
-  PGXPValue* pMem = GetPtr(addr);
+  PGXPValue* pMem = GetWritePtr(addr);
   if (!pMem) [[unlikely]]
     return;
 
@@ -341,7 +593,7 @@ ALWAYS_INLINE_RELEASE void CPU::PGXP::WriteMem(u32 addr, const PGXPValue& value)
 
 ALWAYS_INLINE_RELEASE void CPU::PGXP::WriteMem16(u32 addr, const PGXPValue& value)
 {
-  PGXPValue* dest = GetPtr(addr);
+  PGXPValue* dest = GetWritePtr(addr);
   if (!dest) [[unlikely]]
     return;
 
@@ -573,7 +825,7 @@ ALWAYS_INLINE_RELEASE void CPU::PGXP::CacheVertex(u32 value, const PGXPValue& ve
   const s16 sx = static_cast<s16>(value & 0xFFFFu);
   const s16 sy = static_cast<s16>(value >> 16);
   DebugAssert(sx >= -1024 && sx <= 1023 && sy >= -1024 && sy <= 1023);
-  s_vertex_cache[(sy + 1024) * VERTEX_CACHE_WIDTH + (sx + 1024)] = vertex;
+  *s_vertex_cache.LookupForWrite((sy + 1024) * VERTEX_CACHE_WIDTH + (sx + 1024)) = vertex;
 }
 
 ALWAYS_INLINE_RELEASE CPU::PGXPValue* CPU::PGXP::GetCachedVertex(u32 value)
@@ -581,7 +833,7 @@ ALWAYS_INLINE_RELEASE CPU::PGXPValue* CPU::PGXP::GetCachedVertex(u32 value)
   const s16 sx = static_cast<s16>(value & 0xFFFFu);
   const s16 sy = static_cast<s16>(value >> 16);
   return (sx >= -1024 && sx <= 1023 && sy >= -1024 && sy <= 1013) ?
-           &s_vertex_cache[(sy + 1024) * VERTEX_CACHE_WIDTH + (sx + 1024)] :
+           s_vertex_cache.LookupForRead((sy + 1024) * VERTEX_CACHE_WIDTH + (sx + 1024)) :
            nullptr;
 }
 
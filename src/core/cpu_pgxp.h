@@ -4,13 +4,33 @@
 #pragma once
 #include "cpu_core.h"
 
+#include <memory>
+#include <vector>
+
 namespace CPU::PGXP {
 
+/// Copy of the PGXP registers and shadow memory, for memory save states.
+struct MemoryStateData
+{
+  /// Only chunks which have been written are stored. Chunks with the same generation have the same contents, so their
+  /// buffers are shared between states.
+  std::vector<std::shared_ptr<const PGXPValue[]>> chunks;
+  std::vector<u32> chunk_generations;
+
+  PGXPValue gpr[static_cast<u8>(Reg::count)] = {};
+  PGXPValue cop0[32] = {};
+  PGXPValue gte[64] = {};
+};
+
 /// State management.
 void Initialize();
 void Reset();
 void Shutdown();
 
+/// Saves/restores PGXP state for runahead/rewind. Only chunks which differ from the state are copied.
+void DoMemoryState(MemoryStateData& data, bool reading);
+void FreeMemoryState(MemoryStateData& data);
+
 /// Vertex lookup from GPU side.
 bool GetPreciseVertex(u32 addr, u32 value, int x, int y, int xOffs, int yOffs, float* out_x, float* out_y,
                       float* out_w);
@@ -6,6 +6,7 @@
 #include "cpu_core_private.h"
 #include "cpu_disasm.h"
 #include "cpu_pgxp.h"
+#include "cpu_trace.h"
 #include "settings.h"
 
 #include "common/assert.h"
@@ -72,6 +73,9 @@ void CPU::Recompiler::Recompiler::BeginBlock()
   GenerateCall(reinterpret_cast<const void*>(&CPU::CodeCache::LogCurrentState));
 #endif
 
+  if (Trace::IsActive())
+    GenerateCall(reinterpret_cast<const void*>(&CPU::Trace::RecordBlock));
+
   if (m_block->protection == CodeCache::PageProtectionMode::ManualCheck)
   {
     DEBUG_LOG("Generate manual protection for PC {:08X}", m_block->pc);
@@ -80,6 +84,20 @@ void CPU::Recompiler::Recompiler::BeginBlock()
     GenerateBlockProtectCheck(ram_ptr, shadow_ptr, m_block->size * sizeof(Instruction));
   }
 
+  // Idle loops are detected and skipped in C++, since the evaluation has to follow the interpreter exactly.
+  if (m_block->HasFlag(CodeCache::BlockFlags::IsIdleLoop))
+  {
+    StoreConstantToCPUPointer(m_block->pc, &g_state.pc);
+    GenerateCall(reinterpret_cast<const void*>(&CPU::CodeCache::TrySkipIdleLoopAtPC));
+  }
+
+  // Count executions until the block is hot enough to be recompiled as a superblock.
+  if (m_block->HasFlag(CodeCache::BlockFlags::IsSuperblockCandidate))
+  {
+    StoreConstantToCPUPointer(m_block->pc, &g_state.pc);
+    GenerateCall(reinterpret_cast<const void*>(&CPU::CodeCache::RecordBlockExecution));
+  }
+
   GenerateICacheCheckAndUpdate();
 
   if (g_settings.bios_tty_logging)
@@ -1369,6 +1387,37 @@ void CPU::Recompiler::Recompiler::CompileBranchDelaySlot(bool dirty_pc /* = true
   m_current_instruction_branch_delay_slot = false;
 }
 
+bool CPU::Recompiler::Recompiler::IsSuperblockContinuation(CompileFlags cf) const
+{
+  // Superblocks are the only blocks which have instructions after a branch delay slot.
+  if (!m_block->HasFlag(CodeCache::BlockFlags::IsSuperblock) || (!cf.delay_slot_swapped && iinfo->is_last_instruction))
+    return false;
+
+  const CodeCache::InstructionInfo* delay_slot_info = cf.delay_slot_swapped ? iinfo : (iinfo + 1);
+  return !delay_slot_info->is_last_instruction;
+}
+
+void CPU::Recompiler::Recompiler::ContinueSuperblock(CompileFlags cf)
+{
+  if (!cf.delay_slot_swapped)
+  {
+    CompileBranchDelaySlot();
+  }
+  else
+  {
+    // Delay slot was already compiled, line up with it so the next instruction is picked up.
+    inst++;
+    m_current_instruction_pc += sizeof(Instruction);
+  }
+
+  GenerateSuperblockEventTest(m_compiler_pc);
+}
+
+void CPU::Recompiler::Recompiler::GenerateSuperblockEventTest(u32 newpc)
+{
+  Panic("Superblocks are not supported on this backend");
+}
+
 void CPU::Recompiler::Recompiler::CompileTemplate(void (Recompiler::*const_func)(CompileFlags),
                                                   void (Recompiler::*func)(CompileFlags), const void* pgxp_cpu_func,
                                                   u32 tflags)
@@ -1849,6 +1898,12 @@ void CPU::Recompiler::Recompiler::Compile_b_const(CompileFlags cf)
   if (link)
     SetConstantReg(Reg::ra, GetBranchReturnAddress(cf));
 
+  if (!taken && IsSuperblockContinuation(cf))
+  {
+    ContinueSuperblock(cf);
+    return;
+  }
+
   CompileBranchDelaySlot();
   EndBlock(taken ? taken_pc : m_compiler_pc, true);
 }
@@ -1942,6 +1997,12 @@ void CPU::Recompiler::Recompiler::Compile_bxx_const(CompileFlags cf, BranchCondi
   }
 
   const u32 taken_pc = GetConditionalBranchTarget(cf);
+  if (!taken && IsSuperblockContinuation(cf))
+  {
+    ContinueSuperblock(cf);
+    return;
+  }
+
   CompileBranchDelaySlot();
   EndBlock(taken ? taken_pc : m_compiler_pc, true);
 }
@@ -37,6 +37,9 @@ public:
   // Align functions to 16 bytes.
   static constexpr u32 FUNCTION_ALIGNMENT = 16;
 
+  // Hot blocks can be recompiled as superblocks.
+  static constexpr bool SUPPORTS_SUPERBLOCKS = true;
+
 #elif defined(CPU_ARCH_ARM32)
 
   // A reasonable "maximum" number of bytes per instruction.
@@ -50,6 +53,9 @@ public:
   // Align functions to 4 bytes (word size).
   static constexpr u32 FUNCTION_ALIGNMENT = 16;
 
+  // Hot blocks can be recompiled as superblocks.
+  static constexpr bool SUPPORTS_SUPERBLOCKS = false;
+
 #elif defined(CPU_ARCH_ARM64)
 
   // A reasonable "maximum" number of bytes per instruction.
@@ -65,6 +71,9 @@ public:
   // Align functions to 16 bytes.
   static constexpr u32 FUNCTION_ALIGNMENT = 16;
 
+  // Hot blocks can be recompiled as superblocks.
+  static constexpr bool SUPPORTS_SUPERBLOCKS = true;
+
 #elif defined(CPU_ARCH_RISCV64)
 
   // Number of host registers.
@@ -80,6 +89,9 @@ public:
   // Align functions to 16 bytes.
   static constexpr u32 FUNCTION_ALIGNMENT = 16;
 
+  // Hot blocks can be recompiled as superblocks.
+  static constexpr bool SUPPORTS_SUPERBLOCKS = false;
+
 #endif
 
 public:
@@ -269,6 +281,7 @@ protected:
   virtual void GenerateCall(const void* func, s32 arg1reg = -1, s32 arg2reg = -1, s32 arg3reg = -1) = 0;
   virtual void EndBlock(const std::optional<u32>& newpc, bool do_event_test) = 0;
   virtual void EndBlockWithException(Exception excode) = 0;
+  virtual void GenerateSuperblockEventTest(u32 newpc);
   virtual const void* EndCompile(u32* code_size, u32* far_code_size) = 0;
 
   ALWAYS_INLINE bool IsHostRegAllocated(u32 r) const { return (m_host_regs[r].flags & HR_ALLOCATED) != 0; }
@@ -324,6 +337,8 @@ protected:
 
   void CompileInstruction();
   void CompileBranchDelaySlot(bool dirty_pc = true);
+  bool IsSuperblockContinuation(CompileFlags cf) const;
+  void ContinueSuperblock(CompileFlags cf);
 
   void CompileTemplate(void (Recompiler::*const_func)(CompileFlags), void (Recompiler::*func)(CompileFlags),
                        const void* pgxp_cpu_func, u32 tflags);
@@ -915,12 +915,45 @@ void CPU::ARM64Recompiler::EndAndLinkBlock(const std::optional<u32>& newpc, bool
   {
     const void* target = (newpc.value() == m_block->pc) ?
                            CodeCache::CreateSelfBlockLink(m_block, armAsm->GetCursorAddress<void*>(),
-                                                          armAsm->GetBuffer()->GetStartAddress<const void*>()) :
+                                                          m_emitter.GetBuffer()->GetStartAddress<const void*>()) :
                            CodeCache::CreateBlockLink(m_block, armAsm->GetCursorAddress<void*>(), newpc.value());
     armEmitJmp(armAsm, target, true);
   }
 }
 
+void CPU::ARM64Recompiler::GenerateSuperblockEventTest(u32 newpc)
+{
+  // Same as the event test in EndAndLinkBlock(), except guest registers stay in host registers afterwards.
+  // Only the path which leaves for the event dispatcher needs to write everything back.
+  const TickCount cycles = std::exchange(m_cycles, 0);
+  armAsm->ldr(RWARG1, PTR(&g_state.pending_ticks));
+  armAsm->ldr(RWARG2, PTR(&g_state.downcount));
+  if (cycles > 0)
+    armAsm->add(RWARG1, RWARG1, armCheckAddSubConstant(cycles));
+  if (m_gte_done_cycle > cycles)
+  {
+    armAsm->add(RWARG3, RWARG1, armCheckAddSubConstant(m_gte_done_cycle - cycles));
+    armAsm->str(RWARG3, PTR(&g_state.gte_completion_tick));
+  }
+  armAsm->cmp(RWARG1, RWARG2);
+  if (cycles > 0)
+    armAsm->str(RWARG1, PTR(&g_state.pending_ticks));
+
+  BackupHostState();
+  SwitchToFarCode(true, ge);
+  EmitMov(RWSCRATCH, newpc);
+  armAsm->str(RWSCRATCH, PTR(&g_state.pc));
+  m_dirty_pc = false;
+  Flush(FLUSH_END_BLOCK);
+  armEmitJmp(armAsm, CodeCache::g_run_events_and_dispatch, false);
+  SwitchToNearCode(false);
+  RestoreHostState();
+
+  // GTE completion is in the state now, same as at the start of a block.
+  m_gte_done_cycle = 0;
+  m_dirty_gte_done_cycle = true;
+}
+
 const void* CPU::ARM64Recompiler::EndCompile(u32* code_size, u32* far_code_size)
 {
 #ifdef VIXL_DEBUG
@@ -1261,16 +1294,20 @@ void CPU::ARM64Recompiler::Compile_bxx(CompileFlags cf, BranchCondition cond)
   AssertRegOrConstS(cf);
 
   const u32 taken_pc = GetConditionalBranchTarget(cf);
+  const bool superblock_continuation = IsSuperblockContinuation(cf);
 
-  Flush(FLUSH_FOR_BRANCH);
+  // Superblock exits flush everything themselves, so registers can stay dirty across the branch.
+  if (!superblock_continuation)
+    Flush(FLUSH_FOR_BRANCH);
 
   DebugAssert(cf.valid_host_s);
 
   // MipsT() here should equal zero for zero branches.
   DebugAssert(cond == BranchCondition::Equal || cond == BranchCondition::NotEqual || cf.MipsT() == Reg::zero);
 
-  Label taken;
   const Register rs = CFGetRegS(cf);
+  bool compare_with_zero = false;
+  Condition taken_cond = al;
   switch (cond)
   {
     case BranchCondition::Equal:
@@ -1279,7 +1316,7 @@ void CPU::ARM64Recompiler::Compile_bxx(CompileFlags cf, BranchCondition cond)
       AssertRegOrConstT(cf);
       if (cf.const_t && HasConstantRegValue(cf.MipsT(), 0))
       {
-        (cond == BranchCondition::Equal) ? armAsm->cbz(rs, &taken) : armAsm->cbnz(rs, &taken);
+        compare_with_zero = true;
       }
       else
       {
@@ -1288,7 +1325,7 @@ void CPU::ARM64Recompiler::Compile_bxx(CompileFlags cf, BranchCondition cond)
         else if (cf.const_t)
           armAsm->cmp(rs, armCheckCompareConstant(GetConstantRegU32(cf.MipsT())));
 
-        armAsm->b(&taken, (cond == BranchCondition::Equal) ? eq : ne);
+        taken_cond = (cond == BranchCondition::Equal) ? eq : ne;
       }
     }
     break;
@@ -1296,32 +1333,56 @@ void CPU::ARM64Recompiler::Compile_bxx(CompileFlags cf, BranchCondition cond)
     case BranchCondition::GreaterThanZero:
     {
       armAsm->cmp(rs, 0);
-      armAsm->b(&taken, gt);
+      taken_cond = gt;
     }
     break;
 
     case BranchCondition::GreaterEqualZero:
     {
       armAsm->cmp(rs, 0);
-      armAsm->b(&taken, ge);
+      taken_cond = ge;
     }
     break;
 
     case BranchCondition::LessThanZero:
     {
       armAsm->cmp(rs, 0);
-      armAsm->b(&taken, lt);
+      taken_cond = lt;
     }
     break;
 
     case BranchCondition::LessEqualZero:
     {
       armAsm->cmp(rs, 0);
-      armAsm->b(&taken, le);
+      taken_cond = le;
     }
     break;
   }
 
+  if (superblock_continuation)
+  {
+    // Superblock: the taken path leaves through far code, and the not-taken path carries on with the same registers.
+    // The delay slot is always a nop here, so nothing needs compiling on the taken path.
+    BackupHostState();
+    if (compare_with_zero)
+      SwitchToFarCodeIfRegZeroOrNonZero(rs, cond == BranchCondition::NotEqual);
+    else
+      SwitchToFarCode(true, taken_cond);
+    DebugAssert(cf.delay_slot_swapped);
+    EndBlock(taken_pc, true);
+    SwitchToNearCode(false);
+    RestoreHostState();
+
+    ContinueSuperblock(cf);
+    return;
+  }
+
+  Label taken;
+  if (compare_with_zero)
+    (cond == BranchCondition::Equal) ? armAsm->cbz(rs, &taken) : armAsm->cbnz(rs, &taken);
+  else
+    armAsm->b(&taken, taken_cond);
+
   BackupHostState();
   if (!cf.delay_slot_swapped)
     CompileBranchDelaySlot();
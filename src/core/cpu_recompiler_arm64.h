@@ -39,6 +39,7 @@ protected:
   void EndBlock(const std::optional<u32>& newpc, bool do_event_test) override;
   void EndBlockWithException(Exception excode) override;
   void EndAndLinkBlock(const std::optional<u32>& newpc, bool do_event_test, bool force_run_events);
+  void GenerateSuperblockEventTest(u32 newpc) override;
   const void* EndCompile(u32* code_size, u32* far_code_size) override;
 
   void Flush(u32 flags) override;
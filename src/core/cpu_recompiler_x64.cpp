@@ -665,12 +665,44 @@ void CPU::X64Recompiler::EndAndLinkBlock(const std::optional<u32>& newpc, bool d
   else
   {
     const void* target = (newpc.value() == m_block->pc) ?
-                           CodeCache::CreateSelfBlockLink(m_block, cg->getCurr<void*>(), cg->getCode()) :
+                           CodeCache::CreateSelfBlockLink(m_block, cg->getCurr<void*>(), m_emitter->getCode()) :
                            CodeCache::CreateBlockLink(m_block, cg->getCurr<void*>(), newpc.value());
     cg->jmp(target, CodeGenerator::T_NEAR);
   }
 }
 
+void CPU::X64Recompiler::GenerateSuperblockEventTest(u32 newpc)
+{
+  // Same as the event test in EndAndLinkBlock(), except guest registers stay in host registers afterwards.
+  // Only the path which leaves for the event dispatcher needs to write everything back.
+  const TickCount cycles = std::exchange(m_cycles, 0);
+  cg->mov(RWARG1, cg->dword[PTR(&g_state.pending_ticks)]);
+  if (cycles > 0)
+    (cycles == 1) ? cg->inc(RWARG1) : cg->add(RWARG1, cycles);
+  if (m_gte_done_cycle > cycles)
+  {
+    cg->mov(RWARG2, RWARG1);
+    ((m_gte_done_cycle - cycles) == 1) ? cg->inc(RWARG2) : cg->add(RWARG2, m_gte_done_cycle - cycles);
+    cg->mov(cg->dword[PTR(&g_state.gte_completion_tick)], RWARG2);
+  }
+  if (cycles > 0)
+    cg->mov(cg->dword[PTR(&g_state.pending_ticks)], RWARG1);
+  cg->cmp(RWARG1, cg->dword[PTR(&g_state.downcount)]);
+
+  BackupHostState();
+  SwitchToFarCode(true, &CodeGenerator::jge);
+  cg->mov(cg->dword[PTR(&g_state.pc)], newpc);
+  m_dirty_pc = false;
+  Flush(FLUSH_END_BLOCK);
+  cg->jmp(CodeCache::g_run_events_and_dispatch);
+  SwitchToNearCode(false);
+  RestoreHostState();
+
+  // GTE completion is in the state now, same as at the start of a block.
+  m_gte_done_cycle = 0;
+  m_dirty_gte_done_cycle = true;
+}
+
 const void* CPU::X64Recompiler::EndCompile(u32* code_size, u32* far_code_size)
 {
   const void* code = m_emitter->getCode();
@@ -1030,7 +1062,9 @@ void CPU::X64Recompiler::Compile_bxx(CompileFlags cf, BranchCondition cond)
 {
   const u32 taken_pc = GetConditionalBranchTarget(cf);
 
-  Flush(FLUSH_FOR_BRANCH);
+  // Superblock exits flush everything themselves, so registers can stay dirty across the branch.
+  if (!IsSuperblockContinuation(cf))
+    Flush(FLUSH_FOR_BRANCH);
 
   DebugAssert(cf.valid_host_s);
 
@@ -1039,7 +1073,8 @@ void CPU::X64Recompiler::Compile_bxx(CompileFlags cf, BranchCondition cond)
 
   // TODO: Swap this back to near once instructions don't blow up
   constexpr CodeGenerator::LabelType type = CodeGenerator::T_NEAR;
-  Label taken;
+  void (CodeGenerator::*taken_jump)(const Label&, CodeGenerator::LabelType);
+  void (CodeGenerator::*far_taken_jump)(const void*);
   switch (cond)
   {
     case BranchCondition::Equal:
@@ -1054,39 +1089,71 @@ void CPU::X64Recompiler::Compile_bxx(CompileFlags cf, BranchCondition cond)
       else
         cg->cmp(CFGetRegS(cf), MipsPtr(cf.MipsT()));
 
-      (cond == BranchCondition::Equal) ? cg->je(taken, type) : cg->jne(taken, type);
+      if (cond == BranchCondition::Equal)
+      {
+        taken_jump = &CodeGenerator::je;
+        far_taken_jump = &CodeGenerator::je;
+      }
+      else
+      {
+        taken_jump = &CodeGenerator::jne;
+        far_taken_jump = &CodeGenerator::jne;
+      }
     }
     break;
 
     case BranchCondition::GreaterThanZero:
     {
       cg->cmp(CFGetRegS(cf), 0);
-      cg->jg(taken, type);
+      taken_jump = &CodeGenerator::jg;
+      far_taken_jump = &CodeGenerator::jg;
     }
     break;
 
     case BranchCondition::GreaterEqualZero:
     {
       cg->test(CFGetRegS(cf), CFGetRegS(cf));
-      cg->jns(taken, type);
+      taken_jump = &CodeGenerator::jns;
+      far_taken_jump = &CodeGenerator::jns;
     }
     break;
 
     case BranchCondition::LessThanZero:
     {
       cg->test(CFGetRegS(cf), CFGetRegS(cf));
-      cg->js(taken, type);
+      taken_jump = &CodeGenerator::js;
+      far_taken_jump = &CodeGenerator::js;
     }
     break;
 
     case BranchCondition::LessEqualZero:
+    default:
     {
       cg->cmp(CFGetRegS(cf), 0);
-      cg->jle(taken, type);
+      taken_jump = &CodeGenerator::jle;
+      far_taken_jump = &CodeGenerator::jle;
     }
     break;
   }
 
+  if (IsSuperblockContinuation(cf))
+  {
+    // Superblock: the taken path leaves through far code, and the not-taken path carries on with the same registers.
+    // The delay slot is always a nop here, so nothing needs compiling on the taken path.
+    BackupHostState();
+    SwitchToFarCode(true, far_taken_jump);
+    DebugAssert(cf.delay_slot_swapped);
+    EndBlock(taken_pc, true);
+    SwitchToNearCode(false);
+    RestoreHostState();
+
+    ContinueSuperblock(cf);
+    return;
+  }
+
+  Label taken;
+  (cg->*taken_jump)(taken, type);
+
   BackupHostState();
   if (!cf.delay_slot_swapped)
     CompileBranchDelaySlot();
@@ -0,0 +1,687 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#include "cpu_trace.h"
+#include "cpu_code_cache.h"
+#include "cpu_core.h"
+#include "cpu_disasm.h"
+#include "settings.h"
+#include "system.h"
+
+#include "util/compress_helpers.h"
+
+#include "common/assert.h"
+#include "common/error.h"
+#include "common/file_system.h"
+#include "common/gsvector.h"
+#include "common/heap_array.h"
+#include "common/log.h"
+#include "common/path.h"
+#include "common/small_string.h"
+#include "common/threading.h"
+
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <optional>
+#include <string>
+
+LOG_CHANNEL(CPU);
+
+namespace CPU::Trace {
+namespace {
+
+enum : u32
+{
+  FILE_MAGIC = 0x52544344, // DCTR
+  FILE_VERSION = 1,
+
+  SEGMENT_SIZE = 256 * 1024,
+  MIN_SEGMENTS = 4,
+
+  NUM_GPRS = static_cast<u32>(Reg::count),
+  NUM_GTE_REGS = GTE::NUM_DATA_REGS + GTE::NUM_CONTROL_REGS,
+
+  // Register indices in records. GTE data registers are followed by control registers.
+  INDEX_LOAD_VALUE = NUM_GPRS,
+  INDEX_GTE = 64,
+
+  RECORD_COUNT_MASK = 0x3F,
+  RECORD_FLAG_PC = 0x40,
+  RECORD_FLAG_BLOCK = 0x80,
+
+  // header + pc + instruction + all GPRs + load value + up to one GTE register
+  ENTRY_SIZE = 1 + sizeof(u32),
+  MAX_RECORD_SIZE = 1 + sizeof(u32) + sizeof(u32) + (NUM_GPRS + 2) * ENTRY_SIZE,
+};
+static_assert((NUM_GPRS + 2) <= RECORD_COUNT_MASK);
+static_assert(NUM_GTE_REGS == 64);
+
+struct FileHeader
+{
+  u32 magic;
+  u32 version;
+  u32 segment_size;
+  u32 reserved;
+};
+
+struct FrameHeader
+{
+  u32 compressed_size;
+  u32 uncompressed_size;
+};
+
+struct SegmentHeader
+{
+  u64 sequence;
+  u32 size;
+  u32 reserved;
+
+  // Register values at the start of the segment, records only contain changes.
+  u32 regs[NUM_GPRS];
+};
+
+struct State
+{
+  DynamicHeapArray<u8> buffer;
+  u32 num_segments = 0;
+  bool active = false;
+
+  // Writer state, only accessed on the CPU thread.
+  u8* segment = nullptr;
+  u8* write_ptr = nullptr;
+  u8* write_end = nullptr;
+  u64 sequence = 0;
+  u32 last_pc = 0;
+  bool last_pc_valid = false;
+  alignas(VECTOR_ALIGNMENT) u32 shadow_regs[NUM_GPRS];
+  u32 shadow_gte_regs[NUM_GTE_REGS];
+  u64 shadow_gte_valid = 0;
+
+  // Number of completed segments, read by the stream thread.
+  std::atomic<u64> completed_segments{0};
+
+  std::string stream_path;
+  FileSystem::ManagedCFilePtr stream_fp;
+  Threading::Thread stream_thread;
+  Threading::KernelSemaphore stream_wake;
+  std::atomic_bool stream_shutdown{false};
+};
+
+} // namespace
+
+static u8* GetSegment(u64 sequence);
+static void BeginSegment();
+static void EndSegment();
+static u32 WriteChangedRegisters(u8*& ptr);
+static u32 WriteChangedGTERegister(u8*& ptr, u32 index);
+static bool GetLoadValue(const Instruction inst, u32* value);
+static void OnActiveChanged();
+
+static bool WriteFileHeader(std::FILE* fp, Error* error);
+static bool WriteSegment(std::FILE* fp, const u8* segment, Error* error);
+static void StreamThreadEntryPoint();
+
+static bool DecodeSegment(const u8* data, size_t size, std::optional<u64>* next_sequence, std::FILE* output,
+                          Error* error);
+
+static State s_state;
+
+} // namespace CPU::Trace
+
+ALWAYS_INLINE static u8* WriteU32(u8* ptr, u32 value)
+{
+  std::memcpy(ptr, &value, sizeof(value));
+  return ptr + sizeof(value);
+}
+
+ALWAYS_INLINE static u8* WriteEntry(u8* ptr, u32 index, u32 value)
+{
+  *ptr = static_cast<u8>(index);
+  return WriteU32(ptr + 1, value);
+}
+
+ALWAYS_INLINE static u32 ReadU32(const u8*& ptr)
+{
+  u32 value;
+  std::memcpy(&value, ptr, sizeof(value));
+  ptr += sizeof(value);
+  return value;
+}
+
+bool CPU::Trace::IsActive()
+{
+  return s_state.active;
+}
+
+u8* CPU::Trace::GetSegment(u64 sequence)
+{
+  return &s_state.buffer[(sequence % s_state.num_segments) * SEGMENT_SIZE];
+}
+
+void CPU::Trace::BeginSegment()
+{
+  u8* const segment = GetSegment(s_state.sequence);
+  SegmentHeader* const hdr = reinterpret_cast<SegmentHeader*>(segment);
+  hdr->sequence = s_state.sequence;
+  hdr->size = 0;
+  hdr->reserved = 0;
+  std::memcpy(hdr->regs, g_state.regs.r, sizeof(hdr->regs));
+  std::memcpy(s_state.shadow_regs, g_state.regs.r, sizeof(s_state.shadow_regs));
+
+  // GTE registers are only recorded when they're referenced, so the first reference in each segment must write them.
+  s_state.shadow_gte_valid = 0;
+  s_state.last_pc_valid = false;
+
+  s_state.segment = segment;
+  s_state.write_ptr = segment + sizeof(SegmentHeader);
+  s_state.write_end = segment + SEGMENT_SIZE - MAX_RECORD_SIZE;
+}
+
+void CPU::Trace::EndSegment()
+{
+  reinterpret_cast<SegmentHeader*>(s_state.segment)->size = static_cast<u32>(s_state.write_ptr - s_state.segment);
+  s_state.sequence++;
+  s_state.completed_segments.store(s_state.sequence, std::memory_order_release);
+
+  // The next segment can overwrite one which the stream thread is copying. Make sure the count is visible before any
+  // of those writes are, otherwise the stream thread's re-check could miss the overwrite.
+  std::atomic_thread_fence(std::memory_order_release);
+  if (s_state.stream_thread.Joinable())
+    s_state.stream_wake.Post();
+}
+
+u32 CPU::Trace::WriteChangedRegisters(u8*& ptr)
+{
+  u32 count = 0;
+  for (u32 i = 0; i < 32; i += 4)
+  {
+    const GSVector4i value = GSVector4i::load<false>(&g_state.regs.r[i]);
+    const GSVector4i shadow = GSVector4i::load<true>(&s_state.shadow_regs[i]);
+    u32 mask = static_cast<u32>(GSVector4::cast(value.eq32(shadow)).mask()) ^ 0xFu;
+    if (mask == 0)
+      continue;
+
+    GSVector4i::store<true>(&s_state.shadow_regs[i], value);
+    do
+    {
+      const u32 reg = i + static_cast<u32>(std::countr_zero(mask));
+      ptr = WriteEntry(ptr, reg, g_state.regs.r[reg]);
+      count++;
+      mask &= mask - 1;
+    } while (mask != 0);
+  }
+
+  // hi/lo
+  for (u32 reg = 32; reg < NUM_GPRS; reg++)
+  {
+    if (g_state.regs.r[reg] != s_state.shadow_regs[reg])
+    {
+      s_state.shadow_regs[reg] = g_state.regs.r[reg];
+      ptr = WriteEntry(ptr, reg, g_state.regs.r[reg]);
+      count++;
+    }
+  }
+
+  return count;
+}
+
+u32 CPU::Trace::WriteChangedGTERegister(u8*& ptr, u32 index)
+{
+  const u32 value = g_state.gte_regs.r32[index];
+  const u64 bit = u64(1) << index;
+  if ((s_state.shadow_gte_valid & bit) && s_state.shadow_gte_regs[index] == value)
+    return 0;
+
+  s_state.shadow_gte_valid |= bit;
+  s_state.shadow_gte_regs[index] = value;
+  ptr = WriteEntry(ptr, INDEX_GTE + index, value);
+  return 1;
+}
+
+bool CPU::Trace::GetLoadValue(const Instruction inst, u32* value)
+{
+  // Same sizes as the disassembler comments.
+  const VirtualMemoryAddress address = g_state.regs.r[static_cast<u8>(inst.i.rs.GetValue())] + inst.i.imm_sext32();
+  switch (inst.op)
+  {
+    case InstructionOp::lb:
+    case InstructionOp::lbu:
+    {
+      u8 data = 0;
+      SafeReadMemoryByte(address, &data);
+      *value = ZeroExtend32(data);
+      return true;
+    }
+
+    case InstructionOp::lh:
+    case InstructionOp::lhu:
+    {
+      u16 data = 0;
+      SafeReadMemoryHalfWord(address, &data);
+      *value = ZeroExtend32(data);
+      return true;
+    }
+
+    case InstructionOp::lw:
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+    case InstructionOp::lwc0:
+    case InstructionOp::lwc1:
+    case InstructionOp::lwc2:
+    case InstructionOp::lwc3:
+    {
+      *value = 0;
+      SafeReadMemoryWord(address, value);
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+void CPU::Trace::RecordInstruction()
+{
+  if (s_state.write_ptr > s_state.write_end) [[unlikely]]
+  {
+    EndSegment();
+    BeginSegment();
+  }
+
+  const u32 pc = g_state.current_instruction_pc;
+  const Instruction inst = g_state.current_instruction;
+
+  u8* const header = s_state.write_ptr;
+  u8* ptr = header + 1;
+  u32 flags = 0;
+  if (!s_state.last_pc_valid || pc != (s_state.last_pc + 4))
+  {
+    flags |= RECORD_FLAG_PC;
+    ptr = WriteU32(ptr, pc);
+  }
+  ptr = WriteU32(ptr, inst.bits);
+
+  u32 count = WriteChangedRegisters(ptr);
+
+  u32 load_value;
+  if (GetLoadValue(inst, &load_value))
+  {
+    ptr = WriteEntry(ptr, INDEX_LOAD_VALUE, load_value);
+    count++;
+  }
+
+  // Only the GTE registers which the disassembler shows.
+  if (inst.op == InstructionOp::cop2 && inst.cop.IsCommonInstruction())
+  {
+    const u32 rd = static_cast<u8>(inst.r.rd.GetValue());
+    const CopCommonInstruction op = inst.cop.CommonOp();
+    if (op == CopCommonInstruction::mfcn || op == CopCommonInstruction::mtcn)
+      count += WriteChangedGTERegister(ptr, rd);
+    else if (op == CopCommonInstruction::cfcn || op == CopCommonInstruction::ctcn)
+      count += WriteChangedGTERegister(ptr, GTE::NUM_DATA_REGS + rd);
+  }
+  else if (inst.op == InstructionOp::lwc2 || inst.op == InstructionOp::swc2)
+  {
+    count += WriteChangedGTERegister(ptr, static_cast<u8>(inst.r.rt.GetValue()));
+  }
+
+  *header = static_cast<u8>(flags | count);
+  s_state.write_ptr = ptr;
+  s_state.last_pc = pc;
+  s_state.last_pc_valid = true;
+}
+
+void CPU::Trace::RecordBlock()
+{
+  if (s_state.write_ptr > s_state.write_end) [[unlikely]]
+  {
+    EndSegment();
+    BeginSegment();
+  }
+
+  u8* const header = s_state.write_ptr;
+  u8* ptr = WriteU32(header + 1, g_state.pc);
+  const u32 count = WriteChangedRegisters(ptr);
+  *header = static_cast<u8>(RECORD_FLAG_BLOCK | RECORD_FLAG_PC | count);
+  s_state.write_ptr = ptr;
+  s_state.last_pc_valid = false;
+}
+
+void CPU::Trace::OnActiveChanged()
+{
+  if (!System::IsValid())
+    return;
+
+  // Recompiled blocks only call the hook if it was enabled when they were compiled. The interpreters pick up the new
+  // state when execution is re-entered.
+  if (CodeCache::IsUsingRecompiler())
+    CodeCache::Reset();
+
+  UpdateDebugDispatcherFlag();
+  System::InterruptExecution();
+}
+
+bool CPU::Trace::Start(u32 buffer_size, const char* stream_path, Error* error)
+{
+  if (s_state.active)
+    Stop();
+
+  s_state.num_segments = std::max<u32>(buffer_size / SEGMENT_SIZE, MIN_SEGMENTS);
+  s_state.buffer.resize(static_cast<size_t>(s_state.num_segments) * SEGMENT_SIZE);
+  s_state.sequence = 0;
+  s_state.completed_segments.store(0, std::memory_order_relaxed);
+
+  if (stream_path)
+  {
+    s_state.stream_fp = FileSystem::OpenManagedCFile(stream_path, "wb", error);
+    if (!s_state.stream_fp || !WriteFileHeader(s_state.stream_fp.get(), error))
+    {
+      s_state.stream_fp.reset();
+      s_state.buffer.deallocate();
+      return false;
+    }
+
+    s_state.stream_path = stream_path;
+    s_state.stream_shutdown.store(false, std::memory_order_relaxed);
+    if (!s_state.stream_thread.Start(&StreamThreadEntryPoint))
+    {
+      Error::SetStringView(error, "Failed to start trace writer thread.");
+      s_state.stream_fp.reset();
+      s_state.stream_path = {};
+      s_state.buffer.deallocate();
+      return false;
+    }
+  }
+
+  INFO_LOG("Starting CPU trace with {} segments of {} KB{}{}", s_state.num_segments, SEGMENT_SIZE / 1024,
+           stream_path ? ", streaming to " : "", stream_path ? stream_path : "");
+
+  BeginSegment();
+  s_state.active = true;
+  OnActiveChanged();
+  return true;
+}
+
+void CPU::Trace::Stop()
+{
+  if (!s_state.active)
+    return;
+
+  if (s_state.stream_thread.Joinable())
+  {
+    EndSegment();
+    s_state.stream_shutdown.store(true, std::memory_order_release);
+    s_state.stream_wake.Post();
+    s_state.stream_thread.Join();
+    s_state.stream_fp.reset();
+    INFO_LOG("CPU trace written to {}", s_state.stream_path);
+    s_state.stream_path = {};
+  }
+  else
+  {
+    const std::string path = Path::Combine(EmuFolders::DataRoot, "cpu_trace.bin");
+    Error error;
+    if (SaveBuffer(path.c_str(), &error))
+      INFO_LOG("CPU trace written to {}", path);
+    else
+      ERROR_LOG("Failed to write CPU trace to {}: {}", path, error.GetDescription());
+  }
+
+  s_state.active = false;
+  s_state.segment = nullptr;
+  s_state.write_ptr = nullptr;
+  s_state.write_end = nullptr;
+  s_state.buffer.deallocate();
+  OnActiveChanged();
+}
+
+bool CPU::Trace::WriteFileHeader(std::FILE* fp, Error* error)
+{
+  const FileHeader header = {FILE_MAGIC, FILE_VERSION, SEGMENT_SIZE, 0};
+  if (std::fwrite(&header, sizeof(header), 1, fp) != 1)
+  {
+    Error::SetErrno(error, "fwrite() failed: ", errno);
+    return false;
+  }
+
+  return true;
+}
+
+bool CPU::Trace::WriteSegment(std::FILE* fp, const u8* segment, Error* error)
+{
+  const u32 size = reinterpret_cast<const SegmentHeader*>(segment)->size;
+  const CompressHelpers::OptionalByteBuffer compressed =
+    CompressHelpers::CompressToBuffer(CompressHelpers::CompressType::Zstandard, segment, size, 1, error);
+  if (!compressed.has_value())
+    return false;
+
+  const FrameHeader frame = {static_cast<u32>(compressed->size()), size};
+  if (std::fwrite(&frame, sizeof(frame), 1, fp) != 1 ||
+      std::fwrite(compressed->data(), compressed->size(), 1, fp) != 1)
+  {
+    Error::SetErrno(error, "fwrite() failed: ", errno);
+    return false;
+  }
+
+  return true;
+}
+
+bool CPU::Trace::SaveBuffer(const char* path, Error* error)
+{
+  if (!s_state.active)
+  {
+    Error::SetStringView(error, "Trace is not active.");
+    return false;
+  }
+
+  FileSystem::ManagedCFilePtr fp = FileSystem::OpenManagedCFile(path, "wb", error);
+  if (!fp || !WriteFileHeader(fp.get(), error))
+    return false;
+
+  // Include the segment currently being written. The stream thread never reads it, so the size can be updated here.
+  reinterpret_cast<SegmentHeader*>(s_state.segment)->size = static_cast<u32>(s_state.write_ptr - s_state.segment);
+
+  const u64 first = (s_state.sequence >= s_state.num_segments) ? (s_state.sequence - (s_state.num_segments - 1)) : 0;
+  for (u64 sequence = first; sequence <= s_state.sequence; sequence++)
+  {
+    const u8* segment = GetSegment(sequence);
+    if (reinterpret_cast<const SegmentHeader*>(segment)->size > sizeof(SegmentHeader) &&
+        !WriteSegment(fp.get(), segment, error))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void CPU::Trace::SaveBufferOnCrash()
+{
+  // Streamed traces are already on disk, and the writer thread may still be using the file.
+  if (!s_state.active || s_state.stream_thread.Joinable())
+    return;
+
+  const std::string path = Path::Combine(EmuFolders::DataRoot, "cpu_trace_crash.bin");
+  if (SaveBuffer(path.c_str(), nullptr))
+    std::fprintf(stderr, "CPU trace written to %s\n", path.c_str());
+}
+
+void CPU::Trace::StreamThreadEntryPoint()
+{
+  Threading::SetNameOfCurrentThread("CPU Trace Writer");
+
+  DynamicHeapArray<u8> segment(SEGMENT_SIZE);
+  u64 next_sequence = 0;
+  bool write_error = false;
+  for (;;)
+  {
+    s_state.stream_wake.Wait();
+
+    const bool shutdown = s_state.stream_shutdown.load(std::memory_order_acquire);
+    u64 completed = s_state.completed_segments.load(std::memory_order_acquire);
+    for (; next_sequence < completed && !write_error; next_sequence++)
+    {
+      // Segments which have been lapped by the writer are lost. The decoder reports the gap.
+      if ((completed - next_sequence) >= s_state.num_segments)
+      {
+        const u64 new_sequence = completed - (s_state.num_segments - 1);
+        WARNING_LOG("CPU trace writer fell behind, dropping {} segments", new_sequence - next_sequence);
+        next_sequence = new_sequence;
+      }
+
+      // The writer doesn't wait for us, so check the segment wasn't overwritten while it was being copied. The fence
+      // pairs with the one in EndSegment(), the header check catches a segment which was already being reused.
+      std::memcpy(segment.data(), GetSegment(next_sequence), SEGMENT_SIZE);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      completed = s_state.completed_segments.load(std::memory_order_relaxed);
+      if ((completed - next_sequence) >= s_state.num_segments ||
+          reinterpret_cast<const SegmentHeader*>(segment.data())->sequence != next_sequence)
+      {
+        continue;
+      }
+
+      Error error;
+      if (!WriteSegment(s_state.stream_fp.get(), segment.data(), &error))
+      {
+        ERROR_LOG("Failed to write CPU trace: {}", error.GetDescription());
+        write_error = true;
+      }
+    }
+
+    if (shutdown)
+      break;
+  }
+}
+
+bool CPU::Trace::DecodeFile(const char* path, std::FILE* output, Error* error)
+{
+  FileSystem::ManagedCFilePtr fp = FileSystem::OpenManagedCFile(path, "rb", error);
+  if (!fp)
+    return false;
+
+  FileHeader header;
+  if (std::fread(&header, sizeof(header), 1, fp.get()) != 1 || header.magic != FILE_MAGIC ||
+      header.version != FILE_VERSION || header.segment_size != SEGMENT_SIZE)
+  {
+    Error::SetStringView(error, "File does not have the correct header.");
+    return false;
+  }
+
+  DynamicHeapArray<u8> compressed;
+  std::optional<u64> next_sequence;
+  FrameHeader frame;
+  while (std::fread(&frame, sizeof(frame), 1, fp.get()) == 1)
+  {
+    if (frame.uncompressed_size < sizeof(SegmentHeader) || frame.uncompressed_size > SEGMENT_SIZE)
+    {
+      Error::SetStringFmt(error, "Invalid segment size {}.", frame.uncompressed_size);
+      return false;
+    }
+
+    compressed.resize(frame.compressed_size);
+    if (std::fread(compressed.data(), frame.compressed_size, 1, fp.get()) != 1)
+    {
+      Error::SetStringView(error, "Unexpected end of file.");
+      return false;
+    }
+
+    const CompressHelpers::OptionalByteBuffer data = CompressHelpers::DecompressBuffer(
+      CompressHelpers::CompressType::Zstandard, compressed.cspan(), frame.uncompressed_size, error);
+    if (!data.has_value() || !DecodeSegment(data->data(), data->size(), &next_sequence, output, error))
+      return false;
+  }
+
+  return true;
+}
+
+bool CPU::Trace::DecodeSegment(const u8* data, size_t size, std::optional<u64>* next_sequence, std::FILE* output,
+                               Error* error)
+{
+  SegmentHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (header.size != size)
+  {
+    Error::SetStringFmt(error, "Segment {} is corrupted.", header.sequence);
+    return false;
+  }
+
+  // Segments are only missing if the stream thread fell behind. Older segments in a saved buffer were overwritten.
+  if (next_sequence->has_value() && header.sequence != next_sequence->value())
+    std::fprintf(output, "*** %" PRIu64 " segments missing ***\n", header.sequence - next_sequence->value());
+  *next_sequence = header.sequence + 1;
+
+  Registers regs = {};
+  std::memcpy(regs.r, header.regs, sizeof(header.regs));
+  GTE::Regs gte_regs = {};
+  u32 load_value = 0;
+  const DisassemblyValues values = {&regs, &gte_regs, &load_value};
+
+  TinyString instr;
+  TinyString comment;
+  u32 pc = 0;
+  const u8* ptr = data + sizeof(SegmentHeader);
+  const u8* const end = data + size;
+  while (ptr != end)
+  {
+    const u32 flags = *(ptr++);
+    const u32 count = flags & RECORD_COUNT_MASK;
+    const size_t record_size = ((flags & RECORD_FLAG_PC) ? sizeof(u32) : 0) +
+                               ((flags & RECORD_FLAG_BLOCK) ? 0 : sizeof(u32)) + count * ENTRY_SIZE;
+    if (static_cast<size_t>(end - ptr) < record_size)
+    {
+      Error::SetStringFmt(error, "Segment {} is truncated.", header.sequence);
+      return false;
+    }
+
+    pc = (flags & RECORD_FLAG_PC) ? ReadU32(ptr) : (pc + 4);
+    const u32 bits = (flags & RECORD_FLAG_BLOCK) ? 0 : ReadU32(ptr);
+    for (u32 i = 0; i < count; i++)
+    {
+      const u32 index = *(ptr++);
+      const u32 value = ReadU32(ptr);
+      if (index < NUM_GPRS)
+      {
+        regs.r[index] = value;
+      }
+      else if (index == INDEX_LOAD_VALUE)
+      {
+        load_value = value;
+      }
+      else if (index >= INDEX_GTE && index < (INDEX_GTE + NUM_GTE_REGS))
+      {
+        gte_regs.r32[index - INDEX_GTE] = value;
+      }
+      else
+      {
+        Error::SetStringFmt(error, "Invalid register index {} in segment {}.", index, header.sequence);
+        return false;
+      }
+    }
+
+    if (flags & RECORD_FLAG_BLOCK)
+    {
+      std::fprintf(output, "%08x: <block>\n", pc);
+      continue;
+    }
+
+    // Same format as CPU::LogInstruction().
+    instr.clear();
+    comment.clear();
+    DisassembleInstruction(&instr, pc, bits);
+    DisassembleInstructionComment(&comment, pc, bits, values);
+    if (!comment.empty())
+    {
+      for (u32 i = instr.length(); i < 30; i++)
+        instr.append(' ');
+      instr.append("; ");
+      instr.append(comment);
+    }
+
+    std::fprintf(output, "%08x: %08x %s\n", pc, bits, instr.c_str());
+  }
+
+  return true;
+}
@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#pragma once
+
+#include "common/types.h"
+
+#include <cstdio>
+
+class Error;
+
+/// Binary execution trace. Each instruction is recorded as its PC, instruction word, and the registers which changed
+/// since the previous instruction, into a ring buffer of fixed-size segments. Each segment begins with a copy of the
+/// registers, so the oldest segments can be overwritten, and the buffer always holds the most recent execution.
+/// Completed segments can be compressed and streamed to disk by a worker thread, which never blocks the CPU thread.
+namespace CPU::Trace {
+
+static constexpr u32 DEFAULT_BUFFER_SIZE = 64 * 1024 * 1024;
+
+bool IsActive();
+
+/// Starts tracing, with a ring buffer of buffer_size bytes. If stream_path is not null, completed segments are
+/// written to it as they fill, otherwise the buffer is only written when the trace is stopped.
+bool Start(u32 buffer_size, const char* stream_path, Error* error);
+
+/// Stops tracing. If the trace was not being streamed, the buffer is written to cpu_trace.bin in the data directory.
+void Stop();
+
+/// Writes the segments currently in the ring buffer to a trace file.
+bool SaveBuffer(const char* path, Error* error);
+
+/// Writes the ring buffer to cpu_trace_crash.bin in the data directory, if a trace is active and not being streamed.
+/// Called from crash handlers, so this is best-effort only.
+void SaveBufferOnCrash();
+
+/// Renders a trace file in the same format as the text execution log.
+bool DecodeFile(const char* path, std::FILE* output, Error* error);
+
+/// Records the current instruction, before it is executed. Called by the interpreters.
+void RecordInstruction();
+
+/// Records entry to the block at the current PC, without per-instruction detail. Called by recompiled code.
+void RecordBlock();
+
+} // namespace CPU::Trace
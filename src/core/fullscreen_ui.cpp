@@ -6202,6 +6202,13 @@ void FullscreenUI::DrawAdvancedSettingsPage()
     bsi, FSUI_CSTR("Enable Recompiler Block Linking"),
     FSUI_CSTR("Performance enhancement - jumps directly between blocks instead of returning to the dispatcher."), "CPU",
     "RecompilerBlockLinking", true);
+  DrawToggleSetting(
+    bsi, FSUI_CSTR("Enable Idle Loop Skipping"),
+    FSUI_CSTR("Performance enhancement - fast-forwards loops which are waiting for an interrupt or event."), "CPU",
+    "IdleLoopSkipping", false);
+  DrawToggleSetting(bsi, FSUI_CSTR("Enable Recompiler Superblocks"),
+                    FSUI_CSTR("Performance enhancement - recompiles frequently-run code across conditional branches."),
+                    "CPU", "RecompilerSuperblocks", false);
   DrawEnumSetting(bsi, FSUI_CSTR("Recompiler Fast Memory Access"),
                   FSUI_CSTR("Avoids calls to C++ code, significantly speeding up the recompiler."), "CPU",
                   "FastmemMode", Settings::DEFAULT_CPU_FASTMEM_MODE, &Settings::ParseCPUFastmemMode,
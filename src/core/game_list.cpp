@@ -25,6 +25,7 @@
 #include "common/path.h"
 #include "common/progress_callback.h"
 #include "common/string_util.h"
+#include "common/task_queue.h"
 #include "common/thirdparty/SmallVector.h"
 #include "common/timer.h"
 
@@ -32,9 +33,13 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <bit>
+#include <condition_variable>
 #include <ctime>
+#include <mutex>
 #include <string_view>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -110,9 +115,11 @@ static void ScanDirectory(const char* path, bool recursive, bool only_cache,
 static bool AddFileFromCache(const std::string& path, std::time_t timestamp, const PlayedTimeMap& played_time_map,
                              const INISettingsInterface& custom_attributes_ini,
                              const Achievements::ProgressDatabase& achievements_progress);
-static void ScanFile(std::string path, std::time_t timestamp, std::unique_lock<std::recursive_mutex>& lock,
-                     const PlayedTimeMap& played_time_map, const INISettingsInterface& custom_attributes_ini,
-                     const Achievements::ProgressDatabase& achievements_progress, BinaryFileWriter& cache_writer);
+static void ScanFile(std::string path, std::time_t timestamp, Entry* entry, const PlayedTimeMap& played_time_map,
+                     const INISettingsInterface& custom_attributes_ini,
+                     const Achievements::ProgressDatabase& achievements_progress);
+static void AddScannedEntry(Entry entry, BinaryFileWriter& cache_writer);
+static u32 GetScanWorkerCount(size_t num_files);
 
 static bool LoadOrInitializeCache(std::FILE* fp, bool invalidate_cache);
 static bool LoadEntriesFromCache(BinaryFileReader& reader);
@@ -544,6 +551,16 @@ void GameList::ScanDirectory(const char* path, bool recursive, bool only_cache,
   progress->SetProgressRange(static_cast<u32>(files.size()));
   progress->SetProgressValue(0);
 
+  // Cached entries are cheap, add them straight away. Anything else gets queued for the worker pool.
+  struct PendingScan
+  {
+    FILESYSTEM_FIND_DATA* ffd;
+    u32 file_number;
+    bool done;
+    Entry entry;
+  };
+  std::vector<PendingScan> pending;
+
   u32 files_scanned = 0;
   for (FILESYSTEM_FIND_DATA& ffd : files)
   {
@@ -561,17 +578,74 @@ void GameList::ScanDirectory(const char* path, bool recursive, bool only_cache,
       continue;
     }
 
-    progress->SetStatusText(SmallString::from_format(TRANSLATE_FS("GameList", "Scanning '{}'..."),
-                                                     FileSystem::GetDisplayNameFromPath(ffd.FileName)));
-    ScanFile(std::move(ffd.FileName), ffd.ModificationTime, lock, played_time_map, custom_attributes_ini,
-             achievements_progress, cache_writer);
-    progress->SetProgressValue(files_scanned);
+    pending.push_back(PendingScan{&ffd, files_scanned, false, {}});
+  }
+
+  if (!pending.empty() && !progress->IsCancelled())
+  {
+    // Not safe to lazy-load from multiple threads.
+    GameDatabase::EnsureLoaded();
+
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    std::atomic_bool cancelled{false};
+
+    // Scanning happens on the workers, but results are merged on this thread in directory order, so that the cache
+    // file is only written from one thread, and the progress callback is only touched from the calling thread.
+    TaskQueue workers;
+    workers.SetWorkerCount(GetScanWorkerCount(pending.size()));
+    for (PendingScan& ps : pending)
+    {
+      workers.SubmitTask([&ps, &done_mutex, &done_cv, &cancelled, &played_time_map, &custom_attributes_ini,
+                          &achievements_progress]() {
+        if (!cancelled.load(std::memory_order_relaxed))
+        {
+          ScanFile(ps.ffd->FileName, ps.ffd->ModificationTime, &ps.entry, played_time_map, custom_attributes_ini,
+                   achievements_progress);
+        }
+
+        std::unique_lock lock(done_mutex);
+        ps.done = true;
+        done_cv.notify_all();
+      });
+    }
+
+    for (PendingScan& ps : pending)
+    {
+      if (progress->IsCancelled())
+      {
+        cancelled.store(true, std::memory_order_relaxed);
+        break;
+      }
+
+      progress->SetStatusText(SmallString::from_format(TRANSLATE_FS("GameList", "Scanning '{}'..."),
+                                                       FileSystem::GetDisplayNameFromPath(ps.ffd->FileName)));
+
+      {
+        std::unique_lock lock(done_mutex);
+        done_cv.wait(lock, [&ps]() { return ps.done; });
+      }
+
+      AddScannedEntry(std::move(ps.entry), cache_writer);
+      progress->SetProgressValue(ps.file_number);
+    }
+
+    // tasks reference our locals, so they have to finish before we return
+    workers.WaitForAll();
   }
 
   progress->SetProgressValue(files_scanned);
   progress->PopState();
 }
 
+u32 GameList::GetScanWorkerCount(size_t num_files)
+{
+  // Scanning is a mix of I/O and hashing. More threads than this just thrashes the disk.
+  static constexpr u32 MAX_SCAN_WORKERS = 8;
+  const u32 hw_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  return static_cast<u32>(std::min<size_t>(std::min(hw_threads, MAX_SCAN_WORKERS), num_files));
+}
+
 bool GameList::AddFileFromCache(const std::string& path, std::time_t timestamp, const PlayedTimeMap& played_time_map,
                                 const INISettingsInterface& custom_attributes_ini,
                                 const Achievements::ProgressDatabase& achievements_progress)
@@ -598,47 +672,46 @@ bool GameList::AddFileFromCache(const std::string& path, std::time_t timestamp,
   return true;
 }
 
-void GameList::ScanFile(std::string path, std::time_t timestamp, std::unique_lock<std::recursive_mutex>& lock,
-                        const PlayedTimeMap& played_time_map, const INISettingsInterface& custom_attributes_ini,
-                        const Achievements::ProgressDatabase& achievements_progress, BinaryFileWriter& cache_writer)
+void GameList::ScanFile(std::string path, std::time_t timestamp, Entry* entry, const PlayedTimeMap& played_time_map,
+                        const INISettingsInterface& custom_attributes_ini,
+                        const Achievements::ProgressDatabase& achievements_progress)
 {
-  // don't block UI while scanning
-  lock.unlock();
-
   VERBOSE_LOG("Scanning '{}'...", path);
 
-  Entry entry;
-  if (PopulateEntryFromPath(path, &entry))
+  if (PopulateEntryFromPath(path, entry))
   {
-    const auto iter = played_time_map.find(entry.serial);
+    const auto iter = played_time_map.find(entry->serial);
     if (iter != played_time_map.end())
     {
-      entry.last_played_time = iter->second.last_played_time;
-      entry.total_played_time = iter->second.total_played_time;
+      entry->last_played_time = iter->second.last_played_time;
+      entry->total_played_time = iter->second.total_played_time;
     }
 
-    ApplyCustomAttributes(entry.path, &entry, custom_attributes_ini);
+    ApplyCustomAttributes(entry->path, entry, custom_attributes_ini);
 
-    if (entry.IsDisc())
-      PopulateEntryAchievements(&entry, achievements_progress);
+    if (entry->IsDisc())
+      PopulateEntryAchievements(entry, achievements_progress);
   }
   else
   {
-    MakeInvalidEntry(&entry);
+    MakeInvalidEntry(entry);
   }
 
-  entry.path = std::move(path);
-  entry.last_modified_time = timestamp;
+  entry->path = std::move(path);
+  entry->last_modified_time = timestamp;
+}
 
+void GameList::AddScannedEntry(Entry entry, BinaryFileWriter& cache_writer)
+{
   if (cache_writer.IsOpen() && !WriteEntryToCache(&entry, cache_writer)) [[unlikely]]
     WARNING_LOG("Failed to write entry '{}' to cache", entry.path);
 
-  lock.lock();
-
   // don't add invalid entries to the list
   if (!entry.IsValid())
     return;
 
+  std::unique_lock lock(s_mutex);
+
   // replace if present
   auto it = std::find_if(s_entries.begin(), s_entries.end(),
                          [&entry](const Entry& existing_entry) { return (existing_entry.path == entry.path); });
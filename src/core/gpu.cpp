@@ -1213,6 +1213,13 @@ void GPU::CRTCTickEvent(TickCount ticks)
 
         if (m_gpu_dump) [[unlikely]]
         {
+          // keyframes are interleaved with the command stream, so they can only go in between commands
+          if (m_gpu_dump->IsKeyframeDue() && m_blitter_state == BlitterState::Idle && m_fifo.IsEmpty())
+          {
+            ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+            m_gpu_dump->WriteKeyframe();
+          }
+
           m_gpu_dump->WriteVSync(System::GetGlobalTickCounter());
           if (m_gpu_dump->IsFinished()) [[unlikely]]
             StopRecordingGPUDump();
@@ -1910,8 +1917,9 @@ void GPU::CalculateDrawRect(u32 window_width, u32 window_height, u32 crtc_displa
 
 void GPU::ReadVRAM(u16 x, u16 y, u16 width, u16 height)
 {
-  // If we're using the software renderer, we only need to sync the thread.
-  if (!GPUBackend::IsUsingHardwareBackend() || g_settings.gpu_use_software_renderer_for_readbacks)
+  // If we're using the software renderer for readbacks, we only need to sync the thread. The software backend still
+  // gets the command, because it may have primitives queued for its worker threads.
+  if (GPUBackend::IsUsingHardwareBackend() && g_settings.gpu_use_software_renderer_for_readbacks)
   {
     GPUBackend::SyncGPUThread(true);
     return;
@@ -2128,6 +2136,12 @@ void GPU::DrawDebugStateWindow(float scale)
   }
 }
 
+static GPUDumpCompressionMode GetGPUDumpCompressionMode()
+{
+  return Settings::ParseGPUDumpCompressionMode(Host::GetTinyStringSettingValue("GPU", "DumpCompressionMode"))
+    .value_or(Settings::DEFAULT_GPU_DUMP_COMPRESSION_MODE);
+}
+
 bool GPU::StartRecordingGPUDump(const char* path, u32 num_frames /* = 1 */)
 {
   if (m_gpu_dump)
@@ -2145,9 +2159,13 @@ bool GPU::StartRecordingGPUDump(const char* path, u32 num_frames /* = 1 */)
   // ensure vram is up to date
   ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
 
+  // indexed dumps can be seeked, which needs keyframes
+  const u32 keyframe_interval =
+    (GetGPUDumpCompressionMode() == GPUDumpCompressionMode::ZstIndexed) ? GPUDump::INDEXED_KEYFRAME_INTERVAL : 0;
+
   std::string osd_key = fmt::format("GPUDump_{}", Path::GetFileName(path));
   Error error;
-  m_gpu_dump = GPUDump::Recorder::Create(path, System::GetGameSerial(), num_frames, &error);
+  m_gpu_dump = GPUDump::Recorder::Create(path, System::GetGameSerial(), num_frames, keyframe_interval, &error);
   if (!m_gpu_dump)
   {
     Host::AddIconOSDWarning(
@@ -2187,9 +2205,7 @@ void GPU::StopRecordingGPUDump()
   }
 
   // Are we compressing the dump?
-  const GPUDumpCompressionMode compress_mode =
-    Settings::ParseGPUDumpCompressionMode(Host::GetTinyStringSettingValue("GPU", "DumpCompressionMode"))
-      .value_or(Settings::DEFAULT_GPU_DUMP_COMPRESSION_MODE);
+  const GPUDumpCompressionMode compress_mode = GetGPUDumpCompressionMode();
   std::string osd_key = fmt::format("GPUDump_{}", Path::GetFileName(m_gpu_dump->GetPath()));
   if (compress_mode == GPUDumpCompressionMode::Disabled)
   {
@@ -118,6 +118,11 @@ bool GPUBackend::UpdateSettings(const GPUSettings& old_settings, Error* error)
   return true;
 }
 
+void GPUBackend::UpdateCLUT(GPUTexturePaletteReg reg, bool clut_is_8bit)
+{
+  GPU_SW_Rasterizer::UpdateCLUT(reg, clut_is_8bit);
+}
+
 void GPUBackend::UpdatePostProcessingSettings(bool force_reload)
 {
 }
@@ -380,6 +385,8 @@ bool GPUBackend::AllocateMemorySaveStates(std::span<System::MemorySaveState> sta
 
 void GPUBackend::HandleCommand(const GPUThreadCommand* cmd)
 {
+  const PerformanceCounters::ProfileScope profile(PerformanceCounters::ProfileSection::GPUCommands);
+
   switch (cmd->type)
   {
     case GPUBackendCommandType::ClearVRAM:
@@ -488,7 +495,7 @@ void GPUBackend::HandleCommand(const GPUThreadCommand* cmd)
     case GPUBackendCommandType::UpdateCLUT:
     {
       const GPUBackendUpdateCLUTCommand* ccmd = static_cast<const GPUBackendUpdateCLUTCommand*>(cmd);
-      GPU_SW_Rasterizer::UpdateCLUT(ccmd->reg, ccmd->clut_is_8bit);
+      UpdateCLUT(ccmd->reg, ccmd->clut_is_8bit);
     }
     break;
 
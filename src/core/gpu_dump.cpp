@@ -6,6 +6,7 @@
 #include "cpu_core_private.h"
 #include "gpu.h"
 #include "settings.h"
+#include "system.h"
 
 #include "scmversion/scmversion.h"
 
@@ -24,6 +25,8 @@
 
 #include "fmt/format.h"
 
+#include <algorithm>
+
 LOG_CHANNEL(GPUDump);
 
 namespace GPUDump {
@@ -32,10 +35,28 @@ static constexpr GPUVersion GPU_VERSION = GPUVersion::V2_1MB_VRAM;
 // Write the file header.
 static constexpr u8 FILE_HEADER[] = {'P', 'S', 'X', 'G', 'P', 'U', 'D', 'U', 'M', 'P', 'v', '1', '\0', '\0'};
 
+// Indexed dumps: header, chunks, then the chunk index, frame start offsets and keyframe offsets.
+static constexpr u8 INDEXED_FILE_HEADER[] = {'P', 'S', 'X', 'G', 'P', 'U', 'D', 'U', 'M', 'P', 'i', '1', '\0', '\0'};
+static constexpr u32 INDEXED_CHUNK_SIZE = 4 * 1024 * 1024;
+static constexpr int INDEXED_CHUNK_CLEVEL = 3;
+
+namespace {
+struct IndexedFileHeader
+{
+  u32 chunk_count;
+  u32 frame_count;
+  u32 keyframe_count;
+  u32 reserved;
+  u64 index_offset;
+};
+static_assert(sizeof(IndexedFileHeader) == 24);
+} // namespace
+
 }; // namespace GPUDump
 
-GPUDump::Recorder::Recorder(FileSystem::AtomicRenamedFile fp, u32 vsyncs_remaining, std::string path)
-  : m_fp(std::move(fp)), m_vsyncs_remaining(vsyncs_remaining), m_path(path)
+GPUDump::Recorder::Recorder(FileSystem::AtomicRenamedFile fp, u32 vsyncs_remaining, u32 keyframe_interval,
+                            std::string path)
+  : m_fp(std::move(fp)), m_vsyncs_remaining(vsyncs_remaining), m_keyframe_interval(keyframe_interval), m_path(path)
 {
 }
 
@@ -66,7 +87,7 @@ bool GPUDump::Recorder::Close(Error* error)
 }
 
 std::unique_ptr<GPUDump::Recorder> GPUDump::Recorder::Create(std::string path, std::string_view serial, u32 num_frames,
-                                                             Error* error)
+                                                             u32 keyframe_interval, Error* error)
 {
   std::unique_ptr<Recorder> ret;
 
@@ -74,7 +95,7 @@ std::unique_ptr<GPUDump::Recorder> GPUDump::Recorder::Create(std::string path, s
   if (!fp)
     return ret;
 
-  ret = std::unique_ptr<Recorder>(new Recorder(std::move(fp), num_frames, std::move(path)));
+  ret = std::unique_ptr<Recorder>(new Recorder(std::move(fp), num_frames, keyframe_interval, std::move(path)));
   ret->WriteHeaders(serial);
   g_gpu.WriteCurrentVideoModeToDump(ret.get());
   ret->WriteCurrentVRAM();
@@ -121,6 +142,11 @@ bool GPUDump::Recorder::Compress(const std::string& source_path, GPUDumpCompress
       return false;
     }
   }
+  else if (mode == GPUDumpCompressionMode::ZstIndexed)
+  {
+    if (!CompressIndexed(source_path, data.value(), error))
+      return false;
+  }
   else
   {
     Error::SetStringView(error, "Unknown compression mode.");
@@ -131,6 +157,124 @@ bool GPUDump::Recorder::Compress(const std::string& source_path, GPUDumpCompress
   return FileSystem::DeleteFile(source_path.c_str(), error);
 }
 
+bool GPUDump::Recorder::CompressIndexed(const std::string& source_path, std::span<const u8> data, Error* error)
+{
+  if (data.size() < sizeof(FILE_HEADER) || std::memcmp(data.data(), FILE_HEADER, sizeof(FILE_HEADER)) != 0)
+  {
+    Error::SetStringView(error, "File does not have the correct header.");
+    return false;
+  }
+
+  auto fp = FileSystem::CreateAtomicRenamedFile(fmt::format("{}.zsi", source_path), error);
+  if (!fp)
+    return false;
+
+  // header gets rewritten once we know where the index is
+  IndexedFileHeader hdr = {};
+  if (std::fwrite(INDEXED_FILE_HEADER, sizeof(INDEXED_FILE_HEADER), 1, fp.get()) != 1 ||
+      std::fwrite(&hdr, sizeof(hdr), 1, fp.get()) != 1)
+  {
+    Error::SetErrno(error, "fwrite() failed: ", errno);
+    FileSystem::DiscardAtomicRenamedFile(fp);
+    return false;
+  }
+
+  std::vector<IndexedChunk> chunks;
+  std::vector<u64> frame_offsets;
+  std::vector<u64> keyframe_offsets;
+  u64 file_offset = sizeof(INDEXED_FILE_HEADER) + sizeof(hdr);
+  size_t chunk_start = 0;
+  size_t position = sizeof(FILE_HEADER);
+  bool trace_started = false;
+
+  const auto write_chunk = [&](size_t chunk_end) {
+    const std::span<const u8> chunk_data = data.subspan(chunk_start, chunk_end - chunk_start);
+    CompressHelpers::OptionalByteBuffer cdata =
+      CompressHelpers::CompressToBuffer(CompressHelpers::CompressType::Zstandard, chunk_data, INDEXED_CHUNK_CLEVEL,
+                                        error);
+    if (!cdata.has_value())
+      return false;
+
+    if (std::fwrite(cdata->data(), cdata->size(), 1, fp.get()) != 1)
+    {
+      Error::SetErrno(error, "fwrite() failed: ", errno);
+      return false;
+    }
+
+    chunks.push_back(IndexedChunk{.file_offset = file_offset,
+                                  .stream_offset = chunk_start,
+                                  .compressed_size = static_cast<u32>(cdata->size()),
+                                  .uncompressed_size = static_cast<u32>(chunk_data.size())});
+    file_offset += cdata->size();
+    chunk_start = chunk_end;
+    return true;
+  };
+
+  // Split on packet boundaries, so each chunk can be played without its neighbours.
+  while ((position + sizeof(PacketHeader)) <= data.size())
+  {
+    PacketHeader phdr;
+    std::memcpy(&phdr, &data[position], sizeof(phdr));
+    const size_t packet_end = position + sizeof(phdr) + (phdr.length * sizeof(u32));
+    if (packet_end > data.size())
+    {
+      WARNING_LOG("Ignoring truncated packet at offset {}", position);
+      break;
+    }
+
+    if (trace_started && phdr.type == PacketType::Keyframe)
+    {
+      keyframe_offsets.push_back(position);
+    }
+    else if (phdr.type == PacketType::TraceBegin || (trace_started && phdr.type == PacketType::VSyncEvent))
+    {
+      trace_started = true;
+      frame_offsets.push_back(packet_end);
+    }
+
+    position = packet_end;
+    if ((position - chunk_start) >= INDEXED_CHUNK_SIZE && !write_chunk(position))
+    {
+      FileSystem::DiscardAtomicRenamedFile(fp);
+      return false;
+    }
+  }
+
+  if (frame_offsets.size() < 2)
+  {
+    Error::SetStringView(error, "Dump does not contain at least one frame.");
+    FileSystem::DiscardAtomicRenamedFile(fp);
+    return false;
+  }
+
+  if (position > chunk_start && !write_chunk(position))
+  {
+    FileSystem::DiscardAtomicRenamedFile(fp);
+    return false;
+  }
+
+  hdr.chunk_count = static_cast<u32>(chunks.size());
+  hdr.frame_count = static_cast<u32>(frame_offsets.size());
+  hdr.keyframe_count = static_cast<u32>(keyframe_offsets.size());
+  hdr.index_offset = file_offset;
+  if (std::fwrite(chunks.data(), sizeof(IndexedChunk), chunks.size(), fp.get()) != chunks.size() ||
+      std::fwrite(frame_offsets.data(), sizeof(u64), frame_offsets.size(), fp.get()) != frame_offsets.size() ||
+      (!keyframe_offsets.empty() && std::fwrite(keyframe_offsets.data(), sizeof(u64), keyframe_offsets.size(),
+                                                fp.get()) != keyframe_offsets.size()) ||
+      !FileSystem::FSeek64(fp.get(), sizeof(INDEXED_FILE_HEADER), SEEK_SET, error) ||
+      std::fwrite(&hdr, sizeof(hdr), 1, fp.get()) != 1)
+  {
+    if (error && !error->IsValid())
+      Error::SetErrno(error, "fwrite() failed: ", errno);
+    FileSystem::DiscardAtomicRenamedFile(fp);
+    return false;
+  }
+
+  DEV_LOG("Compressed {} bytes to {} chunks, {} frames, {} keyframes", data.size(), chunks.size(),
+          frame_offsets.size(), keyframe_offsets.size());
+  return FileSystem::CommitAtomicRenamedFile(fp, error);
+}
+
 void GPUDump::Recorder::BeginGP0Packet(u32 size)
 {
   BeginPacket(PacketType::GPUPort0Data, size);
@@ -181,6 +325,20 @@ void GPUDump::Recorder::WriteVSync(u64 ticks)
   WriteWord(static_cast<u32>(ticks));
   WriteWord(static_cast<u32>(ticks >> 32));
   EndPacket();
+
+  m_frames_since_keyframe++;
+}
+
+void GPUDump::Recorder::WriteKeyframe()
+{
+  BeginPacket(PacketType::Keyframe);
+  EndPacket();
+
+  // The VRAM write is subject to the mask bit settings, so clear them first. The video mode restores them.
+  WriteGP0Packet(0xE6u << 24);
+  WriteCurrentVRAM();
+  g_gpu.WriteCurrentVideoModeToDump(this);
+  m_frames_since_keyframe = 0;
 }
 
 void GPUDump::Recorder::BeginPacket(PacketType packet, u32 minimum_size)
@@ -310,11 +468,16 @@ void GPUDump::Recorder::WriteCurrentVRAM()
   EndPacket();
 }
 
-GPUDump::Player::Player(std::string path, DynamicHeapArray<u8> data) : m_data(std::move(data)), m_path(std::move(path))
+GPUDump::Player::Player(std::string path) : m_path(std::move(path))
 {
 }
 
-GPUDump::Player::~Player() = default;
+GPUDump::Player::~Player()
+{
+  // prefetch task references us
+  std::unique_lock lock(m_prefetch_mutex);
+  WaitForPrefetch(lock);
+}
 
 std::unique_ptr<GPUDump::Player> GPUDump::Player::Open(std::string path, Error* error)
 {
@@ -324,13 +487,35 @@ std::unique_ptr<GPUDump::Player> GPUDump::Player::Open(std::string path, Error*
 
   std::optional<DynamicHeapArray<u8>> data;
   if (StringUtil::EndsWithNoCase(path, ".psxgpu.zst") || StringUtil::EndsWithNoCase(path, ".psxgpu.xz"))
+  {
     data = CompressHelpers::DecompressFile(path.c_str(), std::nullopt, error);
+  }
   else
+  {
+    // indexed dumps are streamed, everything else gets loaded up front
+    FileSystem::ManagedCFilePtr fp = FileSystem::OpenManagedCFile(path.c_str(), "rb", error);
+    if (!fp)
+      return ret;
+
+    u8 file_header[sizeof(INDEXED_FILE_HEADER)];
+    if (std::fread(file_header, sizeof(file_header), 1, fp.get()) == 1 &&
+        std::memcmp(file_header, INDEXED_FILE_HEADER, sizeof(INDEXED_FILE_HEADER)) == 0)
+    {
+      ret = OpenIndexed(std::move(path), std::move(fp), error);
+      if (ret)
+        INFO_LOG("Loading {} took {:.0f}ms.", Path::GetFileName(ret->GetPath()), timer.GetTimeMilliseconds());
+
+      return ret;
+    }
+
+    fp.reset();
     data = FileSystem::ReadBinaryFile(path.c_str(), error);
+  }
   if (!data.has_value())
     return ret;
 
-  ret = std::unique_ptr<Player>(new Player(std::move(path), std::move(data.value())));
+  ret = std::unique_ptr<Player>(new Player(std::move(path)));
+  ret->m_data = std::move(data.value());
   if (!ret->Preprocess(error))
   {
     ret.reset();
@@ -341,14 +526,201 @@ std::unique_ptr<GPUDump::Player> GPUDump::Player::Open(std::string path, Error*
   return ret;
 }
 
+std::unique_ptr<GPUDump::Player> GPUDump::Player::OpenIndexed(std::string path, FileSystem::ManagedCFilePtr fp,
+                                                              Error* error)
+{
+  std::unique_ptr<Player> ret;
+
+  IndexedFileHeader hdr;
+  if (std::fread(&hdr, sizeof(hdr), 1, fp.get()) != 1)
+  {
+    Error::SetStringView(error, "Failed to read indexed header.");
+    return ret;
+  }
+
+  if (hdr.chunk_count == 0 || hdr.frame_count < 2)
+  {
+    Error::SetStringView(error, "Index is empty.");
+    return ret;
+  }
+
+  ret = std::unique_ptr<Player>(new Player(std::move(path)));
+  ret->m_chunks.resize(hdr.chunk_count);
+
+  std::vector<u64> frame_offsets(hdr.frame_count);
+  std::vector<u64> keyframe_offsets(hdr.keyframe_count);
+  if (!FileSystem::FSeek64(fp.get(), static_cast<s64>(hdr.index_offset), SEEK_SET, error) ||
+      std::fread(ret->m_chunks.data(), sizeof(IndexedChunk), hdr.chunk_count, fp.get()) != hdr.chunk_count ||
+      std::fread(frame_offsets.data(), sizeof(u64), hdr.frame_count, fp.get()) != hdr.frame_count ||
+      (hdr.keyframe_count > 0 &&
+       std::fread(keyframe_offsets.data(), sizeof(u64), hdr.keyframe_count, fp.get()) != hdr.keyframe_count))
+  {
+    if (error && !error->IsValid())
+      Error::SetStringView(error, "Failed to read index.");
+    ret.reset();
+    return ret;
+  }
+
+  // chunks must be contiguous, otherwise the position lookup breaks
+  u64 stream_offset = 0;
+  for (const IndexedChunk& chunk : ret->m_chunks)
+  {
+    if (chunk.stream_offset != stream_offset || chunk.uncompressed_size == 0)
+    {
+      Error::SetStringView(error, "Chunk index is corrupted.");
+      ret.reset();
+      return ret;
+    }
+
+    stream_offset += chunk.uncompressed_size;
+  }
+
+  ret->m_frame_offsets.assign(frame_offsets.begin(), frame_offsets.end());
+  ret->m_keyframe_offsets.assign(keyframe_offsets.begin(), keyframe_offsets.end());
+  ret->m_fp = std::move(fp);
+
+  if (!ret->ReadChunk(0, &ret->m_data, error))
+  {
+    ret.reset();
+    return ret;
+  }
+
+  ret->m_data_start = 0;
+  ret->m_current_chunk = 0;
+  if (!ret->ProcessHeader(error))
+  {
+    Error::AddPrefix(error, "Failed to process header: ");
+    ret.reset();
+    return ret;
+  }
+
+  ret->m_position = ret->m_start_offset;
+  ret->StartPrefetch(0);
+  DEV_LOG("Indexed dump has {} chunks, {} frames, {} keyframes", ret->m_chunks.size(), ret->m_frame_offsets.size(),
+          ret->m_keyframe_offsets.size());
+  return ret;
+}
+
+bool GPUDump::Player::ReadChunk(u32 index, DynamicHeapArray<u8>* data, Error* error)
+{
+  const IndexedChunk& chunk = m_chunks[index];
+  DynamicHeapArray<u8> compressed_data(chunk.compressed_size);
+  if (!FileSystem::FSeek64(m_fp.get(), static_cast<s64>(chunk.file_offset), SEEK_SET, error) ||
+      std::fread(compressed_data.data(), chunk.compressed_size, 1, m_fp.get()) != 1)
+  {
+    if (error && !error->IsValid())
+      Error::SetStringView(error, "Failed to read chunk.");
+    return false;
+  }
+
+  CompressHelpers::OptionalByteBuffer decompressed_data = CompressHelpers::DecompressBuffer(
+    CompressHelpers::CompressType::Zstandard, compressed_data.cspan(), chunk.uncompressed_size, error);
+  if (!decompressed_data.has_value())
+    return false;
+
+  if (decompressed_data->size() != chunk.uncompressed_size)
+  {
+    Error::SetStringView(error, "Chunk decompressed to incorrect size.");
+    return false;
+  }
+
+  *data = std::move(decompressed_data.value());
+  return true;
+}
+
+void GPUDump::Player::WaitForPrefetch(std::unique_lock<std::mutex>& lock)
+{
+  m_prefetch_cv.wait(lock, [this]() { return !m_prefetch_pending; });
+}
+
+bool GPUDump::Player::LoadChunk(u32 index)
+{
+  std::unique_lock lock(m_prefetch_mutex);
+  WaitForPrefetch(lock);
+
+  if (m_prefetch_valid && m_prefetch_chunk == index)
+  {
+    m_data.swap(m_prefetch_data);
+    m_prefetch_valid = false;
+  }
+  else
+  {
+    // not prefetched, i.e. we seeked or looped
+    Error error;
+    if (!ReadChunk(index, &m_data, &error))
+    {
+      ERROR_LOG("Failed to read chunk {}: {}", index, error.GetDescription());
+      m_data.deallocate();
+      return false;
+    }
+  }
+
+  m_current_chunk = index;
+  m_data_start = static_cast<size_t>(m_chunks[index].stream_offset);
+
+  StartPrefetch(index);
+  return true;
+}
+
+void GPUDump::Player::StartPrefetch(u32 current_chunk)
+{
+  // Decompress the next chunk while this one is played. Looping goes back to the first chunk.
+  if (m_chunks.size() <= 1)
+    return;
+
+  const u32 next_chunk = (current_chunk + 1) % static_cast<u32>(m_chunks.size());
+  m_prefetch_chunk = next_chunk;
+  m_prefetch_pending = true;
+  m_prefetch_valid = false;
+  System::QueueAsyncTask([this, next_chunk]() {
+    DynamicHeapArray<u8> data;
+    Error error;
+    const bool result = ReadChunk(next_chunk, &data, &error);
+    if (!result)
+      WARNING_LOG("Failed to prefetch chunk {}: {}", next_chunk, error.GetDescription());
+
+    // notify under the lock, otherwise we could be destroyed before the notify
+    std::unique_lock lock(m_prefetch_mutex);
+    if (result)
+      m_prefetch_data = std::move(data);
+    m_prefetch_valid = result;
+    m_prefetch_pending = false;
+    m_prefetch_cv.notify_all();
+  });
+}
+
+bool GPUDump::Player::LoadPosition(size_t position)
+{
+  if (position >= m_data_start && position < (m_data_start + m_data.size()))
+    return true;
+
+  // plain dumps are always fully loaded
+  if (m_chunks.empty())
+    return false;
+
+  const auto iter =
+    std::upper_bound(m_chunks.begin(), m_chunks.end(), position,
+                     [](size_t pos, const IndexedChunk& chunk) { return (pos < chunk.stream_offset); });
+  if (iter == m_chunks.begin())
+    return false;
+
+  const IndexedChunk& chunk = *(iter - 1);
+  if (position >= (chunk.stream_offset + chunk.uncompressed_size))
+    return false;
+
+  return LoadChunk(static_cast<u32>(std::distance(m_chunks.begin(), iter) - 1));
+}
+
 std::optional<GPUDump::Player::PacketRef> GPUDump::Player::GetNextPacket()
 {
   std::optional<PacketRef> ret;
 
-  if (m_position >= m_data.size())
+  if (!LoadPosition(m_position))
     return ret;
 
-  size_t new_position = m_position;
+  size_t new_position = m_position - m_data_start;
+  if ((new_position + sizeof(PacketHeader)) > m_data.size())
+    return ret;
 
   PacketHeader hdr;
   std::memcpy(&hdr, &m_data[new_position], sizeof(hdr));
@@ -362,7 +734,7 @@ std::optional<GPUDump::Player::PacketRef> GPUDump::Player::GetNextPacket()
                             std::span<const u32>(reinterpret_cast<const u32*>(&m_data[new_position]), hdr.length) :
                             std::span<const u32>()};
   new_position += (hdr.length * sizeof(u32));
-  m_position = new_position;
+  m_position = m_data_start + new_position;
   return ret;
 }
 
@@ -396,6 +768,7 @@ bool GPUDump::Player::Preprocess(Error* error)
 
 bool GPUDump::Player::ProcessHeader(Error* error)
 {
+  DebugAssert(m_data_start == 0);
   if (m_data.size() < sizeof(FILE_HEADER) || std::memcmp(m_data.data(), FILE_HEADER, sizeof(FILE_HEADER)) != 0)
   {
     Error::SetStringView(error, "File does not have the correct header.");
@@ -463,10 +836,17 @@ bool GPUDump::Player::FindFrameStarts(Error* error)
 {
   for (;;)
   {
+    const size_t packet_position = m_position;
     const std::optional<PacketRef> packet = GetNextPacket();
     if (!packet.has_value())
       break;
 
+    if (!m_frame_offsets.empty() && packet->type == PacketType::Keyframe)
+    {
+      m_keyframe_offsets.push_back(packet_position);
+      continue;
+    }
+
     switch (packet->type)
     {
       case PacketType::TraceBegin:
@@ -525,6 +905,21 @@ void GPUDump::Player::ProcessPacket(const PacketRef& pkt)
   }
 }
 
+bool GPUDump::Player::SeekToFrame(u32 frame)
+{
+  if (frame >= m_frame_offsets.size())
+    return false;
+
+  // Replay from the last keyframe before the frame, or the start if there isn't one. The frames in between still have
+  // to be drawn, but we don't present them.
+  const size_t frame_offset = m_frame_offsets[frame];
+  const auto iter = std::upper_bound(m_keyframe_offsets.begin(), m_keyframe_offsets.end(), frame_offset);
+  m_position = (iter != m_keyframe_offsets.begin()) ? *(iter - 1) : m_start_offset;
+  m_seek_position = frame_offset;
+  DEV_LOG("Seeking to frame {} at offset {}, from offset {}", frame, frame_offset, m_position);
+  return true;
+}
+
 void GPUDump::Player::Execute()
 {
   if (fastjmp_set(CPU::GetExecutionJmpBuf()) != 0)
@@ -536,9 +931,14 @@ void GPUDump::Player::Execute()
     if (!packet.has_value())
     {
       m_position = g_settings.gpu_dump_fast_replay_mode ? m_frame_offsets.front() : m_start_offset;
+      m_seek_position = 0;
       continue;
     }
 
+    // skip vsyncs until we reach the frame we're seeking to
+    if (m_position <= m_seek_position && packet->type == PacketType::VSyncEvent) [[unlikely]]
+      continue;
+
     ProcessPacket(packet.value());
   }
 }
@@ -8,7 +8,9 @@
 #include "common/bitfield.h"
 #include "common/file_system.h"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 
 // Implements the specification from https://github.com/ps1dev/standards/blob/main/GPUDUMP.md
 
@@ -35,10 +37,14 @@ enum class PacketType : u8
   GameID = 0x10,
   TextualVideoFormat = 0x11,
   Comment = 0x12,
+  Keyframe = 0x13, // no data, marks the start of a VRAM/video mode snapshot which playback can start from
 };
 
 static constexpr u32 MAX_PACKET_LENGTH = ((1u << 24) - 1); // 3 bytes for packet size
 
+/// Number of frames between VRAM keyframes, when recording a dump which will be indexed.
+static constexpr u32 INDEXED_KEYFRAME_INTERVAL = 60;
+
 union PacketHeader
 {
   // Length0,Length1,Length2,Type
@@ -48,12 +54,25 @@ union PacketHeader
 };
 static_assert(sizeof(PacketHeader) == 4);
 
+/// Indexed dumps store the plain dump stream as independently-compressed chunks, each containing whole packets, so
+/// that playback can start at any frame without decompressing everything before it.
+struct IndexedChunk
+{
+  u64 file_offset;
+  u64 stream_offset;
+  u32 compressed_size;
+  u32 uncompressed_size;
+};
+static_assert(sizeof(IndexedChunk) == 24);
+
 class Recorder
 {
 public:
   ~Recorder();
 
-  static std::unique_ptr<Recorder> Create(std::string path, std::string_view serial, u32 num_frames, Error* error);
+  /// If keyframe_interval is not zero, the GPU will write a copy of VRAM and the video mode every N frames.
+  static std::unique_ptr<Recorder> Create(std::string path, std::string_view serial, u32 num_frames,
+                                          u32 keyframe_interval, Error* error);
 
   /// Compresses an already-created dump.
   static bool Compress(const std::string& source_path, GPUDumpCompressionMode mode, Error* error);
@@ -63,6 +82,12 @@ public:
   /// Returns true if the caller should stop recording data.
   bool IsFinished();
 
+  /// Returns true if a keyframe should be written before the next vsync.
+  ALWAYS_INLINE bool IsKeyframeDue() const
+  {
+    return (m_keyframe_interval != 0 && m_frames_since_keyframe >= m_keyframe_interval);
+  }
+
   bool Close(Error* error);
 
   void BeginPacket(PacketType packet, u32 minimum_size = 0);
@@ -83,8 +108,13 @@ public:
   void WriteDiscardVRAMRead(u32 width, u32 height);
   void WriteVSync(u64 ticks);
 
+  /// Writes the current VRAM and video mode, which playback can start from. VRAM must be up to date.
+  void WriteKeyframe();
+
 private:
-  Recorder(FileSystem::AtomicRenamedFile fp, u32 vsyncs_remaining, std::string path);
+  Recorder(FileSystem::AtomicRenamedFile fp, u32 vsyncs_remaining, u32 keyframe_interval, std::string path);
+
+  static bool CompressIndexed(const std::string& source_path, std::span<const u8> data, Error* error);
 
   void WriteHeaders(std::string_view serial);
   void WriteCurrentVRAM();
@@ -92,6 +122,8 @@ private:
   FileSystem::AtomicRenamedFile m_fp;
   std::vector<u32> m_packet_buffer;
   u32 m_vsyncs_remaining = 0;
+  u32 m_keyframe_interval = 0;
+  u32 m_frames_since_keyframe = 0;
   PacketType m_current_packet = PacketType::Comment;
   bool m_write_error = false;
 
@@ -110,10 +142,21 @@ public:
 
   static std::unique_ptr<Player> Open(std::string path, Error* error);
 
+  /// Moves playback to the start of the specified frame. The GPU state is rebuilt from the closest keyframe.
+  bool SeekToFrame(u32 frame);
+
   void Execute();
 
 private:
-  Player(std::string path, DynamicHeapArray<u8> data);
+  Player(std::string path);
+
+  static std::unique_ptr<Player> OpenIndexed(std::string path, FileSystem::ManagedCFilePtr fp, Error* error);
+
+  bool ReadChunk(u32 index, DynamicHeapArray<u8>* data, Error* error);
+  bool LoadChunk(u32 index);
+  void StartPrefetch(u32 current_chunk);
+  bool LoadPosition(size_t position);
+  void WaitForPrefetch(std::unique_lock<std::mutex>& lock);
 
   struct PacketRef
   {
@@ -131,14 +174,32 @@ private:
 
   void ProcessPacket(const PacketRef& pkt);
 
+  // Offsets are relative to the uncompressed stream. m_data holds the stream from m_data_start, which is the whole
+  // dump for plain dumps, or the current chunk for indexed dumps.
   DynamicHeapArray<u8> m_data;
+  size_t m_data_start = 0;
   size_t m_start_offset = 0;
   size_t m_position = 0;
+  size_t m_seek_position = 0;
 
   std::string m_path;
   std::string m_serial;
   ConsoleRegion m_region = ConsoleRegion::NTSC_U;
   std::vector<size_t> m_frame_offsets;
+  std::vector<size_t> m_keyframe_offsets;
+
+  // Indexed dumps only. The chunk after the current one is decompressed on the async task queue, which has sole
+  // access to the file while the prefetch is pending.
+  FileSystem::ManagedCFilePtr m_fp;
+  std::vector<IndexedChunk> m_chunks;
+  u32 m_current_chunk = 0;
+
+  std::mutex m_prefetch_mutex;
+  std::condition_variable m_prefetch_cv;
+  DynamicHeapArray<u8> m_prefetch_data;
+  u32 m_prefetch_chunk = 0;
+  bool m_prefetch_pending = false;
+  bool m_prefetch_valid = false;
 };
 
 } // namespace GPUDump
@@ -24,6 +24,7 @@
 #include "common/log.h"
 #include "common/path.h"
 #include "common/string_util.h"
+#include "common/task_queue.h"
 #include "common/timer.h"
 
 #include "IconsEmoji.h"
@@ -38,6 +39,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <mutex>
 #include <numeric>
 #include <unordered_set>
 
@@ -53,6 +55,7 @@ static constexpr u32 NUM_PAGE_DRAW_RECTS = 4;
 static constexpr const GSVector4i& INVALID_RECT = GPU_HW::INVALID_RECT;
 static constexpr const GPUTexture::Format REPLACEMENT_TEXTURE_FORMAT = GPUTexture::Format::RGBA8;
 static constexpr const char LOCAL_CONFIG_FILENAME[] = "config.yaml";
+static constexpr u32 NUM_REPLACEMENT_LOAD_WORKERS = 2;
 
 static constexpr u32 STATE_PALETTE_RECORD_SIZE =
   sizeof(GSVector4i) + sizeof(SourceKey) + sizeof(PaletteRecordFlags) + sizeof(HashType) + sizeof(u16) * MAX_CLUT_SIZE;
@@ -64,6 +67,10 @@ struct HashCacheEntry
   u32 ref_count;
   u32 last_used_frame;
   TList<Source> sources;
+
+  // Replacement images which were still being decoded when the entry was created.
+  // The entry is dropped once they are ready, so it can be recreated with the replacements applied.
+  std::vector<std::string> pending_replacements;
 };
 
 namespace {
@@ -241,10 +248,23 @@ struct DumpedTextureKeyHash
 {
   size_t operator()(const DumpedTextureKey& k) const;
 };
+
+struct ReplacementImageCacheEntry
+{
+  TextureReplacementImage image;
+  u32 last_used_frame;
+};
+
+struct ReplacementLoadRequest
+{
+  std::string path;
+  u32 last_request_frame;
+  u32 num_requests;
+};
 } // namespace
 
 using HashCache = std::unordered_map<HashCacheKey, HashCacheEntry, HashCacheKeyHash>;
-using ReplacementImageCache = PreferUnorderedStringMap<TextureReplacementImage>;
+using ReplacementImageCache = PreferUnorderedStringMap<ReplacementImageCacheEntry>;
 using GPUReplacementImageCache = PreferUnorderedStringMap<std::pair<std::unique_ptr<GPUTexture>, u32>>;
 
 using VRAMReplacementMap = std::unordered_map<VRAMReplacementName, std::string, VRAMReplacementNameHash>;
@@ -325,9 +345,17 @@ static void LoadTextureReplacementAliases(const ryml::ConstNodeRef& root, bool l
                                           bool load_texture_replacement_aliases);
 
 static const TextureReplacementImage* GetTextureReplacementImage(const std::string& path);
-static GPUTexture* GetTextureReplacementGPUImage(const std::string& path);
+static void InsertTextureReplacementImage(const std::string& path, TextureReplacementImage image);
+static GPUTexture* GetTextureReplacementGPUImage(const std::string& path, bool allow_deferred_load);
+static void CompactTextureReplacementImages();
 static void CompactTextureReplacementGPUImages();
 static void PreloadReplacementTextures();
+
+static void QueueReplacementImageLoad(const std::string& path);
+static void BumpReplacementImageLoadPriority(const std::vector<std::string>& paths);
+static void ReplacementImageLoadTask();
+static void ProcessCompletedReplacementImageLoads();
+static void CancelReplacementImageLoads();
 static void PurgeUnreferencedTexturesFromCache();
 
 static void DumpTexture(TextureReplacementType type, u32 offset_x, u32 offset_y, u32 src_width, u32 src_height,
@@ -552,12 +580,28 @@ struct GPUTextureCacheState
   TextureReplacementMap vram_write_texture_replacements;
   TextureReplacementMap texture_page_texture_replacements;
 
-  // TODO: Check the size, purge some when it gets too large.
   ReplacementImageCache replacement_image_cache;
+  size_t replacement_image_cache_memory_usage = 0;
+  std::vector<std::pair<ReplacementImageCache::iterator, s32>> replacement_image_cache_purge_list;
   GPUReplacementImageCache gpu_replacement_image_cache;
   size_t gpu_replacement_image_cache_vram_usage = 0;
   std::vector<std::pair<GPUReplacementImageCache::iterator, s32>> gpu_replacement_image_cache_purge_list;
 
+  /// Replacement images are decoded on worker threads when not preloading. Paths which are queued or being decoded
+  /// are in replacement_loads_in_flight, which is only accessed on the GPU thread. The request list and completed
+  /// list are shared with the workers, and protected by replacement_load_mutex.
+  TaskQueue replacement_load_queue;
+  std::mutex replacement_load_mutex;
+  std::vector<ReplacementLoadRequest> replacement_load_requests;
+  std::vector<std::pair<std::string, std::optional<TextureReplacementImage>>> completed_replacement_loads;
+  u32 replacement_load_generation = 0;
+  bool replacement_load_workers_started = false;
+  PreferUnorderedStringSet replacement_loads_in_flight;
+  PreferUnorderedStringSet failed_replacement_loads;
+
+  /// Paths which GetTextureReplacementGPUImage() deferred since the last ApplyTextureReplacements().
+  std::vector<std::string> deferred_replacement_loads;
+
   std::unordered_set<VRAMReplacementName, VRAMReplacementNameHash> dumped_vram_writes;
   std::unordered_set<DumpedTextureKey, DumpedTextureKeyHash> dumped_textures;
 
@@ -809,6 +853,10 @@ bool GPUTextureCache::DoState(StateWrapper& sw, bool skip)
 
 void GPUTextureCache::Shutdown()
 {
+  CancelReplacementImageLoads();
+  s_state.replacement_load_queue.SetWorkerCount(0);
+  s_state.replacement_load_workers_started = false;
+
   Invalidate();
   ClearHashCache();
   DestroyPipelines();
@@ -827,6 +875,8 @@ void GPUTextureCache::Shutdown()
   s_state.gpu_replacement_image_cache_vram_usage = 0;
 
   s_state.replacement_image_cache.clear();
+  s_state.replacement_image_cache_memory_usage = 0;
+  s_state.replacement_image_cache_purge_list = {};
   s_state.vram_replacements.clear();
   s_state.vram_write_texture_replacements.clear();
   s_state.texture_page_texture_replacements.clear();
@@ -1563,6 +1613,9 @@ void GPUTextureCache::Invalidate()
   DebugAssert(!s_state.last_vram_write);
 #endif
 
+  // Any loads deferred since the last ApplyTextureReplacements() belonged to sources which no longer exist.
+  s_state.deferred_replacement_loads.clear();
+
   ClearHashCache();
 }
 
@@ -2265,6 +2318,8 @@ GPUTextureCache::HashCacheEntry* GPUTextureCache::LookupHashCache(SourceKey key,
   if (it != s_state.hash_cache.end())
   {
     GL_INS_FMT("TC: Hash cache hit {:X} {:X}", hkey.texture_hash, hkey.palette_hash);
+    if (!it->second.pending_replacements.empty())
+      BumpReplacementImageLoadPriority(it->second.pending_replacements);
     return &it->second;
   }
 
@@ -2328,6 +2383,8 @@ void GPUTextureCache::Compact()
   const u32 max_hash_cache_size = s_state.config.max_hash_cache_entries;
   const size_t max_hash_cache_memory = static_cast<size_t>(s_state.config.max_hash_cache_vram_usage_mb) * 1048576;
 
+  ProcessCompletedReplacementImageLoads();
+
   bool might_need_cache_purge =
     (s_state.hash_cache.size() > max_hash_cache_size || s_state.hash_cache_memory_usage >= max_hash_cache_memory);
   if (might_need_cache_purge)
@@ -2383,6 +2440,7 @@ void GPUTextureCache::Compact()
             static_cast<float>(s_state.hash_cache_memory_usage) / 1048576.0f);
   }
 
+  CompactTextureReplacementImages();
   CompactTextureReplacementGPUImages();
 }
 
@@ -2707,7 +2765,8 @@ GPUTexture* GPUTextureCache::GetVRAMReplacement(u32 width, u32 height, const voi
   if (it == s_state.vram_replacements.end())
     return nullptr;
 
-  return GetTextureReplacementGPUImage(it->second);
+  // VRAM writes are only uploaded once, so if the replacement isn't available now it never will be.
+  return GetTextureReplacementGPUImage(it->second, false);
 }
 
 bool GPUTextureCache::ShouldDumpVRAMWrite(u32 width, u32 height)
@@ -2913,7 +2972,7 @@ void GPUTextureCache::GetVRAMWriteTextureReplacements(std::vector<TextureReplace
       continue;
     }
 
-    GPUTexture* texture = GetTextureReplacementGPUImage(it->second.second);
+    GPUTexture* texture = GetTextureReplacementGPUImage(it->second.second, true);
     if (!texture)
       continue;
 
@@ -2988,7 +3047,7 @@ void GPUTextureCache::GetTexturePageTextureReplacements(std::vector<TextureRepla
         continue;
     }
 
-    GPUTexture* texture = GetTextureReplacementGPUImage(it->second.second);
+    GPUTexture* texture = GetTextureReplacementGPUImage(it->second.second, true);
     if (!texture)
       continue;
 
@@ -3275,7 +3334,7 @@ const GPUTextureCache::TextureReplacementImage* GPUTextureCache::GetTextureRepla
 {
   auto it = s_state.replacement_image_cache.find(path);
   if (it != s_state.replacement_image_cache.end())
-    return &it->second;
+    return &it->second.image;
 
   Image image;
   Error error;
@@ -3287,11 +3346,27 @@ const GPUTextureCache::TextureReplacementImage* GPUTextureCache::GetTextureRepla
 
   VERBOSE_LOG("Loaded '{}': {}x{} {}", Path::GetFileName(path), image.GetWidth(), image.GetHeight(),
               Image::GetFormatName(image.GetFormat()));
-  it = s_state.replacement_image_cache.emplace(path, std::move(image)).first;
-  return &it->second;
+  InsertTextureReplacementImage(path, std::move(image));
+  return &s_state.replacement_image_cache.find(path)->second.image;
 }
 
-GPUTexture* GPUTextureCache::GetTextureReplacementGPUImage(const std::string& path)
+void GPUTextureCache::InsertTextureReplacementImage(const std::string& path, TextureReplacementImage image)
+{
+  s_state.replacement_image_cache_memory_usage += image.GetStorageSize();
+
+  const auto it = s_state.replacement_image_cache.find(path);
+  if (it != s_state.replacement_image_cache.end()) [[unlikely]]
+  {
+    s_state.replacement_image_cache_memory_usage -= it->second.image.GetStorageSize();
+    it->second.image = std::move(image);
+    it->second.last_used_frame = System::GetFrameNumber();
+    return;
+  }
+
+  s_state.replacement_image_cache.emplace(path, ReplacementImageCacheEntry{std::move(image), System::GetFrameNumber()});
+}
+
+GPUTexture* GPUTextureCache::GetTextureReplacementGPUImage(const std::string& path, bool allow_deferred_load)
 {
   // Already in cache?
   const auto git = s_state.gpu_replacement_image_cache.find(path);
@@ -3301,27 +3376,44 @@ GPUTexture* GPUTextureCache::GetTextureReplacementGPUImage(const std::string& pa
     return git->second.first.get();
   }
 
-  // Need to upload it.
-  Error error;
-  std::unique_ptr<GPUTexture> tex;
-
-  // Check CPU cache first.
+  // Need to upload it, check CPU cache first.
+  const TextureReplacementImage* image;
   const auto it = s_state.replacement_image_cache.find(path);
   if (it != s_state.replacement_image_cache.end())
   {
-    tex = g_gpu_device->FetchAndUploadTextureImage(it->second, GPUTexture::Flags::None, &error);
+    it->second.last_used_frame = System::GetFrameNumber();
+    image = &it->second.image;
+  }
+  else if (allow_deferred_load)
+  {
+    // Decode it in the background, the caller uses the original texture until it's ready.
+    if (!s_state.failed_replacement_loads.contains(path))
+    {
+      QueueReplacementImageLoad(path);
+      s_state.deferred_replacement_loads.push_back(path);
+    }
+
+    return nullptr;
   }
   else
   {
-    // Need to load it.
-    Image cpu_image;
-    if (cpu_image.LoadFromFile(path.c_str(), &error))
-      tex = g_gpu_device->FetchAndUploadTextureImage(cpu_image, GPUTexture::Flags::None, &error);
+    if (s_state.failed_replacement_loads.contains(path))
+      return nullptr;
+
+    // Caller can't wait, decode it now.
+    image = GetTextureReplacementImage(path);
+    if (!image)
+    {
+      s_state.failed_replacement_loads.insert(path);
+      return nullptr;
+    }
   }
 
+  Error error;
+  std::unique_ptr<GPUTexture> tex = g_gpu_device->FetchAndUploadTextureImage(*image, GPUTexture::Flags::None, &error);
   if (!tex)
   {
-    ERROR_LOG("Failed to load/upload '{}': {}", Path::GetFileName(path), error.GetDescription());
+    ERROR_LOG("Failed to upload '{}': {}", Path::GetFileName(path), error.GetDescription());
     return nullptr;
   }
 
@@ -3335,6 +3427,44 @@ GPUTexture* GPUTextureCache::GetTextureReplacementGPUImage(const std::string& pa
     .first->second.first.get();
 }
 
+void GPUTextureCache::CompactTextureReplacementImages()
+{
+  // Preloading is an explicit request to keep everything resident.
+  if (g_gpu_settings.texture_replacements.preload_textures)
+    return;
+
+  const size_t max_usage = static_cast<size_t>(s_state.config.max_replacement_cache_memory_usage_mb) * 1048576;
+  if (s_state.replacement_image_cache_memory_usage <= max_usage)
+    return;
+
+  DEV_LOG("Compacting replacement image cache, count = {}, size = {:.1f} MB", s_state.replacement_image_cache.size(),
+          static_cast<float>(s_state.replacement_image_cache_memory_usage) / 1048576.0f);
+
+  const u32 frame_number = System::GetFrameNumber();
+  s_state.replacement_image_cache_purge_list.reserve(s_state.replacement_image_cache.size());
+  for (auto it = s_state.replacement_image_cache.begin(); it != s_state.replacement_image_cache.end(); ++it)
+    s_state.replacement_image_cache_purge_list.emplace_back(it, frame_number - it->second.last_used_frame);
+
+  // Reverse sort, put the oldest on the end.
+  std::sort(s_state.replacement_image_cache_purge_list.begin(), s_state.replacement_image_cache_purge_list.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+
+  while (s_state.replacement_image_cache_memory_usage > max_usage && !s_state.replacement_image_cache_purge_list.empty())
+  {
+    ReplacementImageCache::iterator iter = s_state.replacement_image_cache_purge_list.back().first;
+    s_state.replacement_image_cache_purge_list.pop_back();
+
+    s_state.replacement_image_cache_memory_usage -= iter->second.image.GetStorageSize();
+    s_state.replacement_image_cache.erase(iter);
+  }
+
+  s_state.replacement_image_cache_purge_list.clear();
+
+  DEV_LOG("Finished compacting replacement image cache, count = {}, size = {:.1f} MB",
+          s_state.replacement_image_cache.size(),
+          static_cast<float>(s_state.replacement_image_cache_memory_usage) / 1048576.0f);
+}
+
 void GPUTextureCache::CompactTextureReplacementGPUImages()
 {
   // Instead of compacting to exactly the maximum, let's go down to the maximum less 16MB.
@@ -3380,6 +3510,146 @@ void GPUTextureCache::CompactTextureReplacementGPUImages()
           static_cast<float>(s_state.gpu_replacement_image_cache_vram_usage) / 1048576.0f);
 }
 
+void GPUTextureCache::QueueReplacementImageLoad(const std::string& path)
+{
+  const u32 frame_number = System::GetFrameNumber();
+  if (s_state.replacement_loads_in_flight.contains(path))
+  {
+    BumpReplacementImageLoadPriority({path});
+    return;
+  }
+
+  if (!s_state.replacement_load_workers_started)
+  {
+    s_state.replacement_load_queue.SetWorkerCount(NUM_REPLACEMENT_LOAD_WORKERS);
+    s_state.replacement_load_workers_started = true;
+  }
+
+  s_state.replacement_loads_in_flight.insert(path);
+  {
+    std::unique_lock lock(s_state.replacement_load_mutex);
+    s_state.replacement_load_requests.push_back(ReplacementLoadRequest{path, frame_number, 1});
+  }
+
+  // Tasks don't carry a path, each one picks the most wanted request when it runs.
+  s_state.replacement_load_queue.SubmitTask(&GPUTextureCache::ReplacementImageLoadTask);
+}
+
+void GPUTextureCache::BumpReplacementImageLoadPriority(const std::vector<std::string>& paths)
+{
+  const u32 frame_number = System::GetFrameNumber();
+  std::unique_lock lock(s_state.replacement_load_mutex);
+  for (ReplacementLoadRequest& req : s_state.replacement_load_requests)
+  {
+    if (std::find(paths.begin(), paths.end(), req.path) != paths.end())
+    {
+      req.last_request_frame = frame_number;
+      req.num_requests++;
+    }
+  }
+}
+
+void GPUTextureCache::ReplacementImageLoadTask()
+{
+  std::unique_lock lock(s_state.replacement_load_mutex);
+  if (s_state.replacement_load_requests.empty())
+    return;
+
+  // Textures wanted this frame win over ones from a while ago, then the most frequently wanted.
+  const auto it = std::max_element(s_state.replacement_load_requests.begin(), s_state.replacement_load_requests.end(),
+                                   [](const ReplacementLoadRequest& lhs, const ReplacementLoadRequest& rhs) {
+                                     return (lhs.last_request_frame < rhs.last_request_frame ||
+                                             (lhs.last_request_frame == rhs.last_request_frame &&
+                                              lhs.num_requests < rhs.num_requests));
+                                   });
+  std::string path = std::move(it->path);
+  if (it != (s_state.replacement_load_requests.end() - 1))
+    *it = std::move(s_state.replacement_load_requests.back());
+  s_state.replacement_load_requests.pop_back();
+
+  const u32 generation = s_state.replacement_load_generation;
+  lock.unlock();
+
+  std::optional<TextureReplacementImage> image(std::in_place);
+  Error error;
+  if (image->LoadFromFile(path.c_str(), &error))
+  {
+    VERBOSE_LOG("Loaded '{}': {}x{} {}", Path::GetFileName(path), image->GetWidth(), image->GetHeight(),
+                Image::GetFormatName(image->GetFormat()));
+  }
+  else
+  {
+    ERROR_LOG("Failed to load '{}': {}", Path::GetFileName(path), error.GetDescription());
+    image.reset();
+  }
+
+  lock.lock();
+
+  // Drop it if the replacements were reloaded while we were decoding.
+  if (generation == s_state.replacement_load_generation)
+    s_state.completed_replacement_loads.emplace_back(std::move(path), std::move(image));
+}
+
+void GPUTextureCache::ProcessCompletedReplacementImageLoads()
+{
+  if (s_state.replacement_loads_in_flight.empty())
+    return;
+
+  std::vector<std::pair<std::string, std::optional<TextureReplacementImage>>> completed;
+  {
+    std::unique_lock lock(s_state.replacement_load_mutex);
+    if (s_state.completed_replacement_loads.empty())
+      return;
+
+    completed = std::move(s_state.completed_replacement_loads);
+    s_state.completed_replacement_loads = {};
+  }
+
+  for (auto& [path, image] : completed)
+  {
+    const auto it = s_state.replacement_loads_in_flight.find(path);
+    if (it != s_state.replacement_loads_in_flight.end())
+      s_state.replacement_loads_in_flight.erase(it);
+
+    if (image.has_value())
+      InsertTextureReplacementImage(path, std::move(image.value()));
+    else
+      s_state.failed_replacement_loads.insert(std::move(path));
+  }
+
+  // Drop any hash cache entries that were waiting on these, so they get recreated with the replacement.
+  for (auto it = s_state.hash_cache.begin(); it != s_state.hash_cache.end();)
+  {
+    const std::vector<std::string>& pending = it->second.pending_replacements;
+    if (!pending.empty() && std::any_of(pending.begin(), pending.end(), [](const std::string& path) {
+          return !s_state.replacement_loads_in_flight.contains(path);
+        }))
+    {
+      RemoveFromHashCache(it++);
+      continue;
+    }
+
+    ++it;
+  }
+
+  DEV_LOG("{} replacement images loaded in background, {} remaining", completed.size(),
+          s_state.replacement_loads_in_flight.size());
+}
+
+void GPUTextureCache::CancelReplacementImageLoads()
+{
+  {
+    std::unique_lock lock(s_state.replacement_load_mutex);
+    s_state.replacement_load_requests.clear();
+    s_state.completed_replacement_loads.clear();
+    s_state.replacement_load_generation++;
+  }
+
+  s_state.replacement_loads_in_flight.clear();
+  s_state.failed_replacement_loads.clear();
+  s_state.deferred_replacement_loads.clear();
+}
+
 void GPUTextureCache::PreloadReplacementTextures()
 {
   static constexpr float UPDATE_INTERVAL = 1.0f;
@@ -3580,6 +3850,9 @@ bool GPUTextureCache::LoadLocalConfiguration(bool load_vram_write_replacement_al
     GetOptionalTFromObject<u32>(root, "MaxHashCacheVRAMUsageMB").value_or(s_state.config.max_hash_cache_vram_usage_mb);
   s_state.config.max_replacement_cache_vram_usage_mb = GetOptionalTFromObject<u32>(root, "MaxReplacementCacheVRAMUsage")
                                                          .value_or(s_state.config.max_replacement_cache_vram_usage_mb);
+  s_state.config.max_replacement_cache_memory_usage_mb =
+    GetOptionalTFromObject<u32>(root, "MaxReplacementCacheMemoryUsage")
+      .value_or(s_state.config.max_replacement_cache_memory_usage_mb);
   s_state.config.replacement_scale_linear_filter =
     GetOptionalTFromObject<bool>(root, "ReplacementScaleLinearFilter")
       .value_or(static_cast<bool>(s_state.config.replacement_scale_linear_filter));
@@ -3597,6 +3870,7 @@ bool GPUTextureCache::LoadLocalConfiguration(bool load_vram_write_replacement_al
 
 void GPUTextureCache::ReloadTextureReplacements(bool show_info)
 {
+  CancelReplacementImageLoads();
   s_state.dumped_textures.clear();
   s_state.dumped_vram_writes.clear();
   s_state.vram_replacements.clear();
@@ -3671,12 +3945,17 @@ void GPUTextureCache::PurgeUnreferencedTexturesFromCache()
 
   for (const auto& it : s_state.texture_page_texture_replacements)
     reinsert_texture(it.second.second);
+
+  s_state.replacement_image_cache_memory_usage = 0;
+  for (const auto& it : s_state.replacement_image_cache)
+    s_state.replacement_image_cache_memory_usage += it.second.image.GetStorageSize();
 }
 
 void GPUTextureCache::ApplyTextureReplacements(SourceKey key, HashType tex_hash, HashType pal_hash,
                                                HashCacheEntry* entry)
 {
   std::vector<TextureReplacementSubImage> subimages;
+  s_state.deferred_replacement_loads.clear();
   if (HasTexturePageTextureReplacements())
   {
     GetTexturePageTextureReplacements(subimages, key.page, tex_hash, pal_hash, key.mode, key.palette);
@@ -3704,6 +3983,10 @@ void GPUTextureCache::ApplyTextureReplacements(SourceKey key, HashType tex_hash,
     });
   }
 
+  // Anything still being decoded gets applied when the entry is recreated.
+  entry->pending_replacements = std::move(s_state.deferred_replacement_loads);
+  s_state.deferred_replacement_loads = {};
+
   if (subimages.empty())
     return;
 
@@ -23,6 +23,8 @@ LOG_CHANNEL(GPU);
 
 GPU_SW::GPU_SW(GPUPresenter& presenter) : GPUBackend(presenter)
 {
+  // Memory save state slots start with a generation of zero, so they'll always be copied in full.
+  m_vram_tile_generations.fill(m_vram_generation);
 }
 
 GPU_SW::~GPU_SW() = default;
@@ -56,58 +58,187 @@ bool GPU_SW::Initialize(bool upload_vram, Error* error)
   if (!upload_vram)
     std::memset(g_vram, 0, sizeof(g_vram));
 
+  m_vram_dirty_tiles.set();
+  SetRenderThreadCount(g_gpu_settings.gpu_software_renderer_threads);
   return true;
 }
 
+bool GPU_SW::UpdateSettings(const GPUSettings& old_settings, Error* error)
+{
+  if (!GPUBackend::UpdateSettings(old_settings, error))
+    return false;
+
+  if (g_gpu_settings.gpu_software_renderer_threads != old_settings.gpu_software_renderer_threads)
+    SetRenderThreadCount(g_gpu_settings.gpu_software_renderer_threads);
+
+  return true;
+}
+
+void GPU_SW::SetRenderThreadCount(u32 count)
+{
+  FlushQueuedPrimitives();
+
+  // A single thread is no different to drawing immediately.
+  count = (count > 1) ? count : 0;
+  if (m_render_thread_count == count)
+    return;
+
+  // The GPU thread draws its share of the bands too.
+  m_render_thread_count = count;
+  m_render_workers.SetWorkerCount((count > 0) ? (count - 1) : 0);
+  if (count > 0)
+  {
+    if (m_queue_buffer.empty())
+      m_queue_buffer.resize(QUEUE_BUFFER_SIZE);
+    m_queued_primitives.reserve(MAX_QUEUED_PRIMITIVES);
+    INFO_LOG("Using {} threads for software rendering.", count);
+  }
+  else
+  {
+    m_queue_buffer.deallocate();
+    m_queued_primitives = {};
+  }
+}
+
 void GPU_SW::ClearVRAM()
 {
+  FlushQueuedPrimitives();
   std::memset(g_vram, 0, sizeof(g_vram));
   std::memset(g_gpu_clut, 0, sizeof(g_gpu_clut));
+  m_vram_dirty_tiles.set();
 }
 
 void GPU_SW::LoadState(const GPUBackendLoadStateCommand* cmd)
 {
+  FlushQueuedPrimitives();
   std::memcpy(g_vram, cmd->vram_data, sizeof(g_vram));
   std::memcpy(g_gpu_clut, cmd->clut_data, sizeof(g_gpu_clut));
+  m_vram_dirty_tiles.set();
 }
 
 bool GPU_SW::AllocateMemorySaveState(System::MemorySaveState& mss, Error* error)
 {
-  mss.gpu_state_data.resize(sizeof(g_vram) + sizeof(g_gpu_clut));
+  // Tile generations are stored after the VRAM/CLUT data, outside of the state stream.
+  mss.gpu_state_data.resize(sizeof(g_vram) + sizeof(g_gpu_clut) + sizeof(m_vram_tile_generations));
+  std::memset(mss.gpu_state_data.data() + sizeof(g_vram) + sizeof(g_gpu_clut), 0, sizeof(m_vram_tile_generations));
   return true;
 }
 
 void GPU_SW::DoMemoryState(StateWrapper& sw, System::MemorySaveState& mss)
 {
-  sw.DoBytes(g_vram, sizeof(g_vram));
+  FlushQueuedPrimitives();
+  UpdateVRAMTileGenerations();
+
+  u8* const state_vram = mss.gpu_state_data.data();
+  u32* const state_generations =
+    reinterpret_cast<u32*>(mss.gpu_state_data.data() + sizeof(g_vram) + sizeof(g_gpu_clut));
+  for (u32 tile = 0; tile < VRAM_TILE_COUNT; tile++)
+  {
+    if (state_generations[tile] == m_vram_tile_generations[tile])
+      continue;
+
+    const u32 tile_x = (tile % VRAM_TILES_WIDE) * VRAM_TILE_WIDTH;
+    const u32 tile_y = (tile / VRAM_TILES_WIDE) * VRAM_TILE_HEIGHT;
+    for (u32 row = 0; row < VRAM_TILE_HEIGHT; row++)
+    {
+      const u32 offset = ((tile_y + row) * VRAM_WIDTH + tile_x) * sizeof(u16);
+      if (sw.IsReading())
+        std::memcpy(reinterpret_cast<u8*>(g_vram) + offset, state_vram + offset, VRAM_TILE_WIDTH * sizeof(u16));
+      else
+        std::memcpy(state_vram + offset, reinterpret_cast<const u8*>(g_vram) + offset, VRAM_TILE_WIDTH * sizeof(u16));
+    }
+
+    if (sw.IsReading())
+      m_vram_tile_generations[tile] = state_generations[tile];
+    else
+      state_generations[tile] = m_vram_tile_generations[tile];
+  }
+
+  sw.SetPosition(sw.GetPosition() + sizeof(g_vram));
   sw.DoBytes(g_gpu_clut, sizeof(g_gpu_clut));
   DebugAssert(!sw.HasError());
 }
 
+void GPU_SW::MarkVRAMDirty(u32 x, u32 y, u32 width, u32 height)
+{
+  // Coordinates can wrap around.
+  const u32 start_tile_x = (x % VRAM_WIDTH) / VRAM_TILE_WIDTH;
+  const u32 start_tile_y = (y % VRAM_HEIGHT) / VRAM_TILE_HEIGHT;
+  const u32 num_tiles_x =
+    std::min(((x % VRAM_TILE_WIDTH) + width + (VRAM_TILE_WIDTH - 1)) / VRAM_TILE_WIDTH, VRAM_TILES_WIDE);
+  const u32 num_tiles_y =
+    std::min(((y % VRAM_TILE_HEIGHT) + height + (VRAM_TILE_HEIGHT - 1)) / VRAM_TILE_HEIGHT, VRAM_TILES_HIGH);
+  for (u32 ty = 0; ty < num_tiles_y; ty++)
+  {
+    const u32 row_start = ((start_tile_y + ty) % VRAM_TILES_HIGH) * VRAM_TILES_WIDE;
+    for (u32 tx = 0; tx < num_tiles_x; tx++)
+      m_vram_dirty_tiles[row_start + ((start_tile_x + tx) % VRAM_TILES_WIDE)] = true;
+  }
+}
+
+ALWAYS_INLINE_RELEASE void GPU_SW::MarkDrawingAreaDirty()
+{
+  // Primitives are clipped to the drawing area, so it's cheaper to flag the whole area once.
+  if (m_drawing_area_dirty)
+    return;
+
+  m_drawing_area_dirty = true;
+  if (!m_clamped_drawing_area.rempty())
+  {
+    MarkVRAMDirty(m_clamped_drawing_area.left, m_clamped_drawing_area.top, m_clamped_drawing_area.width(),
+                  m_clamped_drawing_area.height());
+  }
+}
+
+void GPU_SW::UpdateVRAMTileGenerations()
+{
+  m_drawing_area_dirty = false;
+  if (m_vram_dirty_tiles.none())
+    return;
+
+  m_vram_generation++;
+  for (u32 tile = 0; tile < VRAM_TILE_COUNT; tile++)
+  {
+    if (m_vram_dirty_tiles[tile])
+      m_vram_tile_generations[tile] = m_vram_generation;
+  }
+  m_vram_dirty_tiles.reset();
+}
+
 void GPU_SW::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
 {
+  FlushQueuedPrimitives();
 }
 
 void GPU_SW::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color, bool interlaced_rendering, u8 active_line_lsb)
 {
+  FlushQueuedPrimitives();
+  MarkVRAMDirty(x, y, width, height);
   GPU_SW_Rasterizer::FillVRAM(x, y, width, height, color, interlaced_rendering, active_line_lsb);
 }
 
 void GPU_SW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data, bool set_mask, bool check_mask)
 {
+  FlushQueuedPrimitives();
+  MarkVRAMDirty(x, y, width, height);
   GPU_SW_Rasterizer::WriteVRAM(x, y, width, height, data, set_mask, check_mask);
 }
 
 void GPU_SW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height, bool set_mask, bool check_mask)
 {
+  FlushQueuedPrimitives();
+  MarkVRAMDirty(dst_x, dst_y, width, height);
   GPU_SW_Rasterizer::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height, set_mask, check_mask);
 }
 
 void GPU_SW::DrawPolygon(const GPUBackendDrawPolygonCommand* cmd)
 {
+  MarkDrawingAreaDirty();
+  if (m_render_thread_count > 0 && QueuePolygon(cmd, cmd->vertices))
+    return;
+
   const GPU_SW_Rasterizer::DrawTriangleFunction DrawFunction = GPU_SW_Rasterizer::GetDrawTriangleFunction(
     cmd->shading_enable, cmd->texture_enable, cmd->raw_texture_enable, cmd->transparency_enable);
-
   DrawFunction(cmd, &cmd->vertices[0], &cmd->vertices[1], &cmd->vertices[2]);
   if (cmd->num_vertices > 3)
     DrawFunction(cmd, &cmd->vertices[2], &cmd->vertices[1], &cmd->vertices[3]);
@@ -115,8 +246,7 @@ void GPU_SW::DrawPolygon(const GPUBackendDrawPolygonCommand* cmd)
 
 void GPU_SW::DrawPrecisePolygon(const GPUBackendDrawPrecisePolygonCommand* cmd)
 {
-  const GPU_SW_Rasterizer::DrawTriangleFunction DrawFunction = GPU_SW_Rasterizer::GetDrawTriangleFunction(
-    cmd->shading_enable, cmd->texture_enable, cmd->raw_texture_enable, cmd->transparency_enable);
+  MarkDrawingAreaDirty();
 
   // Need to cut out the irrelevant bits.
   // TODO: In _theory_ we could use the fixed-point parts here.
@@ -128,6 +258,11 @@ void GPU_SW::DrawPrecisePolygon(const GPUBackendDrawPrecisePolygonCommand* cmd)
       .x = src.native_x, .y = src.native_y, .color = src.color, .texcoord = src.texcoord};
   }
 
+  if (m_render_thread_count > 0 && QueuePolygon(cmd, vertices))
+    return;
+
+  const GPU_SW_Rasterizer::DrawTriangleFunction DrawFunction = GPU_SW_Rasterizer::GetDrawTriangleFunction(
+    cmd->shading_enable, cmd->texture_enable, cmd->raw_texture_enable, cmd->transparency_enable);
   DrawFunction(cmd, &vertices[0], &vertices[1], &vertices[2]);
   if (cmd->num_vertices > 3)
     DrawFunction(cmd, &vertices[2], &vertices[1], &vertices[3]);
@@ -147,9 +282,12 @@ void GPU_SW::DrawSprite(const GPUBackendDrawRectangleCommand* cmd)
     return;
   }
 
+  MarkDrawingAreaDirty();
+  if (m_render_thread_count > 0 && QueueRectangle(cmd))
+    return;
+
   const GPU_SW_Rasterizer::DrawRectangleFunction DrawFunction =
     GPU_SW_Rasterizer::GetDrawRectangleFunction(cmd->texture_enable, cmd->raw_texture_enable, cmd->transparency_enable);
-
   DrawFunction(cmd);
 }
 
@@ -157,15 +295,22 @@ void GPU_SW::DrawLine(const GPUBackendDrawLineCommand* cmd)
 {
   const GPU_SW_Rasterizer::DrawLineFunction DrawFunction =
     GPU_SW_Rasterizer::GetDrawLineFunction(cmd->shading_enable, cmd->transparency_enable);
+  MarkDrawingAreaDirty();
 
   for (u16 i = 0; i < cmd->num_vertices; i += 2)
+  {
+    if (m_render_thread_count > 0 && QueueLine(cmd, &cmd->vertices[i], &cmd->vertices[i + 1]))
+      continue;
+
     DrawFunction(cmd, &cmd->vertices[i], &cmd->vertices[i + 1]);
+  }
 }
 
 void GPU_SW::DrawPreciseLine(const GPUBackendDrawPreciseLineCommand* cmd)
 {
   const GPU_SW_Rasterizer::DrawLineFunction DrawFunction =
     GPU_SW_Rasterizer::GetDrawLineFunction(cmd->shading_enable, cmd->transparency_enable);
+  MarkDrawingAreaDirty();
 
   // Need to cut out the irrelevant bits.
   // TODO: In _theory_ we could use the fixed-point parts here.
@@ -178,13 +323,278 @@ void GPU_SW::DrawPreciseLine(const GPUBackendDrawPreciseLineCommand* cmd)
       {.x = end.native_x, .y = end.native_y, .color = end.color},
     };
 
+    if (m_render_thread_count > 0 && QueueLine(cmd, &vertices[0], &vertices[1]))
+      continue;
+
     DrawFunction(cmd, &vertices[0], &vertices[1]);
   }
 }
 
 void GPU_SW::DrawingAreaChanged()
 {
-  // GPU_SW_Rasterizer::g_drawing_area set by base class.
+  // GPU_SW_Rasterizer::g_drawing_area set by base class. Queued primitives keep a copy of the old area.
+  m_drawing_area_dirty = false;
+}
+
+void GPU_SW::UpdateCLUT(GPUTexturePaletteReg reg, bool clut_is_8bit)
+{
+  // The palette is read from VRAM, so any queued primitives that could draw over it have to be finished first.
+  if (!m_queued_primitives.empty() &&
+      m_queued_draw_bounds.rintersects(
+        GetPaletteRect(reg, clut_is_8bit ? GPUTextureMode::Palette8Bit : GPUTextureMode::Palette4Bit)))
+  {
+    FlushQueuedPrimitives();
+  }
+
+  GPU_SW_Rasterizer::UpdateCLUT(reg, clut_is_8bit);
+
+  // Primitives queued from now on need a new copy.
+  m_queued_clut = nullptr;
+}
+
+bool GPU_SW::BeginQueuedPrimitive(const GPUBackendDrawCommand* cmd, s32 min_y, s32 max_y, u32 size,
+                                  u32 num_primitives, GPUDrawingArea* area)
+{
+  const GPUDrawingArea& drawing_area = GPU_SW_Rasterizer::g_drawing_area;
+  s32 top = static_cast<s32>(drawing_area.top);
+  s32 bottom = static_cast<s32>(drawing_area.bottom);
+
+  // Positions wrap outside of this range, in which case the primitive could touch any row.
+  if (min_y >= -1024 && max_y < 1024)
+  {
+    top = std::max(top, min_y);
+    bottom = std::min(bottom, max_y);
+  }
+
+  // Nothing will be drawn, so there's no point queuing it.
+  if (drawing_area.left > drawing_area.right || top > bottom)
+    return false;
+
+  // Rows past the bottom of VRAM wrap around.
+  const u32 right = std::min(drawing_area.right + 1, static_cast<u32>(VRAM_WIDTH));
+  const GSVector4i bounds = (bottom < static_cast<s32>(VRAM_HEIGHT)) ?
+                              GSVector4i(drawing_area.left, top, right, bottom + 1) :
+                              GSVector4i(drawing_area.left, 0, right, VRAM_HEIGHT);
+
+  // Primitives that sample from the area they're drawing to depend on the order pixels are written in, so those have to
+  // be drawn serially. Otherwise, textures can't overlap anything drawn by the queue, and the reverse.
+  const GSVector4i texture_rect = cmd->texture_enable ?
+                                    GetTextureRect(cmd->draw_mode.texture_page, cmd->draw_mode.texture_mode) :
+                                    GSVector4i::zero();
+  if (texture_rect.rintersects(bounds))
+  {
+    FlushQueuedPrimitives();
+    return false;
+  }
+  else if (ConflictsWithQueue(bounds, texture_rect, m_queued_draw_bounds, m_queued_texture_bounds))
+  {
+    FlushQueuedPrimitives();
+  }
+
+  // Leave space for a copy of the CLUT, and alignment of each allocation.
+  size += sizeof(g_gpu_clut) + (QUEUE_ALLOCATION_ALIGNMENT * 4);
+  if ((m_queue_buffer_used + size) > QUEUE_BUFFER_SIZE ||
+      (m_queued_primitives.size() + num_primitives) > MAX_QUEUED_PRIMITIVES)
+  {
+    FlushQueuedPrimitives();
+  }
+
+  m_queued_draw_bounds = m_queued_draw_bounds.rempty() ? bounds : m_queued_draw_bounds.runion(bounds);
+  if (cmd->texture_enable)
+  {
+    m_queued_texture_bounds =
+      m_queued_texture_bounds.rempty() ? texture_rect : m_queued_texture_bounds.runion(texture_rect);
+  }
+
+  *area = drawing_area;
+  area->top = static_cast<u32>(top);
+  area->bottom = static_cast<u32>(bottom);
+  return true;
+}
+
+void* GPU_SW::CopyToQueue(const void* data, u32 size)
+{
+  DebugAssert((m_queue_buffer_used + size) <= QUEUE_BUFFER_SIZE);
+  void* ptr = &m_queue_buffer[m_queue_buffer_used];
+  std::memcpy(ptr, data, size);
+  m_queue_buffer_used += Common::AlignUpPow2(size, QUEUE_ALLOCATION_ALIGNMENT);
+  return ptr;
+}
+
+const u16* GPU_SW::GetQueuedCLUT(const GPUBackendDrawCommand* cmd)
+{
+  if (!cmd->texture_enable || !cmd->draw_mode.IsUsingPalette())
+    return g_gpu_clut;
+
+  // The CLUT can change before the queue is drawn.
+  if (!m_queued_clut)
+    m_queued_clut = static_cast<const u16*>(CopyToQueue(g_gpu_clut, sizeof(g_gpu_clut)));
+
+  return m_queued_clut;
+}
+
+bool GPU_SW::QueuePolygon(const GPUBackendDrawCommand* cmd, const GPUBackendDrawPolygonCommand::Vertex* vertices)
+{
+  using Vertex = GPUBackendDrawPolygonCommand::Vertex;
+
+  const u32 num_vertices = cmd->num_vertices;
+  s32 min_y = vertices[0].y;
+  s32 max_y = vertices[0].y;
+  for (u32 i = 1; i < num_vertices; i++)
+  {
+    min_y = std::min(min_y, vertices[i].y);
+    max_y = std::max(max_y, vertices[i].y);
+  }
+
+  // Pad by a row, so rounding in the rasterizer can't put pixels outside of the range.
+  GPUDrawingArea area;
+  if (!BeginQueuedPrimitive(cmd, min_y - 1, max_y + 1,
+                            sizeof(GPUBackendDrawCommand) + (sizeof(Vertex) * num_vertices), num_vertices - 2, &area))
+  {
+    return false;
+  }
+
+  const GPUBackendDrawCommand* qcmd =
+    static_cast<const GPUBackendDrawCommand*>(CopyToQueue(cmd, sizeof(GPUBackendDrawCommand)));
+  const Vertex* qvertices = static_cast<const Vertex*>(CopyToQueue(vertices, sizeof(Vertex) * num_vertices));
+  const u16* clut = GetQueuedCLUT(cmd);
+  const GPU_SW_Rasterizer::DrawTriangleFunction DrawFunction = GPU_SW_Rasterizer::GetDrawTriangleFunction(
+    cmd->shading_enable, cmd->texture_enable, cmd->raw_texture_enable, cmd->transparency_enable);
+
+  QueuedPrimitive prim;
+  prim.draw_triangle = DrawFunction;
+  prim.cmd = qcmd;
+  prim.vertices[0] = &qvertices[0];
+  prim.vertices[1] = &qvertices[1];
+  prim.vertices[2] = &qvertices[2];
+  prim.clut = clut;
+  prim.area = area;
+  prim.type = QueuedPrimitiveType::Triangle;
+  m_queued_primitives.push_back(prim);
+
+  if (num_vertices > 3)
+  {
+    prim.vertices[0] = &qvertices[2];
+    prim.vertices[1] = &qvertices[1];
+    prim.vertices[2] = &qvertices[3];
+    m_queued_primitives.push_back(prim);
+  }
+
+  return true;
+}
+
+bool GPU_SW::QueueRectangle(const GPUBackendDrawRectangleCommand* cmd)
+{
+  GPUDrawingArea area;
+  if (!BeginQueuedPrimitive(cmd, cmd->y, cmd->y + static_cast<s32>(cmd->height) - 1,
+                            sizeof(GPUBackendDrawRectangleCommand), 1, &area))
+  {
+    return false;
+  }
+
+  QueuedPrimitive& prim = m_queued_primitives.emplace_back();
+  prim.draw_rectangle =
+    GPU_SW_Rasterizer::GetDrawRectangleFunction(cmd->texture_enable, cmd->raw_texture_enable, cmd->transparency_enable);
+  prim.cmd = static_cast<const GPUBackendDrawCommand*>(CopyToQueue(cmd, sizeof(GPUBackendDrawRectangleCommand)));
+  prim.clut = GetQueuedCLUT(cmd);
+  prim.area = area;
+  prim.type = QueuedPrimitiveType::Rectangle;
+  return true;
+}
+
+bool GPU_SW::QueueLine(const GPUBackendDrawCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
+                       const GPUBackendDrawLineCommand::Vertex* p1)
+{
+  using Vertex = GPUBackendDrawLineCommand::Vertex;
+
+  GPUDrawingArea area;
+  if (!BeginQueuedPrimitive(cmd, std::min(p0->y, p1->y) - 1, std::max(p0->y, p1->y) + 1,
+                            sizeof(GPUBackendDrawCommand) + (sizeof(Vertex) * 2), 1, &area))
+  {
+    return false;
+  }
+
+  QueuedPrimitive& prim = m_queued_primitives.emplace_back();
+  prim.draw_line = GPU_SW_Rasterizer::GetDrawLineFunction(cmd->shading_enable, cmd->transparency_enable);
+  prim.cmd = static_cast<const GPUBackendDrawCommand*>(CopyToQueue(cmd, sizeof(GPUBackendDrawCommand)));
+  prim.vertices[0] = CopyToQueue(p0, sizeof(Vertex));
+  prim.vertices[1] = CopyToQueue(p1, sizeof(Vertex));
+  prim.clut = g_gpu_clut;
+  prim.area = area;
+  prim.type = QueuedPrimitiveType::Line;
+  return true;
+}
+
+void GPU_SW::FlushQueuedPrimitives()
+{
+  if (m_queued_primitives.empty())
+    return;
+
+  for (u32 i = 1; i < m_render_thread_count; i++)
+    m_render_workers.SubmitTask([this, i]() { DrawQueuedPrimitives(i); });
+  DrawQueuedPrimitives(0);
+  m_render_workers.WaitForAll();
+
+  m_queued_primitives.clear();
+  m_queue_buffer_used = 0;
+  m_queued_clut = nullptr;
+  m_queued_draw_bounds = GSVector4i::zero();
+  m_queued_texture_bounds = GSVector4i::zero();
+}
+
+void GPU_SW::DrawQueuedPrimitives(u32 thread_index)
+{
+  GPUDrawingArea band_area;
+  GPU_SW_Rasterizer::g_thread_drawing_area = &band_area;
+
+  for (const QueuedPrimitive& prim : m_queued_primitives)
+  {
+    GPU_SW_Rasterizer::g_thread_clut = prim.clut;
+
+    // Band ownership is based on the VRAM row, because the drawing area can extend past the bottom and wrap around.
+    const u32 first_band = prim.area.top / RENDER_BAND_HEIGHT;
+    const u32 last_band = prim.area.bottom / RENDER_BAND_HEIGHT;
+    for (u32 band = first_band; band <= last_band; band++)
+    {
+      if (((band % RENDER_BAND_COUNT) % m_render_thread_count) != thread_index)
+        continue;
+
+      band_area = prim.area;
+      band_area.top = std::max(prim.area.top, band * RENDER_BAND_HEIGHT);
+      band_area.bottom = std::min(prim.area.bottom, (band * RENDER_BAND_HEIGHT) + (RENDER_BAND_HEIGHT - 1));
+
+      switch (prim.type)
+      {
+        case QueuedPrimitiveType::Triangle:
+        {
+          using Vertex = GPUBackendDrawPolygonCommand::Vertex;
+          prim.draw_triangle(prim.cmd, static_cast<const Vertex*>(prim.vertices[0]),
+                             static_cast<const Vertex*>(prim.vertices[1]),
+                             static_cast<const Vertex*>(prim.vertices[2]));
+        }
+        break;
+
+        case QueuedPrimitiveType::Rectangle:
+        {
+          prim.draw_rectangle(static_cast<const GPUBackendDrawRectangleCommand*>(prim.cmd));
+        }
+        break;
+
+        case QueuedPrimitiveType::Line:
+        {
+          using Vertex = GPUBackendDrawLineCommand::Vertex;
+          prim.draw_line(prim.cmd, static_cast<const Vertex*>(prim.vertices[0]),
+                         static_cast<const Vertex*>(prim.vertices[1]));
+        }
+        break;
+
+          DefaultCaseIsUnreachable();
+      }
+    }
+  }
+
+  GPU_SW_Rasterizer::g_thread_drawing_area = &GPU_SW_Rasterizer::g_drawing_area;
+  GPU_SW_Rasterizer::g_thread_clut = g_gpu_clut;
 }
 
 void GPU_SW::ClearCache()
@@ -197,6 +607,7 @@ void GPU_SW::OnBufferSwapped()
 
 void GPU_SW::FlushRender()
 {
+  FlushQueuedPrimitives();
 }
 
 void GPU_SW::RestoreDeviceContext()
@@ -383,6 +794,8 @@ bool GPU_SW::CopyOut(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u3
 
 void GPU_SW::UpdateDisplay(const GPUBackendUpdateDisplayCommand* cmd)
 {
+  FlushQueuedPrimitives();
+
   if (!g_gpu_settings.gpu_show_vram)
   {
     if (cmd->display_disabled)
@@ -5,12 +5,17 @@
 
 #include "gpu.h"
 #include "gpu_backend.h"
+#include "gpu_sw_rasterizer.h"
 
 #include "util/gpu_device.h"
 
 #include "common/heap_array.h"
+#include "common/task_queue.h"
 
+#include <array>
+#include <bitset>
 #include <memory>
+#include <vector>
 
 // TODO: Move to cpp
 // TODO: Rename to GPUSWBackend, preserved to avoid conflicts.
@@ -21,6 +26,7 @@ public:
   ~GPU_SW() override;
 
   bool Initialize(bool upload_vram, Error* error) override;
+  bool UpdateSettings(const GPUSettings& old_settings, Error* error) override;
 
   void RestoreDeviceContext() override;
   void FlushRender() override;
@@ -39,6 +45,7 @@ public:
   void DrawPreciseLine(const GPUBackendDrawPreciseLineCommand* cmd) override;
   void DrawSprite(const GPUBackendDrawRectangleCommand* cmd) override;
   void DrawingAreaChanged() override;
+  void UpdateCLUT(GPUTexturePaletteReg reg, bool clut_is_8bit) override;
   void ClearCache() override;
   void OnBufferSwapped() override;
 
@@ -51,9 +58,79 @@ public:
   bool AllocateMemorySaveState(System::MemorySaveState& mss, Error* error) override;
   void DoMemoryState(StateWrapper& sw, System::MemorySaveState& mss) override;
 
+  /// Returns true if a primitive which draws to draw_bounds and samples from texture_rect (zero if untextured) can't join
+  /// the queue. The bands are drawn concurrently, so texels which one primitive samples can't be drawn by another.
+  ALWAYS_INLINE static bool ConflictsWithQueue(const GSVector4i draw_bounds, const GSVector4i texture_rect,
+                                               const GSVector4i queued_draw_bounds,
+                                               const GSVector4i queued_texture_bounds)
+  {
+    return (texture_rect.rintersects(queued_draw_bounds) || draw_bounds.rintersects(queued_texture_bounds));
+  }
+
 private:
   static constexpr GPUTexture::Format FORMAT_FOR_24BIT = GPUTexture::Format::RGBA8; // RGBA8 always supported.
 
+  // VRAM is tracked in tiles for memory save states, so only modified regions need to be copied.
+  static constexpr u32 VRAM_TILE_WIDTH = 64;
+  static constexpr u32 VRAM_TILE_HEIGHT = 16;
+  static constexpr u32 VRAM_TILES_WIDE = VRAM_WIDTH / VRAM_TILE_WIDTH;
+  static constexpr u32 VRAM_TILES_HIGH = VRAM_HEIGHT / VRAM_TILE_HEIGHT;
+  static constexpr u32 VRAM_TILE_COUNT = VRAM_TILES_WIDE * VRAM_TILES_HIGH;
+
+  // With worker threads, primitives are queued and drawn in bands of scanlines. Each band is owned by one thread, which
+  // draws the queue in submission order, so mask bits and blending behave exactly as they do when drawing serially.
+  static constexpr u32 RENDER_BAND_HEIGHT = 32;
+  static constexpr u32 RENDER_BAND_COUNT = VRAM_HEIGHT / RENDER_BAND_HEIGHT;
+  static constexpr u32 MAX_QUEUED_PRIMITIVES = 4096;
+  static constexpr u32 QUEUE_BUFFER_SIZE = 1024 * 1024;
+  static constexpr u32 QUEUE_ALLOCATION_ALIGNMENT = 8;
+
+  enum class QueuedPrimitiveType : u8
+  {
+    Triangle,
+    Rectangle,
+    Line,
+  };
+
+  struct QueuedPrimitive
+  {
+    union
+    {
+      GPU_SW_Rasterizer::DrawTriangleFunction draw_triangle;
+      GPU_SW_Rasterizer::DrawRectangleFunction draw_rectangle;
+      GPU_SW_Rasterizer::DrawLineFunction draw_line;
+    };
+
+    // Copies in the queue buffer.
+    const GPUBackendDrawCommand* cmd;
+    const void* vertices[3];
+    const u16* clut;
+
+    // Drawing area at the time of submission, with the rows limited to those the primitive can touch.
+    GPUDrawingArea area;
+
+    QueuedPrimitiveType type;
+  };
+
+  void SetRenderThreadCount(u32 count);
+
+  bool BeginQueuedPrimitive(const GPUBackendDrawCommand* cmd, s32 min_y, s32 max_y, u32 size, u32 num_primitives,
+                            GPUDrawingArea* area);
+  void* CopyToQueue(const void* data, u32 size);
+  const u16* GetQueuedCLUT(const GPUBackendDrawCommand* cmd);
+
+  bool QueuePolygon(const GPUBackendDrawCommand* cmd, const GPUBackendDrawPolygonCommand::Vertex* vertices);
+  bool QueueRectangle(const GPUBackendDrawRectangleCommand* cmd);
+  bool QueueLine(const GPUBackendDrawCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
+                 const GPUBackendDrawLineCommand::Vertex* p1);
+
+  void FlushQueuedPrimitives();
+  void DrawQueuedPrimitives(u32 thread_index);
+
+  void MarkVRAMDirty(u32 x, u32 y, u32 width, u32 height);
+  void MarkDrawingAreaDirty();
+  void UpdateVRAMTileGenerations();
+
   template<GPUTexture::Format display_format>
   bool CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 line_skip);
 
@@ -66,4 +143,18 @@ private:
   FixedHeapArray<u8, GPU_MAX_DISPLAY_WIDTH * GPU_MAX_DISPLAY_HEIGHT * sizeof(u32)> m_upload_buffer;
   GPUTexture::Format m_16bit_display_format = GPUTexture::Format::Unknown;
   std::unique_ptr<GPUTexture> m_upload_texture;
+
+  std::bitset<VRAM_TILE_COUNT> m_vram_dirty_tiles;
+  std::array<u32, VRAM_TILE_COUNT> m_vram_tile_generations;
+  u32 m_vram_generation = 1;
+  bool m_drawing_area_dirty = false;
+
+  u32 m_render_thread_count = 0;
+  TaskQueue m_render_workers;
+  std::vector<QueuedPrimitive> m_queued_primitives;
+  DynamicHeapArray<u8> m_queue_buffer;
+  u32 m_queue_buffer_used = 0;
+  const u16* m_queued_clut = nullptr;
+  GSVector4i m_queued_draw_bounds = GSVector4i::zero();
+  GSVector4i m_queued_texture_bounds = GSVector4i::zero();
 };
@@ -36,6 +36,8 @@ FillVRAMFunction FillVRAM = nullptr;
 WriteVRAMFunction WriteVRAM = nullptr;
 CopyVRAMFunction CopyVRAM = nullptr;
 GPUDrawingArea g_drawing_area = {};
+constinit thread_local const GPUDrawingArea* g_thread_drawing_area = &g_drawing_area;
+constinit thread_local const u16* g_thread_clut = g_gpu_clut;
 } // namespace GPU_SW_Rasterizer
 
 void GPU_SW_Rasterizer::UpdateCLUT(GPUTexturePaletteReg reg, bool clut_is_8bit)
@@ -22,6 +22,11 @@ extern const DitherLUT g_dither_lut;
 // TODO: Pack in struct
 extern GPUDrawingArea g_drawing_area;
 
+// Drawing area and CLUT read by the rasterizer on the calling thread. These point to the global state, except on the
+// software renderer's worker threads, which clip to their own scanline bands and read snapshots of the CLUT.
+extern constinit thread_local const GPUDrawingArea* g_thread_drawing_area;
+extern constinit thread_local const u16* g_thread_clut;
+
 extern void UpdateCLUT(GPUTexturePaletteReg reg, bool clut_is_8bit);
 
 using DrawRectangleFunction = void (*)(const GPUBackendDrawRectangleCommand* cmd);
@@ -98,7 +98,7 @@ template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
           GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 4)) % VRAM_WIDTH,
                    (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
         const size_t palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
-        texture_color = g_gpu_clut[palette_index];
+        texture_color = g_thread_clut[palette_index];
       }
       break;
 
@@ -108,7 +108,7 @@ template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
           GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 2)) % VRAM_WIDTH,
                    (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
         const size_t palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
-        texture_color = g_gpu_clut[palette_index];
+        texture_color = g_thread_clut[palette_index];
       }
       break;
 
@@ -236,7 +236,7 @@ static void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
   for (u32 offset_y = 0; offset_y < cmd->height; offset_y++)
   {
     const s32 y = origin_y + static_cast<s32>(offset_y);
-    if (y < static_cast<s32>(g_drawing_area.top) || y > static_cast<s32>(g_drawing_area.bottom) ||
+    if (y < static_cast<s32>(g_thread_drawing_area->top) || y > static_cast<s32>(g_thread_drawing_area->bottom) ||
         (cmd->interlaced_rendering &&
          cmd->active_line_lsb == ConvertToBoolUnchecked(Truncate8(static_cast<u32>(y)) & 1u)))
     {
@@ -249,7 +249,7 @@ static void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
     for (u32 offset_x = 0; offset_x < cmd->width; offset_x++)
     {
       const s32 x = origin_x + static_cast<s32>(offset_x);
-      if (x < static_cast<s32>(g_drawing_area.left) || x > static_cast<s32>(g_drawing_area.right))
+      if (x < static_cast<s32>(g_thread_drawing_area->left) || x > static_cast<s32>(g_thread_drawing_area->right))
         continue;
 
       const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + offset_x);
@@ -296,14 +296,14 @@ template<u32 mask>
 ALWAYS_INLINE_RELEASE static GSVector8i GatherCLUTVector(GSVector8i indices, GSVector8i shifts)
 {
   const GSVector8i offsets = indices.srlv32(shifts) & GSVector8i::cxpr(mask);
-  GSVector8i pixels = GSVector8i::zext32(g_gpu_clut[static_cast<u32>(offsets.extract32<0>())]);
-  pixels = pixels.insert16<2>(g_gpu_clut[static_cast<u32>(offsets.extract32<1>())]);
-  pixels = pixels.insert16<4>(g_gpu_clut[static_cast<u32>(offsets.extract32<2>())]);
-  pixels = pixels.insert16<6>(g_gpu_clut[static_cast<u32>(offsets.extract32<3>())]);
-  pixels = pixels.insert16<8>(g_gpu_clut[static_cast<u32>(offsets.extract32<4>())]);
-  pixels = pixels.insert16<10>(g_gpu_clut[static_cast<u32>(offsets.extract32<5>())]);
-  pixels = pixels.insert16<12>(g_gpu_clut[static_cast<u32>(offsets.extract32<6>())]);
-  pixels = pixels.insert16<14>(g_gpu_clut[static_cast<u32>(offsets.extract32<7>())]);
+  GSVector8i pixels = GSVector8i::zext32(g_thread_clut[static_cast<u32>(offsets.extract32<0>())]);
+  pixels = pixels.insert16<2>(g_thread_clut[static_cast<u32>(offsets.extract32<1>())]);
+  pixels = pixels.insert16<4>(g_thread_clut[static_cast<u32>(offsets.extract32<2>())]);
+  pixels = pixels.insert16<6>(g_thread_clut[static_cast<u32>(offsets.extract32<3>())]);
+  pixels = pixels.insert16<8>(g_thread_clut[static_cast<u32>(offsets.extract32<4>())]);
+  pixels = pixels.insert16<10>(g_thread_clut[static_cast<u32>(offsets.extract32<5>())]);
+  pixels = pixels.insert16<12>(g_thread_clut[static_cast<u32>(offsets.extract32<6>())]);
+  pixels = pixels.insert16<14>(g_thread_clut[static_cast<u32>(offsets.extract32<7>())]);
   return pixels;
 }
 
@@ -375,10 +375,10 @@ ALWAYS_INLINE_RELEASE static GSVector4i GatherCLUTVector(GSVector4i indices, GSV
 #ifdef GSVECTOR_HAS_SRLV
   // On everywhere except RISC-V, we can do the shl 1 (* 2) as part of the load instruction.
   const GSVector4i offsets = indices.srlv32(shifts) & GSVector4i::cxpr(mask);
-  GSVector4i pixels = GSVector4i::zext32(g_gpu_clut[static_cast<u32>(offsets.extract32<0>())]);
-  pixels = pixels.insert16<2>(g_gpu_clut[static_cast<u32>(offsets.extract32<1>())]);
-  pixels = pixels.insert16<4>(g_gpu_clut[static_cast<u32>(offsets.extract32<2>())]);
-  pixels = pixels.insert16<6>(g_gpu_clut[static_cast<u32>(offsets.extract32<3>())]);
+  GSVector4i pixels = GSVector4i::zext32(g_thread_clut[static_cast<u32>(offsets.extract32<0>())]);
+  pixels = pixels.insert16<2>(g_thread_clut[static_cast<u32>(offsets.extract32<1>())]);
+  pixels = pixels.insert16<4>(g_thread_clut[static_cast<u32>(offsets.extract32<2>())]);
+  pixels = pixels.insert16<6>(g_thread_clut[static_cast<u32>(offsets.extract32<3>())]);
   return pixels;
 #else
   // Without variable shifts, it's probably quicker to do it without vectors.
@@ -388,10 +388,10 @@ ALWAYS_INLINE_RELEASE static GSVector4i GatherCLUTVector(GSVector4i indices, GSV
   GSVector4i::store<true>(indices_array, indices);
   GSVector4i::store<true>(shifts_array, shifts);
 
-  GSVector4i pixels = GSVector4i::zext32(g_gpu_clut[((indices_array[0] >> shifts_array[0]) & mask)]);
-  pixels = pixels.insert16<2>(g_gpu_clut[((indices_array[1] >> shifts_array[1]) & mask)]);
-  pixels = pixels.insert16<4>(g_gpu_clut[((indices_array[2] >> shifts_array[2]) & mask)]);
-  pixels = pixels.insert16<6>(g_gpu_clut[((indices_array[3] >> shifts_array[3]) & mask)]);
+  GSVector4i pixels = GSVector4i::zext32(g_thread_clut[((indices_array[0] >> shifts_array[0]) & mask)]);
+  pixels = pixels.insert16<2>(g_thread_clut[((indices_array[1] >> shifts_array[1]) & mask)]);
+  pixels = pixels.insert16<4>(g_thread_clut[((indices_array[2] >> shifts_array[2]) & mask)]);
+  pixels = pixels.insert16<6>(g_thread_clut[((indices_array[3] >> shifts_array[3]) & mask)]);
   return pixels;
 #endif
 }
@@ -486,8 +486,8 @@ struct PixelVectors
 
   PixelVectors(const GPUBackendDrawCommand* cmd)
   {
-    clip_left = GSVectorNi(g_drawing_area.left);
-    clip_right = GSVectorNi(g_drawing_area.right);
+    clip_left = GSVectorNi(g_thread_drawing_area->left);
+    clip_right = GSVectorNi(g_thread_drawing_area->right);
 
     mask_and = GSVectorNi(cmd->GetMaskAND());
     mask_or = GSVectorNi(cmd->GetMaskOR());
@@ -730,7 +730,7 @@ static void DrawRectangle(const GPUBackendDrawRectangleCommand* RESTRICT cmd)
   for (u32 offset_y = 0; offset_y < cmd->height; offset_y++)
   {
     const s32 y = origin_y + static_cast<s32>(offset_y);
-    if (y >= static_cast<s32>(g_drawing_area.top) && y <= static_cast<s32>(g_drawing_area.bottom) &&
+    if (y >= static_cast<s32>(g_thread_drawing_area->top) && y <= static_cast<s32>(g_thread_drawing_area->bottom) &&
         (!cmd->interlaced_rendering ||
          cmd->active_line_lsb != ConvertToBoolUnchecked(Truncate8(static_cast<u32>(y)) & 1u)))
     {
@@ -834,8 +834,8 @@ static void DrawLine(const GPUBackendDrawCommand* RESTRICT cmd, const GPUBackend
 
     if ((!cmd->interlaced_rendering ||
          cmd->active_line_lsb != ConvertToBoolUnchecked(Truncate8(static_cast<u32>(y)) & 1u)) &&
-        x >= static_cast<s32>(g_drawing_area.left) && x <= static_cast<s32>(g_drawing_area.right) &&
-        y >= static_cast<s32>(g_drawing_area.top) && y <= static_cast<s32>(g_drawing_area.bottom))
+        x >= static_cast<s32>(g_thread_drawing_area->left) && x <= static_cast<s32>(g_thread_drawing_area->right) &&
+        y >= static_cast<s32>(g_thread_drawing_area->top) && y <= static_cast<s32>(g_thread_drawing_area->bottom))
     {
       const u8 r = shading_enable ? unfp_rgb(curr) : p0->r;
       const u8 g = shading_enable ? unfp_rgb(curg) : p0->g;
@@ -991,16 +991,16 @@ static void DrawSpan(const GPUBackendDrawCommand* RESTRICT cmd, s32 y, s32 x_sta
   s32 current_x = TruncateGPUVertexPosition(x_start);
 
   // Skip pixels outside of the scissor rectangle.
-  if (current_x < static_cast<s32>(g_drawing_area.left))
+  if (current_x < static_cast<s32>(g_thread_drawing_area->left))
   {
-    const s32 delta = static_cast<s32>(g_drawing_area.left) - current_x;
+    const s32 delta = static_cast<s32>(g_thread_drawing_area->left) - current_x;
     x_start += delta;
     current_x += delta;
     width -= delta;
   }
 
-  if ((current_x + width) > (static_cast<s32>(g_drawing_area.right) + 1))
-    width = static_cast<s32>(g_drawing_area.right) + 1 - current_x;
+  if ((current_x + width) > (static_cast<s32>(g_thread_drawing_area->right) + 1))
+    width = static_cast<s32>(g_thread_drawing_area->right) + 1 - current_x;
 
   if (width <= 0)
     return;
@@ -1058,7 +1058,7 @@ ALWAYS_INLINE_RELEASE static void DrawTrianglePart(const GPUBackendDrawCommand*
       right_x -= right_x_step;
 
       const s32 y = TruncateGPUVertexPosition(current_y);
-      if (y < static_cast<s32>(g_drawing_area.top))
+      if (y < static_cast<s32>(g_thread_drawing_area->top))
         break;
 
       // Opposite direction means we need to subtract when stepping instead of adding.
@@ -1067,7 +1067,7 @@ ALWAYS_INLINE_RELEASE static void DrawTrianglePart(const GPUBackendDrawCommand*
       if constexpr (shading_enable)
         lrgb.StepY<true>(rgbstep);
 
-      if (y > static_cast<s32>(g_drawing_area.bottom) ||
+      if (y > static_cast<s32>(g_thread_drawing_area->bottom) ||
           (cmd->interlaced_rendering &&
            cmd->active_line_lsb == ConvertToBoolUnchecked(static_cast<u32>(current_y) & 1u)))
       {
@@ -1095,11 +1095,11 @@ ALWAYS_INLINE_RELEASE static void DrawTrianglePart(const GPUBackendDrawCommand*
     {
       const s32 y = TruncateGPUVertexPosition(current_y);
 
-      if (y > static_cast<s32>(g_drawing_area.bottom))
+      if (y > static_cast<s32>(g_thread_drawing_area->bottom))
       {
         break;
       }
-      if (y >= static_cast<s32>(g_drawing_area.top) &&
+      if (y >= static_cast<s32>(g_thread_drawing_area->top) &&
           (!cmd->interlaced_rendering ||
            cmd->active_line_lsb != ConvertToBoolUnchecked(static_cast<u32>(current_y) & 1u)))
       {
@@ -1173,16 +1173,16 @@ ALWAYS_INLINE_RELEASE static void DrawSpan(const GPUBackendDrawCommand* RESTRICT
   s32 current_x = TruncateGPUVertexPosition(x_start);
 
   // Skip pixels outside of the scissor rectangle.
-  if (current_x < static_cast<s32>(g_drawing_area.left))
+  if (current_x < static_cast<s32>(g_thread_drawing_area->left))
   {
-    const s32 delta = static_cast<s32>(g_drawing_area.left) - current_x;
+    const s32 delta = static_cast<s32>(g_thread_drawing_area->left) - current_x;
     x_start += delta;
     current_x += delta;
     width -= delta;
   }
 
-  if ((current_x + width) > (static_cast<s32>(g_drawing_area.right) + 1))
-    width = static_cast<s32>(g_drawing_area.right) + 1 - current_x;
+  if ((current_x + width) > (static_cast<s32>(g_thread_drawing_area->right) + 1))
+    width = static_cast<s32>(g_thread_drawing_area->right) + 1 - current_x;
 
   if (width <= 0)
     return;
@@ -1309,7 +1309,7 @@ ALWAYS_INLINE_RELEASE static void DrawTrianglePart(const GPUBackendDrawCommand*
       right_x -= right_x_step;
 
       const s32 y = TruncateGPUVertexPosition(current_y);
-      if (y < static_cast<s32>(g_drawing_area.top))
+      if (y < static_cast<s32>(g_thread_drawing_area->top))
         break;
 
       // Opposite direction means we need to subtract when stepping instead of adding.
@@ -1318,7 +1318,7 @@ ALWAYS_INLINE_RELEASE static void DrawTrianglePart(const GPUBackendDrawCommand*
       if constexpr (shading_enable)
         lrgb.StepY<true>(rgbstep);
 
-      if (y > static_cast<s32>(g_drawing_area.bottom) ||
+      if (y > static_cast<s32>(g_thread_drawing_area->bottom) ||
           (cmd->interlaced_rendering &&
            cmd->active_line_lsb == ConvertToBoolUnchecked(static_cast<u32>(current_y) & 1u)))
       {
@@ -1348,11 +1348,11 @@ ALWAYS_INLINE_RELEASE static void DrawTrianglePart(const GPUBackendDrawCommand*
     {
       const s32 y = TruncateGPUVertexPosition(current_y);
 
-      if (y > static_cast<s32>(g_drawing_area.bottom))
+      if (y > static_cast<s32>(g_thread_drawing_area->bottom))
       {
         break;
       }
-      if (y >= static_cast<s32>(g_drawing_area.top) &&
+      if (y >= static_cast<s32>(g_thread_drawing_area->top) &&
           (!cmd->interlaced_rendering ||
            cmd->active_line_lsb != ConvertToBoolUnchecked(static_cast<u32>(current_y) & 1u)))
       {
@@ -5,6 +5,7 @@
 #include "cpu_core.h"
 #include "cpu_core_private.h"
 #include "cpu_pgxp.h"
+#include "gte_batch.h"
 #include "host.h"
 #include "settings.h"
 
@@ -53,6 +54,13 @@ static constexpr float FREECAM_MAX_TURN_SPEED = 360.0f;
 
 namespace {
 
+enum class LightMode : u8
+{
+  None,  // NCS/NCT
+  Color, // NCCS/NCCT
+  Depth, // NCDS/NCDT
+};
+
 struct ALIGN_TO_CACHE_LINE Config
 {
   DisplayAspectRatio aspect_ratio = DisplayAspectRatio::R4_3;
@@ -221,12 +229,15 @@ static u32 UNRDivide(u32 lhs, u32 rhs);
 static void MulMatVec(const s16* M_, const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm);
 static void MulMatVec(const s16* M_, const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm);
 static void MulMatVecBuggy(const s16* M_, const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm);
+static void SetMACAndIR(const Batch::Accumulator& acc, u8 shift, bool lm);
 
 static void InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3, u8 shift, bool lm);
 static void RTPS(const s16 V[3], u8 shift, bool lm, bool last);
-static void NCS(const s16 V[3], u8 shift, bool lm);
-static void NCCS(const s16 V[3], u8 shift, bool lm);
-static void NCDS(const s16 V[3], u8 shift, bool lm);
+static void RTPSProject(const s16 V[3], s64 x, s64 y, s64 z, u8 shift, bool lm, bool last);
+template<u32 count>
+static void RTPBatch(u8 shift, bool lm);
+template<u32 count, LightMode mode>
+static void NCBatch(u8 shift, bool lm);
 static void DPCS(const u8 color[3], u8 shift, bool lm);
 
 #ifdef ENABLE_FREECAM
@@ -544,38 +555,32 @@ ALWAYS_INLINE u32 GTE::UNRDivide(u32 lhs, u32 rhs)
   return std::min<u32>(0x1FFFF, result);
 }
 
-void GTE::MulMatVec(const s16* M_, const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
+ALWAYS_INLINE void GTE::SetMACAndIR(const Batch::Accumulator& acc, u8 shift, bool lm)
 {
-#define M(i, j) M_[((i) * 3) + (j)]
-#define dot3(i)                                                                                                        \
-  TruncateAndSetMACAndIR<i + 1>(SignExtendMACResult<i + 1>((s64(M(i, 0)) * s64(Vx)) + (s64(M(i, 1)) * s64(Vy))) +      \
-                                  (s64(M(i, 2)) * s64(Vz)),                                                            \
-                                shift, lm)
+  u32 flags = Batch::GetMACFlags(acc);
+  const GSVector4i mac = Batch::GetMAC(acc, shift);
+  const GSVector4i ir = Batch::SaturateIR(mac, lm, &flags);
 
-  dot3(0);
-  dot3(1);
-  dot3(2);
+  REGS.MAC1 = mac.extract32<0>();
+  REGS.MAC2 = mac.extract32<1>();
+  REGS.MAC3 = mac.extract32<2>();
+  REGS.dr32[9] = ir.extract32<0>();
+  REGS.dr32[10] = ir.extract32<1>();
+  REGS.dr32[11] = ir.extract32<2>();
+  REGS.FLAG.bits |= flags;
+}
 
-#undef dot3
-#undef M
+void GTE::MulMatVec(const s16* M_, const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
+{
+  SetMACAndIR(
+    Batch::MulMatVec(Batch::LoadMatrix(M_), GSVector4i::zero(), Batch::LoadVector(Vx, Vy, Vz)), shift, lm);
 }
 
 void GTE::MulMatVec(const s16* M_, const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
 {
-#define M(i, j) M_[((i) * 3) + (j)]
-#define dot3(i)                                                                                                        \
-  TruncateAndSetMACAndIR<i + 1>(                                                                                       \
-    SignExtendMACResult<i + 1>(SignExtendMACResult<i + 1>((s64(T[i]) << 12) + (s64(M(i, 0)) * s64(Vx))) +              \
-                               (s64(M(i, 1)) * s64(Vy))) +                                                             \
-      (s64(M(i, 2)) * s64(Vz)),                                                                                        \
-    shift, lm)
-
-  dot3(0);
-  dot3(1);
-  dot3(2);
-
-#undef dot3
-#undef M
+  SetMACAndIR(
+    Batch::MulMatVec(Batch::LoadMatrix(M_), Batch::LoadVector(T[0], T[1], T[2]), Batch::LoadVector(Vx, Vy, Vz)),
+    shift, lm);
 }
 
 void GTE::MulMatVecBuggy(const s16* M_, const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
@@ -718,6 +723,55 @@ void GTE::RTPS(const s16 V[3], u8 shift, bool lm, bool last)
   REGS.dr32[11] = std::clamp(REGS.MAC3, lm ? 0 : IR123_MIN_VALUE, IR123_MAX_VALUE);
 #undef dot3
 
+  RTPSProject(V, x, y, z, shift, lm, last);
+}
+
+template<u32 count>
+void GTE::RTPBatch(u8 shift, bool lm)
+{
+  // Transform all vertices up front, the matrix and translation only need to be loaded once.
+  // x/y/z are only needed as 64-bit for PGXP, which can use the sign-extended value.
+  static constexpr const s16* V_lookup[3] = {REGS.V0, REGS.V1, REGS.V2};
+  const Batch::Matrix RT = Batch::LoadMatrix(&REGS.RT[0][0]);
+  const GSVector4i TR = Batch::LoadVector(REGS.TR[0], REGS.TR[1], REGS.TR[2]);
+  std::array<Batch::Accumulator, count> acc;
+  for (u32 i = 0; i < count; i++)
+  {
+    const s16* V = V_lookup[i];
+    acc[i] = Batch::MulMatVec(RT, TR, Batch::LoadVector(V[0], V[1], V[2]));
+  }
+
+  // The command does saturate IR1,IR2,IR3 to -8000h..+7FFFh (regardless of lm bit). When using RTP with sf=0, then the
+  // IR3 saturation flag (FLAG.22) gets set <only> if "MAC3 SAR 12" exceeds -8000h..+7FFFh (although IR3 is saturated
+  // when "MAC3" exceeds -8000h..+7FFFh).
+  const s32 ir_min = lm ? 0 : IR123_MIN_VALUE;
+  const GSVector4i min = GSVector4i::cxpr(ir_min);
+  const GSVector4i flag_min = GSVector4i(ir_min, ir_min, IR123_MIN_VALUE, 0);
+
+  for (u32 i = 0; i < count; i++)
+  {
+    const Batch::Accumulator& vacc = acc[i];
+    u32 flags = Batch::GetMACFlags(vacc);
+    const GSVector4i mac = Batch::GetMAC(vacc, shift);
+    const GSVector4i ir = Batch::SaturateIR(mac, min, mac.blend32<4>(vacc.hi), flag_min, &flags);
+
+    REGS.MAC1 = mac.extract32<0>();
+    REGS.MAC2 = mac.extract32<1>();
+    REGS.MAC3 = mac.extract32<2>();
+    REGS.dr32[9] = ir.extract32<0>();
+    REGS.dr32[10] = ir.extract32<1>();
+    REGS.dr32[11] = ir.extract32<2>();
+    REGS.FLAG.bits |= flags;
+
+    const s64 x = (s64(vacc.hi.extract32<0>()) << 12) | vacc.lo.extract32<0>();
+    const s64 y = (s64(vacc.hi.extract32<1>()) << 12) | vacc.lo.extract32<1>();
+    const s64 z = (s64(vacc.hi.extract32<2>()) << 12) | vacc.lo.extract32<2>();
+    RTPSProject(V_lookup[i], x, y, z, shift, lm, (i == (count - 1)));
+  }
+}
+
+void GTE::RTPSProject(const s16 V[3], s64 x, s64 y, s64 z, u8 shift, bool lm, bool last)
+{
   // SZ3 = MAC3 SAR ((1-sf)*12)                           ;ScreenZ FIFO 0..+FFFFh
   PushSZ(s32(z >> 12));
 
@@ -870,7 +924,15 @@ void GTE::RTPS(const s16 V[3], u8 shift, bool lm, bool last)
 void GTE::Execute_RTPS(Instruction inst)
 {
   REGS.FLAG.Clear();
-  RTPS(REGS.V0, inst.GetShift(), inst.lm, true);
+
+#ifdef ENABLE_FREECAM
+  // Freecam needs to adjust the full-precision position before it's truncated.
+  if (s_config.freecam_active)
+    RTPS(REGS.V0, inst.GetShift(), inst.lm, true);
+  else
+#endif
+    RTPBatch<1>(inst.GetShift(), inst.lm);
+
   REGS.FLAG.UpdateError();
 }
 
@@ -881,9 +943,18 @@ void GTE::Execute_RTPT(Instruction inst)
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
-  RTPS(REGS.V0, shift, lm, false);
-  RTPS(REGS.V1, shift, lm, false);
-  RTPS(REGS.V2, shift, lm, true);
+#ifdef ENABLE_FREECAM
+  if (s_config.freecam_active)
+  {
+    RTPS(REGS.V0, shift, lm, false);
+    RTPS(REGS.V1, shift, lm, false);
+    RTPS(REGS.V2, shift, lm, true);
+  }
+  else
+#endif
+  {
+    RTPBatch<3>(shift, lm);
+  }
 
   REGS.FLAG.UpdateError();
 }
@@ -951,23 +1022,64 @@ ALWAYS_INLINE void GTE::InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3,
   TruncateAndSetMACAndIR<3>(s64(s32(REGS.IR3) * s32(REGS.IR0)) + in_MAC3, shift, lm);
 }
 
-void GTE::NCS(const s16 V[3], u8 shift, bool lm)
+template<u32 count, GTE::LightMode mode>
+void GTE::NCBatch(u8 shift, bool lm)
 {
-  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
-  MulMatVec(&REGS.LLM[0][0], V[0], V[1], V[2], shift, lm);
+  // Neither light matrix changes between vertices, so both products are computed for every vertex up front. The
+  // first product's MAC/IR is always overwritten by the second, only its flags need to be kept.
+  static constexpr const s16* V_lookup[3] = {REGS.V0, REGS.V1, REGS.V2};
+  const Batch::Matrix LLM = Batch::LoadMatrix(&REGS.LLM[0][0]);
+  const Batch::Matrix LCM = Batch::LoadMatrix(&REGS.LCM[0][0]);
+  const GSVector4i BK = Batch::LoadVector(REGS.BK[0], REGS.BK[1], REGS.BK[2]);
+  std::array<Batch::Accumulator, count> acc;
+  u32 flags = 0;
+  for (u32 i = 0; i < count; i++)
+  {
+    // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
+    const s16* V = V_lookup[i];
+    const Batch::Accumulator lacc = Batch::MulMatVec(LLM, GSVector4i::zero(), Batch::LoadVector(V[0], V[1], V[2]));
+    flags |= Batch::GetMACFlags(lacc);
+    const GSVector4i ir = Batch::SaturateIR(Batch::GetMAC(lacc, shift), lm, &flags);
+
+    // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
+    acc[i] = Batch::MulMatVec(LCM, BK, ir);
+  }
+  REGS.FLAG.bits |= flags;
 
-  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(&REGS.LCM[0][0], REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
+  for (u32 i = 0; i < count; i++)
+  {
+    SetMACAndIR(acc[i], shift, lm);
 
-  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
-  PushRGBFromMAC();
+    if constexpr (mode == LightMode::Color)
+    {
+      // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
+      // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)       ;<--- for NCDx/NCCx
+      TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4, shift, lm);
+      TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4, shift, lm);
+      TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4, shift, lm);
+    }
+    else if constexpr (mode == LightMode::Depth)
+    {
+      // No need to assign these to MAC[1-3], as it'll never overflow.
+      // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
+      const s32 in_MAC1 = (s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4;
+      const s32 in_MAC2 = (s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4;
+      const s32 in_MAC3 = (s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4;
+
+      // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for NCDx only
+      InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+    }
+
+    // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
+    PushRGBFromMAC();
+  }
 }
 
 void GTE::Execute_NCS(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  NCS(REGS.V0, inst.GetShift(), inst.lm);
+  NCBatch<1, LightMode::None>(inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
@@ -976,39 +1088,16 @@ void GTE::Execute_NCT(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  const u8 shift = inst.GetShift();
-  const bool lm = inst.lm;
-
-  NCS(REGS.V0, shift, lm);
-  NCS(REGS.V1, shift, lm);
-  NCS(REGS.V2, shift, lm);
+  NCBatch<3, LightMode::None>(inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
 
-void GTE::NCCS(const s16 V[3], u8 shift, bool lm)
-{
-  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
-  MulMatVec(&REGS.LLM[0][0], V[0], V[1], V[2], shift, lm);
-
-  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(&REGS.LCM[0][0], REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
-
-  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
-  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)       ;<--- for NCDx/NCCx
-  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4, shift, lm);
-
-  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
-  PushRGBFromMAC();
-}
-
 void GTE::Execute_NCCS(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  NCCS(REGS.V0, inst.GetShift(), inst.lm);
+  NCBatch<1, LightMode::Color>(inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
@@ -1017,42 +1106,16 @@ void GTE::Execute_NCCT(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  const u8 shift = inst.GetShift();
-  const bool lm = inst.lm;
-
-  NCCS(REGS.V0, shift, lm);
-  NCCS(REGS.V1, shift, lm);
-  NCCS(REGS.V2, shift, lm);
+  NCBatch<3, LightMode::Color>(inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
 
-void GTE::NCDS(const s16 V[3], u8 shift, bool lm)
-{
-  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
-  MulMatVec(&REGS.LLM[0][0], V[0], V[1], V[2], shift, lm);
-
-  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(&REGS.LCM[0][0], REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
-
-  // No need to assign these to MAC[1-3], as it'll never overflow.
-  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
-  const s32 in_MAC1 = (s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4;
-  const s32 in_MAC2 = (s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4;
-  const s32 in_MAC3 = (s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4;
-
-  // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for NCDx only
-  InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
-
-  // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
-  PushRGBFromMAC();
-}
-
 void GTE::Execute_NCDS(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  NCDS(REGS.V0, inst.GetShift(), inst.lm);
+  NCBatch<1, LightMode::Depth>(inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
@@ -1061,12 +1124,7 @@ void GTE::Execute_NCDT(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  const u8 shift = inst.GetShift();
-  const bool lm = inst.lm;
-
-  NCDS(REGS.V0, shift, lm);
-  NCDS(REGS.V1, shift, lm);
-  NCDS(REGS.V2, shift, lm);
+  NCBatch<3, LightMode::Depth>(inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#pragma once
+
+#include "common/gsvector.h"
+#include "common/types.h"
+
+// Vectorized matrix * vector products for the GTE, with MAC1-3 in lanes 0-2.
+//
+// The hardware accumulates into 44-bit registers, checking for overflow after each addition. Instead of using 64-bit
+// lanes, the accumulator is split at the 12-bit fraction: hi holds the bits above, lo the 12 bits below. Overflowing
+// 44 bits is then exactly a signed overflow of the 32-bit hi addition, and the wrapped hi value matches what the
+// 44-bit sign extension produces. MAC/IR/FLAG results are bit-identical to the scalar s64 implementation.
+namespace GTE::Batch {
+
+// Must match GTE::FLAGS.
+enum : u32
+{
+  FLAG_MAC1_OVERFLOW_BIT = 30,
+  FLAG_MAC1_UNDERFLOW_BIT = 27,
+  FLAG_IR1_SATURATED_BIT = 24,
+};
+
+static constexpr s32 IR_MIN_VALUE = -0x8000;
+static constexpr s32 IR_MAX_VALUE = 0x7FFF;
+
+/// 3x3 matrix, stored as columns so each column can be multiplied by one vector component.
+struct Matrix
+{
+  GSVector4i col0;
+  GSVector4i col1;
+  GSVector4i col2;
+};
+
+struct Accumulator
+{
+  GSVector4i hi;
+  GSVector4i lo;
+
+  // Sign bit set in lanes which overflowed/underflowed at any step.
+  GSVector4i overflow;
+  GSVector4i underflow;
+};
+
+ALWAYS_INLINE static Matrix LoadMatrix(const s16* M)
+{
+  return Matrix{GSVector4i(M[0], M[3], M[6], 0), GSVector4i(M[1], M[4], M[7], 0), GSVector4i(M[2], M[5], M[8], 0)};
+}
+
+ALWAYS_INLINE static GSVector4i LoadVector(s32 x, s32 y, s32 z)
+{
+  return GSVector4i(x, y, z, 0);
+}
+
+/// Starts accumulating with T SHL 12.
+ALWAYS_INLINE static Accumulator Begin(const GSVector4i& T)
+{
+  const GSVector4i zero = GSVector4i::zero();
+  return Accumulator{T, zero, zero, zero};
+}
+
+/// Adds a product which fits in 32 bits, i.e. s16 * s16, and checks for 44-bit overflow.
+ALWAYS_INLINE static void Add(Accumulator& acc, const GSVector4i& product)
+{
+  const GSVector4i lo = acc.lo.add32(product & GSVector4i::cxpr(0xFFF));
+  const GSVector4i carry = product.sra32<12>().add32(lo.srl32<12>());
+  const GSVector4i hi = acc.hi.add32(carry);
+
+  // Signed overflow if both inputs have a different sign to the result. Direction comes from the addend's sign, since
+  // it can only push the value further in that direction.
+  const GSVector4i overflowed = (acc.hi ^ hi) & (carry ^ hi);
+  acc.overflow = acc.overflow | overflowed.andnot(carry);
+  acc.underflow = acc.underflow | (overflowed & carry);
+
+  acc.hi = hi;
+  acc.lo = lo & GSVector4i::cxpr(0xFFF);
+}
+
+/// (T SHL 12) + M * V, in the same order as the hardware.
+ALWAYS_INLINE static Accumulator MulMatVec(const Matrix& M, const GSVector4i& T, const GSVector4i& V)
+{
+  Accumulator acc = Begin(T);
+  Add(acc, M.col0.mul32l(V.xxxx()));
+  Add(acc, M.col1.mul32l(V.yyyy()));
+  Add(acc, M.col2.mul32l(V.zzzz()));
+  return acc;
+}
+
+/// MAC SAR shift, truncated to 32 bits. Shift must be 0 or 12.
+ALWAYS_INLINE static GSVector4i GetMAC(const Accumulator& acc, u8 shift)
+{
+  return (shift != 0) ? acc.hi : (acc.hi.sll32<12>() | acc.lo);
+}
+
+/// Spreads the sign bits of lanes 0-2 to consecutive descending FLAG bits, starting at lane0_bit.
+template<u32 lane0_bit>
+ALWAYS_INLINE static u32 LaneMaskToFlags(const GSVector4i& v)
+{
+  const u32 mask = static_cast<u32>(GSVector4::cast(v).mask());
+  return ((mask & 1u) << lane0_bit) | ((mask & 2u) << (lane0_bit - 2)) | ((mask & 4u) << (lane0_bit - 4));
+}
+
+ALWAYS_INLINE static u32 GetMACFlags(const Accumulator& acc)
+{
+  return LaneMaskToFlags<FLAG_MAC1_OVERFLOW_BIT>(acc.overflow) |
+         LaneMaskToFlags<FLAG_MAC1_UNDERFLOW_BIT>(acc.underflow);
+}
+
+/// Saturates value to IR1-3, flagging lanes where flag_value is out of range. flag_min is usually the same as min,
+/// but RTPS checks IR3 against MAC3 SAR 12 without lm.
+ALWAYS_INLINE static GSVector4i SaturateIR(const GSVector4i& value, const GSVector4i& min, const GSVector4i& flag_value,
+                                           const GSVector4i& flag_min, u32* flags)
+{
+  const GSVector4i max = GSVector4i::cxpr(IR_MAX_VALUE);
+  *flags |= LaneMaskToFlags<FLAG_IR1_SATURATED_BIT>(flag_value.lt32(flag_min) | flag_value.gt32(max));
+  return value.max_s32(min).min_s32(max);
+}
+
+ALWAYS_INLINE static GSVector4i SaturateIR(const GSVector4i& value, bool lm, u32* flags)
+{
+  const GSVector4i min = GSVector4i::cxpr(lm ? 0 : IR_MIN_VALUE);
+  return SaturateIR(value, min, value, min, flags);
+}
+
+} // namespace GTE::Batch
@@ -17,12 +17,27 @@
 
 #include "imgui.h"
 
+#include "cpuinfo.h"
+
 #include <array>
 #include <memory>
 
 LOG_CHANNEL(MDEC);
 
 namespace MDEC {
+
+using IDCTBlocksFunction = void (*)(s16* blocks, u32 count, const s16* matrix);
+
+namespace SIMD {
+#include "mdec_idct.inl"
+} // namespace SIMD
+
+#ifdef CPU_ARCH_SSE
+namespace AVX2 {
+extern const IDCTBlocksFunction IDCTBlocksPtr;
+} // namespace AVX2
+#endif
+
 namespace {
 
 static constexpr u32 DATA_IN_FIFO_SIZE = 1024;
@@ -119,7 +134,7 @@ static void YUVToRGB_Old(u32 xx, u32 yy, const std::array<s16, 64>& Crblk, const
                          const std::array<s16, 64>& Yblk);
 
 static bool DecodeRLE_New(s16* blk, const u8* qt);
-static void IDCT_New(s16* blk);
+static void IDCT_New(u32 first_block, u32 count);
 static void YUVToRGB_New(u32 xx, u32 yy, const std::array<s16, 64>& Crblk, const std::array<s16, 64>& Cbblk,
                          const std::array<s16, 64>& Yblk);
 
@@ -142,6 +157,7 @@ struct MDECState
   std::array<u8, 64> iq_y{};
 
   alignas(VECTOR_ALIGNMENT) std::array<s16, 64> scale_table{};
+  alignas(32) std::array<s16, SIMD::IDCT_MATRIX_SIZE> idct_matrix{};
 
   // blocks, for colour: 0 - Crblk, 1 - Cbblk, 2-5 - Y 1-4
   alignas(VECTOR_ALIGNMENT) std::array<std::array<s16, 64>, NUM_BLOCKS> blocks;
@@ -157,10 +173,15 @@ struct MDECState
 } // namespace
 
 ALIGN_TO_CACHE_LINE static MDECState s_state;
+static IDCTBlocksFunction s_idct_blocks = &SIMD::IDCTBlocks;
 } // namespace MDEC
 
 void MDEC::Initialize()
 {
+#ifdef CPU_ARCH_SSE
+  s_idct_blocks = cpuinfo_has_x86_avx2() ? AVX2::IDCTBlocksPtr : &SIMD::IDCTBlocks;
+#endif
+
   s_state.total_blocks_decoded = 0;
   Reset();
 }
@@ -197,6 +218,8 @@ bool MDEC::DoState(StateWrapper& sw)
   else
   {
     sw.Do(&s_state.scale_table);
+    if (sw.IsReading())
+      SIMD::BuildIDCTMatrix(s_state.idct_matrix.data(), s_state.scale_table.data());
   }
 
   sw.Do(&s_state.blocks);
@@ -537,7 +560,7 @@ bool MDEC::DecodeMonoMacroblock()
     if (!DecodeRLE_New(s_state.blocks[0].data(), s_state.iq_y.data()))
       return false;
 
-    IDCT_New(s_state.blocks[0].data());
+    IDCT_New(0, 1);
   }
 
   DEBUG_LOG("Decoded mono macroblock, {} words remaining", s_state.remaining_halfwords / 2);
@@ -580,15 +603,21 @@ bool MDEC::DecodeColoredMacroblock()
   }
   else
   {
+    // Transform all blocks decoded in this call together. Blocks before current_block must be transformed on return,
+    // so that save states don't depend on when the data arrived.
+    const u32 first_block = s_state.current_block;
     for (; s_state.current_block < NUM_BLOCKS; s_state.current_block++)
     {
       if (!DecodeRLE_New(s_state.blocks[s_state.current_block].data(),
                          (s_state.current_block >= 2) ? s_state.iq_y.data() : s_state.iq_uv.data()))
+      {
+        IDCT_New(first_block, s_state.current_block - first_block);
         return false;
-
-      IDCT_New(s_state.blocks[s_state.current_block].data());
+      }
     }
 
+    IDCT_New(first_block, NUM_BLOCKS - first_block);
+
     if (!s_state.data_out_fifo.IsEmpty())
       return false;
 
@@ -1016,30 +1045,11 @@ bool MDEC::DecodeRLE_New(s16* blk, const u8* qt)
   return false;
 }
 
-static s16 IDCTRow(const s16* blk, const s16* idct_matrix)
-{
-  // IDCT matrix is -32768..32767, block is -16384..16383. 4 adds can happen without overflow.
-  GSVector4i sum = GSVector4i::load<false>(blk).madd_s16(GSVector4i::load<true>(idct_matrix)).addp_s32();
-  return static_cast<s16>(((static_cast<s64>(sum.extract32<0>()) + static_cast<s64>(sum.extract32<1>())) + 0x20000) >>
-                          18);
-}
-
-void MDEC::IDCT_New(s16* blk)
+void MDEC::IDCT_New(u32 first_block, u32 count)
 {
-  alignas(VECTOR_ALIGNMENT) std::array<s16, 64> temp;
-  for (u32 x = 0; x < 8; x++)
-  {
-    for (u32 y = 0; y < 8; y++)
-      temp[y * 8 + x] = IDCTRow(&blk[x * 8], &s_state.scale_table[y * 8]);
-  }
-  for (u32 x = 0; x < 8; x++)
-  {
-    for (u32 y = 0; y < 8; y++)
-    {
-      const s32 sum = IDCTRow(&temp[x * 8], &s_state.scale_table[y * 8]);
-      blk[x * 8 + y] = static_cast<s16>(std::clamp(SignExtendN<9, s32>(sum), -128, 127));
-    }
-  }
+  // Blocks are contiguous.
+  if (count > 0)
+    s_idct_blocks(s_state.blocks[first_block].data(), count, s_state.idct_matrix.data());
 }
 
 void MDEC::YUVToRGB_New(u32 xx, u32 yy, const std::array<s16, 64>& Crblk, const std::array<s16, 64>& Cbblk,
@@ -1123,6 +1133,8 @@ void MDEC::SetScaleMatrix(const u16* values)
     for (u32 x = 0; x < 8; x++)
       s_state.scale_table[y * 8 + x] = values[x * 8 + y];
   }
+
+  SIMD::BuildIDCTMatrix(s_state.idct_matrix.data(), s_state.scale_table.data());
 }
 
 void MDEC::DrawDebugStateWindow(float scale)
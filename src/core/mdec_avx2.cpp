@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+#include "common/intrin.h"
+#include "common/types.h"
+
+// This file is compiled with AVX2 enabled, and must only be called after checking for support.
+//
+// Everything here is written with raw intrinsics and has internal linkage. Shared inline code (GSVector, std
+// templates) would be emitted as mergeable definitions compiled with AVX2, which the linker is free to pick over the
+// baseline copies used by the rest of the program. The only exported symbol is IDCTBlocksPtr.
+#ifdef CPU_ARCH_SSE
+
+#ifndef CPU_ARCH_AVX2
+#error This file must be compiled with AVX2 enabled.
+#endif
+
+namespace MDEC::AVX2 {
+
+namespace {
+
+/// (s64(p0) + s64(p1) + 0x20000) >> 18, without needing 64-bit lanes. Same as IDCTCombine() in mdec_idct.inl.
+ALWAYS_INLINE __m256i IDCTCombine(__m256i p0, __m256i p1)
+{
+  const __m256i mask = _mm256_set1_epi32(0x3FFFF);
+  const __m256i hi = _mm256_add_epi32(_mm256_srai_epi32(p0, 18), _mm256_srai_epi32(p1, 18));
+  const __m256i lo = _mm256_add_epi32(_mm256_add_epi32(_mm256_and_si256(p0, mask), _mm256_and_si256(p1, mask)),
+                                      _mm256_set1_epi32(0x20000));
+  return _mm256_add_epi32(hi, _mm256_srai_epi32(lo, 18));
+}
+
+/// Returns the dot product of the row with each row of the scale table. Each pair of elements is broadcast, and
+/// multiplied with the same pair of scale table columns in all eight rows.
+ALWAYS_INLINE __m128i IDCTRow(__m128i row, const __m256i* matrix)
+{
+  const __m256i brow = _mm256_broadcastsi128_si256(row);
+  const __m256i p0 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(brow, 0x00), matrix[0]),
+                                      _mm256_madd_epi16(_mm256_shuffle_epi32(brow, 0x55), matrix[1]));
+  const __m256i p1 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(brow, 0xAA), matrix[2]),
+                                      _mm256_madd_epi16(_mm256_shuffle_epi32(brow, 0xFF), matrix[3]));
+
+  // Results are within -0x4000..0x4000, so packing doesn't saturate.
+  const __m256i res = IDCTCombine(p0, p1);
+  return _mm_packs_epi32(_mm256_castsi256_si128(res), _mm256_extracti128_si256(res, 1));
+}
+
+ALWAYS_INLINE void IDCTTranspose(__m128i* rows)
+{
+  const __m128i t0 = _mm_unpacklo_epi16(rows[0], rows[1]);
+  const __m128i t1 = _mm_unpackhi_epi16(rows[0], rows[1]);
+  const __m128i t2 = _mm_unpacklo_epi16(rows[2], rows[3]);
+  const __m128i t3 = _mm_unpackhi_epi16(rows[2], rows[3]);
+  const __m128i t4 = _mm_unpacklo_epi16(rows[4], rows[5]);
+  const __m128i t5 = _mm_unpackhi_epi16(rows[4], rows[5]);
+  const __m128i t6 = _mm_unpacklo_epi16(rows[6], rows[7]);
+  const __m128i t7 = _mm_unpackhi_epi16(rows[6], rows[7]);
+
+  const __m128i u0 = _mm_unpacklo_epi32(t0, t2);
+  const __m128i u1 = _mm_unpackhi_epi32(t0, t2);
+  const __m128i u2 = _mm_unpacklo_epi32(t1, t3);
+  const __m128i u3 = _mm_unpackhi_epi32(t1, t3);
+  const __m128i u4 = _mm_unpacklo_epi32(t4, t6);
+  const __m128i u5 = _mm_unpackhi_epi32(t4, t6);
+  const __m128i u6 = _mm_unpacklo_epi32(t5, t7);
+  const __m128i u7 = _mm_unpackhi_epi32(t5, t7);
+
+  rows[0] = _mm_unpacklo_epi64(u0, u4);
+  rows[1] = _mm_unpackhi_epi64(u0, u4);
+  rows[2] = _mm_unpacklo_epi64(u1, u5);
+  rows[3] = _mm_unpackhi_epi64(u1, u5);
+  rows[4] = _mm_unpacklo_epi64(u2, u6);
+  rows[5] = _mm_unpackhi_epi64(u2, u6);
+  rows[6] = _mm_unpacklo_epi64(u3, u7);
+  rows[7] = _mm_unpackhi_epi64(u3, u7);
+}
+
+/// Transforms count consecutive 8x8 blocks in-place, see IDCTBlocks() in mdec_idct.inl.
+void IDCTBlocks(s16* blocks, u32 count, const s16* matrix)
+{
+  const __m256i mat[4] = {
+    _mm256_load_si256(reinterpret_cast<const __m256i*>(&matrix[0])),
+    _mm256_load_si256(reinterpret_cast<const __m256i*>(&matrix[16])),
+    _mm256_load_si256(reinterpret_cast<const __m256i*>(&matrix[32])),
+    _mm256_load_si256(reinterpret_cast<const __m256i*>(&matrix[48])),
+  };
+  const __m128i min = _mm_set1_epi16(-128);
+  const __m128i max = _mm_set1_epi16(127);
+
+  for (u32 i = 0; i < count; i++)
+  {
+    __m128i* const blk = reinterpret_cast<__m128i*>(&blocks[i * 64]);
+
+    // First pass produces the transpose of the intermediate block.
+    __m128i rows[8];
+    for (u32 x = 0; x < 8; x++)
+      rows[x] = IDCTRow(_mm_load_si128(&blk[x]), mat);
+
+    IDCTTranspose(rows);
+
+    // clamp(sext9(sum), -128, 127)
+    for (u32 x = 0; x < 8; x++)
+    {
+      const __m128i res = _mm_srai_epi16(_mm_slli_epi16(IDCTRow(rows[x], mat), 7), 7);
+      _mm_store_si128(&blk[x], _mm_min_epi16(_mm_max_epi16(res, min), max));
+    }
+  }
+}
+
+} // namespace
+
+using IDCTBlocksFunction = void (*)(s16* blocks, u32 count, const s16* matrix);
+extern const IDCTBlocksFunction IDCTBlocksPtr;
+constinit const IDCTBlocksFunction IDCTBlocksPtr = &IDCTBlocks;
+
+} // namespace MDEC::AVX2
+
+#endif // CPU_ARCH_SSE
@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2019-2024 Connor McLaughlin <stenzek@gmail.com>
+// SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+// Vectorized MDEC IDCT, included inside a namespace. mdec_avx2.cpp has an AVX2 version of the same transform.
+//
+// Output is bit-exact with the scalar implementation, where each output is the sum of two 32-bit dot products of four
+// elements (which can wrap), added together as 64-bit and rounded.
+
+#ifdef __INTELLISENSE__
+
+#include "common/gsvector.h"
+
+#endif
+
+/// Scale table with each pair of columns interleaved, so that rows can be multiplied with madd_s16().
+/// matrix[k * 16 + y * 2 + i] = scale_table[y * 8 + k * 2 + i]
+static constexpr u32 IDCT_MATRIX_SIZE = 64;
+
+ALWAYS_INLINE static void BuildIDCTMatrix(s16* matrix, const s16* scale_table)
+{
+  for (u32 k = 0; k < 4; k++)
+  {
+    for (u32 y = 0; y < 8; y++)
+    {
+      matrix[k * 16 + y * 2 + 0] = scale_table[y * 8 + k * 2 + 0];
+      matrix[k * 16 + y * 2 + 1] = scale_table[y * 8 + k * 2 + 1];
+    }
+  }
+}
+
+/// (s64(p0) + s64(p1) + 0x20000) >> 18, without needing 64-bit lanes.
+ALWAYS_INLINE static GSVector4i IDCTCombine(const GSVector4i& p0, const GSVector4i& p1)
+{
+  const GSVector4i mask = GSVector4i::cxpr(0x3FFFF);
+  const GSVector4i hi = p0.sra32<18>().add32(p1.sra32<18>());
+  const GSVector4i lo = (p0 & mask).add32(p1 & mask).add32(GSVector4i::cxpr(0x20000));
+  return hi.add32(lo.sra32<18>());
+}
+
+/// Returns the dot product of the row with each row of the scale table.
+ALWAYS_INLINE static GSVector4i IDCTRow(const GSVector4i& row, const s16* matrix)
+{
+  // Each pair of elements is broadcast, and multiplied with the same pair of scale table columns in four rows.
+  const GSVector4i b0 = row.xxxx();
+  const GSVector4i b1 = row.yyyy();
+  const GSVector4i b2 = row.zzzz();
+  const GSVector4i b3 = row.wwww();
+  const GSVector4i p0_lo = b0.madd_s16(GSVector4i::load<true>(&matrix[0]))
+                             .add32(b1.madd_s16(GSVector4i::load<true>(&matrix[16])));
+  const GSVector4i p1_lo = b2.madd_s16(GSVector4i::load<true>(&matrix[32]))
+                             .add32(b3.madd_s16(GSVector4i::load<true>(&matrix[48])));
+  const GSVector4i p0_hi = b0.madd_s16(GSVector4i::load<true>(&matrix[8]))
+                             .add32(b1.madd_s16(GSVector4i::load<true>(&matrix[24])));
+  const GSVector4i p1_hi = b2.madd_s16(GSVector4i::load<true>(&matrix[40]))
+                             .add32(b3.madd_s16(GSVector4i::load<true>(&matrix[56])));
+
+  // Results are within -0x4000..0x4000, so packing doesn't saturate.
+  return IDCTCombine(p0_lo, p1_lo).ps32(IDCTCombine(p0_hi, p1_hi));
+}
+
+ALWAYS_INLINE static void IDCTTranspose(GSVector4i* rows)
+{
+  const GSVector4i t0 = rows[0].upl16(rows[1]);
+  const GSVector4i t1 = rows[0].uph16(rows[1]);
+  const GSVector4i t2 = rows[2].upl16(rows[3]);
+  const GSVector4i t3 = rows[2].uph16(rows[3]);
+  const GSVector4i t4 = rows[4].upl16(rows[5]);
+  const GSVector4i t5 = rows[4].uph16(rows[5]);
+  const GSVector4i t6 = rows[6].upl16(rows[7]);
+  const GSVector4i t7 = rows[6].uph16(rows[7]);
+
+  const GSVector4i u0 = t0.upl32(t2);
+  const GSVector4i u1 = t0.uph32(t2);
+  const GSVector4i u2 = t1.upl32(t3);
+  const GSVector4i u3 = t1.uph32(t3);
+  const GSVector4i u4 = t4.upl32(t6);
+  const GSVector4i u5 = t4.uph32(t6);
+  const GSVector4i u6 = t5.upl32(t7);
+  const GSVector4i u7 = t5.uph32(t7);
+
+  rows[0] = u0.upl64(u4);
+  rows[1] = u0.uph64(u4);
+  rows[2] = u1.upl64(u5);
+  rows[3] = u1.uph64(u5);
+  rows[4] = u2.upl64(u6);
+  rows[5] = u2.uph64(u6);
+  rows[6] = u3.upl64(u7);
+  rows[7] = u3.uph64(u7);
+}
+
+/// Transforms count consecutive 8x8 blocks in-place. Blocks and the matrix must be vector-aligned.
+static void IDCTBlocks(s16* blocks, u32 count, const s16* matrix)
+{
+  for (u32 i = 0; i < count; i++)
+  {
+    s16* const blk = &blocks[i * 64];
+
+    // First pass produces the transpose of the intermediate block.
+    GSVector4i rows[8];
+    for (u32 x = 0; x < 8; x++)
+      rows[x] = IDCTRow(GSVector4i::load<true>(&blk[x * 8]), matrix);
+
+    IDCTTranspose(rows);
+
+    // clamp(sext9(sum), -128, 127)
+    for (u32 x = 0; x < 8; x++)
+    {
+      const GSVector4i res = IDCTRow(rows[x], matrix).sll16<7>().sra16<7>();
+      GSVector4i::store<true>(&blk[x * 8], res.max_s16(GSVector4i::cxpr16(-128)).min_s16(GSVector4i::cxpr16(127)));
+    }
+  }
+}
@@ -18,13 +18,32 @@
 #include "IconsFontAwesome5.h"
 #include "fmt/format.h"
 
+#include <atomic>
+#include <mutex>
+
 LOG_CHANNEL(MemoryCard);
 
+struct MemoryCard::SaveFileState
+{
+  // Writes can run concurrently on different workers, so they're serialized here, and a write is skipped if a newer
+  // snapshot of the card has already been written.
+  std::mutex mutex;
+  u32 queued_generation = 0;
+  u32 written_generation = 0;
+
+  // Contents of the file on disk, so unchanged cards aren't rewritten.
+  std::string file_path;
+  MemoryCardImage::DataArray file_data;
+};
+
+static std::atomic<u32> s_outstanding_saves{0};
+
 MemoryCard::MemoryCard()
   : m_save_event(
       "Memory Card Host Flush", GetSaveDelayInTicks(), GetSaveDelayInTicks(),
       [](void* param, TickCount ticks, TickCount ticks_late) { static_cast<MemoryCard*>(param)->SaveIfChanged(true); },
-      this)
+      this),
+    m_save_file_state(std::make_shared<SaveFileState>())
 {
   m_FLAG.no_write_yet = true;
 }
@@ -300,6 +319,9 @@ std::unique_ptr<MemoryCard> MemoryCard::Open(std::string_view path)
   std::unique_ptr<MemoryCard> mc = std::make_unique<MemoryCard>();
   mc->m_path = path;
 
+  // The card could have just been ejected, make sure we read what it wrote.
+  FlushSaves();
+
   Error error;
   if (!FileSystem::FileExists(mc->m_path.c_str())) [[unlikely]]
   {
@@ -318,10 +340,21 @@ std::unique_ptr<MemoryCard> MemoryCard::Open(std::string_view path)
     mc->m_path = {};
     mc->m_changed = false;
   }
+  else
+  {
+    mc->m_save_file_state->file_path = mc->m_path;
+    mc->m_save_file_state->file_data = mc->m_data;
+  }
 
   return mc;
 }
 
+void MemoryCard::FlushSaves()
+{
+  while (s_outstanding_saves.load(std::memory_order_acquire) > 0)
+    System::WaitForAllAsyncTasks();
+}
+
 void MemoryCard::Format()
 {
   MemoryCardImage::Format(&m_data);
@@ -340,19 +373,66 @@ bool MemoryCard::SaveIfChanged(bool display_osd_message)
   if (m_path.empty())
     return false;
 
+  // Writing can take a while on slow or network storage, so do it on a worker with a snapshot of the card.
+  const u32 generation = ++m_save_file_state->queued_generation;
+  s_outstanding_saves.fetch_add(1, std::memory_order_acq_rel);
+  System::QueueAsyncTask([state = m_save_file_state, data = m_data, path = m_path, generation, display_osd_message]() {
+    WriteFile(state.get(), data, path, generation, display_osd_message);
+    s_outstanding_saves.fetch_sub(1, std::memory_order_acq_rel);
+  });
+
+  return true;
+}
+
+void MemoryCard::WriteFile(SaveFileState* state, const MemoryCardImage::DataArray& data, const std::string& path,
+                           u32 generation, bool display_osd_message)
+{
+  std::unique_lock lock(state->mutex);
+  if (generation <= state->written_generation)
+  {
+    DEV_LOG("Skipping save of memory card {}, a newer copy has been written.", Path::GetFileTitle(path));
+    return;
+  }
+
+  state->written_generation = generation;
+
+  u32 changed_blocks = MemoryCardImage::NUM_BLOCKS;
+  if (state->file_path == path)
+  {
+    changed_blocks = 0;
+    for (u32 i = 0; i < MemoryCardImage::NUM_BLOCKS; i++)
+    {
+      const u32 offset = i * MemoryCardImage::BLOCK_SIZE;
+      changed_blocks += BoolToUInt32(std::memcmp(&data[offset], &state->file_data[offset],
+                                                 MemoryCardImage::BLOCK_SIZE) != 0);
+    }
+
+    // Games often rewrite the same data, e.g. when saving to the same slot.
+    if (changed_blocks == 0)
+    {
+      INFO_LOG("Not saving memory card to {}, contents are unchanged.", Path::GetFileTitle(path));
+      return;
+    }
+  }
+
   std::string osd_key;
   std::string display_name;
   if (display_osd_message)
   {
-    osd_key = fmt::format("memory_card_save_{}", m_path);
-    display_name = FileSystem::GetDisplayNameFromPath(m_path);
+    osd_key = fmt::format("memory_card_save_{}", path);
+    display_name = FileSystem::GetDisplayNameFromPath(path);
   }
 
-  INFO_LOG("Saving memory card to {}...", Path::GetFileTitle(m_path));
+  INFO_LOG("Saving memory card to {} ({} of {} blocks changed)...", Path::GetFileTitle(path), changed_blocks,
+           static_cast<u32>(MemoryCardImage::NUM_BLOCKS));
 
+  // Written in its entirety to a temporary file and renamed over the original, so a crash can't leave it torn.
   Error error;
-  if (!MemoryCardImage::SaveToFile(m_data, m_path.c_str(), &error))
+  if (!MemoryCardImage::SaveToFile(data, path.c_str(), &error))
   {
+    // Contents of the file are unknown now, so write everything next time.
+    state->file_path = {};
+
     if (display_osd_message)
     {
       Host::AddIconOSDMessage(std::move(osd_key), ICON_FA_SD_CARD,
@@ -361,9 +441,12 @@ bool MemoryCard::SaveIfChanged(bool display_osd_message)
                               Host::OSD_ERROR_DURATION);
     }
 
-    return false;
+    return;
   }
 
+  state->file_path = path;
+  state->file_data = data;
+
   if (display_osd_message)
   {
     Host::AddIconOSDMessage(
@@ -371,8 +454,6 @@ bool MemoryCard::SaveIfChanged(bool display_osd_message)
       fmt::format(TRANSLATE_FS("MemoryCard", "Saved memory card to '{}'."), Path::GetFileName(display_name)),
       Host::OSD_QUICK_DURATION);
   }
-
-  return true;
 }
 
 void MemoryCard::QueueFileSave()
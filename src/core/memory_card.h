@@ -25,6 +25,9 @@ public:
   static std::unique_ptr<MemoryCard> Create();
   static std::unique_ptr<MemoryCard> Open(std::string_view path);
 
+  /// Waits for any card writes which are in progress on the async task queue.
+  static void FlushSaves();
+
   const MemoryCardImage::DataArray& GetData() const { return m_data; }
   MemoryCardImage::DataArray& GetData() { return m_data; }
   const std::string& GetFilename() const { return m_path; }
@@ -93,7 +96,12 @@ private:
     GetID4,
   };
 
+  /// Shared with queued writes, which can outlive the card.
+  struct SaveFileState;
+
   static TickCount GetSaveDelayInTicks();
+  static void WriteFile(SaveFileState* state, const MemoryCardImage::DataArray& data, const std::string& path,
+                        u32 generation, bool display_osd_message);
 
   bool SaveIfChanged(bool display_osd_message);
   void QueueFileSave();
@@ -108,6 +116,7 @@ private:
 
   TimingEvent m_save_event;
   std::string m_path;
+  std::shared_ptr<SaveFileState> m_save_file_state;
 
   MemoryCardImage::DataArray m_data{};
 };
@@ -5,151 +5,384 @@
 #include "bus.h"
 #include "cpu_core.h"
 
+#include "common/align.h"
+#include "common/bitutils.h"
+#include "common/gsvector.h"
 #include "common/log.h"
 
 #include "fmt/format.h"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
 LOG_CHANNEL(Cheats);
 
-static bool IsValidScanAddress(PhysicalMemoryAddress address)
+/// Returns a pointer to the memory backing the specified address, and the number of bytes which can be accessed
+/// contiguously from it. For addresses which can't be scanned, returns nullptr and the number of bytes to skip.
+static const u8* GetScanMemoryPointer(PhysicalMemoryAddress address, u32* size)
 {
   if ((address & CPU::SCRATCHPAD_ADDR_MASK) == CPU::SCRATCHPAD_ADDR &&
       (address & CPU::SCRATCHPAD_OFFSET_MASK) < CPU::SCRATCHPAD_SIZE)
   {
-    return true;
+    const u32 offset = address & CPU::SCRATCHPAD_OFFSET_MASK;
+    *size = CPU::SCRATCHPAD_SIZE - offset;
+    return &CPU::g_state.scratchpad[offset];
   }
 
-  address &= CPU::PHYSICAL_MEMORY_ADDRESS_MASK;
+  const PhysicalMemoryAddress masked_address = address & CPU::PHYSICAL_MEMORY_ADDRESS_MASK;
 
-  if (address < Bus::RAM_MIRROR_END)
-    return true;
+  if (masked_address < Bus::RAM_MIRROR_END)
+  {
+    const u32 offset = masked_address & Bus::g_ram_mask;
+    *size = Bus::g_ram_size - offset;
+    return &Bus::g_unprotected_ram[offset];
+  }
 
-  if (address >= Bus::BIOS_BASE && address < (Bus::BIOS_BASE + Bus::BIOS_SIZE))
-    return true;
+  if (masked_address >= Bus::BIOS_BASE && masked_address < (Bus::BIOS_BASE + Bus::BIOS_SIZE))
+  {
+    const u32 offset = masked_address - Bus::BIOS_BASE;
+    *size = Bus::BIOS_SIZE - offset;
+    return &Bus::g_bios[offset];
+  }
 
-  return false;
+  // All scannable regions are aligned to at least 1KB.
+  *size = CPU::SCRATCHPAD_SIZE - (address & CPU::SCRATCHPAD_OFFSET_MASK);
+  return nullptr;
 }
 
-MemoryScan::MemoryScan() = default;
-
-MemoryScan::~MemoryScan() = default;
-
-void MemoryScan::ResetSearch()
+/// Loads four elements, extended to 32 bits in the same way as Result::value.
+template<MemoryAccessSize size>
+ALWAYS_INLINE static GSVector4i LoadElements(const u8* ptr, bool is_signed)
 {
-  m_results.clear();
+  if constexpr (size == MemoryAccessSize::Byte)
+  {
+    const GSVector4i v = GSVector4i::load32(ptr).u8to32();
+    return is_signed ? v.sll32<24>().sra32<24>() : v;
+  }
+  else if constexpr (size == MemoryAccessSize::HalfWord)
+  {
+    const GSVector4i v = GSVector4i::loadl<false>(ptr);
+    return is_signed ? v.s16to32() : v.u16to32();
+  }
+  else
+  {
+    return GSVector4i::load<false>(ptr);
+  }
 }
 
-void MemoryScan::Search()
+/// Vectorized version of Result::Filter(), returns a bit for each lane which passes.
+ALWAYS_INLINE static u32 FilterElements(MemoryScan::Operator op, const GSVector4i& value, const GSVector4i& last_value,
+                                        const GSVector4i& comp_value, bool is_signed)
 {
-  m_results.clear();
+  // Unsigned comparisons are done by flipping the sign bit.
+  const GSVector4i bias = GSVector4i::cxpr(is_signed ? 0 : static_cast<s32>(0x80000000u));
+  const auto gt = [&bias](const GSVector4i& lhs, const GSVector4i& rhs) { return (lhs ^ bias).gt32(rhs ^ bias); };
 
-  switch (m_size)
+  GSVector4i res;
+  switch (op)
   {
-    case MemoryAccessSize::Byte:
-      SearchBytes();
+    case MemoryScan::Operator::Equal:
+      res = value.eq32(comp_value);
       break;
 
-    case MemoryAccessSize::HalfWord:
-      SearchHalfwords();
+    case MemoryScan::Operator::NotEqual:
+      res = ~value.eq32(comp_value);
       break;
 
-    case MemoryAccessSize::Word:
-      SearchWords();
+    case MemoryScan::Operator::GreaterThan:
+      res = gt(value, comp_value);
       break;
 
-    default:
+    case MemoryScan::Operator::GreaterEqual:
+      res = ~gt(comp_value, value);
       break;
+
+    case MemoryScan::Operator::LessThan:
+      res = gt(comp_value, value);
+      break;
+
+    case MemoryScan::Operator::LessEqual:
+      res = ~gt(value, comp_value);
+      break;
+
+    case MemoryScan::Operator::IncreasedBy:
+      res = value.sub32(last_value).eq32(comp_value);
+      break;
+
+    case MemoryScan::Operator::DecreasedBy:
+      res = last_value.sub32(value).eq32(comp_value);
+      break;
+
+    case MemoryScan::Operator::ChangedBy:
+    {
+      GSVector4i diff;
+      if (is_signed)
+      {
+        const GSVector4i sdiff = last_value.sub32(value);
+        const GSVector4i sign = sdiff.sra32<31>();
+        diff = (sdiff ^ sign).sub32(sign);
+      }
+      else
+      {
+        diff = last_value.max_u32(value).sub32(last_value.min_u32(value));
+      }
+      res = diff.eq32(comp_value);
+    }
+    break;
+
+    case MemoryScan::Operator::EqualLast:
+      res = value.eq32(last_value);
+      break;
+
+    case MemoryScan::Operator::NotEqualLast:
+      res = ~value.eq32(last_value);
+      break;
+
+    case MemoryScan::Operator::GreaterThanLast:
+      res = gt(value, last_value);
+      break;
+
+    case MemoryScan::Operator::GreaterEqualLast:
+      res = ~gt(last_value, value);
+      break;
+
+    case MemoryScan::Operator::LessThanLast:
+      res = gt(last_value, value);
+      break;
+
+    case MemoryScan::Operator::LessEqualLast:
+      res = ~gt(value, last_value);
+      break;
+
+    case MemoryScan::Operator::Any:
+      return 0xF;
+
+    default:
+      return 0;
   }
+
+  return static_cast<u32>(GSVector4::cast(res).mask());
 }
 
-void MemoryScan::SearchBytes()
+/// Filters a block of 64 elements, returning a bit for each element which passes.
+template<MemoryAccessSize size>
+static u64 FilterBlock(const u8* values, const u8* last_values, MemoryScan::Operator op, u32 comp_value, bool is_signed)
 {
-  for (PhysicalMemoryAddress address = m_start_address; address < m_end_address; address++)
+  static constexpr u32 element_size = 1u << static_cast<u32>(size);
+  const GSVector4i comp = GSVector4i(static_cast<s32>(comp_value));
+
+  u64 mask = 0;
+  for (u32 i = 0; i < 64; i += 4)
   {
-    if (!IsValidScanAddress(address))
-      continue;
+    const GSVector4i value = LoadElements<size>(&values[i * element_size], is_signed);
+    const GSVector4i last_value = LoadElements<size>(&last_values[i * element_size], is_signed);
+    mask |= static_cast<u64>(FilterElements(op, value, last_value, comp, is_signed)) << i;
+  }
 
-    u8 bvalue = 0;
-    if (!CPU::SafeReadMemoryByte(address, &bvalue)) [[unlikely]]
-      continue;
+  return mask;
+}
 
-    Result res;
-    res.address = address;
-    res.value = m_signed ? SignExtend32(bvalue) : ZeroExtend32(bvalue);
-    res.last_value = res.value;
-    res.value_changed = false;
+MemoryScan::MemoryScan() = default;
 
-    if (res.Filter(m_operator, m_value, m_signed))
-      m_results.push_back(res);
-  }
+MemoryScan::~MemoryScan() = default;
+
+void MemoryScan::SetMaxResults(u32 count)
+{
+  m_max_results = count;
+  UpdateResults();
+}
+
+void MemoryScan::ResetSearch()
+{
+  m_results.clear();
+  m_ranges.clear();
+  m_snapshot = {};
+  m_candidates = {};
+  m_result_count = 0;
 }
 
-void MemoryScan::SearchHalfwords()
+void MemoryScan::Search()
 {
-  for (PhysicalMemoryAddress address = m_start_address; address < m_end_address; address += 2)
+  ResetSearch();
+
+  m_scan_size = m_size;
+  BuildRanges();
+  if (m_ranges.empty())
+    return;
+
+  const ScanRange& last_range = m_ranges.back();
+  const u32 num_elements = last_range.first_element + Common::AlignUpPow2(last_range.num_elements, 64);
+  m_snapshot.resize(num_elements * GetScanElementSize());
+  m_candidates.resize(num_elements / 64);
+
+  // Everything within the ranges starts out as a candidate.
+  for (const ScanRange& range : m_ranges)
   {
-    if (!IsValidScanAddress(address))
-      continue;
+    u64* words = &m_candidates[range.first_element / 64];
+    std::fill_n(words, range.num_elements / 64, ~static_cast<u64>(0));
+    if ((range.num_elements % 64) != 0)
+      words[range.num_elements / 64] = (static_cast<u64>(1) << (range.num_elements % 64)) - 1;
+  }
 
-    u16 bvalue = 0;
-    if (!CPU::SafeReadMemoryHalfWord(address, &bvalue)) [[unlikely]]
-      continue;
+  // The first search compares each value against itself, like Result::Filter() with last_value == value.
+  ReadRanges(m_snapshot.data());
+  FilterCandidates(m_snapshot.data(), m_snapshot.data());
+  UpdateResults();
+}
+
+void MemoryScan::SearchAgain()
+{
+  if (m_result_count == 0)
+    return;
+
+  std::vector<u8> values(m_snapshot.size());
+  ReadRanges(values.data());
+  FilterCandidates(values.data(), m_snapshot.data());
 
-    Result res;
-    res.address = address;
-    res.value = m_signed ? SignExtend32(bvalue) : ZeroExtend32(bvalue);
-    res.last_value = res.value;
-    res.value_changed = false;
+  // Remaining candidates compare against their current value next time.
+  m_snapshot.swap(values);
+  UpdateResults();
+}
+
+u32 MemoryScan::GetScanElementSize() const
+{
+  return 1u << static_cast<u32>(m_scan_size);
+}
+
+void MemoryScan::BuildRanges()
+{
+  const u32 element_size = GetScanElementSize();
+  const u64 end_address = m_end_address;
+  u64 address = m_start_address;
+  u32 next_element = 0;
+
+  while (address < end_address)
+  {
+    u32 size;
+    const u8* ptr = GetScanMemoryPointer(static_cast<PhysicalMemoryAddress>(address), &size);
+    const u64 run_size = std::min<u64>(size, end_address - address);
+
+    // Elements which straddle the end of a region are skipped.
+    const u32 num_elements = static_cast<u32>(run_size / element_size);
+    if (ptr && num_elements > 0)
+    {
+      m_ranges.push_back(ScanRange{static_cast<PhysicalMemoryAddress>(address), num_elements, next_element});
+      next_element += Common::AlignUpPow2(num_elements, 64);
+    }
 
-    if (res.Filter(m_operator, m_value, m_signed))
-      m_results.push_back(res);
+    // Stay on the element grid relative to the start address.
+    address += Common::AlignUpPow2(run_size, element_size);
   }
 }
 
-void MemoryScan::SearchWords()
+void MemoryScan::ReadRanges(u8* dst) const
 {
-  for (PhysicalMemoryAddress address = m_start_address; address < m_end_address; address += 4)
+  const u32 element_size = GetScanElementSize();
+  for (const ScanRange& range : m_ranges)
   {
-    if (!IsValidScanAddress(address))
+    // RAM size could have changed since the ranges were built.
+    u32 size;
+    const u8* ptr = GetScanMemoryPointer(range.address, &size);
+    if (!ptr) [[unlikely]]
       continue;
 
-    u32 bvalue = 0;
-    if (!CPU::SafeReadMemoryWord(address, &bvalue)) [[unlikely]]
+    std::memcpy(&dst[range.first_element * element_size], ptr, std::min(size, range.num_elements * element_size));
+  }
+}
+
+void MemoryScan::FilterCandidates(const u8* values, const u8* last_values)
+{
+  const u32 element_size = GetScanElementSize();
+  u32 result_count = 0;
+
+  for (u64& word : m_candidates)
+  {
+    // Most blocks are empty after a few searches.
+    if (word == 0 || m_operator == Operator::Any)
+    {
+      result_count += static_cast<u32>(std::popcount(word));
       continue;
+    }
 
-    Result res;
-    res.address = address;
-    res.value = bvalue;
-    res.last_value = res.value;
-    res.value_changed = false;
+    const size_t offset = static_cast<size_t>(&word - m_candidates.data()) * 64 * element_size;
+    switch (m_scan_size)
+    {
+      case MemoryAccessSize::Byte:
+        word &= FilterBlock<MemoryAccessSize::Byte>(&values[offset], &last_values[offset], m_operator, m_value,
+                                                     m_signed);
+        break;
+
+      case MemoryAccessSize::HalfWord:
+        word &= FilterBlock<MemoryAccessSize::HalfWord>(&values[offset], &last_values[offset], m_operator, m_value,
+                                                         m_signed);
+        break;
+
+      case MemoryAccessSize::Word:
+        word &= FilterBlock<MemoryAccessSize::Word>(&values[offset], &last_values[offset], m_operator, m_value,
+                                                     m_signed);
+        break;
+    }
 
-    if (res.Filter(m_operator, m_value, m_signed))
-      m_results.push_back(res);
+    result_count += static_cast<u32>(std::popcount(word));
   }
+
+  m_result_count = result_count;
 }
 
-void MemoryScan::SearchAgain()
+void MemoryScan::UpdateResults()
 {
-  ResultVector new_results;
-  new_results.reserve(m_results.size());
-  for (Result& res : m_results)
-  {
-    res.UpdateValue(m_size, m_signed);
+  m_results.clear();
 
-    if (res.Filter(m_operator, m_value, m_signed))
+  const u32 element_size = GetScanElementSize();
+  for (const ScanRange& range : m_ranges)
+  {
+    const u32 first_word = range.first_element / 64;
+    const u32 num_words = (range.num_elements + 63) / 64;
+    for (u32 word_index = first_word; word_index < (first_word + num_words); word_index++)
     {
-      res.last_value = res.value;
-      new_results.push_back(res);
+      u64 word = m_candidates[word_index];
+      while (word != 0)
+      {
+        if (m_results.size() >= m_max_results)
+          return;
+
+        const u32 element = word_index * 64 + CountTrailingZeros(word);
+        word &= word - 1;
+
+        const u8* value_ptr = &m_snapshot[element * element_size];
+        Result res;
+        res.address = range.address + (element - range.first_element) * element_size;
+        switch (m_scan_size)
+        {
+          case MemoryAccessSize::Byte:
+            res.value = m_signed ? SignExtend32(*value_ptr) : ZeroExtend32(*value_ptr);
+            break;
+
+          case MemoryAccessSize::HalfWord:
+          {
+            u16 value;
+            std::memcpy(&value, value_ptr, sizeof(value));
+            res.value = m_signed ? SignExtend32(value) : ZeroExtend32(value);
+          }
+          break;
+
+          case MemoryAccessSize::Word:
+            std::memcpy(&res.value, value_ptr, sizeof(res.value));
+            break;
+        }
+        res.last_value = res.value;
+        res.value_changed = false;
+        m_results.push_back(res);
+      }
     }
   }
-
-  m_results.swap(new_results);
 }
 
 void MemoryScan::UpdateResultsValues()
 {
   for (Result& res : m_results)
-    res.UpdateValue(m_size, m_signed);
+    res.UpdateValue(m_scan_size, m_signed);
 }
 
 void MemoryScan::SetResultValue(u32 index, u32 value)
@@ -161,7 +394,7 @@ void MemoryScan::SetResultValue(u32 index, u32 value)
   if (res.value == value)
     return;
 
-  switch (m_size)
+  switch (m_scan_size)
   {
     case MemoryAccessSize::Byte:
       CPU::SafeWriteMemoryByte(res.address, Truncate8(value));
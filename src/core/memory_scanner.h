@@ -46,6 +46,8 @@ public:
 
   using ResultVector = std::vector<Result>;
 
+  static constexpr u32 DEFAULT_MAX_RESULTS = 5000;
+
   MemoryScan();
   ~MemoryScan();
 
@@ -55,9 +57,12 @@ public:
   Operator GetOperator() const { return m_operator; }
   PhysicalMemoryAddress GetStartAddress() const { return m_start_address; }
   PhysicalMemoryAddress GetEndAddress() const { return m_end_address; }
+  u32 GetMaxResults() const { return m_max_results; }
+
+  /// Only the first GetMaxResults() matches are returned as Result objects, GetResultCount() is the total.
   const ResultVector& GetResults() const { return m_results; }
   const Result& GetResult(u32 index) const { return m_results[index]; }
-  u32 GetResultCount() const { return static_cast<u32>(m_results.size()); }
+  u32 GetResultCount() const { return m_result_count; }
 
   void SetValue(u32 value) { m_value = value; }
   void SetValueSigned(bool s) { m_signed = s; }
@@ -65,6 +70,7 @@ public:
   void SetOperator(Operator op) { m_operator = op; }
   void SetStartAddress(PhysicalMemoryAddress addr) { m_start_address = addr; }
   void SetEndAddress(PhysicalMemoryAddress addr) { m_end_address = addr; }
+  void SetMaxResults(u32 count);
 
   void ResetSearch();
   void Search();
@@ -74,9 +80,20 @@ public:
   void SetResultValue(u32 index, u32 value);
 
 private:
-  void SearchBytes();
-  void SearchHalfwords();
-  void SearchWords();
+  /// Contiguous run of scannable memory. Elements of all ranges are stored back-to-back in the snapshot and the
+  /// candidate bitmap, with each range starting on a 64-element boundary so that it owns whole bitmap words.
+  struct ScanRange
+  {
+    PhysicalMemoryAddress address;
+    u32 num_elements;
+    u32 first_element;
+  };
+
+  u32 GetScanElementSize() const;
+  void BuildRanges();
+  void ReadRanges(u8* dst) const;
+  void FilterCandidates(const u8* values, const u8* last_values);
+  void UpdateResults();
 
   u32 m_value = 0;
   MemoryAccessSize m_size = MemoryAccessSize::HalfWord;
@@ -85,6 +102,14 @@ private:
   PhysicalMemoryAddress m_end_address = 0x200000;
   ResultVector m_results;
   bool m_signed = false;
+
+  // Candidates are kept as one bit per element, along with the value of every element at the last search.
+  std::vector<ScanRange> m_ranges;
+  std::vector<u8> m_snapshot;
+  std::vector<u64> m_candidates;
+  MemoryAccessSize m_scan_size = MemoryAccessSize::HalfWord;
+  u32 m_result_count = 0;
+  u32 m_max_results = DEFAULT_MAX_RESULTS;
 };
 
 class MemoryWatchList
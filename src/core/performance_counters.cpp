@@ -7,6 +7,7 @@
 #include "gpu_thread.h"
 #include "system.h"
 #include "system_private.h"
+#include "timing_event.h"
 
 #include "util/media_capture.h"
 
@@ -14,6 +15,9 @@
 #include "common/threading.h"
 #include "common/timer.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <utility>
 
 LOG_CHANNEL(PerfMon);
@@ -59,11 +63,33 @@ struct State
   u32 frame_time_history_pos;
 };
 
+struct ProfileState
+{
+  // GPU commands and CD-ROM reads can happen on other threads.
+  std::array<std::atomic<u64>, static_cast<size_t>(ProfileSection::MaxCount)> section_time;
+  std::array<std::atomic<u64>, static_cast<size_t>(ProfileSection::MaxCount)> section_count;
+
+  // Only accessed on the CPU thread.
+  struct EventStats
+  {
+    const TimingEvent* event;
+    std::string name;
+    u64 time;
+    u64 count;
+  };
+  std::vector<EventStats> event_stats;
+  const TimingEvent* current_event;
+  u64 current_event_start;
+};
+
 } // namespace
 
 static constexpr const float PERFORMANCE_COUNTER_UPDATE_INTERVAL = 1.0f;
 
 ALIGN_TO_CACHE_LINE State s_state = {};
+static ProfileState s_profile_state;
+
+bool g_profiling_enabled = false;
 
 } // namespace PerformanceCounters
 
@@ -242,3 +268,124 @@ void PerformanceCounters::AccumulateGPUTime()
   s_state.accumulated_gpu_time += g_gpu_device->GetAndResetAccumulatedGPUTime();
   s_state.presents_since_last_update++;
 }
+
+void PerformanceCounters::SetProfilingEnabled(bool enabled)
+{
+  if (g_profiling_enabled == enabled)
+    return;
+
+  ResetProfile();
+  g_profiling_enabled = enabled;
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PerformanceCounters::ResetProfile()
+{
+  for (size_t i = 0; i < static_cast<size_t>(ProfileSection::MaxCount); i++)
+  {
+    s_profile_state.section_time[i].store(0, std::memory_order_relaxed);
+    s_profile_state.section_count[i].store(0, std::memory_order_relaxed);
+  }
+
+  s_profile_state.event_stats.clear();
+  s_profile_state.current_event = nullptr;
+  s_profile_state.current_event_start = 0;
+}
+
+const char* PerformanceCounters::GetProfileSectionName(ProfileSection section)
+{
+  static constexpr const std::array<const char*, static_cast<size_t>(ProfileSection::MaxCount)> names = {{
+    "Execution",
+    "TimingEvents",
+    "GPUCommands",
+    "SPUMixing",
+    "CDROMReads",
+  }};
+
+  return names[static_cast<size_t>(section)];
+}
+
+PerformanceCounters::ProfileSectionStats PerformanceCounters::GetProfileSectionStats(ProfileSection section)
+{
+  const size_t index = static_cast<size_t>(section);
+  return ProfileSectionStats{
+    Timer::ConvertValueToMilliseconds(s_profile_state.section_time[index].load(std::memory_order_relaxed)),
+    s_profile_state.section_count[index].load(std::memory_order_relaxed)};
+}
+
+std::vector<PerformanceCounters::TimingEventProfile> PerformanceCounters::GetTimingEventProfiles()
+{
+  std::vector<TimingEventProfile> ret;
+  ret.reserve(s_profile_state.event_stats.size());
+
+  // Events with the same name, e.g. per-voice events, are combined.
+  for (const ProfileState::EventStats& es : s_profile_state.event_stats)
+  {
+    const double time_ms = Timer::ConvertValueToMilliseconds(es.time);
+    const auto iter =
+      std::find_if(ret.begin(), ret.end(), [&es](const TimingEventProfile& tep) { return (tep.name == es.name); });
+    if (iter != ret.end())
+    {
+      iter->total_time_ms += time_ms;
+      iter->count += es.count;
+    }
+    else
+    {
+      ret.push_back(TimingEventProfile{es.name, time_ms, es.count});
+    }
+  }
+
+  std::sort(ret.begin(), ret.end(), [](const TimingEventProfile& lhs, const TimingEventProfile& rhs) {
+    return (lhs.total_time_ms > rhs.total_time_ms);
+  });
+
+  return ret;
+}
+
+u64 PerformanceCounters::GetProfileTimestamp()
+{
+  return Timer::GetCurrentValue();
+}
+
+void PerformanceCounters::AddProfileTime(ProfileSection section, u64 start_timestamp)
+{
+  const u64 time = Timer::GetCurrentValue() - start_timestamp;
+  const size_t index = static_cast<size_t>(section);
+  s_profile_state.section_time[index].fetch_add(time, std::memory_order_relaxed);
+  s_profile_state.section_count[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformanceCounters::BeginTimingEvent(const TimingEvent* event)
+{
+  EndTimingEvent();
+
+  s_profile_state.current_event = event;
+  s_profile_state.current_event_start = Timer::GetCurrentValue();
+}
+
+void PerformanceCounters::EndTimingEvent()
+{
+  const TimingEvent* event = std::exchange(s_profile_state.current_event, nullptr);
+  if (!event)
+    return;
+
+  const u64 time = Timer::GetCurrentValue() - s_profile_state.current_event_start;
+  s_profile_state.section_time[static_cast<size_t>(ProfileSection::TimingEvents)].fetch_add(
+    time, std::memory_order_relaxed);
+  s_profile_state.section_count[static_cast<size_t>(ProfileSection::TimingEvents)].fetch_add(
+    1, std::memory_order_relaxed);
+
+  // Check the name as well, in case the event was destroyed and another created at the same address.
+  auto iter = std::find_if(s_profile_state.event_stats.begin(), s_profile_state.event_stats.end(),
+                           [event](const ProfileState::EventStats& es) {
+                             return (es.event == event && es.name == event->GetName());
+                           });
+  if (iter == s_profile_state.event_stats.end())
+  {
+    s_profile_state.event_stats.push_back(ProfileState::EventStats{event, std::string(event->GetName()), 0, 0});
+    iter = s_profile_state.event_stats.end() - 1;
+  }
+
+  iter->time += time;
+  iter->count++;
+}
@@ -5,7 +5,11 @@
 
 #include "common/types.h"
 
+#include <string>
+#include <vector>
+
 class GPUBackend;
+class TimingEvent;
 
 namespace PerformanceCounters
 {
@@ -32,4 +36,70 @@ void Reset();
 void Update(GPUBackend* gpu, u32 frame_number, u32 internal_frame_number);
 void AccumulateGPUTime();
 
+/// Subsystem profiling, used for benchmarking. Sections can be nested, e.g. SPU mixing is also part of the time
+/// for the SPU timing event, and everything on the CPU thread is part of Execution.
+enum class ProfileSection : u8
+{
+  Execution,    // System::Execute() on the CPU thread, includes timing events.
+  TimingEvents, // All timing event callbacks.
+  GPUCommands,  // GPU backend command processing, on whichever thread executes it.
+  SPUMixing,
+  CDROMReads, // Reads from the disc image, including readahead on the reader thread.
+
+  MaxCount
+};
+
+struct ProfileSectionStats
+{
+  double total_time_ms;
+  u64 count;
+};
+
+struct TimingEventProfile
+{
+  std::string name;
+  double total_time_ms;
+  u64 count;
+};
+
+extern bool g_profiling_enabled;
+
+ALWAYS_INLINE bool IsProfiling()
+{
+  return g_profiling_enabled;
+}
+
+/// Should only be changed while the system is not executing.
+void SetProfilingEnabled(bool enabled);
+void ResetProfile();
+
+const char* GetProfileSectionName(ProfileSection section);
+ProfileSectionStats GetProfileSectionStats(ProfileSection section);
+std::vector<TimingEventProfile> GetTimingEventProfiles();
+
+u64 GetProfileTimestamp();
+void AddProfileTime(ProfileSection section, u64 start_timestamp);
+
+/// Event callbacks can exit execution, so an unfinished event is completed by EndTimingEvent() on the next call.
+void BeginTimingEvent(const TimingEvent* event);
+void EndTimingEvent();
+
+class ProfileScope
+{
+public:
+  ALWAYS_INLINE ProfileScope(ProfileSection section)
+    : m_start(IsProfiling() ? GetProfileTimestamp() : 0), m_section(section)
+  {
+  }
+  ALWAYS_INLINE ~ProfileScope()
+  {
+    if (m_start != 0) [[unlikely]]
+      AddProfileTime(m_section, m_start);
+  }
+
+private:
+  u64 m_start;
+  ProfileSection m_section;
+};
+
 } // namespace Host
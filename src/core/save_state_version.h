@@ -26,6 +26,9 @@ struct SAVE_STATE_HEADER
     None = 0,
     Deflate = 1,
     Zstandard = 2,
+
+    // Data is split into independently-compressed Zstandard chunks, see SAVE_STATE_CHUNK_HEADER.
+    ZstandardChunked = 3,
   };
 
   u32 magic;
@@ -50,4 +53,12 @@ struct SAVE_STATE_HEADER
   u32 data_uncompressed_size;
   u32 offset_to_data;
 };
+
+// Start of the data for ZstandardChunked. Followed by the compressed size of each chunk, then the chunks themselves.
+// Every chunk except the last decompresses to chunk_size bytes.
+struct SAVE_STATE_CHUNK_HEADER
+{
+  u32 chunk_size;
+  u32 num_chunks;
+};
 #pragma pack(pop)
@@ -205,6 +205,8 @@ void Settings::Load(const SettingsInterface& si, const SettingsInterface& contro
   cpu_recompiler_memory_exceptions = si.GetBoolValue("CPU", "RecompilerMemoryExceptions", false);
   cpu_recompiler_block_linking = si.GetBoolValue("CPU", "RecompilerBlockLinking", true);
   cpu_recompiler_icache = si.GetBoolValue("CPU", "RecompilerICache", false);
+  cpu_idle_loop_skipping = si.GetBoolValue("CPU", "IdleLoopSkipping", false);
+  cpu_recompiler_superblocks = si.GetBoolValue("CPU", "RecompilerSuperblocks", false);
   cpu_fastmem_mode = ParseCPUFastmemMode(
                        si.GetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(DEFAULT_CPU_FASTMEM_MODE)).c_str())
                        .value_or(DEFAULT_CPU_FASTMEM_MODE);
@@ -229,6 +231,8 @@ void Settings::Load(const SettingsInterface& si, const SettingsInterface& contro
   gpu_use_thread = si.GetBoolValue("GPU", "UseThread", true);
   gpu_max_queued_frames = static_cast<u8>(si.GetUIntValue("GPU", "MaxQueuedFrames", DEFAULT_GPU_MAX_QUEUED_FRAMES));
   gpu_use_software_renderer_for_readbacks = si.GetBoolValue("GPU", "UseSoftwareRendererForReadbacks", false);
+  gpu_software_renderer_threads = static_cast<u8>(
+    std::min<u32>(si.GetUIntValue("GPU", "SoftwareRendererThreads", 0u), MAX_GPU_SOFTWARE_RENDERER_THREADS));
   gpu_scaled_interlacing = si.GetBoolValue("GPU", "ScaledInterlacing", true);
   gpu_force_round_texcoords = si.GetBoolValue("GPU", "ForceRoundTextureCoordinates", false);
   gpu_texture_filter =
@@ -369,6 +373,8 @@ void Settings::Load(const SettingsInterface& si, const SettingsInterface& contro
   cdrom_region_check = si.GetBoolValue("CDROM", "RegionCheck", false);
   cdrom_subq_skew = si.GetBoolValue("CDROM", "SubQSkew", false);
   cdrom_load_image_to_ram = si.GetBoolValue("CDROM", "LoadImageToRAM", false);
+  cdrom_share_preloaded_image = si.GetBoolValue("CDROM", "SharePreloadedImage", false);
+  cdrom_compress_preloaded_image = si.GetBoolValue("CDROM", "CompressPreloadedImage", false);
   cdrom_load_image_patches = si.GetBoolValue("CDROM", "LoadImagePatches", false);
   cdrom_mute_cd_audio = si.GetBoolValue("CDROM", "MuteCDAudio", false);
   cdrom_read_speedup =
@@ -492,6 +498,9 @@ void Settings::Load(const SettingsInterface& si, const SettingsInterface& contro
   texture_replacements.config.max_replacement_cache_vram_usage_mb =
     si.GetUIntValue("TextureReplacements", "MaxReplacementCacheVRAMUsage",
                     TextureReplacementSettings::Configuration::DEFAULT_MAX_REPLACEMENT_CACHE_VRAM_USAGE_MB);
+  texture_replacements.config.max_replacement_cache_memory_usage_mb =
+    si.GetUIntValue("TextureReplacements", "MaxReplacementCacheMemoryUsage",
+                    TextureReplacementSettings::Configuration::DEFAULT_MAX_REPLACEMENT_CACHE_MEMORY_USAGE_MB);
 
   texture_replacements.config.max_vram_write_splits = Truncate16(
     std::min<u32>(si.GetUIntValue("TextureReplacements", "MaxVRAMWriteSplits", 0u), std::numeric_limits<u16>::max()));
@@ -563,6 +572,8 @@ void Settings::Save(SettingsInterface& si, bool ignore_base) const
   si.SetBoolValue("CPU", "RecompilerMemoryExceptions", cpu_recompiler_memory_exceptions);
   si.SetBoolValue("CPU", "RecompilerBlockLinking", cpu_recompiler_block_linking);
   si.SetBoolValue("CPU", "RecompilerICache", cpu_recompiler_icache);
+  si.SetBoolValue("CPU", "IdleLoopSkipping", cpu_idle_loop_skipping);
+  si.SetBoolValue("CPU", "RecompilerSuperblocks", cpu_recompiler_superblocks);
   si.SetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(cpu_fastmem_mode));
 
   si.SetStringValue("GPU", "Renderer", GetRendererName(gpu_renderer));
@@ -588,6 +599,7 @@ void Settings::Save(SettingsInterface& si, bool ignore_base) const
   si.SetUIntValue("GPU", "MaxQueuedFrames", gpu_max_queued_frames);
   si.SetBoolValue("GPU", "UseThread", gpu_use_thread);
   si.SetBoolValue("GPU", "UseSoftwareRendererForReadbacks", gpu_use_software_renderer_for_readbacks);
+  si.SetUIntValue("GPU", "SoftwareRendererThreads", gpu_software_renderer_threads);
   si.SetBoolValue("GPU", "ScaledInterlacing", gpu_scaled_interlacing);
   si.SetBoolValue("GPU", "ForceRoundTextureCoordinates", gpu_force_round_texcoords);
   si.SetStringValue("GPU", "TextureFilter", GetTextureFilterName(gpu_texture_filter));
@@ -667,6 +679,8 @@ void Settings::Save(SettingsInterface& si, bool ignore_base) const
   si.SetBoolValue("CDROM", "RegionCheck", cdrom_region_check);
   si.SetBoolValue("CDROM", "SubQSkew", cdrom_subq_skew);
   si.SetBoolValue("CDROM", "LoadImageToRAM", cdrom_load_image_to_ram);
+  si.SetBoolValue("CDROM", "SharePreloadedImage", cdrom_share_preloaded_image);
+  si.SetBoolValue("CDROM", "CompressPreloadedImage", cdrom_compress_preloaded_image);
   si.SetBoolValue("CDROM", "LoadImagePatches", cdrom_load_image_patches);
   si.SetBoolValue("CDROM", "MuteCDAudio", cdrom_mute_cd_audio);
   si.SetUIntValue("CDROM", "ReadSpeedup", cdrom_read_speedup);
@@ -764,6 +778,8 @@ void Settings::Save(SettingsInterface& si, bool ignore_base) const
                   texture_replacements.config.max_hash_cache_vram_usage_mb);
   si.SetUIntValue("TextureReplacements", "MaxReplacementCacheVRAMUsage",
                   texture_replacements.config.max_replacement_cache_vram_usage_mb);
+  si.SetUIntValue("TextureReplacements", "MaxReplacementCacheMemoryUsage",
+                  texture_replacements.config.max_replacement_cache_memory_usage_mb);
 
   si.SetUIntValue("TextureReplacements", "MaxVRAMWriteSplits", texture_replacements.config.max_vram_write_splits);
   si.SetUIntValue("TextureReplacements", "MaxVRAMWriteCoalesceWidth",
@@ -829,6 +845,7 @@ bool Settings::TextureReplacementSettings::Configuration::operator==(const Confi
           max_hash_cache_entries == rhs.max_hash_cache_entries &&
           max_hash_cache_vram_usage_mb == rhs.max_hash_cache_vram_usage_mb &&
           max_replacement_cache_vram_usage_mb == rhs.max_replacement_cache_vram_usage_mb &&
+          max_replacement_cache_memory_usage_mb == rhs.max_replacement_cache_memory_usage_mb &&
           max_vram_write_splits == rhs.max_vram_write_splits &&
           max_vram_write_coalesce_width == rhs.max_vram_write_coalesce_width &&
           max_vram_write_coalesce_height == rhs.max_vram_write_coalesce_height &&
@@ -942,6 +959,12 @@ std::string Settings::TextureReplacementSettings::Configuration::ExportToYAML(bo
 # same size as the uncompressed source image on disk.
 {}MaxReplacementCacheVRAMUsage: {}
 
+# Sets the maximum amount of system memory in megabytes used to hold decoded
+# replacement images. When the limit is exceeded, the least recently used images
+# are discarded, and decoded again in the background if they are needed. This
+# limit does not apply when replacement textures are preloaded.
+{}MaxReplacementCacheMemoryUsage: {}
+
 # Enables the use of a bilinear filter when scaling replacement textures.
 # If more than one replacement texture in a 256x256 texture page has a different
 # scaling over the native resolution, or the texture page is not covered, a
@@ -961,22 +984,23 @@ std::string Settings::TextureReplacementSettings::Configuration::ExportToYAML(bo
 )";
 
   const std::string_view comment_str = comment ? "#" : "";
-  return fmt::format(CONFIG_TEMPLATE, comment_str, dump_texture_pages, // DumpTexturePages
-                     comment_str, dump_full_texture_pages,             // DumpFullTexturePages
-                     comment_str, dump_c16_textures,                   // DumpC16Textures
-                     comment_str, reduce_palette_range,                // ReducePaletteRange
-                     comment_str, convert_copies_to_writes,            // ConvertCopiesToWrites
-                     comment_str, max_vram_write_splits,               // MaxVRAMWriteSplits
-                     comment_str, max_vram_write_coalesce_width,       // MaxVRAMWriteCoalesceWidth
-                     comment_str, max_vram_write_coalesce_height,      // MaxVRAMWriteCoalesceHeight
-                     comment_str, texture_dump_width_threshold,        // DumpTextureWidthThreshold
-                     comment_str, texture_dump_height_threshold,       // DumpTextureHeightThreshold
-                     comment_str, vram_write_dump_width_threshold,     // DumpVRAMWriteWidthThreshold
-                     comment_str, vram_write_dump_height_threshold,    // DumpVRAMWriteHeightThreshold
-                     comment_str, max_hash_cache_entries,              // MaxHashCacheEntries
-                     comment_str, max_hash_cache_vram_usage_mb,        // MaxHashCacheVRAMUsageMB
-                     comment_str, max_replacement_cache_vram_usage_mb, // MaxReplacementCacheVRAMUsage
-                     comment_str, replacement_scale_linear_filter);    // ReplacementScaleLinearFilter
+  return fmt::format(CONFIG_TEMPLATE, comment_str, dump_texture_pages,   // DumpTexturePages
+                     comment_str, dump_full_texture_pages,               // DumpFullTexturePages
+                     comment_str, dump_c16_textures,                     // DumpC16Textures
+                     comment_str, reduce_palette_range,                  // ReducePaletteRange
+                     comment_str, convert_copies_to_writes,              // ConvertCopiesToWrites
+                     comment_str, max_vram_write_splits,                 // MaxVRAMWriteSplits
+                     comment_str, max_vram_write_coalesce_width,         // MaxVRAMWriteCoalesceWidth
+                     comment_str, max_vram_write_coalesce_height,        // MaxVRAMWriteCoalesceHeight
+                     comment_str, texture_dump_width_threshold,          // DumpTextureWidthThreshold
+                     comment_str, texture_dump_height_threshold,         // DumpTextureHeightThreshold
+                     comment_str, vram_write_dump_width_threshold,       // DumpVRAMWriteWidthThreshold
+                     comment_str, vram_write_dump_height_threshold,      // DumpVRAMWriteHeightThreshold
+                     comment_str, max_hash_cache_entries,                // MaxHashCacheEntries
+                     comment_str, max_hash_cache_vram_usage_mb,          // MaxHashCacheVRAMUsageMB
+                     comment_str, max_replacement_cache_vram_usage_mb,   // MaxReplacementCacheVRAMUsage
+                     comment_str, max_replacement_cache_memory_usage_mb, // MaxReplacementCacheMemoryUsage
+                     comment_str, replacement_scale_linear_filter);      // ReplacementScaleLinearFilter
 }
 
 void Settings::FixIncompatibleSettings(const SettingsInterface& si, bool display_osd_messages)
@@ -1695,8 +1719,8 @@ const char* Settings::GetGPUWireframeModeDisplayName(GPUWireframeMode mode)
                                   "GPUWireframeMode");
 }
 
-static constexpr const std::array s_gpu_dump_compression_mode_names = {"Disabled", "ZstLow",    "ZstDefault", "ZstHigh",
-                                                                       "XZLow",    "XZDefault", "XZHigh"};
+static constexpr const std::array s_gpu_dump_compression_mode_names = {
+  "Disabled", "ZstLow", "ZstDefault", "ZstHigh", "XZLow", "XZDefault", "XZHigh", "ZstIndexed"};
 static constexpr const std::array s_gpu_dump_compression_mode_display_names = {
   TRANSLATE_DISAMBIG_NOOP("Settings", "Disabled", "GPUDumpCompressionMode"),
   TRANSLATE_DISAMBIG_NOOP("Settings", "Zstandard (Low)", "GPUDumpCompressionMode"),
@@ -1705,6 +1729,7 @@ static constexpr const std::array s_gpu_dump_compression_mode_display_names = {
   TRANSLATE_DISAMBIG_NOOP("Settings", "XZ (Low)", "GPUDumpCompressionMode"),
   TRANSLATE_DISAMBIG_NOOP("Settings", "XZ (Default)", "GPUDumpCompressionMode"),
   TRANSLATE_DISAMBIG_NOOP("Settings", "XZ (High)", "GPUDumpCompressionMode"),
+  TRANSLATE_DISAMBIG_NOOP("Settings", "Zstandard (Indexed)", "GPUDumpCompressionMode"),
 };
 static_assert(s_gpu_dump_compression_mode_names.size() == static_cast<size_t>(GPUDumpCompressionMode::MaxCount));
 static_assert(s_gpu_dump_compression_mode_display_names.size() ==
@@ -65,6 +65,7 @@ struct GPUSettings
   u8 gpu_resolution_scale = 1;
   u8 gpu_multisamples = 1;
   u8 gpu_max_queued_frames = DEFAULT_GPU_MAX_QUEUED_FRAMES;
+  u8 gpu_software_renderer_threads = 0;
 
   ForceVideoTimingMode gpu_force_video_timing = DEFAULT_FORCE_VIDEO_TIMING_MODE;
   GPUTextureFilter gpu_texture_filter = DEFAULT_GPU_TEXTURE_FILTER;
@@ -159,6 +160,7 @@ struct GPUSettings
       static constexpr u32 DEFAULT_MAX_HASH_CACHE_ENTRIES = 1200;
       static constexpr u32 DEFAULT_MAX_HASH_CACHE_VRAM_USAGE_MB = 2048;
       static constexpr u32 DEFAULT_MAX_REPLACEMENT_CACHE_VRAM_USAGE_MB = 512;
+      static constexpr u32 DEFAULT_MAX_REPLACEMENT_CACHE_MEMORY_USAGE_MB = 1024;
 
       constexpr Configuration() = default;
 
@@ -174,6 +176,7 @@ struct GPUSettings
       u32 max_hash_cache_entries = DEFAULT_MAX_HASH_CACHE_ENTRIES;
       u32 max_hash_cache_vram_usage_mb = DEFAULT_MAX_HASH_CACHE_VRAM_USAGE_MB;
       u32 max_replacement_cache_vram_usage_mb = DEFAULT_MAX_REPLACEMENT_CACHE_VRAM_USAGE_MB;
+      u32 max_replacement_cache_memory_usage_mb = DEFAULT_MAX_REPLACEMENT_CACHE_MEMORY_USAGE_MB;
 
       u16 max_vram_write_splits = 0;
       u16 max_vram_write_coalesce_width = 0;
@@ -258,6 +261,9 @@ struct GPUSettings
   static constexpr float DEFAULT_DISPLAY_PRE_FRAME_SLEEP_BUFFER = 2.0f;
   static constexpr float DEFAULT_OSD_SCALE = 100.0f;
 
+  // Zero or one renders on the GPU thread only.
+  static constexpr u8 MAX_GPU_SOFTWARE_RENDERER_THREADS = 16;
+
 #ifndef __ANDROID__
   static constexpr u8 DEFAULT_GPU_MAX_QUEUED_FRAMES = 2;
 #else
@@ -286,6 +292,8 @@ struct Settings : public GPUSettings
   bool cpu_recompiler_memory_exceptions : 1 = false;
   bool cpu_recompiler_block_linking : 1 = true;
   bool cpu_recompiler_icache : 1 = false;
+  bool cpu_idle_loop_skipping : 1 = false;
+  bool cpu_recompiler_superblocks : 1 = false;
 
   bool sync_to_host_refresh_rate : 1 = false;
   bool inhibit_screensaver : 1 = true;
@@ -305,6 +313,8 @@ struct Settings : public GPUSettings
   bool cdrom_region_check : 1 = false;
   bool cdrom_subq_skew : 1 = false;
   bool cdrom_load_image_to_ram : 1 = false;
+  bool cdrom_share_preloaded_image : 1 = false;
+  bool cdrom_compress_preloaded_image : 1 = false;
   bool cdrom_load_image_patches : 1 = false;
   bool cdrom_mute_cd_audio : 1 = false;
 
@@ -7,6 +7,7 @@
 #include "host.h"
 #include "imgui.h"
 #include "interrupt_controller.h"
+#include "performance_counters.h"
 #include "system.h"
 #include "timing_event.h"
 
@@ -2351,6 +2352,8 @@ void SPU::ProcessReverb(s32 left_in, s32 right_in, s32* left_out, s32* right_out
 
 void SPU::Execute(void* param, TickCount ticks, TickCount ticks_late)
 {
+  const PerformanceCounters::ProfileScope profile(PerformanceCounters::ProfileSection::SPUMixing);
+
   u32 remaining_frames;
   if (g_settings.cpu_overclock_active)
   {
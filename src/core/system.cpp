@@ -11,6 +11,7 @@
 #include "cpu_code_cache.h"
 #include "cpu_core.h"
 #include "cpu_pgxp.h"
+#include "cpu_trace.h"
 #include "dma.h"
 #include "fullscreen_ui.h"
 #include "game_database.h"
@@ -123,6 +124,10 @@ static constexpr u32 MAX_SKIPPED_DUPLICATE_FRAME_COUNT = 2; // 20fps minimum
 static constexpr u32 MAX_SKIPPED_TIMEOUT_FRAME_COUNT = 1;   // 30fps minimum
 static constexpr u8 MEMORY_CARD_FAST_FORWARD_FRAMES = 30;
 
+// Uncompressed size of each chunk in chunked save states. Large enough to compress as well as the whole state would,
+// small enough that RAM, VRAM and SPU RAM each span separate chunks.
+static constexpr u32 SAVE_STATE_CHUNK_SIZE = 1024 * 1024;
+
 namespace {
 
 struct SaveStateBuffer
@@ -208,13 +213,19 @@ static bool LoadStateBufferFromFile(SaveStateBuffer* buffer, std::FILE* fp, Erro
                                     bool read_media_path, bool read_screenshot, bool read_data);
 static bool ReadAndDecompressStateData(std::FILE* fp, std::span<u8> dst, u32 file_offset, u32 compressed_size,
                                        SAVE_STATE_HEADER::CompressionType method, Error* error);
+static bool DecompressChunkedStateData(std::span<u8> dst, std::span<const u8> src, Error* error);
 static bool SaveStateToBuffer(SaveStateBuffer* buffer, Error* error, u32 screenshot_size = 256);
 static bool SaveStateBufferToFile(const SaveStateBuffer& buffer, std::FILE* fp, Error* error,
                                   SaveStateCompressionMode compression_mode);
 static u32 CompressAndWriteStateData(std::FILE* fp, std::span<const u8> src, SaveStateCompressionMode method,
                                      u32* header_type, Error* error);
+static u32 CompressAndWriteChunkedStateData(std::FILE* fp, std::span<const u8> src, int level, Error* error);
 static bool DoState(StateWrapper& sw, bool update_display);
 static void DoMemoryState(StateWrapper& sw, MemorySaveState& mss, bool update_display);
+static void DoMemoryStateRAM(MemorySaveState& mss, bool reading);
+static size_t EncodeMemoryStateDelta(u8* dst, const u8* old_state, const u8* new_state, size_t size);
+static void ApplyMemoryStateDelta(u8* state, size_t size, std::span<const u8> delta);
+static u64 GetMemorySaveStateStorageSize();
 
 static bool IsExecutionInterrupted();
 static void CheckForAndExitExecution();
@@ -295,6 +306,13 @@ struct ALIGN_TO_CACHE_LINE StateVars
   std::vector<MemorySaveState> memory_save_states;
   u32 memory_save_state_front = 0;
   u32 memory_save_state_count = 0;
+  bool memory_save_states_delta_compressed = false;
+  bool memory_save_states_full_logged = false;
+
+  // Newest memory state when using delta compression, older states are stored as deltas against their successor.
+  DynamicHeapArray<u8> memory_save_state_keyframe;
+  DynamicHeapArray<u8> memory_save_state_scratch;
+  DynamicHeapArray<u8> memory_save_state_delta;
 
   const BIOS::ImageInfo* bios_image_info = nullptr;
   BIOS::ImageInfo::Hash bios_hash = {};
@@ -642,6 +660,11 @@ size_t System::GetGPUDumpFrameCount()
   return s_state.gpu_dump_player ? s_state.gpu_dump_player->GetFrameCount() : 0;
 }
 
+bool System::SeekGPUDump(u32 frame)
+{
+  return (s_state.gpu_dump_player && s_state.gpu_dump_player->SeekToFrame(frame));
+}
+
 bool System::IsStartupCancelled()
 {
   return s_state.startup_cancelled.load(std::memory_order_acquire);
@@ -824,7 +847,7 @@ bool System::IsPsfPath(std::string_view path)
 bool System::IsGPUDumpPath(std::string_view path)
 {
   return (StringUtil::EndsWithNoCase(path, ".psxgpu") || StringUtil::EndsWithNoCase(path, ".psxgpu.zst") ||
-          StringUtil::EndsWithNoCase(path, ".psxgpu.xz"));
+          StringUtil::EndsWithNoCase(path, ".psxgpu.xz") || StringUtil::EndsWithNoCase(path, ".psxgpu.zsi"));
 }
 
 bool System::IsLoadablePath(std::string_view path)
@@ -1983,6 +2006,7 @@ void System::DestroySystem()
   g_gpu.Shutdown();
   DMA::Shutdown();
   PIO::Shutdown();
+  CPU::Trace::Stop(); // resets the code cache, so must happen before it's shut down
   CPU::CodeCache::Shutdown();
   CPU::PGXP::Shutdown();
   CPU::Shutdown();
@@ -2052,6 +2076,9 @@ void System::Execute()
       {
         s_state.system_executing = true;
 
+        const u64 profile_start =
+          PerformanceCounters::IsProfiling() ? PerformanceCounters::GetProfileTimestamp() : 0;
+
         TimingEvents::CommitLeftoverTicks();
 
         if (s_state.gpu_dump_player) [[unlikely]]
@@ -2061,6 +2088,13 @@ void System::Execute()
         else
           CPU::Execute();
 
+        if (profile_start != 0) [[unlikely]]
+        {
+          // Frame done exits execution from within the event callback.
+          PerformanceCounters::EndTimingEvent();
+          PerformanceCounters::AddProfileTime(PerformanceCounters::ProfileSection::Execution, profile_start);
+        }
+
         s_state.system_executing = false;
         continue;
       }
@@ -2088,6 +2122,10 @@ void System::FrameDone()
 
     Cheats::ApplyFrameEndCodes();
 
+    // Replayed frames are catching up as fast as possible, and rewinding shouldn't be slowed down by it either.
+    if (s_state.runahead_replay_frames == 0 && !IsRewinding())
+      CPU::CodeCache::PrecompileCachedBlocks();
+
     if (Achievements::IsActive())
       Achievements::FrameUpdate();
   }
@@ -2428,7 +2466,7 @@ bool System::DoState(StateWrapper& sw, bool update_display)
       CPU::PGXP::Reset();
   }
 
-  if (!sw.DoMarker("Bus") || !Bus::DoState(sw))
+  if (!sw.DoMarker("Bus") || !Bus::DoState(sw, true))
     return false;
 
   if (!sw.DoMarker("DMA") || !DMA::DoState(sw))
@@ -2528,7 +2566,16 @@ System::MemorySaveState& System::GetFirstMemoryState()
   return s_state.memory_save_states[idx];
 }
 
-System::MemorySaveState& System::PopMemoryState()
+System::MemorySaveState& System::GetLastMemoryState()
+{
+  const u32 max_count = static_cast<u32>(s_state.memory_save_states.size());
+  DebugAssert(s_state.memory_save_state_count > 0);
+
+  const u32 idx = (s_state.memory_save_state_front + max_count - 1) % max_count;
+  return s_state.memory_save_states[idx];
+}
+
+void System::PopMemoryState()
 {
   const u32 max_count = static_cast<u32>(s_state.memory_save_states.size());
   DebugAssert(s_state.memory_save_state_count > 0);
@@ -2536,7 +2583,15 @@ System::MemorySaveState& System::PopMemoryState()
 
   const s32 front = static_cast<s32>(s_state.memory_save_state_front) - 1;
   s_state.memory_save_state_front = static_cast<u32>((front < 0) ? (front + static_cast<s32>(max_count)) : front);
-  return s_state.memory_save_states[s_state.memory_save_state_front];
+
+  // Reconstruct the new newest state from its delta, it no longer needs to be stored separately.
+  if (s_state.memory_save_states_delta_compressed && s_state.memory_save_state_count > 0)
+  {
+    MemorySaveState& mss = GetLastMemoryState();
+    ApplyMemoryStateDelta(s_state.memory_save_state_keyframe.data(), s_state.memory_save_state_keyframe.size(),
+                          mss.state_data.cspan(0, mss.delta_size));
+    mss.delta_size = 0;
+  }
 }
 
 bool System::AllocateMemoryStates(size_t state_count, bool recycle_old_textures)
@@ -2552,13 +2607,48 @@ bool System::AllocateMemoryStates(size_t state_count, bool recycle_old_textures)
   // Allocate CPU buffers.
   // TODO: Maybe look at host memory limits here...
   const size_t size = GetMaxSaveStateSize();
-  for (MemorySaveState& mss : s_state.memory_save_states)
+  if (s_state.memory_save_states_delta_compressed)
+  {
+    // Slots are sized on demand to fit their delta, only the newest state and the scratch buffers are full-sized.
+    const size_t aligned_size = Common::AlignUpPow2(size, sizeof(u64));
+    if (s_state.memory_save_state_keyframe.size() != aligned_size)
+    {
+      s_state.memory_save_state_keyframe.resize(aligned_size);
+      s_state.memory_save_state_scratch.resize(aligned_size);
+
+      // Worst case delta is the state size plus a run header.
+      s_state.memory_save_state_delta.resize(aligned_size + sizeof(u32) * 4);
+    }
+
+    for (MemorySaveState& mss : s_state.memory_save_states)
+    {
+      mss.state_size = 0;
+      mss.delta_size = 0;
+      mss.state_data.deallocate();
+    }
+  }
+  else
   {
-    mss.state_size = 0;
-    if (mss.state_data.size() != size)
-      mss.state_data.resize(size);
+    s_state.memory_save_state_keyframe.deallocate();
+    s_state.memory_save_state_scratch.deallocate();
+    s_state.memory_save_state_delta.deallocate();
+
+    // Runahead saves and loads every frame, so only copy the RAM pages that have changed.
+    Bus::SetRAMDirtyPageTracking(true);
+
+    for (MemorySaveState& mss : s_state.memory_save_states)
+    {
+      mss.state_size = 0;
+      if (mss.state_data.size() != size)
+        mss.state_data.resize(size);
+
+      // RAM buffer is allocated on first save.
+      mss.ram_page_generations.fill(0);
+    }
   }
 
+  s_state.memory_save_states_full_logged = false;
+
   // Allocate GPU buffers.
   Error error;
   if (!GPUBackend::AllocateMemorySaveStates(s_state.memory_save_states, &error))
@@ -2623,6 +2713,10 @@ void System::FreeMemoryStateStorage(bool release_memory, bool release_textures,
       mss.gpu_state_size = 0;
       mss.state_data.deallocate();
       mss.state_size = 0;
+      mss.delta_size = 0;
+      mss.ram_data.deallocate();
+      mss.ram_page_generations.deallocate();
+      CPU::PGXP::FreeMemoryState(mss.pgxp);
     }
 
     if (!textures.empty())
@@ -2644,6 +2738,10 @@ void System::FreeMemoryStateStorage(bool release_memory, bool release_textures,
     s_state.memory_save_states = std::vector<MemorySaveState>();
     s_state.memory_save_state_front = 0;
     s_state.memory_save_state_count = 0;
+    s_state.memory_save_state_keyframe.deallocate();
+    s_state.memory_save_state_scratch.deallocate();
+    s_state.memory_save_state_delta.deallocate();
+    Bus::SetRAMDirtyPageTracking(false);
   }
 }
 
@@ -2653,7 +2751,19 @@ void System::LoadMemoryState(MemorySaveState& mss, bool update_display)
   Timer load_timer;
 #endif
 
-  StateWrapper sw(mss.state_data.cspan(0, mss.state_size), StateWrapper::Mode::Read, SAVE_STATE_VERSION);
+  std::span<const u8> state_data;
+  if (s_state.memory_save_states_delta_compressed)
+  {
+    // Only the newest state is available uncompressed.
+    DebugAssert(&mss == &GetLastMemoryState());
+    state_data = s_state.memory_save_state_keyframe.cspan(0, mss.state_size);
+  }
+  else
+  {
+    state_data = mss.state_data.cspan(0, mss.state_size);
+  }
+
+  StateWrapper sw(state_data, StateWrapper::Mode::Read, SAVE_STATE_VERSION);
   DoMemoryState(sw, mss, update_display);
   DebugAssert(!sw.HasError());
 
@@ -2672,10 +2782,55 @@ void System::SaveMemoryState(MemorySaveState& mss)
   Timer save_timer;
 #endif
 
-  StateWrapper sw(mss.state_data.span(), StateWrapper::Mode::Write, SAVE_STATE_VERSION);
-  DoMemoryState(sw, mss, false);
-  DebugAssert(!sw.HasError());
-  mss.state_size = sw.GetPosition();
+  if (!s_state.memory_save_states_delta_compressed)
+  {
+    StateWrapper sw(mss.state_data.span(), StateWrapper::Mode::Write, SAVE_STATE_VERSION);
+    DoMemoryState(sw, mss, false);
+    DebugAssert(!sw.HasError());
+    mss.state_size = sw.GetPosition();
+  }
+  else
+  {
+    StateWrapper sw(s_state.memory_save_state_scratch.span(), StateWrapper::Mode::Write, SAVE_STATE_VERSION);
+    DoMemoryState(sw, mss, false);
+    DebugAssert(!sw.HasError());
+    mss.state_size = sw.GetPosition();
+
+    // Previous newest state gets replaced by a delta against the state we just saved.
+    if (s_state.memory_save_state_count > 1)
+    {
+      const u32 max_count = static_cast<u32>(s_state.memory_save_states.size());
+      MemorySaveState& prev_mss =
+        s_state.memory_save_states[(s_state.memory_save_state_front + max_count - 2) % max_count];
+      const size_t compare_size = Common::AlignUpPow2(std::max(prev_mss.state_size, mss.state_size), sizeof(u64));
+      const size_t delta_size =
+        EncodeMemoryStateDelta(s_state.memory_save_state_delta.data(), s_state.memory_save_state_keyframe.data(),
+                               s_state.memory_save_state_scratch.data(), compare_size);
+
+      // Grow with some headroom, and only shrink once the slot is mostly unused, so that a single large delta doesn't
+      // keep a full-size buffer in the slot.
+      if (prev_mss.state_data.size() < delta_size || prev_mss.state_data.size() > (delta_size * 4))
+      {
+        prev_mss.state_data.deallocate();
+        prev_mss.state_data.resize(delta_size + (delta_size / 4));
+      }
+
+      std::memcpy(prev_mss.state_data.data(), s_state.memory_save_state_delta.data(), delta_size);
+      prev_mss.delta_size = delta_size;
+    }
+
+    s_state.memory_save_state_keyframe.swap(s_state.memory_save_state_scratch);
+    mss.delta_size = 0;
+
+    if (s_state.memory_save_state_count == s_state.memory_save_states.size() &&
+        !s_state.memory_save_states_full_logged)
+    {
+      s_state.memory_save_states_full_logged = true;
+      const u64 storage_size = GetMemorySaveStateStorageSize();
+      INFO_LOG("Rewind buffer filled: {} slots using {:.2f}MB RAM, {} bytes per slot", s_state.memory_save_state_count,
+               static_cast<double>(storage_size) / 1048576.0, storage_size / s_state.memory_save_state_count);
+    }
+  }
 
 #ifdef PROFILE_MEMORY_SAVE_STATES
   DEV_LOG("Saving frame {} to memory state slot {} took {} bytes and {:.4f} ms", s_state.frame_number,
@@ -2685,6 +2840,82 @@ void System::SaveMemoryState(MemorySaveState& mss)
 #endif
 }
 
+size_t System::EncodeMemoryStateDelta(u8* dst, const u8* old_state, const u8* new_state, size_t size)
+{
+  // Stored as a sequence of [u32 unchanged words, u32 changed words, changed words XOR new state].
+  // Worst case output is size + 8 bytes, since every literal run after the first is preceded by an unchanged word.
+  DebugAssert(Common::IsAlignedPow2(size, sizeof(u64)));
+  const size_t num_words = size / sizeof(u64);
+  u8* const dst_start = dst;
+  size_t word = 0;
+  while (word < num_words)
+  {
+    const size_t skip_start = word;
+    while (word < num_words && std::memcmp(old_state + word * sizeof(u64), new_state + word * sizeof(u64),
+                                           sizeof(u64)) == 0)
+    {
+      word++;
+    }
+
+    const size_t literal_start = word;
+    while (word < num_words)
+    {
+      u64 old_word, new_word;
+      std::memcpy(&old_word, old_state + word * sizeof(u64), sizeof(old_word));
+      std::memcpy(&new_word, new_state + word * sizeof(u64), sizeof(new_word));
+      if (old_word == new_word)
+        break;
+
+      const u64 delta_word = old_word ^ new_word;
+      std::memcpy(dst + sizeof(u32) * 2 + (word - literal_start) * sizeof(u64), &delta_word, sizeof(delta_word));
+      word++;
+    }
+
+    const u32 skip_count = static_cast<u32>(literal_start - skip_start);
+    const u32 literal_count = static_cast<u32>(word - literal_start);
+    std::memcpy(dst, &skip_count, sizeof(skip_count));
+    std::memcpy(dst + sizeof(u32), &literal_count, sizeof(literal_count));
+    dst += sizeof(u32) * 2 + literal_count * sizeof(u64);
+  }
+
+  return static_cast<size_t>(dst - dst_start);
+}
+
+void System::ApplyMemoryStateDelta(u8* state, size_t size, std::span<const u8> delta)
+{
+  const u8* src = delta.data();
+  const u8* const src_end = src + delta.size();
+  u8* const state_end = state + size;
+  while (src < src_end)
+  {
+    u32 skip_count, literal_count;
+    std::memcpy(&skip_count, src, sizeof(skip_count));
+    std::memcpy(&literal_count, src + sizeof(u32), sizeof(literal_count));
+    src += sizeof(u32) * 2;
+    state += skip_count * sizeof(u64);
+    DebugAssert((state + literal_count * sizeof(u64)) <= state_end);
+
+    for (u32 i = 0; i < literal_count; i++)
+    {
+      u64 state_word, delta_word;
+      std::memcpy(&state_word, state, sizeof(state_word));
+      std::memcpy(&delta_word, src, sizeof(delta_word));
+      state_word ^= delta_word;
+      std::memcpy(state, &state_word, sizeof(state_word));
+      state += sizeof(u64);
+      src += sizeof(u64);
+    }
+  }
+}
+
+u64 System::GetMemorySaveStateStorageSize()
+{
+  u64 size = s_state.memory_save_states_delta_compressed ? s_state.memory_save_state_keyframe.size() : 0;
+  for (const MemorySaveState& mss : s_state.memory_save_states)
+    size += mss.state_data.size();
+  return size;
+}
+
 void System::DoMemoryState(StateWrapper& sw, MemorySaveState& mss, bool update_display)
 {
 #if defined(_DEBUG) || defined(_DEVEL)
@@ -2704,13 +2935,24 @@ void System::DoMemoryState(StateWrapper& sw, MemorySaveState& mss, bool update_d
 
   SAVE_COMPONENT("CPU", CPU::DoState(sw));
 
-  // don't need to reset pgxp because the value checks will save us from broken rendering, and it
-  // saves using imprecise values for a frame in 30fps games.
-  // TODO: Save PGXP state to memory state instead. It'll be 8MB, but potentially worth it.
-  if (sw.IsReading())
-    CPU::CodeCache::InvalidateAllRAMBlocks();
+  // PGXP memory is sparse and stored outside of the state data, so only touched chunks are copied.
+  if (g_settings.gpu_pgxp_enable)
+    CPU::PGXP::DoMemoryState(mss.pgxp, sw.IsReading());
+  else if (!sw.IsReading())
+    CPU::PGXP::FreeMemoryState(mss.pgxp);
+
+  // Only code pages which differ from the state need their blocks invalidated. Incremental restores know exactly which
+  // pages they replace, otherwise the code pages are compared against a copy taken before RAM is overwritten.
+  const bool incremental_ram = Bus::IsTrackingRAMDirtyPages();
+  if (sw.IsReading() && !incremental_ram)
+    CPU::CodeCache::BeginRAMRestore();
+
+  SAVE_COMPONENT("Bus", Bus::DoState(sw, !incremental_ram));
+  if (incremental_ram)
+    DoMemoryStateRAM(mss, sw.IsReading());
+  else if (sw.IsReading())
+    CPU::CodeCache::EndRAMRestore();
 
-  SAVE_COMPONENT("Bus", Bus::DoState(sw));
   SAVE_COMPONENT("DMA", DMA::DoState(sw));
   SAVE_COMPONENT("InterruptController", InterruptController::DoState(sw));
 
@@ -2731,6 +2973,43 @@ void System::DoMemoryState(StateWrapper& sw, MemorySaveState& mss, bool update_d
     g_gpu.UpdateDisplay(false);
 }
 
+void System::DoMemoryStateRAM(MemorySaveState& mss, bool reading)
+{
+  const std::span<u32> generations = Bus::UpdateRAMPageGenerations();
+  if (mss.ram_data.size() != Bus::g_ram_size) [[unlikely]]
+  {
+    DebugAssert(!reading);
+    mss.ram_data.resize(Bus::g_ram_size);
+    mss.ram_page_generations.resize(generations.size());
+    mss.ram_page_generations.fill(0);
+  }
+
+  for (size_t i = 0; i < generations.size(); i++)
+  {
+    if (mss.ram_page_generations[i] == generations[i])
+      continue;
+
+    // Bypass protection when restoring, so the page isn't flagged as dirty again.
+    const size_t offset = i << HOST_PAGE_SHIFT;
+    if (reading)
+    {
+      if (Bus::IsRAMCodePage(static_cast<u32>(i)) &&
+          std::memcmp(Bus::g_unprotected_ram + offset, mss.ram_data.data() + offset, HOST_PAGE_SIZE) != 0)
+      {
+        CPU::CodeCache::InvalidateRestoredRAMPage(static_cast<u32>(i));
+      }
+
+      std::memcpy(Bus::g_unprotected_ram + offset, mss.ram_data.data() + offset, HOST_PAGE_SIZE);
+      generations[i] = mss.ram_page_generations[i];
+    }
+    else
+    {
+      std::memcpy(mss.ram_data.data() + offset, Bus::g_unprotected_ram + offset, HOST_PAGE_SIZE);
+      mss.ram_page_generations[i] = generations[i];
+    }
+  }
+}
+
 bool System::LoadBIOS(Error* error)
 {
   std::optional<BIOS::Image> bios_image = BIOS::GetBIOSImage(s_state.region, error);
@@ -3152,6 +3431,10 @@ bool System::ReadAndDecompressStateData(std::FILE* fp, std::span<u8> dst, u32 fi
 
     return true;
   }
+  else if (method == SAVE_STATE_HEADER::CompressionType::ZstandardChunked)
+  {
+    return DecompressChunkedStateData(dst, compressed_data.cspan(), error);
+  }
   else [[unlikely]]
   {
     Error::SetStringView(error, "Unknown method.");
@@ -3159,6 +3442,69 @@ bool System::ReadAndDecompressStateData(std::FILE* fp, std::span<u8> dst, u32 fi
   }
 }
 
+bool System::DecompressChunkedStateData(std::span<u8> dst, std::span<const u8> src, Error* error)
+{
+  SAVE_STATE_CHUNK_HEADER chunk_header;
+  if (src.size() < sizeof(chunk_header)) [[unlikely]]
+  {
+    Error::SetStringView(error, "Chunk header is missing.");
+    return false;
+  }
+
+  std::memcpy(&chunk_header, src.data(), sizeof(chunk_header));
+  if (chunk_header.chunk_size == 0 ||
+      chunk_header.num_chunks != ((dst.size() + chunk_header.chunk_size - 1) / chunk_header.chunk_size) ||
+      (src.size() - sizeof(chunk_header)) / sizeof(u32) < chunk_header.num_chunks) [[unlikely]]
+  {
+    Error::SetStringView(error, "Chunk header is corrupted.");
+    return false;
+  }
+
+  // Chunk offsets are needed up front to decompress them in any order.
+  std::vector<std::span<const u8>> chunks(chunk_header.num_chunks);
+  size_t offset = sizeof(chunk_header) + sizeof(u32) * chunk_header.num_chunks;
+  for (u32 i = 0; i < chunk_header.num_chunks; i++)
+  {
+    u32 chunk_compressed_size;
+    std::memcpy(&chunk_compressed_size, &src[sizeof(chunk_header) + sizeof(u32) * i], sizeof(chunk_compressed_size));
+    if (chunk_compressed_size > (src.size() - offset)) [[unlikely]]
+    {
+      Error::SetStringFmt(error, "Chunk {} is truncated.", i);
+      return false;
+    }
+
+    chunks[i] = src.subspan(offset, chunk_compressed_size);
+    offset += chunk_compressed_size;
+  }
+
+  std::atomic_bool failed{false};
+  Error chunk_error;
+  s_state.async_task_queue.ParallelFor(chunk_header.num_chunks, [&](u32 i) {
+    const size_t dst_offset = static_cast<size_t>(i) * chunk_header.chunk_size;
+    const std::span<u8> chunk_dst =
+      dst.subspan(dst_offset, std::min<size_t>(chunk_header.chunk_size, dst.size() - dst_offset));
+    const size_t result = ZSTD_decompress(chunk_dst.data(), chunk_dst.size(), chunks[i].data(), chunks[i].size());
+    if (ZSTD_isError(result) || result != chunk_dst.size()) [[unlikely]]
+    {
+      // Only the first failure is reported.
+      if (!failed.exchange(true, std::memory_order_acq_rel))
+      {
+        const char* errstr = ZSTD_isError(result) ? ZSTD_getErrorString(ZSTD_getErrorCode(result)) : nullptr;
+        Error::SetStringFmt(&chunk_error, "Failed to decompress chunk {}: {}", i, errstr ? errstr : "Size mismatch");
+      }
+    }
+  });
+
+  if (failed.load(std::memory_order_acquire)) [[unlikely]]
+  {
+    if (error)
+      *error = std::move(chunk_error);
+    return false;
+  }
+
+  return true;
+}
+
 bool System::SaveState(std::string path, Error* error, bool backup_existing_save, bool ignore_memcard_busy)
 {
   if (!IsValid() || IsReplayingGPUDump())
@@ -3436,11 +3782,19 @@ u32 System::CompressAndWriteStateData(std::FILE* fp, std::span<const u8> src, Sa
   }
   else if (method >= SaveStateCompressionMode::ZstLow && method <= SaveStateCompressionMode::ZstHigh)
   {
+    const int level =
+      ((method == SaveStateCompressionMode::ZstLow) ? 1 : ((method == SaveStateCompressionMode::ZstHigh) ? 18 : 0));
+
+    // Anything larger than the screenshot is compressed in parallel.
+    if (src.size() > SAVE_STATE_CHUNK_SIZE)
+    {
+      *header_type = static_cast<u32>(SAVE_STATE_HEADER::CompressionType::ZstandardChunked);
+      return CompressAndWriteChunkedStateData(fp, src, level, error);
+    }
+
     const size_t buffer_size = ZSTD_compressBound(src.size());
     buffer.resize(buffer_size);
 
-    const int level =
-      ((method == SaveStateCompressionMode::ZstLow) ? 1 : ((method == SaveStateCompressionMode::ZstHigh) ? 18 : 0));
     const size_t compressed_size = ZSTD_compress(buffer.data(), buffer_size, src.data(), src.size(), level);
     if (ZSTD_isError(compressed_size)) [[unlikely]]
     {
@@ -3467,6 +3821,67 @@ u32 System::CompressAndWriteStateData(std::FILE* fp, std::span<const u8> src, Sa
   return write_size;
 }
 
+u32 System::CompressAndWriteChunkedStateData(std::FILE* fp, std::span<const u8> src, int level, Error* error)
+{
+  const u32 num_chunks = static_cast<u32>((src.size() + SAVE_STATE_CHUNK_SIZE - 1) / SAVE_STATE_CHUNK_SIZE);
+  std::vector<DynamicHeapArray<u8>> chunks(num_chunks);
+  std::vector<u32> chunk_sizes(num_chunks);
+
+  std::atomic_bool failed{false};
+  Error chunk_error;
+  s_state.async_task_queue.ParallelFor(num_chunks, [&](u32 i) {
+    const size_t src_offset = static_cast<size_t>(i) * SAVE_STATE_CHUNK_SIZE;
+    const std::span<const u8> chunk_src =
+      src.subspan(src_offset, std::min<size_t>(SAVE_STATE_CHUNK_SIZE, src.size() - src_offset));
+    DynamicHeapArray<u8>& buffer = chunks[i];
+    buffer.resize(ZSTD_compressBound(chunk_src.size()));
+
+    const size_t compressed_size =
+      ZSTD_compress(buffer.data(), buffer.size(), chunk_src.data(), chunk_src.size(), level);
+    if (ZSTD_isError(compressed_size)) [[unlikely]]
+    {
+      if (!failed.exchange(true, std::memory_order_acq_rel))
+      {
+        const char* errstr = ZSTD_getErrorString(ZSTD_getErrorCode(compressed_size));
+        Error::SetStringFmt(&chunk_error, "ZSTD_compress() failed: {}", errstr ? errstr : "<unknown>");
+      }
+
+      return;
+    }
+
+    chunk_sizes[i] = static_cast<u32>(compressed_size);
+  });
+
+  if (failed.load(std::memory_order_acquire)) [[unlikely]]
+  {
+    if (error)
+      *error = std::move(chunk_error);
+    return 0;
+  }
+
+  const SAVE_STATE_CHUNK_HEADER chunk_header = {SAVE_STATE_CHUNK_SIZE, num_chunks};
+  if (std::fwrite(&chunk_header, sizeof(chunk_header), 1, fp) != 1 ||
+      std::fwrite(chunk_sizes.data(), sizeof(u32) * num_chunks, 1, fp) != 1) [[unlikely]]
+  {
+    Error::SetStringFmt(error, "fwrite() failed: {}", errno);
+    return 0;
+  }
+
+  u32 write_size = static_cast<u32>(sizeof(chunk_header) + sizeof(u32) * num_chunks);
+  for (u32 i = 0; i < num_chunks; i++)
+  {
+    if (std::fwrite(chunks[i].data(), chunk_sizes[i], 1, fp) != 1) [[unlikely]]
+    {
+      Error::SetStringFmt(error, "fwrite() failed: {}", errno);
+      return 0;
+    }
+
+    write_size += chunk_sizes[i];
+  }
+
+  return write_size;
+}
+
 float System::GetTargetSpeed()
 {
   return s_state.target_speed;
@@ -4215,6 +4630,7 @@ void System::UpdateRunningGame(const std::string& path, CDImage* image, bool boo
   if (s_state.running_game_serial != prev_serial)
   {
     GPUThread::SetGameSerial(s_state.running_game_serial);
+    CPU::CodeCache::GameChanged(s_state.running_game_serial);
     UpdateSessionTime(prev_serial);
   }
 
@@ -4418,6 +4834,8 @@ void System::CheckForSettingsChanges(const Settings& old_settings)
         (g_settings.cpu_recompiler_memory_exceptions != old_settings.cpu_recompiler_memory_exceptions ||
          g_settings.cpu_recompiler_block_linking != old_settings.cpu_recompiler_block_linking ||
          g_settings.cpu_recompiler_icache != old_settings.cpu_recompiler_icache ||
+         g_settings.cpu_idle_loop_skipping != old_settings.cpu_idle_loop_skipping ||
+         g_settings.cpu_recompiler_superblocks != old_settings.cpu_recompiler_superblocks ||
          g_settings.bios_tty_logging != old_settings.bios_tty_logging))
     {
       Host::AddIconOSDMessage("CPUFlushAllBlocks", ICON_FA_MICROCHIP,
@@ -4471,6 +4889,7 @@ void System::CheckForSettingsChanges(const Settings& old_settings)
              g_settings.gpu_max_queued_frames != old_settings.gpu_max_queued_frames ||
              g_settings.gpu_use_software_renderer_for_readbacks !=
                old_settings.gpu_use_software_renderer_for_readbacks ||
+             g_settings.gpu_software_renderer_threads != old_settings.gpu_software_renderer_threads ||
              g_settings.gpu_scaled_interlacing != old_settings.gpu_scaled_interlacing ||
              g_settings.gpu_force_round_texcoords != old_settings.gpu_force_round_texcoords ||
              g_settings.gpu_texture_filter != old_settings.gpu_texture_filter ||
@@ -4940,8 +5359,16 @@ void System::CalculateRewindMemoryUsage(u32 num_saves, u32 resolution_scale, u64
 
 void System::UpdateMemorySaveStateSettings()
 {
+  if (s_state.memory_save_states_delta_compressed && s_state.memory_save_state_count > 0)
+  {
+    const u64 storage_size = GetMemorySaveStateStorageSize();
+    INFO_LOG("Rewind buffer held {} slots in {:.2f}MB RAM, {} bytes per slot", s_state.memory_save_state_count,
+             static_cast<double>(storage_size) / 1048576.0, storage_size / s_state.memory_save_state_count);
+  }
+
   const bool any_memory_states_active = (g_settings.IsRunaheadEnabled() || g_settings.rewind_enable);
   FreeMemoryStateStorage(true, true, any_memory_states_active);
+  s_state.memory_save_states_delta_compressed = false;
 
   if (IsReplayingGPUDump()) [[unlikely]]
   {
@@ -4958,9 +5385,13 @@ void System::UpdateMemorySaveStateSettings()
     s_state.rewind_save_counter = 0;
     num_slots = g_settings.rewind_save_slots;
 
+    // Rewind states are only ever loaded newest-first, so they can be stored as deltas.
+    s_state.memory_save_states_delta_compressed = true;
+
     u64 ram_usage, vram_usage;
     CalculateRewindMemoryUsage(g_settings.rewind_save_slots, g_settings.gpu_resolution_scale, &ram_usage, &vram_usage);
-    INFO_LOG("Rewind is enabled, saving every {} frames, with {} slots and {}MB RAM and {}MB VRAM usage",
+    INFO_LOG("Rewind is enabled, saving every {} frames, with {} delta-compressed slots and up to {}MB RAM and {}MB "
+             "VRAM usage",
              std::max(s_state.rewind_save_frequency, 1), g_settings.rewind_save_slots, ram_usage / 1048576,
              vram_usage / 1048576);
   }
@@ -4995,7 +5426,9 @@ bool System::LoadOneRewindState()
     return false;
 
   // keep the last state so we can go back to it with smaller frequencies
-  LoadMemoryState((s_state.memory_save_state_count > 1) ? PopMemoryState() : GetFirstMemoryState(), true);
+  LoadMemoryState(GetLastMemoryState(), true);
+  if (s_state.memory_save_state_count > 1)
+    PopMemoryState();
 
   // back in time, need to reset perf counters
   GPUThread::RunOnThread(&PerformanceCounters::Reset);
@@ -175,6 +175,9 @@ bool IsExecuting();
 bool IsReplayingGPUDump();
 size_t GetGPUDumpFrameCount();
 
+/// Continues GPU dump playback from the specified frame.
+bool SeekGPUDump(u32 frame);
+
 bool IsStartupCancelled();
 void CancelPendingStartup();
 void InterruptExecution();
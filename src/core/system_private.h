@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "cpu_pgxp.h"
 #include "system.h"
 
 #include <functional>
@@ -15,9 +16,23 @@ namespace System {
 /// Memory save states - only for internal use.
 struct MemorySaveState
 {
+  /// When rewind delta compression is active, holds the XOR/RLE delta against the next-newer state instead of the
+  /// raw state. The newest state is kept uncompressed outside of the slot.
   DynamicHeapArray<u8> state_data;
   size_t state_size;
 
+  /// Bytes of state_data used by the delta. The buffer keeps its capacity between saves, so it isn't reallocated
+  /// every frame.
+  size_t delta_size;
+
+  /// RAM is kept outside of the state data when dirty page tracking is active. Only pages whose generation differs
+  /// from the current RAM are copied when saving or loading.
+  DynamicHeapArray<u8> ram_data;
+  DynamicHeapArray<u32> ram_page_generations;
+
+  /// PGXP shadow memory, only present when PGXP is enabled.
+  CPU::PGXP::MemoryStateData pgxp;
+
   std::unique_ptr<GPUTexture> vram_texture;
   DynamicHeapArray<u8> gpu_state_data;
   size_t gpu_state_size;
@@ -25,7 +40,8 @@ struct MemorySaveState
 
 MemorySaveState& AllocateMemoryState();
 MemorySaveState& GetFirstMemoryState();
-MemorySaveState& PopMemoryState();
+MemorySaveState& GetLastMemoryState();
+void PopMemoryState();
 bool AllocateMemoryStates(size_t state_count, bool recycle_old_textures);
 void FreeMemoryStateStorage(bool release_memory, bool release_textures, bool recycle_textures);
 void LoadMemoryState(MemorySaveState& mss, bool update_display);
@@ -4,6 +4,7 @@
 #include "timing_event.h"
 #include "cpu_core.h"
 #include "cpu_core_private.h"
+#include "performance_counters.h"
 #include "system.h"
 
 #include "util/state_wrapper.h"
@@ -351,7 +352,16 @@ ALWAYS_INLINE_RELEASE void TimingEvents::CommitGlobalTicks(const GlobalTicks new
       event->m_last_run_time = s_state.global_tick_counter;
 
       // The cycles_late is only an indicator, it doesn't modify the cycles to execute.
-      event->m_callback(event->m_callback_param, ticks_to_execute, ticks_late);
+      if (PerformanceCounters::IsProfiling()) [[unlikely]]
+      {
+        PerformanceCounters::BeginTimingEvent(event);
+        event->m_callback(event->m_callback_param, ticks_to_execute, ticks_late);
+        PerformanceCounters::EndTimingEvent();
+      }
+      else
+      {
+        event->m_callback(event->m_callback_param, ticks_to_execute, ticks_late);
+      }
       if (event->m_active)
       {
         event->m_next_run_time = s_state.current_event_next_run_time;
@@ -146,6 +146,7 @@ enum class GPUDumpCompressionMode : u8
   XZLow,
   XZDefault,
   XZHigh,
+  ZstIndexed,
   MaxCount
 };
 
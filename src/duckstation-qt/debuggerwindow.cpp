@@ -9,8 +9,12 @@
 #include "core/bus.h"
 #include "core/cpu_code_cache.h"
 #include "core/cpu_core_private.h"
+#include "core/cpu_trace.h"
 
 #include "common/assert.h"
+#include "common/error.h"
+
+#include "fmt/format.h"
 
 #include <QtCore/QSignalBlocker>
 #include <QtGui/QCursor>
@@ -178,6 +182,27 @@ void DebuggerWindow::onTraceTriggered()
   }
 }
 
+void DebuggerWindow::onBinaryTraceTriggered()
+{
+  if (!CPU::Trace::IsActive())
+  {
+    Host::RunOnCPUThread([]() {
+      Error error;
+      if (!CPU::Trace::Start(CPU::Trace::DEFAULT_BUFFER_SIZE, nullptr, &error))
+        Host::ReportDebuggerMessage(fmt::format("Failed to start binary trace: {}", error.GetDescription()));
+    });
+    QMessageBox::information(this, windowTitle(),
+                             tr("Binary trace started. The most recent execution is kept in memory, and will be "
+                                "written to cpu_trace.bin when the trace is stopped, or cpu_trace_crash.bin if the "
+                                "emulator crashes."));
+  }
+  else
+  {
+    Host::RunOnCPUThread(&CPU::Trace::Stop);
+    QMessageBox::information(this, windowTitle(), tr("Binary trace stopped and written to cpu_trace.bin."));
+  }
+}
+
 void DebuggerWindow::onFollowAddressTriggered()
 {
   //
@@ -503,6 +528,7 @@ void DebuggerWindow::connectSignals()
   connect(m_ui.actionGoToAddress, &QAction::triggered, this, &DebuggerWindow::onGoToAddressTriggered);
   connect(m_ui.actionDumpAddress, &QAction::triggered, this, &DebuggerWindow::onDumpAddressTriggered);
   connect(m_ui.actionTrace, &QAction::triggered, this, &DebuggerWindow::onTraceTriggered);
+  connect(m_ui.actionBinaryTrace, &QAction::triggered, this, &DebuggerWindow::onBinaryTraceTriggered);
   connect(m_ui.actionStepInto, &QAction::triggered, this, &DebuggerWindow::onStepIntoActionTriggered);
   connect(m_ui.actionStepOver, &QAction::triggered, this, &DebuggerWindow::onStepOverActionTriggered);
   connect(m_ui.actionStepOut, &QAction::triggered, this, &DebuggerWindow::onStepOutActionTriggered);
@@ -583,6 +609,7 @@ void DebuggerWindow::setUIEnabled(bool enabled, bool allow_pause)
   m_ui.actionGoToAddress->setEnabled(enabled);
   m_ui.actionGoToPC->setEnabled(enabled);
   m_ui.actionTrace->setEnabled(enabled);
+  m_ui.actionBinaryTrace->setEnabled(enabled);
   m_ui.memoryRegionRAM->setEnabled(memory_view_enabled);
   m_ui.memoryRegionEXP1->setEnabled(memory_view_enabled);
   m_ui.memoryRegionScratchpad->setEnabled(memory_view_enabled);
@@ -52,6 +52,7 @@ private Q_SLOTS:
   void onDumpAddressTriggered();
   void onFollowAddressTriggered();
   void onTraceTriggered();
+  void onBinaryTraceTriggered();
   void onAddBreakpointTriggered();
   void onToggleBreakpointTriggered();
   void onClearBreakpointsTriggered();
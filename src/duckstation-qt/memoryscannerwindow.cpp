@@ -94,6 +94,7 @@ MemoryScannerWindow::MemoryScannerWindow() : QWidget()
 {
   m_ui.setupUi(this);
   QtUtils::RestoreWindowGeometry("MemoryScannerWindow", this);
+  m_scanner.SetMaxResults(MAX_DISPLAYED_SCAN_RESULTS);
   connectUi();
 
   m_ui.cheatEngineAddress->setText(tr("Address of RAM for HxD Usage: 0x%1")
@@ -505,8 +506,8 @@ void MemoryScannerWindow::updateResults()
     row++;
   }
 
-  m_ui.scanResultCount->setText((row < static_cast<int>(results.size())) ?
-                                  tr("%1 (only showing first %2)").arg(results.size()).arg(row) :
+  m_ui.scanResultCount->setText((static_cast<u32>(row) < m_scanner.GetResultCount()) ?
+                                  tr("%1 (only showing first %2)").arg(m_scanner.GetResultCount()).arg(row) :
                                   QString::number(m_scanner.GetResultCount()));
 
   m_ui.scanResetSearch->setEnabled(!results.empty());
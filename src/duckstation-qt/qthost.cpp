@@ -14,6 +14,7 @@
 #include "core/bus.h"
 #include "core/cheats.h"
 #include "core/controller.h"
+#include "core/cpu_trace.h"
 #include "core/fullscreen_ui.h"
 #include "core/game_database.h"
 #include "core/game_list.h"
@@ -2962,7 +2963,10 @@ bool QtHost::RunSetupWizard()
 
 int main(int argc, char* argv[])
 {
-  CrashHandler::Install(&Bus::CleanupMemoryMap);
+  CrashHandler::Install([]() {
+    CPU::Trace::SaveBufferOnCrash();
+    Bus::CleanupMemoryMap();
+  });
 
   QGuiApplication::setHighDpiScaleFactorRoundingPolicy(Qt::HighDpiScaleFactorRoundingPolicy::PassThrough);
 
@@ -4,13 +4,16 @@
 #include "core/achievements.h"
 #include "core/bus.h"
 #include "core/controller.h"
+#include "core/cpu_trace.h"
 #include "core/fullscreen_ui.h"
+#include "core/game_database.h"
 #include "core/game_list.h"
 #include "core/gpu.h"
 #include "core/gpu_backend.h"
 #include "core/gpu_presenter.h"
 #include "core/gpu_thread.h"
 #include "core/host.h"
+#include "core/performance_counters.h"
 #include "core/spu.h"
 #include "core/system.h"
 #include "core/system_private.h"
@@ -38,13 +41,59 @@
 
 #include "fmt/format.h"
 
+#include <algorithm>
 #include <csignal>
 #include <cstdio>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 LOG_CHANNEL(Host);
 
 namespace RegTestHost {
 
+namespace {
+
+struct BatchJob
+{
+  struct SettingOverride
+  {
+    std::string section;
+    std::string key;
+    std::string value;
+  };
+
+  std::string name;
+  std::string path;
+  std::optional<u32> frames;
+  std::vector<SettingOverride> settings;
+};
+
+/// Sent from the worker to the batch runner, must be trivially copyable.
+struct BatchJobResult
+{
+  bool success;
+  u32 frames_executed;
+  double execution_time_ms;
+  char save_state_hash[SHA256Digest::DIGEST_SIZE * 2 + 1];
+  char ram_hash[SHA256Digest::DIGEST_SIZE * 2 + 1];
+  char spu_ram_hash[SHA256Digest::DIGEST_SIZE * 2 + 1];
+  char vram_hash[SHA256Digest::DIGEST_SIZE * 2 + 1];
+};
+
+struct StateHashes
+{
+  std::string save_state;
+  std::string ram;
+  std::string spu_ram;
+  std::string vram;
+};
+
+} // namespace
+
 static bool ParseCommandLineParameters(int argc, char* argv[], std::optional<SystemBootParameters>& autoboot);
 static void PrintCommandLineVersion();
 static void PrintCommandLineHelp(const char* progname);
@@ -52,10 +101,21 @@ static bool InitializeConfig();
 static void InitializeEarlyConsole();
 static void HookSignals();
 static bool SetFolders();
-static bool SetNewDataRoot(const std::string& filename);
+static bool SetNewDataRoot(std::string_view subdirectory_name);
 static void DumpSystemStateHashes();
 static std::string GetFrameDumpPath(u32 frame);
 static void GPUThreadEntryPoint();
+static std::string GetDumpDirectory(std::string_view subdirectory_name);
+static bool RunSystem(SystemBootParameters boot_params, double* execution_time_ms);
+
+static bool LoadBatchManifest(const char* path, std::vector<BatchJob>* jobs);
+static int RunBatch();
+static void RunBatchJob(const BatchJob& job, BatchJobResult* result);
+static bool WriteBatchResults(const std::vector<BatchJob>& jobs, const std::vector<BatchJobResult>& results,
+                              const std::vector<double>& wall_times);
+static void AppendJSONString(std::string& dest, std::string_view str);
+
+static bool WriteBenchmarkResults(std::string_view boot_filename, double execution_time_ms);
 
 } // namespace RegTestHost
 
@@ -65,7 +125,19 @@ static Threading::Thread s_gpu_thread;
 static u32 s_frames_to_run = 60 * 60;
 static u32 s_frames_remaining = 0;
 static u32 s_frame_dump_interval = 0;
+static u32 s_gpu_dump_start_frame = 0;
 static std::string s_dump_base_directory;
+static RegTestHost::StateHashes s_state_hashes;
+
+static std::string s_batch_manifest_path;
+static std::string s_batch_results_path;
+static u32 s_batch_jobs = 0;
+
+static std::string s_benchmark_results_path;
+
+static std::string s_cpu_trace_path;
+static std::string s_decode_trace_input_path;
+static std::string s_decode_trace_output_path;
 
 bool RegTestHost::SetFolders()
 {
@@ -647,6 +719,8 @@ void RegTestHost::DumpSystemStateHashes()
 {
   Error error;
 
+  s_state_hashes = {};
+
   // don't save full state on gpu dump, it's not going to be complete...
   if (!System::IsReplayingGPUDump())
   {
@@ -658,15 +732,19 @@ void RegTestHost::DumpSystemStateHashes()
       return;
     }
 
-    INFO_LOG("Save State Hash: {}",
-             SHA256Digest::DigestToString(SHA256Digest::GetDigest(state_data.cspan(0, state_data_size))));
-    INFO_LOG("RAM Hash: {}",
-             SHA256Digest::DigestToString(SHA256Digest::GetDigest(std::span<const u8>(Bus::g_ram, Bus::g_ram_size))));
-    INFO_LOG("SPU RAM Hash: {}", SHA256Digest::DigestToString(SHA256Digest::GetDigest(SPU::GetRAM())));
+    s_state_hashes.save_state =
+      SHA256Digest::DigestToString(SHA256Digest::GetDigest(state_data.cspan(0, state_data_size)));
+    s_state_hashes.ram =
+      SHA256Digest::DigestToString(SHA256Digest::GetDigest(std::span<const u8>(Bus::g_ram, Bus::g_ram_size)));
+    s_state_hashes.spu_ram = SHA256Digest::DigestToString(SHA256Digest::GetDigest(SPU::GetRAM()));
+    INFO_LOG("Save State Hash: {}", s_state_hashes.save_state);
+    INFO_LOG("RAM Hash: {}", s_state_hashes.ram);
+    INFO_LOG("SPU RAM Hash: {}", s_state_hashes.spu_ram);
   }
 
-  INFO_LOG("VRAM Hash: {}", SHA256Digest::DigestToString(SHA256Digest::GetDigest(
-                              std::span<const u8>(reinterpret_cast<const u8*>(g_vram), VRAM_SIZE))));
+  s_state_hashes.vram = SHA256Digest::DigestToString(
+    SHA256Digest::GetDigest(std::span<const u8>(reinterpret_cast<const u8*>(g_vram), VRAM_SIZE)));
+  INFO_LOG("VRAM Hash: {}", s_state_hashes.vram);
 }
 
 void RegTestHost::InitializeEarlyConsole()
@@ -698,12 +776,26 @@ void RegTestHost::PrintCommandLineHelp(const char* progname)
   std::fprintf(stderr, "  -dumpdir: Set frame dump base directory (will be dumped to basedir/gametitle).\n");
   std::fprintf(stderr, "  -dumpinterval: Dumps every N frames.\n");
   std::fprintf(stderr, "  -frames: Sets the number of frames to execute.\n");
+  std::fprintf(stderr, "  -gpudumpframe <frame>: Starts GPU dump playback at the specified frame.\n");
   std::fprintf(stderr, "  -log <level>: Sets the log level. Defaults to verbose.\n");
   std::fprintf(stderr, "  -console: Enables console logging output.\n");
   std::fprintf(stderr, "  -pgxp: Enables PGXP.\n");
   std::fprintf(stderr, "  -pgxp-cpu: Forces PGXP CPU mode.\n");
+  std::fprintf(stderr, "  -sharedprecache: Preloads the disc image into shared memory, which is reused by every\n"
+                       "    process running the same image. The copy is kept after exit (in /dev/shm on Linux), so\n"
+                       "    later runs can reuse it.\n");
   std::fprintf(stderr, "  -renderer <renderer>: Sets the graphics renderer. Default to software.\n");
   std::fprintf(stderr, "  -upscale <multiplier>: Enables upscaled rendering at the specified multiplier.\n");
+  std::fprintf(stderr, "  -batch <manifest>: Runs every game listed in the manifest. One game per line, in the\n"
+                       "    form 'path | frames=N | renderer=R | name=N | Section/Key=Value | ...', where all\n"
+                       "    fields after the path are optional. Lines starting with # are ignored.\n");
+  std::fprintf(stderr, "  -jobs <count>: Number of games to run in parallel in batch mode. Defaults to the\n"
+                       "    number of CPUs.\n");
+  std::fprintf(stderr, "  -results <file>: Writes batch results (hashes, dumps, timings) as JSON to the file.\n");
+  std::fprintf(stderr, "  -benchmark <file>: Profiles the run, and writes the emulated FPS and time spent in each\n"
+                       "    subsystem as JSON to the file.\n");
+  std::fprintf(stderr, "  -cputrace <file>: Records a binary CPU execution trace, and streams it to the file.\n");
+  std::fprintf(stderr, "  -decodetrace <trace> <output>: Converts a binary CPU trace to a text log and exits.\n");
   std::fprintf(stderr, "  --: Signals that no more arguments will follow and the remaining\n"
                        "    parameters make up the filename. Use when the filename contains\n"
                        "    spaces or starts with a dash.\n");
@@ -771,6 +863,18 @@ bool RegTestHost::ParseCommandLineParameters(int argc, char* argv[], std::option
 
         continue;
       }
+      else if (CHECK_ARG_PARAM("-gpudumpframe"))
+      {
+        const std::optional<u32> frame = StringUtil::FromChars<u32>(argv[++i]);
+        if (!frame.has_value())
+        {
+          ERROR_LOG("Invalid GPU dump frame specified: {}", argv[i]);
+          return false;
+        }
+
+        s_gpu_dump_start_frame = frame.value();
+        continue;
+      }
       else if (CHECK_ARG_PARAM("-log"))
       {
         std::optional<Log::Level> level = Settings::ParseLogLevelName(argv[++i]);
@@ -829,6 +933,73 @@ bool RegTestHost::ParseCommandLineParameters(int argc, char* argv[], std::option
                                                   Settings::GetCPUExecutionModeName(cpu.value()));
         continue;
       }
+      else if (CHECK_ARG_PARAM("-batch"))
+      {
+        s_batch_manifest_path = argv[++i];
+        if (s_batch_manifest_path.empty())
+        {
+          ERROR_LOG("Invalid batch manifest specified.");
+          return false;
+        }
+
+        continue;
+      }
+      else if (CHECK_ARG_PARAM("-jobs"))
+      {
+        s_batch_jobs = StringUtil::FromChars<u32>(argv[++i]).value_or(0);
+        if (s_batch_jobs == 0)
+        {
+          ERROR_LOG("Invalid job count specified: {}", argv[i]);
+          return false;
+        }
+
+        continue;
+      }
+      else if (CHECK_ARG_PARAM("-benchmark"))
+      {
+        s_benchmark_results_path = argv[++i];
+        if (s_benchmark_results_path.empty())
+        {
+          ERROR_LOG("Invalid benchmark results file specified.");
+          return false;
+        }
+
+        continue;
+      }
+      else if (CHECK_ARG_PARAM("-cputrace"))
+      {
+        s_cpu_trace_path = argv[++i];
+        if (s_cpu_trace_path.empty())
+        {
+          ERROR_LOG("Invalid CPU trace file specified.");
+          return false;
+        }
+
+        continue;
+      }
+      else if (CHECK_ARG("-decodetrace") && (i + 2) < argc)
+      {
+        s_decode_trace_input_path = argv[++i];
+        s_decode_trace_output_path = argv[++i];
+        if (s_decode_trace_input_path.empty() || s_decode_trace_output_path.empty())
+        {
+          ERROR_LOG("Invalid CPU trace files specified.");
+          return false;
+        }
+
+        continue;
+      }
+      else if (CHECK_ARG_PARAM("-results"))
+      {
+        s_batch_results_path = argv[++i];
+        if (s_batch_results_path.empty())
+        {
+          ERROR_LOG("Invalid results file specified.");
+          return false;
+        }
+
+        continue;
+      }
       else if (CHECK_ARG("-pgxp"))
       {
         INFO_LOG("Enabling PGXP.");
@@ -842,6 +1013,13 @@ bool RegTestHost::ParseCommandLineParameters(int argc, char* argv[], std::option
         s_base_settings_interface->SetBoolValue("GPU", "PGXPCPU", true);
         continue;
       }
+      else if (CHECK_ARG("-sharedprecache"))
+      {
+        INFO_LOG("Preloading disc image to shared memory.");
+        s_base_settings_interface->SetBoolValue("CDROM", "LoadImageToRAM", true);
+        s_base_settings_interface->SetBoolValue("CDROM", "SharePreloadedImage", true);
+        continue;
+      }
       else if (CHECK_ARG("--"))
       {
         no_more_args = true;
@@ -865,14 +1043,18 @@ bool RegTestHost::ParseCommandLineParameters(int argc, char* argv[], std::option
   return true;
 }
 
-bool RegTestHost::SetNewDataRoot(const std::string& filename)
+std::string RegTestHost::GetDumpDirectory(std::string_view subdirectory_name)
+{
+  return Path::Combine(s_dump_base_directory, Path::SanitizeFileName(subdirectory_name));
+}
+
+bool RegTestHost::SetNewDataRoot(std::string_view subdirectory_name)
 {
   if (!s_dump_base_directory.empty())
   {
-    std::string game_subdir = Path::SanitizeFileName(Path::GetFileTitle(filename));
-    INFO_LOG("Writing to subdirectory '{}'", game_subdir);
+    INFO_LOG("Writing to subdirectory '{}'", Path::SanitizeFileName(subdirectory_name));
 
-    std::string dump_directory = Path::Combine(s_dump_base_directory, game_subdir);
+    std::string dump_directory = GetDumpDirectory(subdirectory_name);
     if (!FileSystem::DirectoryExists(dump_directory.c_str()))
     {
       INFO_LOG("Creating directory '{}'...", dump_directory);
@@ -896,59 +1078,39 @@ std::string RegTestHost::GetFrameDumpPath(u32 frame)
   return Path::Combine(EmuFolders::DataRoot, fmt::format("frame_{:05d}.png", frame));
 }
 
-int main(int argc, char* argv[])
+bool RegTestHost::RunSystem(SystemBootParameters boot_params, double* execution_time_ms)
 {
-  CrashHandler::Install(&Bus::CleanupMemoryMap);
-
-  Error startup_error;
-  if (!System::PerformEarlyHardwareChecks(&startup_error) || !System::ProcessStartup(&startup_error))
-  {
-    ERROR_LOG("CPUThreadInitialize() failed: {}", startup_error.GetDescription());
-    return EXIT_FAILURE;
-  }
-
-  RegTestHost::InitializeEarlyConsole();
-
-  if (!RegTestHost::InitializeConfig())
-    return EXIT_FAILURE;
-
-  std::optional<SystemBootParameters> autoboot;
-  if (!RegTestHost::ParseCommandLineParameters(argc, argv, autoboot))
-    return EXIT_FAILURE;
-
-  if (!autoboot || autoboot->filename.empty())
-  {
-    ERROR_LOG("No boot path specified.");
-    return EXIT_FAILURE;
-  }
-
-  if (!RegTestHost::SetNewDataRoot(autoboot->filename))
-    return EXIT_FAILURE;
+  Error error;
 
   // Only one async worker.
-  if (!System::CPUThreadInitialize(&startup_error, 1))
+  if (!System::CPUThreadInitialize(&error, 1))
   {
-    ERROR_LOG("CPUThreadInitialize() failed: {}", startup_error.GetDescription());
-    return EXIT_FAILURE;
+    ERROR_LOG("CPUThreadInitialize() failed: {}", error.GetDescription());
+    return false;
   }
 
   RegTestHost::HookSignals();
   s_gpu_thread.Start(&RegTestHost::GPUThreadEntryPoint);
 
-  Error error;
-  int result = -1;
-  INFO_LOG("Trying to boot '{}'...", autoboot->filename);
-  if (!System::BootSystem(std::move(autoboot.value()), &error))
+  bool result = false;
+  INFO_LOG("Trying to boot '{}'...", boot_params.filename);
+  if (!System::BootSystem(std::move(boot_params), &error))
   {
     ERROR_LOG("Failed to boot system: {}", error.GetDescription());
     goto cleanup;
   }
 
+  if (s_gpu_dump_start_frame > 0 && !System::SeekGPUDump(s_gpu_dump_start_frame))
+  {
+    ERROR_LOG("Failed to seek GPU dump to frame {}.", s_gpu_dump_start_frame);
+    goto cleanup;
+  }
+
   if (System::IsReplayingGPUDump() && !s_dump_base_directory.empty())
   {
     INFO_LOG("Replaying GPU dump, dumping all frames.");
     s_frame_dump_interval = 1;
-    s_frames_to_run = static_cast<u32>(System::GetGPUDumpFrameCount());
+    s_frames_to_run = static_cast<u32>(System::GetGPUDumpFrameCount()) - s_gpu_dump_start_frame;
   }
 
   if (s_frame_dump_interval > 0)
@@ -962,6 +1124,13 @@ int main(int argc, char* argv[])
     INFO_LOG("Dumping every {}th frame to '{}'.", s_frame_dump_interval, s_dump_base_directory);
   }
 
+  if (!s_cpu_trace_path.empty() &&
+      !CPU::Trace::Start(CPU::Trace::DEFAULT_BUFFER_SIZE, s_cpu_trace_path.c_str(), &error))
+  {
+    ERROR_LOG("Failed to start CPU trace: {}", error.GetDescription());
+    goto cleanup;
+  }
+
   INFO_LOG("Running for {} frames...", s_frames_to_run);
   s_frames_remaining = s_frames_to_run;
 
@@ -975,10 +1144,11 @@ int main(int argc, char* argv[])
     INFO_LOG("Total execution time: {:.2f}ms, average frame time {:.2f}ms, {:.2f} FPS", elapsed_time_ms,
              elapsed_time_ms / static_cast<double>(s_frames_to_run),
              static_cast<double>(s_frames_to_run) / elapsed_time_ms * 1000.0);
+    if (execution_time_ms)
+      *execution_time_ms = elapsed_time_ms;
   }
 
-  INFO_LOG("Exiting with success.");
-  result = 0;
+  result = true;
 
 cleanup:
   if (s_gpu_thread.Joinable())
@@ -988,6 +1158,586 @@ cleanup:
   }
 
   System::CPUThreadShutdown();
-  System::ProcessShutdown();
   return result;
 }
+
+bool RegTestHost::LoadBatchManifest(const char* path, std::vector<BatchJob>* jobs)
+{
+  Error error;
+  const std::optional<std::string> manifest = FileSystem::ReadFileToString(path, &error);
+  if (!manifest.has_value())
+  {
+    ERROR_LOG("Failed to read batch manifest '{}': {}", path, error.GetDescription());
+    return false;
+  }
+
+  u32 line_number = 0;
+  for (const std::string_view line : StringUtil::SplitString(manifest.value(), '\n', false))
+  {
+    line_number++;
+
+    const std::string_view stripped_line = StringUtil::StripWhitespace(line);
+    if (stripped_line.empty() || stripped_line.front() == '#')
+      continue;
+
+    const std::vector<std::string_view> fields = StringUtil::SplitString(stripped_line, '|', false);
+    const std::string_view game_path = StringUtil::StripWhitespace(fields.front());
+    if (game_path.empty())
+    {
+      ERROR_LOG("{}:{}: Missing game path.", Path::GetFileName(path), line_number);
+      return false;
+    }
+
+    BatchJob job;
+    job.path = Path::IsAbsolute(game_path) ? std::string(game_path) : Path::BuildRelativePath(path, game_path);
+    job.name = Path::GetFileTitle(job.path);
+
+    for (size_t i = 1; i < fields.size(); i++)
+    {
+      const std::string_view field = StringUtil::StripWhitespace(fields[i]);
+      const std::string_view::size_type equals_pos = field.find('=');
+      if (equals_pos == std::string_view::npos)
+      {
+        ERROR_LOG("{}:{}: Malformed field '{}'.", Path::GetFileName(path), line_number, field);
+        return false;
+      }
+
+      const std::string_view key = StringUtil::StripWhitespace(field.substr(0, equals_pos));
+      const std::string_view value = StringUtil::StripWhitespace(field.substr(equals_pos + 1));
+      if (key == "frames")
+      {
+        job.frames = StringUtil::FromChars<u32>(value);
+        if (job.frames.value_or(0) == 0)
+        {
+          ERROR_LOG("{}:{}: Invalid frame count '{}'.", Path::GetFileName(path), line_number, value);
+          return false;
+        }
+      }
+      else if (key == "renderer")
+      {
+        const std::optional<GPURenderer> renderer = Settings::ParseRendererName(TinyString(value));
+        if (!renderer.has_value())
+        {
+          ERROR_LOG("{}:{}: Invalid renderer '{}'.", Path::GetFileName(path), line_number, value);
+          return false;
+        }
+
+        job.settings.push_back({"GPU", "Renderer", Settings::GetRendererName(renderer.value())});
+      }
+      else if (key == "name")
+      {
+        if (value.empty())
+        {
+          ERROR_LOG("{}:{}: Invalid name.", Path::GetFileName(path), line_number);
+          return false;
+        }
+
+        job.name = value;
+      }
+      else
+      {
+        const std::string_view::size_type slash_pos = key.find('/');
+        if (slash_pos == std::string_view::npos || slash_pos == 0 || slash_pos == (key.length() - 1))
+        {
+          ERROR_LOG("{}:{}: Unknown field '{}'.", Path::GetFileName(path), line_number, key);
+          return false;
+        }
+
+        job.settings.push_back(
+          {std::string(key.substr(0, slash_pos)), std::string(key.substr(slash_pos + 1)), std::string(value)});
+      }
+    }
+
+    // Jobs write to their own dump directory, so names must be unique.
+    std::string base_name = std::move(job.name);
+    job.name = base_name;
+    for (u32 suffix = 2; std::any_of(jobs->begin(), jobs->end(),
+                                     [&job](const BatchJob& other) { return (other.name == job.name); });
+         suffix++)
+    {
+      job.name = fmt::format("{}_{}", base_name, suffix);
+    }
+
+    jobs->push_back(std::move(job));
+  }
+
+  return true;
+}
+
+void RegTestHost::RunBatchJob(const BatchJob& job, BatchJobResult* result)
+{
+  *result = {};
+
+  // Restore everything the job changes afterwards, since the next job may run in this process.
+  const u32 old_frames_to_run = s_frames_to_run;
+  const u32 old_frame_dump_interval = s_frame_dump_interval;
+  const std::string old_data_root = EmuFolders::DataRoot;
+  std::vector<std::optional<std::string>> old_settings;
+  old_settings.reserve(job.settings.size());
+  for (const BatchJob::SettingOverride& setting : job.settings)
+  {
+    std::string old_value;
+    old_settings.push_back(
+      s_base_settings_interface->GetStringValue(setting.section.c_str(), setting.key.c_str(), &old_value) ?
+        std::optional<std::string>(std::move(old_value)) :
+        std::nullopt);
+    s_base_settings_interface->SetStringValue(setting.section.c_str(), setting.key.c_str(), setting.value.c_str());
+  }
+
+  if (job.frames.has_value())
+    s_frames_to_run = job.frames.value();
+
+  if (SetNewDataRoot(job.name))
+  {
+    SystemBootParameters boot_params;
+    boot_params.filename = job.path;
+    result->success = RunSystem(std::move(boot_params), &result->execution_time_ms);
+    result->frames_executed = s_frames_to_run - s_frames_remaining;
+    StringUtil::Strlcpy(result->save_state_hash, s_state_hashes.save_state, sizeof(result->save_state_hash));
+    StringUtil::Strlcpy(result->ram_hash, s_state_hashes.ram, sizeof(result->ram_hash));
+    StringUtil::Strlcpy(result->spu_ram_hash, s_state_hashes.spu_ram, sizeof(result->spu_ram_hash));
+    StringUtil::Strlcpy(result->vram_hash, s_state_hashes.vram, sizeof(result->vram_hash));
+  }
+
+  for (size_t i = 0; i < job.settings.size(); i++)
+  {
+    const BatchJob::SettingOverride& setting = job.settings[i];
+    if (old_settings[i].has_value())
+      s_base_settings_interface->SetStringValue(setting.section.c_str(), setting.key.c_str(), old_settings[i]->c_str());
+    else
+      s_base_settings_interface->DeleteValue(setting.section.c_str(), setting.key.c_str());
+  }
+
+  s_frames_to_run = old_frames_to_run;
+  s_frame_dump_interval = old_frame_dump_interval;
+  EmuFolders::DataRoot = std::move(old_data_root);
+  s_state_hashes = {};
+}
+
+int RegTestHost::RunBatch()
+{
+  std::vector<BatchJob> jobs;
+  if (!LoadBatchManifest(s_batch_manifest_path.c_str(), &jobs))
+    return EXIT_FAILURE;
+  if (jobs.empty())
+  {
+    ERROR_LOG("Batch manifest '{}' contains no games.", s_batch_manifest_path);
+    return EXIT_FAILURE;
+  }
+
+  // Load the database once up front, instead of in every job.
+  GameDatabase::EnsureLoaded();
+
+  std::vector<BatchJobResult> results(jobs.size());
+  std::vector<double> wall_times(jobs.size());
+  size_t jobs_completed = 0;
+
+#ifndef _WIN32
+  const u32 num_workers = static_cast<u32>(std::min<size_t>(
+    (s_batch_jobs > 0) ? s_batch_jobs : std::max(std::thread::hardware_concurrency(), 1u), jobs.size()));
+  INFO_LOG("Running {} games with {} workers...", jobs.size(), num_workers);
+
+  // Each game runs in a forked worker, since the emulator state is global. The workers share the parent's
+  // copy of the game database. ProcessStartup() must happen in the worker, as guest RAM is shared memory.
+  struct Worker
+  {
+    pid_t pid;
+    int read_fd;
+    size_t job_index;
+    Timer::Value start_time;
+  };
+  std::vector<Worker> workers;
+  workers.reserve(num_workers);
+
+  // Results are written in a single write(), which is atomic and can't block below PIPE_BUF.
+  static_assert(sizeof(BatchJobResult) <= _POSIX_PIPE_BUF);
+
+  size_t next_job = 0;
+  while (next_job < jobs.size() || !workers.empty())
+  {
+    while (next_job < jobs.size() && workers.size() < num_workers)
+    {
+      const size_t job_index = next_job++;
+      int fds[2];
+      if (pipe(fds) != 0)
+      {
+        ERROR_LOG("pipe() failed: {}", errno);
+        jobs_completed++;
+        continue;
+      }
+
+      // Don't duplicate buffered output in the child.
+      std::fflush(stdout);
+      std::fflush(stderr);
+
+      const Timer::Value start_time = Timer::GetCurrentValue();
+      const pid_t pid = fork();
+      if (pid < 0)
+      {
+        ERROR_LOG("fork() failed: {}", errno);
+        close(fds[0]);
+        close(fds[1]);
+        jobs_completed++;
+        continue;
+      }
+      else if (pid == 0)
+      {
+        close(fds[0]);
+
+        Error error;
+        BatchJobResult result = {};
+        if (System::ProcessStartup(&error))
+        {
+          RunBatchJob(jobs[job_index], &result);
+          System::ProcessShutdown();
+        }
+        else
+        {
+          ERROR_LOG("ProcessStartup() failed: {}", error.GetDescription());
+        }
+
+        const bool written = (write(fds[1], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result)));
+        close(fds[1]);
+        std::fflush(stdout);
+        std::fflush(stderr);
+        _exit((written && result.success) ? EXIT_SUCCESS : EXIT_FAILURE);
+      }
+
+      close(fds[1]);
+      workers.push_back(Worker{pid, fds[0], job_index, start_time});
+    }
+
+    if (workers.empty())
+      continue;
+
+    int status;
+    const pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      ERROR_LOG("waitpid() failed: {}", errno);
+      break;
+    }
+
+    const auto iter = std::find_if(workers.begin(), workers.end(), [pid](const Worker& w) { return (w.pid == pid); });
+    if (iter == workers.end())
+      continue;
+
+    const BatchJob& job = jobs[iter->job_index];
+    BatchJobResult& result = results[iter->job_index];
+    wall_times[iter->job_index] = Timer::ConvertValueToMilliseconds(Timer::GetCurrentValue() - iter->start_time);
+    if (read(iter->read_fd, &result, sizeof(result)) != static_cast<ssize_t>(sizeof(result)))
+      result = {};
+    if (WIFSIGNALED(status))
+      ERROR_LOG("Worker for '{}' was terminated by signal {}.", job.name, WTERMSIG(status));
+
+    close(iter->read_fd);
+    workers.erase(iter);
+
+    jobs_completed++;
+    INFO_LOG("[{}/{}] {}: {}", jobs_completed, jobs.size(), job.name, result.success ? "OK" : "FAILED");
+  }
+#else
+  // No fork() here, so run the games one after another in this process. This still saves the process startup and
+  // game database load for each game.
+  if (s_batch_jobs > 1)
+    WARNING_LOG("Parallel batch jobs are not supported on this platform, running sequentially.");
+
+  Error error;
+  if (!System::ProcessStartup(&error))
+  {
+    ERROR_LOG("ProcessStartup() failed: {}", error.GetDescription());
+    return EXIT_FAILURE;
+  }
+
+  for (size_t i = 0; i < jobs.size(); i++)
+  {
+    const Timer::Value start_time = Timer::GetCurrentValue();
+    RunBatchJob(jobs[i], &results[i]);
+    wall_times[i] = Timer::ConvertValueToMilliseconds(Timer::GetCurrentValue() - start_time);
+
+    jobs_completed++;
+    INFO_LOG("[{}/{}] {}: {}", jobs_completed, jobs.size(), jobs[i].name, results[i].success ? "OK" : "FAILED");
+  }
+
+  System::ProcessShutdown();
+#endif
+
+  if (!s_batch_results_path.empty() && !WriteBatchResults(jobs, results, wall_times))
+    return EXIT_FAILURE;
+
+  const size_t failed_jobs =
+    std::count_if(results.begin(), results.end(), [](const BatchJobResult& r) { return !r.success; });
+  if (failed_jobs > 0)
+  {
+    ERROR_LOG("{} of {} games failed.", failed_jobs, jobs.size());
+    return EXIT_FAILURE;
+  }
+
+  INFO_LOG("All {} games completed successfully.", jobs.size());
+  return EXIT_SUCCESS;
+}
+
+void RegTestHost::AppendJSONString(std::string& dest, std::string_view str)
+{
+  dest.push_back('"');
+  for (const char ch : str)
+  {
+    switch (ch)
+    {
+      case '"':
+        dest.append("\\\"");
+        break;
+      case '\\':
+        dest.append("\\\\");
+        break;
+      case '\n':
+        dest.append("\\n");
+        break;
+      case '\r':
+        dest.append("\\r");
+        break;
+      case '\t':
+        dest.append("\\t");
+        break;
+      default:
+      {
+        if (static_cast<u8>(ch) < 0x20)
+          fmt::format_to(std::back_inserter(dest), "\\u{:04x}", static_cast<u8>(ch));
+        else
+          dest.push_back(ch);
+      }
+      break;
+    }
+  }
+  dest.push_back('"');
+}
+
+bool RegTestHost::WriteBatchResults(const std::vector<BatchJob>& jobs, const std::vector<BatchJobResult>& results,
+                                    const std::vector<double>& wall_times)
+{
+  std::string json;
+  json.append("{\n  \"version\": ");
+  AppendJSONString(json, g_scm_tag_str);
+  json.append(",\n  \"games\": [");
+
+  for (size_t i = 0; i < jobs.size(); i++)
+  {
+    const BatchJob& job = jobs[i];
+    const BatchJobResult& result = results[i];
+
+    json.append((i == 0) ? "\n    {\n      \"name\": " : ",\n    {\n      \"name\": ");
+    AppendJSONString(json, job.name);
+    json.append(",\n      \"path\": ");
+    AppendJSONString(json, job.path);
+    fmt::format_to(std::back_inserter(json), ",\n      \"success\": {},\n      \"frames\": {}", result.success,
+                   result.frames_executed);
+    fmt::format_to(std::back_inserter(json),
+                   ",\n      \"wall_time_ms\": {:.3f},\n      \"execution_time_ms\": {:.3f},\n      \"emulated_fps\": {:.3f}",
+                   wall_times[i], result.execution_time_ms,
+                   (result.execution_time_ms > 0.0) ?
+                     (static_cast<double>(result.frames_executed) / result.execution_time_ms * 1000.0) :
+                     0.0);
+
+    json.append(",\n      \"settings\": {");
+    for (size_t j = 0; j < job.settings.size(); j++)
+    {
+      json.append((j == 0) ? "\n        " : ",\n        ");
+      AppendJSONString(json, fmt::format("{}/{}", job.settings[j].section, job.settings[j].key));
+      json.append(": ");
+      AppendJSONString(json, job.settings[j].value);
+    }
+    json.append(job.settings.empty() ? "}" : "\n      }");
+
+    json.append(",\n      \"hashes\": {\n        \"save_state\": ");
+    AppendJSONString(json, result.save_state_hash);
+    json.append(",\n        \"ram\": ");
+    AppendJSONString(json, result.ram_hash);
+    json.append(",\n        \"spu_ram\": ");
+    AppendJSONString(json, result.spu_ram_hash);
+    json.append(",\n        \"vram\": ");
+    AppendJSONString(json, result.vram_hash);
+    json.append("\n      }");
+
+    json.append(",\n      \"frame_dumps\": [");
+    FileSystem::FindResultsArray frame_dumps;
+    if (!s_dump_base_directory.empty())
+    {
+      FileSystem::FindFiles(GetDumpDirectory(job.name).c_str(), "frame_*.png",
+                            FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_SORT_BY_NAME, &frame_dumps);
+    }
+    for (size_t j = 0; j < frame_dumps.size(); j++)
+    {
+      json.append((j == 0) ? "\n        " : ",\n        ");
+      AppendJSONString(json, frame_dumps[j].FileName);
+    }
+    json.append(frame_dumps.empty() ? "]" : "\n      ]");
+    json.append("\n    }");
+  }
+
+  json.append("\n  ]\n}\n");
+
+  Error error;
+  if (!FileSystem::WriteStringToFile(s_batch_results_path.c_str(), json, &error))
+  {
+    ERROR_LOG("Failed to write batch results to '{}': {}", s_batch_results_path, error.GetDescription());
+    return false;
+  }
+
+  INFO_LOG("Wrote batch results to '{}'.", s_batch_results_path);
+  return true;
+}
+
+bool RegTestHost::WriteBenchmarkResults(std::string_view boot_filename, double execution_time_ms)
+{
+  using PerformanceCounters::ProfileSection;
+
+  const u32 frames_executed = s_frames_to_run - s_frames_remaining;
+  const PerformanceCounters::ProfileSectionStats execution =
+    PerformanceCounters::GetProfileSectionStats(ProfileSection::Execution);
+  const PerformanceCounters::ProfileSectionStats events =
+    PerformanceCounters::GetProfileSectionStats(ProfileSection::TimingEvents);
+
+  std::string json;
+  json.append("{\n  \"version\": ");
+  AppendJSONString(json, g_scm_tag_str);
+  json.append(",\n  \"path\": ");
+  AppendJSONString(json, boot_filename);
+  json.append(",\n  \"renderer\": ");
+  AppendJSONString(json, Settings::GetRendererName(g_settings.gpu_renderer));
+  json.append(",\n  \"cpu_execution_mode\": ");
+  AppendJSONString(json, Settings::GetCPUExecutionModeName(g_settings.cpu_execution_mode));
+  fmt::format_to(std::back_inserter(json), ",\n  \"frames\": {},\n  \"execution_time_ms\": {:.3f}", frames_executed,
+                 execution_time_ms);
+  fmt::format_to(std::back_inserter(json), ",\n  \"emulated_fps\": {:.3f}",
+                 (execution_time_ms > 0.0) ? (static_cast<double>(frames_executed) / execution_time_ms * 1000.0) :
+                                             0.0);
+
+  // Timing events run from within CPU execution, report the CPU's own time separately.
+  fmt::format_to(std::back_inserter(json), ",\n  \"cpu_execution_ms\": {:.3f}",
+                 std::max(execution.total_time_ms - events.total_time_ms, 0.0));
+
+  json.append(",\n  \"sections\": {");
+  for (u32 i = 0; i < static_cast<u32>(ProfileSection::MaxCount); i++)
+  {
+    const ProfileSection section = static_cast<ProfileSection>(i);
+    const PerformanceCounters::ProfileSectionStats stats = PerformanceCounters::GetProfileSectionStats(section);
+    json.append((i == 0) ? "\n    " : ",\n    ");
+    AppendJSONString(json, PerformanceCounters::GetProfileSectionName(section));
+    fmt::format_to(std::back_inserter(json), ": {{ \"time_ms\": {:.3f}, \"count\": {} }}", stats.total_time_ms,
+                   stats.count);
+  }
+  json.append("\n  }");
+
+  json.append(",\n  \"timing_events\": {");
+  const std::vector<PerformanceCounters::TimingEventProfile> event_profiles =
+    PerformanceCounters::GetTimingEventProfiles();
+  for (size_t i = 0; i < event_profiles.size(); i++)
+  {
+    json.append((i == 0) ? "\n    " : ",\n    ");
+    AppendJSONString(json, event_profiles[i].name);
+    fmt::format_to(std::back_inserter(json), ": {{ \"time_ms\": {:.3f}, \"count\": {} }}",
+                   event_profiles[i].total_time_ms, event_profiles[i].count);
+  }
+  json.append(event_profiles.empty() ? "}" : "\n  }");
+  json.append("\n}\n");
+
+  Error error;
+  if (!FileSystem::WriteStringToFile(s_benchmark_results_path.c_str(), json, &error))
+  {
+    ERROR_LOG("Failed to write benchmark results to '{}': {}", s_benchmark_results_path, error.GetDescription());
+    return false;
+  }
+
+  INFO_LOG("Wrote benchmark results to '{}'.", s_benchmark_results_path);
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  CrashHandler::Install(&Bus::CleanupMemoryMap);
+
+  Error startup_error;
+  if (!System::PerformEarlyHardwareChecks(&startup_error))
+  {
+    ERROR_LOG("PerformEarlyHardwareChecks() failed: {}", startup_error.GetDescription());
+    return EXIT_FAILURE;
+  }
+
+  RegTestHost::InitializeEarlyConsole();
+
+  if (!RegTestHost::InitializeConfig())
+    return EXIT_FAILURE;
+
+  std::optional<SystemBootParameters> autoboot;
+  if (!RegTestHost::ParseCommandLineParameters(argc, argv, autoboot))
+    return EXIT_FAILURE;
+
+  if (!s_decode_trace_input_path.empty())
+  {
+    Error error;
+    FileSystem::ManagedCFilePtr output =
+      FileSystem::OpenManagedCFile(s_decode_trace_output_path.c_str(), "wb", &error);
+    if (!output || !CPU::Trace::DecodeFile(s_decode_trace_input_path.c_str(), output.get(), &error))
+    {
+      ERROR_LOG("Failed to decode CPU trace: {}", error.GetDescription());
+      return EXIT_FAILURE;
+    }
+
+    INFO_LOG("CPU trace written to '{}'.", s_decode_trace_output_path);
+    return EXIT_SUCCESS;
+  }
+
+  if (!s_batch_manifest_path.empty())
+  {
+    if (autoboot.has_value())
+    {
+      ERROR_LOG("A boot path can't be specified in batch mode.");
+      return EXIT_FAILURE;
+    }
+    if (!s_benchmark_results_path.empty())
+    {
+      ERROR_LOG("Benchmark mode can't be used in batch mode.");
+      return EXIT_FAILURE;
+    }
+    if (!s_cpu_trace_path.empty())
+    {
+      ERROR_LOG("CPU tracing can't be used in batch mode.");
+      return EXIT_FAILURE;
+    }
+
+    return RegTestHost::RunBatch();
+  }
+
+  if (!autoboot || autoboot->filename.empty())
+  {
+    ERROR_LOG("No boot path specified.");
+    return EXIT_FAILURE;
+  }
+
+  if (!RegTestHost::SetNewDataRoot(Path::GetFileTitle(autoboot->filename)))
+    return EXIT_FAILURE;
+
+  if (!System::ProcessStartup(&startup_error))
+  {
+    ERROR_LOG("ProcessStartup() failed: {}", startup_error.GetDescription());
+    return EXIT_FAILURE;
+  }
+
+  const std::string boot_filename = autoboot->filename;
+  const bool benchmark = !s_benchmark_results_path.empty();
+  if (benchmark)
+    PerformanceCounters::SetProfilingEnabled(true);
+
+  double execution_time_ms = 0.0;
+  bool result = RegTestHost::RunSystem(std::move(autoboot.value()), &execution_time_ms);
+  if (result && benchmark)
+    result = RegTestHost::WriteBenchmarkResults(boot_filename, execution_time_ms);
+  if (result)
+    INFO_LOG("Exiting with success.");
+
+  System::ProcessShutdown();
+  return result ? 0 : -1;
+}
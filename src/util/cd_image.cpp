@@ -351,6 +351,11 @@ bool CDImage::IsPrecached() const
   return false;
 }
 
+bool CDImage::IsMemoryMapped() const
+{
+  return false;
+}
+
 s64 CDImage::GetSizeOnDisk() const
 {
   return -1;
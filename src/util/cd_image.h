@@ -250,6 +250,11 @@ public:
   static std::unique_ptr<CDImage> OpenDeviceImage(const char* path, Error* error);
   static std::unique_ptr<CDImage>
   CreateMemoryImage(CDImage* image, ProgressCallback* progress = ProgressCallback::NullProgressCallback);
+  static std::unique_ptr<CDImage>
+  CreateCompressedMemoryImage(CDImage* image, ProgressCallback* progress = ProgressCallback::NullProgressCallback);
+
+  // Copies the image to shared memory keyed by its contents, or attaches to the copy made by another process.
+  static std::unique_ptr<CDImage> CreateSharedMemoryImage(CDImage* image, ProgressCallback* progress, Error* error);
   static std::unique_ptr<CDImage> OverlayPPFPatch(const char* path, std::unique_ptr<CDImage> parent_image,
                                                   ProgressCallback* progress = ProgressCallback::NullProgressCallback);
 
@@ -330,6 +335,9 @@ public:
   virtual PrecacheResult Precache(ProgressCallback* progress = ProgressCallback::NullProgressCallback);
   virtual bool IsPrecached() const;
 
+  // Returns true if sector reads are served from a memory mapping, and are cheap enough to do on the calling thread.
+  virtual bool IsMemoryMapped() const;
+
   // Returns the size on disk of the image. This could be multiple files.
   // If this function returns -1, it means the size could not be computed.
   virtual s64 GetSizeOnDisk() const;
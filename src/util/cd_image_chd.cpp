@@ -13,18 +13,22 @@
 #include "common/log.h"
 #include "common/path.h"
 #include "common/string_util.h"
+#include "common/threading.h"
 
 #include "fmt/format.h"
 #include "libchdr/cdrom.h"
 #include "libchdr/chd.h"
 
 #include <algorithm>
+#include <array>
 #include <cerrno>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
 #include <limits>
 #include <mutex>
 #include <optional>
+#include <thread>
 
 LOG_CHANNEL(CDImage);
 
@@ -77,17 +81,64 @@ private:
   static constexpr u32 CHD_CD_TRACK_ALIGNMENT = 4;
   static constexpr u32 MAX_PARENTS = 32; // Surely someone wouldn't be insane enough to go beyond this...
 
+  // Decompressed hunks are kept in a small LRU cache, so alternating between hunks doesn't decompress them again.
+  // Sequential reads start a worker thread which decompresses the following hunks ahead of time.
+  static constexpr u32 HUNK_CACHE_SIZE = 16;
+  static constexpr u32 PREFETCH_HUNK_COUNT = 4;
+  static constexpr u32 INVALID_HUNK = static_cast<u32>(-1);
+
+  enum class HunkState : u8
+  {
+    Empty,
+    Loading,
+    Ready,
+  };
+
+  struct CachedHunk
+  {
+    u32 hunk_index = INVALID_HUNK;
+    u32 last_used = 0;
+    HunkState state = HunkState::Empty;
+  };
+
   chd_file* OpenCHD(std::string_view filename, FileSystem::ManagedCFilePtr fp, Error* error, u32 recursion_level);
-  bool UpdateHunkBuffer(const Index& index, LBA lba_in_index, u32& hunk_offset);
+  const u8* GetHunkForSector(const Index& index, LBA lba_in_index, u32& hunk_offset);
+
+  u8* GetCachedHunkData(u32 slot);
+  std::optional<u32> FindCachedHunk(u32 hunk_index) const;
+  u32 AllocateCachedHunk(u32 hunk_index);
+  bool DecompressHunk(std::unique_lock<std::mutex>& lock, u32 slot);
+
+  void QueuePrefetch(u32 hunk_index);
+  void PrefetchThreadEntryPoint();
+  void StopPrefetchThread();
 
   static void CopyAndSwap(void* dst_ptr, const u8* src_ptr);
 
   chd_file* m_chd = nullptr;
   u32 m_hunk_size = 0;
+  u32 m_hunk_count = 0;
   u32 m_sectors_per_hunk = 0;
 
-  DynamicHeapArray<u8, 16> m_hunk_buffer;
-  u32 m_current_hunk_index = static_cast<u32>(-1);
+  // Only accessed from the reading thread. The current hunk is never evicted.
+  const u8* m_current_hunk_data = nullptr;
+  u32 m_current_hunk_index = INVALID_HUNK;
+  u32 m_current_hunk_slot = INVALID_HUNK;
+
+  // Protected by m_cache_mutex. m_chd_mutex is held while decompressing, since libchdr isn't thread-safe.
+  std::mutex m_cache_mutex;
+  std::mutex m_chd_mutex;
+  std::condition_variable m_hunk_loaded_cv;
+  DynamicHeapArray<u8, 16> m_hunk_cache_data;
+  std::array<CachedHunk, HUNK_CACHE_SIZE> m_hunk_cache;
+  u32 m_hunk_cache_counter = 0;
+
+  std::thread m_prefetch_thread;
+  std::condition_variable m_prefetch_cv;
+  u32 m_prefetch_start = INVALID_HUNK;
+  u32 m_prefetch_end = INVALID_HUNK;
+  bool m_prefetch_shutdown = false;
+
   bool m_precached = false;
 };
 } // namespace
@@ -96,6 +147,8 @@ CDImageCHD::CDImageCHD() = default;
 
 CDImageCHD::~CDImageCHD()
 {
+  StopPrefetchThread();
+
   if (m_chd)
     chd_close(m_chd);
 }
@@ -257,8 +310,9 @@ bool CDImageCHD::Open(const char* filename, Error* error)
     return false;
   }
 
+  m_hunk_count = header->totalhunks;
   m_sectors_per_hunk = m_hunk_size / CHD_CD_SECTOR_DATA_SIZE;
-  m_hunk_buffer.resize(m_hunk_size);
+  m_hunk_cache_data.resize(m_hunk_size * HUNK_CACHE_SIZE);
   m_filename = filename;
 
   u32 disc_lba = 0;
@@ -421,11 +475,12 @@ bool CDImageCHD::ReadSubChannelQ(SubChannelQ* subq, const Index& index, LBA lba_
     return CDImage::ReadSubChannelQ(subq, index, lba_in_index);
 
   u32 hunk_offset;
-  if (!UpdateHunkBuffer(index, lba_in_index, hunk_offset))
+  const u8* hunk_data = GetHunkForSector(index, lba_in_index, hunk_offset);
+  if (!hunk_data)
     return false;
 
   u8 deinterleaved_subchannel_data[96];
-  const u8* raw_subchannel_data = &m_hunk_buffer[hunk_offset + RAW_SECTOR_SIZE];
+  const u8* raw_subchannel_data = &hunk_data[hunk_offset + RAW_SECTOR_SIZE];
   const u8* real_subchannel_data = raw_subchannel_data;
   if (index.submode == CDImage::SubchannelMode::RawInterleaved)
   {
@@ -458,6 +513,7 @@ CDImage::PrecacheResult CDImageCHD::Precache(ProgressCallback* progress)
     static_cast<ProgressCallback*>(param)->SetProgressValue(static_cast<u32>((pos + (one_mb - 1)) / one_mb));
   };
 
+  std::unique_lock lock(m_chd_mutex);
   if (chd_precache_progress(m_chd, callback, progress) != CHDERR_NONE)
     return CDImage::PrecacheResult::ReadError;
 
@@ -492,19 +548,20 @@ ALWAYS_INLINE_RELEASE void CDImageCHD::CopyAndSwap(void* dst_ptr, const u8* src_
 bool CDImageCHD::ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index)
 {
   u32 hunk_offset;
-  if (!UpdateHunkBuffer(index, lba_in_index, hunk_offset))
+  const u8* hunk_data = GetHunkForSector(index, lba_in_index, hunk_offset);
+  if (!hunk_data)
     return false;
 
   // Audio data is in big-endian, so we have to swap it for little endian hosts...
   if (index.mode == TrackMode::Audio)
-    CopyAndSwap(buffer, &m_hunk_buffer[hunk_offset]);
+    CopyAndSwap(buffer, &hunk_data[hunk_offset]);
   else
-    std::memcpy(buffer, &m_hunk_buffer[hunk_offset], RAW_SECTOR_SIZE);
+    std::memcpy(buffer, &hunk_data[hunk_offset], RAW_SECTOR_SIZE);
 
   return true;
 }
 
-ALWAYS_INLINE_RELEASE bool CDImageCHD::UpdateHunkBuffer(const Index& index, LBA lba_in_index, u32& hunk_offset)
+ALWAYS_INLINE_RELEASE const u8* CDImageCHD::GetHunkForSector(const Index& index, LBA lba_in_index, u32& hunk_offset)
 {
   const u32 disc_frame = static_cast<LBA>(index.file_offset) + lba_in_index;
   const u32 hunk_index = static_cast<u32>(disc_frame / m_sectors_per_hunk);
@@ -512,22 +569,170 @@ ALWAYS_INLINE_RELEASE bool CDImageCHD::UpdateHunkBuffer(const Index& index, LBA
   DebugAssert((m_hunk_size - hunk_offset) >= CHD_CD_SECTOR_DATA_SIZE);
 
   if (m_current_hunk_index == hunk_index)
-    return true;
+    return m_current_hunk_data;
+
+  std::unique_lock lock(m_cache_mutex);
+
+  u32 slot;
+  if (const std::optional<u32> cached_slot = FindCachedHunk(hunk_index); cached_slot.has_value())
+  {
+    // Might be getting prefetched right now.
+    slot = cached_slot.value();
+    m_hunk_loaded_cv.wait(lock, [this, slot]() { return (m_hunk_cache[slot].state != HunkState::Loading); });
+    if (m_hunk_cache[slot].state != HunkState::Ready || m_hunk_cache[slot].hunk_index != hunk_index)
+    {
+      // Prefetch failed, try again and report the error.
+      slot = AllocateCachedHunk(hunk_index);
+      if (!DecompressHunk(lock, slot))
+        return nullptr;
+    }
+  }
+  else
+  {
+    slot = AllocateCachedHunk(hunk_index);
+    if (!DecompressHunk(lock, slot))
+      return nullptr;
+  }
+
+  m_hunk_cache[slot].last_used = ++m_hunk_cache_counter;
+
+  // Only bother prefetching for sequential reads, e.g. streaming audio/video.
+  const bool sequential = (m_current_hunk_index != INVALID_HUNK && hunk_index == (m_current_hunk_index + 1));
+  m_current_hunk_data = GetCachedHunkData(slot);
+  m_current_hunk_index = hunk_index;
+  m_current_hunk_slot = slot;
+  lock.unlock();
+
+  if (sequential)
+    QueuePrefetch(hunk_index + 1);
+
+  return m_current_hunk_data;
+}
+
+u8* CDImageCHD::GetCachedHunkData(u32 slot)
+{
+  return &m_hunk_cache_data[slot * m_hunk_size];
+}
+
+std::optional<u32> CDImageCHD::FindCachedHunk(u32 hunk_index) const
+{
+  for (u32 i = 0; i < HUNK_CACHE_SIZE; i++)
+  {
+    if (m_hunk_cache[i].hunk_index == hunk_index && m_hunk_cache[i].state != HunkState::Empty)
+      return i;
+  }
+
+  return std::nullopt;
+}
+
+u32 CDImageCHD::AllocateCachedHunk(u32 hunk_index)
+{
+  // Evict the least recently used hunk, except for the one being read from, or any that are being decompressed.
+  u32 slot = INVALID_HUNK;
+  for (u32 i = 0; i < HUNK_CACHE_SIZE; i++)
+  {
+    const CachedHunk& hunk = m_hunk_cache[i];
+    if (hunk.state == HunkState::Loading || i == m_current_hunk_slot)
+      continue;
+
+    if (hunk.state == HunkState::Empty)
+    {
+      slot = i;
+      break;
+    }
+
+    if (slot == INVALID_HUNK || hunk.last_used < m_hunk_cache[slot].last_used)
+      slot = i;
+  }
+
+  // There's at most one hunk being prefetched at a time, so this should never happen.
+  AssertMsg(slot != INVALID_HUNK, "Hunk cache has a free slot");
+
+  CachedHunk& hunk = m_hunk_cache[slot];
+  hunk.hunk_index = hunk_index;
+  hunk.last_used = m_hunk_cache_counter;
+  hunk.state = HunkState::Loading;
+  return slot;
+}
+
+bool CDImageCHD::DecompressHunk(std::unique_lock<std::mutex>& lock, u32 slot)
+{
+  const u32 hunk_index = m_hunk_cache[slot].hunk_index;
+  u8* const data = GetCachedHunkData(slot);
+
+  // The cache can be used while we're decompressing, the slot is reserved.
+  lock.unlock();
+
+  chd_error err;
+  {
+    std::unique_lock chd_lock(m_chd_mutex);
+    err = chd_read(m_chd, hunk_index, data);
+  }
+
+  lock.lock();
+
+  // data might have been partially written
+  m_hunk_cache[slot].state = (err == CHDERR_NONE) ? HunkState::Ready : HunkState::Empty;
+  m_hunk_loaded_cv.notify_all();
 
-  const chd_error err = chd_read(m_chd, hunk_index, m_hunk_buffer.data());
   if (err != CHDERR_NONE)
   {
     ERROR_LOG("chd_read({}) failed: {}", hunk_index, chd_error_string(err));
-
-    // data might have been partially written
-    m_current_hunk_index = static_cast<u32>(-1);
     return false;
   }
 
-  m_current_hunk_index = hunk_index;
   return true;
 }
 
+void CDImageCHD::QueuePrefetch(u32 hunk_index)
+{
+  if (hunk_index >= m_hunk_count)
+    return;
+
+  std::unique_lock lock(m_cache_mutex);
+  m_prefetch_start = hunk_index;
+  m_prefetch_end = std::min(hunk_index + PREFETCH_HUNK_COUNT, m_hunk_count);
+  m_prefetch_cv.notify_one();
+
+  // Images that are only read a few sectors from, e.g. when scanning, never need the thread.
+  if (!m_prefetch_thread.joinable())
+    m_prefetch_thread = std::thread(&CDImageCHD::PrefetchThreadEntryPoint, this);
+}
+
+void CDImageCHD::PrefetchThreadEntryPoint()
+{
+  Threading::SetNameOfCurrentThread("CHD Prefetch");
+
+  std::unique_lock lock(m_cache_mutex);
+  for (;;)
+  {
+    m_prefetch_cv.wait(lock, [this]() { return (m_prefetch_shutdown || m_prefetch_start != m_prefetch_end); });
+    if (m_prefetch_shutdown)
+      break;
+
+    // A new request replaces the remainder of the old one.
+    const u32 hunk_index = m_prefetch_start++;
+    if (FindCachedHunk(hunk_index).has_value())
+      continue;
+
+    DecompressHunk(lock, AllocateCachedHunk(hunk_index));
+  }
+}
+
+void CDImageCHD::StopPrefetchThread()
+{
+  if (!m_prefetch_thread.joinable())
+    return;
+
+  {
+    std::unique_lock lock(m_cache_mutex);
+    m_prefetch_shutdown = true;
+    m_prefetch_cv.notify_one();
+  }
+
+  m_prefetch_thread.join();
+}
+
 s64 CDImageCHD::GetSizeOnDisk() const
 {
   return static_cast<s64>(chd_get_compressed_size(m_chd));
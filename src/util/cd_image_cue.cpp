@@ -10,6 +10,7 @@
 #include "common/error.h"
 #include "common/file_system.h"
 #include "common/log.h"
+#include "common/memmap.h"
 #include "common/path.h"
 #include "common/string_util.h"
 
@@ -40,6 +41,9 @@ public:
 
   virtual bool Read(void* buffer, u64 offset, u32 size, Error* error) = 0;
 
+  /// Returns true if reads are served from a memory mapping of the file.
+  virtual bool IsMemoryMapped() const;
+
 protected:
   std::string m_filename;
 };
@@ -55,9 +59,22 @@ public:
 
   bool Read(void* buffer, u64 offset, u32 size, Error* error) override;
 
+  bool IsMemoryMapped() const override;
+
 private:
+  // Granularity of the access hints given to the host for mapped files.
+  static constexpr u64 ADVISE_WINDOW_SIZE = 512 * 1024;
+
+  void MapFile();
+  void UnmapFile();
+  bool ReadFromMapping(void* buffer, u64 offset, u32 size, Error* error);
+
   FileSystem::ManagedCFilePtr m_file;
   u64 m_file_position = 0;
+
+  const u8* m_mapping = nullptr;
+  u64 m_mapping_size = 0;
+  u64 m_advised_window = std::numeric_limits<u64>::max();
 };
 
 class ECMTrackFileInterface final : public TrackFileInterface
@@ -143,6 +160,7 @@ public:
   bool OpenAndParseSingleFile(const char* path, Error* error);
 
   s64 GetSizeOnDisk() const override;
+  bool IsMemoryMapped() const override;
 
 protected:
   bool ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index) override;
@@ -161,12 +179,21 @@ TrackFileInterface::TrackFileInterface(std::string filename) : m_filename(std::m
 
 TrackFileInterface::~TrackFileInterface() = default;
 
+bool TrackFileInterface::IsMemoryMapped() const
+{
+  return false;
+}
+
 BinaryTrackFileInterface::BinaryTrackFileInterface(std::string filename, FileSystem::ManagedCFilePtr file)
   : TrackFileInterface(std::move(filename)), m_file(std::move(file))
 {
+  MapFile();
 }
 
-BinaryTrackFileInterface::~BinaryTrackFileInterface() = default;
+BinaryTrackFileInterface::~BinaryTrackFileInterface()
+{
+  UnmapFile();
+}
 
 std::unique_ptr<TrackFileInterface> TrackFileInterface::OpenBinaryFile(const std::string_view filename,
                                                                        const std::string& path, Error* error)
@@ -190,8 +217,75 @@ std::unique_ptr<TrackFileInterface> TrackFileInterface::OpenBinaryFile(const std
   return fi;
 }
 
+void BinaryTrackFileInterface::MapFile()
+{
+  // Mapping a whole disc image on a 32-bit host would eat a large chunk of the address space.
+  if constexpr (sizeof(void*) < sizeof(u64))
+    return;
+
+  const s64 size = FileSystem::FSize64(m_file.get());
+  if (size <= 0)
+    return;
+
+  Error error;
+  m_mapping = static_cast<const u8*>(MemMap::MapFileReadOnly(m_file.get(), static_cast<size_t>(size), &error));
+  if (!m_mapping)
+  {
+    WARNING_LOG("Failed to map '{}', falling back to buffered reads: {}", m_filename, error.GetDescription());
+    return;
+  }
+
+  m_mapping_size = static_cast<u64>(size);
+  MemMap::AdviseSequentialAccess(m_mapping, static_cast<size_t>(m_mapping_size));
+  DEV_LOG("Mapped {} bytes of '{}'", m_mapping_size, m_filename);
+}
+
+void BinaryTrackFileInterface::UnmapFile()
+{
+  if (!m_mapping)
+    return;
+
+  MemMap::UnmapFile(m_mapping, static_cast<size_t>(m_mapping_size));
+  m_mapping = nullptr;
+  m_mapping_size = 0;
+}
+
+bool BinaryTrackFileInterface::IsMemoryMapped() const
+{
+  return (m_mapping != nullptr);
+}
+
+bool BinaryTrackFileInterface::ReadFromMapping(void* buffer, u64 offset, u32 size, Error* error)
+{
+  if (offset > m_mapping_size || size > (m_mapping_size - offset)) [[unlikely]]
+  {
+    Error::SetStringFmt(error, "Read of {} bytes at offset {} is past the end of the file", size, offset);
+    return false;
+  }
+
+  // Replaces readahead: when we move into a new window, ask the host to start paging in the one after it.
+  const u64 window = offset / ADVISE_WINDOW_SIZE;
+  if (window != m_advised_window)
+  {
+    m_advised_window = window;
+
+    const u64 next_window_offset = (window + 1) * ADVISE_WINDOW_SIZE;
+    if (next_window_offset < m_mapping_size)
+    {
+      MemMap::AdviseWillNeed(m_mapping + next_window_offset,
+                             static_cast<size_t>(std::min(ADVISE_WINDOW_SIZE, m_mapping_size - next_window_offset)));
+    }
+  }
+
+  std::memcpy(buffer, m_mapping + offset, size);
+  return true;
+}
+
 bool BinaryTrackFileInterface::Read(void* buffer, u64 offset, u32 size, Error* error)
 {
+  if (m_mapping)
+    return ReadFromMapping(buffer, offset, size, error);
+
   if (m_file_position != offset)
   {
     if (!FileSystem::FSeek64(m_file.get(), static_cast<s64>(offset), SEEK_SET, error)) [[unlikely]]
@@ -883,6 +977,14 @@ s64 CDImageCueSheet::GetSizeOnDisk() const
   return size;
 }
 
+bool CDImageCueSheet::IsMemoryMapped() const
+{
+  return (!m_files.empty() && std::all_of(m_files.begin(), m_files.end(),
+                                          [](const std::unique_ptr<TrackFileInterface>& tf) {
+                                            return tf->IsMemoryMapped();
+                                          }));
+}
+
 std::unique_ptr<CDImage> CDImage::OpenCueSheetImage(const char* path, Error* error)
 {
   std::unique_ptr<CDImageCueSheet> image = std::make_unique<CDImageCueSheet>();
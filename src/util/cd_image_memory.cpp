@@ -3,13 +3,28 @@
 
 #include "cd_image.h"
 
+#include "common/align.h"
 #include "common/assert.h"
+#include "common/error.h"
 #include "common/file_system.h"
+#include "common/heap_array.h"
 #include "common/log.h"
+#include "common/memmap.h"
 #include "common/path.h"
+#include "common/small_string.h"
+#include "common/timer.h"
+
+#ifndef XXH_STATIC_LINKING_ONLY
+#define XXH_STATIC_LINKING_ONLY
+#endif
+#include "xxhash.h"
+
+#include <zstd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <optional>
 
 LOG_CHANNEL(CDImage);
 
@@ -22,38 +37,143 @@ public:
   ~CDImageMemory() override;
 
   bool CopyImage(CDImage* image, ProgressCallback* progress);
+  bool ShareImage(CDImage* image, ProgressCallback* progress, Error* error);
 
   bool IsPrecached() const override;
 
 protected:
   bool ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index) override;
 
+  static u32 GetDataSectorCount(CDImage* image);
+  bool CopyLayout(CDImage* image);
+
+  u32 m_memory_sectors = 0;
+
 private:
+  static bool IsKeySector(u32 sector, u32 count);
+  static std::optional<u64> GetContentKey(CDImage* image, u64* sample_hash, Error* error);
+  u64 GetSampleHash() const;
+
+  bool ReadSectors(CDImage* image, ProgressCallback* progress, std::atomic<u32>* sectors_written);
+  bool WaitForSharedImage(u64 key, u64 sample_hash, ProgressCallback* progress, bool* stale, Error* error);
+  void CloseSharedImage(bool delete_if_unused);
+
   u8* m_memory = nullptr;
-  u32 m_memory_sectors = 0;
+
+  std::string m_shared_name;
+  void* m_shared_handle = nullptr;
+  void* m_shared_mapping = nullptr;
+  size_t m_shared_mapping_size = 0;
+};
+
+/// Keeps the image as independently-compressed blocks of sectors, and decompresses blocks as they are read.
+class CDImageCompressedMemory final : public CDImageMemory
+{
+public:
+  CDImageCompressedMemory();
+  ~CDImageCompressedMemory() override;
+
+  bool CompressImage(CDImage* image, ProgressCallback* progress);
+
+protected:
+  bool ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index) override;
+
+private:
+  // Decompressed blocks are kept in a small LRU cache, so readahead and re-reads don't decompress them again.
+  static constexpr u32 SECTORS_PER_BLOCK = 32;
+  static constexpr u32 BLOCK_SIZE = SECTORS_PER_BLOCK * RAW_SECTOR_SIZE;
+  static constexpr u32 BLOCK_CACHE_SIZE = 8;
+  static constexpr u32 INVALID_BLOCK = static_cast<u32>(-1);
+  static constexpr int COMPRESSION_LEVEL = 1;
+
+  struct CachedBlock
+  {
+    u32 block_index = INVALID_BLOCK;
+    u32 last_used = 0;
+  };
+
+  u32 GetBlockSize(u32 block_index) const;
+  bool CompressBlock(ZSTD_CCtx* cctx, const u8* data, u32 size);
+  const u8* GetBlock(u32 block_index);
+
+  // Blocks which don't compress are stored as-is.
+  std::vector<u8> m_compressed_data;
+  std::vector<size_t> m_block_offsets;
+  ZSTD_DCtx* m_dctx = nullptr;
+
+  DynamicHeapArray<u8, 16> m_block_cache_data;
+  std::array<CachedBlock, BLOCK_CACHE_SIZE> m_block_cache;
+  u32 m_block_cache_counter = 0;
+};
+
+/// Shared images begin with this header, and the sectors follow at SHARED_IMAGE_DATA_OFFSET.
+/// The key only covers the file identity, layout and a sample of the sectors, so it's cheap for every process to
+/// compute. The creator also stores a hash of every sector, which is checked before using the image.
+/// The process which creates the mapping fills it while the others wait for the state to change. Where the platform
+/// supports it, the creator holds an exclusive lock on the mapping while filling, and every process using it holds a
+/// shared lock, so a creator which died part way through can be detected, and the last process to close it removes it.
+struct SharedImageHeader
+{
+  u32 magic;
+  u32 version;
+  u64 key;
+  u64 content_hash;
+  u32 sector_count;
+  std::atomic<u32> state;
+  std::atomic<u32> sectors_written;
 };
 
 } // namespace
 
+static_assert(std::atomic<u32>::is_always_lock_free, "Atomics in shared memory must be lock-free");
+
+static constexpr u32 SHARED_IMAGE_MAGIC = 0x4D494443; // CDIM
+static constexpr u32 SHARED_IMAGE_VERSION = 3;
+static constexpr size_t SHARED_IMAGE_DATA_OFFSET = 64;
+static_assert(sizeof(SharedImageHeader) <= SHARED_IMAGE_DATA_OFFSET);
+
+// Zero-filled mappings start in the filling state.
+static constexpr u32 SHARED_IMAGE_STATE_FILLING = 0;
+static constexpr u32 SHARED_IMAGE_STATE_READY = 1;
+static constexpr u32 SHARED_IMAGE_STATE_FAILED = 2;
+
+static constexpr u64 SHARED_IMAGE_POLL_INTERVAL_NS = 10000000;
+// Longer than it takes OpenOrCreateSharedMemory() to remove an empty object left by a creator which died.
+static constexpr double SHARED_IMAGE_OPEN_TIMEOUT = 15.0;
+static constexpr double SHARED_IMAGE_STALL_TIMEOUT = 30.0;
+static constexpr u32 SHARED_IMAGE_MAX_ATTEMPTS = 3;
+
+// The first sectors hold the system area and volume descriptors, the rest are sampled evenly.
+static constexpr u32 SHARED_IMAGE_KEY_HEAD_SECTORS = 32;
+static constexpr u32 SHARED_IMAGE_KEY_SAMPLED_SECTORS = 256;
+
 CDImageMemory::CDImageMemory() = default;
 
 CDImageMemory::~CDImageMemory()
 {
-  if (m_memory)
+  if (m_shared_handle)
+    CloseSharedImage(true);
+  else if (m_memory)
     std::free(m_memory);
 }
 
-bool CDImageMemory::CopyImage(CDImage* image, ProgressCallback* progress)
+u32 CDImageMemory::GetDataSectorCount(CDImage* image)
 {
   // figure out the total number of sectors (not including blank pregaps)
-  m_memory_sectors = 0;
+  u32 count = 0;
   for (u32 i = 0; i < image->GetIndexCount(); i++)
   {
     const Index& index = image->GetIndex(i);
     if (index.file_sector_size > 0)
-      m_memory_sectors += image->GetIndex(i).length;
+      count += index.length;
   }
 
+  return count;
+}
+
+bool CDImageMemory::CopyImage(CDImage* image, ProgressCallback* progress)
+{
+  m_memory_sectors = GetDataSectorCount(image);
   if ((static_cast<u64>(RAW_SECTOR_SIZE) * static_cast<u64>(m_memory_sectors)) >=
       static_cast<u64>(std::numeric_limits<size_t>::max()))
   {
@@ -71,6 +191,252 @@ bool CDImageMemory::CopyImage(CDImage* image, ProgressCallback* progress)
     return false;
   }
 
+  return ReadSectors(image, progress, nullptr) && CopyLayout(image);
+}
+
+bool CDImageMemory::IsKeySector(u32 sector, u32 count)
+{
+  const u32 stride = std::max(count / SHARED_IMAGE_KEY_SAMPLED_SECTORS, 1u);
+  return (sector < SHARED_IMAGE_KEY_HEAD_SECTORS || (sector % stride) == 0 || sector == (count - 1));
+}
+
+std::optional<u64> CDImageMemory::GetContentKey(CDImage* image, u64* sample_hash, Error* error)
+{
+  XXH3_state_t state;
+  XXH3_64bits_reset(&state);
+
+  // Patched images have the same layout, but usually a different size or modification time on disk.
+  FILESYSTEM_STAT_DATA sd;
+  const s64 modification_time =
+    FileSystem::StatFile(image->GetPath().c_str(), &sd) ? static_cast<s64>(sd.ModificationTime) : 0;
+  const std::array<s64, 4> identity = {image->GetSizeOnDisk(), modification_time,
+                                       static_cast<s64>(image->GetLBACount()),
+                                       static_cast<s64>(image->GetCurrentSubImage())};
+  XXH3_64bits_update(&state, identity.data(), sizeof(identity));
+
+  XXH3_state_t sample_state;
+  XXH3_64bits_reset(&sample_state);
+
+  const u32 sector_count = GetDataSectorCount(image);
+  std::array<u8, RAW_SECTOR_SIZE> sector;
+  u32 sector_number = 0;
+  for (u32 i = 0; i < image->GetIndexCount(); i++)
+  {
+    const Index& index = image->GetIndex(i);
+    const std::array<u32, 8> layout = {index.start_lba_on_disc,
+                                       index.track_number,
+                                       index.index_number,
+                                       index.start_lba_in_track,
+                                       index.length,
+                                       static_cast<u32>(index.mode),
+                                       index.control.bits,
+                                       (index.file_sector_size > 0) ? 1u : 0u};
+    XXH3_64bits_update(&state, layout.data(), sizeof(layout));
+    if (index.file_sector_size == 0)
+      continue;
+
+    for (u32 lba = 0; lba < index.length; lba++, sector_number++)
+    {
+      if (!IsKeySector(sector_number, sector_count))
+        continue;
+
+      if (!image->ReadSectorFromIndex(sector.data(), index, lba))
+      {
+        Error::SetStringFmt(error, "Failed to read LBA {} in index {}", lba, i);
+        return std::nullopt;
+      }
+
+      XXH3_64bits_update(&sample_state, sector.data(), sector.size());
+    }
+  }
+
+  *sample_hash = XXH3_64bits_digest(&sample_state);
+  XXH3_64bits_update(&state, sample_hash, sizeof(*sample_hash));
+  return XXH3_64bits_digest(&state);
+}
+
+u64 CDImageMemory::GetSampleHash() const
+{
+  // Sectors are stored in the same order as GetContentKey() reads them.
+  XXH3_state_t state;
+  XXH3_64bits_reset(&state);
+  for (u32 i = 0; i < m_memory_sectors; i++)
+  {
+    if (IsKeySector(i, m_memory_sectors))
+      XXH3_64bits_update(&state, &m_memory[static_cast<size_t>(i) * RAW_SECTOR_SIZE], RAW_SECTOR_SIZE);
+  }
+
+  return XXH3_64bits_digest(&state);
+}
+
+bool CDImageMemory::ShareImage(CDImage* image, ProgressCallback* progress, Error* error)
+{
+  m_memory_sectors = GetDataSectorCount(image);
+  const u64 data_size = static_cast<u64>(RAW_SECTOR_SIZE) * static_cast<u64>(m_memory_sectors);
+  if ((SHARED_IMAGE_DATA_OFFSET + data_size + HOST_PAGE_SIZE) >= static_cast<u64>(std::numeric_limits<size_t>::max()))
+  {
+    Error::SetStringView(error, "Insufficient address space.");
+    return false;
+  }
+
+  u64 sample_hash;
+  const std::optional<u64> key = GetContentKey(image, &sample_hash, error);
+  if (!key.has_value())
+    return false;
+
+  m_shared_name =
+    MemMap::GetGlobalFileMappingName(TinyString::from_format("duckstation_cdimage_{:016X}", key.value()));
+  m_shared_mapping_size =
+    Common::AlignUpPow2(static_cast<size_t>(SHARED_IMAGE_DATA_OFFSET + data_size), HOST_PAGE_SIZE);
+
+  for (u32 attempt = 1;; attempt++)
+  {
+    // Another process may have just created the object, and not resized it yet.
+    bool created = false;
+    const Timer::Value open_start_time = Timer::GetCurrentValue();
+    while (!(m_shared_handle =
+               MemMap::OpenOrCreateSharedMemory(m_shared_name.c_str(), m_shared_mapping_size, &created, error)))
+    {
+      if (Timer::ConvertValueToSeconds(Timer::GetCurrentValue() - open_start_time) >= SHARED_IMAGE_OPEN_TIMEOUT)
+        return false;
+
+      Timer::NanoSleep(SHARED_IMAGE_POLL_INTERVAL_NS);
+    }
+
+    m_shared_mapping = MemMap::MapSharedMemory(m_shared_handle, 0, nullptr, m_shared_mapping_size,
+                                               created ? PageProtect::ReadWrite : PageProtect::ReadOnly);
+    if (!m_shared_mapping)
+    {
+      Error::SetStringFmt(error, "Failed to map {} bytes of shared memory.", m_shared_mapping_size);
+      return false;
+    }
+
+    SharedImageHeader* const hdr = static_cast<SharedImageHeader*>(m_shared_mapping);
+    m_memory = static_cast<u8*>(m_shared_mapping) + SHARED_IMAGE_DATA_OFFSET;
+
+    if (created)
+    {
+      INFO_LOG("Copying CD image to shared memory '{}'", m_shared_name);
+      hdr->magic = SHARED_IMAGE_MAGIC;
+      hdr->version = SHARED_IMAGE_VERSION;
+      hdr->key = key.value();
+      hdr->sector_count = m_memory_sectors;
+
+      if (!ReadSectors(image, progress, &hdr->sectors_written))
+      {
+        // Let waiting processes fall back. Nobody else holds a lock while it's filling, so closing removes it.
+        hdr->state.store(SHARED_IMAGE_STATE_FAILED, std::memory_order_release);
+        Error::SetStringView(error, "Failed to read CD image.");
+        return false;
+      }
+
+      hdr->content_hash = XXH3_64bits(m_memory, static_cast<size_t>(data_size));
+      hdr->state.store(SHARED_IMAGE_STATE_READY, std::memory_order_release);
+      MemMap::MemProtect(m_shared_mapping, m_shared_mapping_size, PageProtect::ReadOnly);
+      MemMap::TryLockSharedMemory(m_shared_handle, false);
+      break;
+    }
+
+    INFO_LOG("Using CD image in shared memory '{}'", m_shared_name);
+    bool stale = false;
+    if (WaitForSharedImage(key.value(), sample_hash, progress, &stale, error))
+      break;
+    else if (!stale || attempt == SHARED_IMAGE_MAX_ATTEMPTS)
+      return false;
+
+    // The creator exited without finishing, so nobody will complete it. Remove it and create it again, unless another
+    // waiting process got there first.
+    WARNING_LOG("Removing incomplete CD image in shared memory '{}'", m_shared_name);
+    MemMap::DeleteSharedMemory(m_shared_name.c_str(), m_shared_handle);
+    CloseSharedImage(false);
+  }
+
+  return CopyLayout(image);
+}
+
+bool CDImageMemory::WaitForSharedImage(u64 key, u64 sample_hash, ProgressCallback* progress, bool* stale,
+                                       Error* error)
+{
+  const SharedImageHeader* const hdr = static_cast<const SharedImageHeader*>(m_shared_mapping);
+
+  progress->SetStatusText("Waiting for CD image to be preloaded by another process...");
+  progress->SetProgressRange(m_memory_sectors);
+  progress->SetProgressValue(0);
+
+  // The creator could have exited without finishing. If the platform can't tell us that, give up if it stops making
+  // progress. The state is checked after locking, since the creator marks it ready before dropping its lock.
+  u32 last_sectors_written = 0;
+  Timer::Value last_progress_time = Timer::GetCurrentValue();
+  for (;;)
+  {
+    const bool locked = MemMap::TryLockSharedMemory(m_shared_handle, false);
+    const u32 state = hdr->state.load(std::memory_order_acquire);
+    if (state == SHARED_IMAGE_STATE_READY)
+    {
+      break;
+    }
+    else if (state != SHARED_IMAGE_STATE_FILLING)
+    {
+      Error::SetStringView(error, "Another process failed to preload the CD image.");
+      return false;
+    }
+    else if (locked)
+    {
+      Error::SetStringView(error, "Another process exited before preloading the CD image.");
+      *stale = true;
+      return false;
+    }
+
+    const Timer::Value current_time = Timer::GetCurrentValue();
+    const u32 sectors_written = hdr->sectors_written.load(std::memory_order_relaxed);
+    if (sectors_written != last_sectors_written)
+    {
+      last_sectors_written = sectors_written;
+      last_progress_time = current_time;
+      progress->SetProgressValue(sectors_written);
+    }
+    else if (Timer::ConvertValueToSeconds(current_time - last_progress_time) >= SHARED_IMAGE_STALL_TIMEOUT)
+    {
+      Error::SetStringView(error, "Timed out waiting for another process to preload the CD image.");
+      return false;
+    }
+
+    Timer::NanoSleep(SHARED_IMAGE_POLL_INTERVAL_NS);
+  }
+
+  // The key only covers a sample of the sectors. Check the samples against this image's in case of a key collision,
+  // and every sector against the hash the creator computed after filling. Both only read memory.
+  if (hdr->magic != SHARED_IMAGE_MAGIC || hdr->version != SHARED_IMAGE_VERSION || hdr->key != key ||
+      hdr->sector_count != m_memory_sectors || GetSampleHash() != sample_hash ||
+      XXH3_64bits(m_memory, static_cast<size_t>(m_memory_sectors) * RAW_SECTOR_SIZE) != hdr->content_hash)
+  {
+    Error::SetStringView(error, "Shared memory does not contain this CD image.");
+    return false;
+  }
+
+  return true;
+}
+
+void CDImageMemory::CloseSharedImage(bool delete_if_unused)
+{
+  if (m_shared_mapping)
+  {
+    MemMap::UnmapSharedMemory(m_shared_mapping, m_shared_mapping_size);
+    m_shared_mapping = nullptr;
+    m_memory = nullptr;
+  }
+
+  // If nobody else holds a lock, this is the last process using it, so remove it instead of leaving it until reboot.
+  // The name may already refer to a new object if this one was removed as stale.
+  if (delete_if_unused && MemMap::TryLockSharedMemory(m_shared_handle, true))
+    MemMap::DeleteSharedMemory(m_shared_name.c_str(), m_shared_handle);
+
+  MemMap::DestroySharedMemory(m_shared_handle);
+  m_shared_handle = nullptr;
+}
+
+bool CDImageMemory::ReadSectors(CDImage* image, ProgressCallback* progress, std::atomic<u32>* sectors_written)
+{
   progress->SetStatusText("Preloading CD image to RAM...");
   progress->SetProgressRange(m_memory_sectors);
   progress->SetProgressValue(0);
@@ -94,9 +460,16 @@ bool CDImageMemory::CopyImage(CDImage* image, ProgressCallback* progress)
       progress->SetProgressValue(sectors_read);
       memory_ptr += RAW_SECTOR_SIZE;
       sectors_read++;
+      if (sectors_written)
+        sectors_written->store(sectors_read, std::memory_order_relaxed);
     }
   }
 
+  return true;
+}
+
+bool CDImageMemory::CopyLayout(CDImage* image)
+{
   for (u32 i = 1; i <= image->GetTrackCount(); i++)
     m_tracks.push_back(image->GetTrack(i));
 
@@ -147,3 +520,194 @@ CDImage::CreateMemoryImage(CDImage* image, ProgressCallback* progress /* = Progr
 
   return memory_image;
 }
+
+std::unique_ptr<CDImage> CDImage::CreateSharedMemoryImage(CDImage* image, ProgressCallback* progress, Error* error)
+{
+  std::unique_ptr<CDImageMemory> memory_image = std::make_unique<CDImageMemory>();
+  if (!memory_image->ShareImage(image, progress, error))
+    return {};
+
+  return memory_image;
+}
+
+CDImageCompressedMemory::CDImageCompressedMemory() = default;
+
+CDImageCompressedMemory::~CDImageCompressedMemory()
+{
+  if (m_dctx)
+    ZSTD_freeDCtx(m_dctx);
+}
+
+u32 CDImageCompressedMemory::GetBlockSize(u32 block_index) const
+{
+  return std::min(m_memory_sectors - block_index * SECTORS_PER_BLOCK, SECTORS_PER_BLOCK) * RAW_SECTOR_SIZE;
+}
+
+bool CDImageCompressedMemory::CompressImage(CDImage* image, ProgressCallback* progress)
+{
+  m_memory_sectors = GetDataSectorCount(image);
+
+  const u32 block_count = (m_memory_sectors + (SECTORS_PER_BLOCK - 1)) / SECTORS_PER_BLOCK;
+  m_block_offsets.reserve(block_count + 1);
+  m_block_offsets.push_back(0);
+
+  // Most discs compress to somewhere around half size.
+  m_compressed_data.reserve((static_cast<size_t>(m_memory_sectors) * RAW_SECTOR_SIZE) / 2);
+
+  ZSTD_CCtx* cctx = ZSTD_createCCtx();
+  m_dctx = ZSTD_createDCtx();
+  if (!cctx || !m_dctx)
+  {
+    progress->ModalError("Failed to create compression context");
+    ZSTD_freeCCtx(cctx);
+    return false;
+  }
+
+  progress->SetStatusText("Preloading and compressing CD image to RAM...");
+  progress->SetProgressRange(m_memory_sectors);
+  progress->SetProgressValue(0);
+
+  DynamicHeapArray<u8, 16> block(BLOCK_SIZE);
+  u32 block_sectors = 0;
+  u32 sectors_read = 0;
+  for (u32 i = 0; i < image->GetIndexCount(); i++)
+  {
+    const Index& index = image->GetIndex(i);
+    if (index.file_sector_size == 0)
+      continue;
+
+    for (u32 lba = 0; lba < index.length; lba++)
+    {
+      if (!image->ReadSectorFromIndex(&block[block_sectors * RAW_SECTOR_SIZE], index, lba))
+      {
+        ERROR_LOG("Failed to read LBA {} in index {}", lba, i);
+        ZSTD_freeCCtx(cctx);
+        return false;
+      }
+
+      progress->SetProgressValue(sectors_read);
+      sectors_read++;
+
+      if ((++block_sectors) == SECTORS_PER_BLOCK)
+      {
+        if (!CompressBlock(cctx, block.data(), BLOCK_SIZE))
+        {
+          ZSTD_freeCCtx(cctx);
+          return false;
+        }
+
+        block_sectors = 0;
+      }
+    }
+  }
+
+  const bool result = (block_sectors == 0 || CompressBlock(cctx, block.data(), block_sectors * RAW_SECTOR_SIZE));
+  ZSTD_freeCCtx(cctx);
+  if (!result)
+    return false;
+
+  m_compressed_data.shrink_to_fit();
+  m_block_cache_data.resize(BLOCK_SIZE * BLOCK_CACHE_SIZE);
+  INFO_LOG("Compressed {} sectors to {} KB ({:.1f}% of raw size)", m_memory_sectors,
+           m_compressed_data.size() / 1024,
+           (static_cast<double>(m_compressed_data.size()) * 100.0) /
+             static_cast<double>(std::max<u64>(static_cast<u64>(m_memory_sectors) * RAW_SECTOR_SIZE, 1)));
+
+  return CopyLayout(image);
+}
+
+bool CDImageCompressedMemory::CompressBlock(ZSTD_CCtx* cctx, const u8* data, u32 size)
+{
+  const size_t offset = m_compressed_data.size();
+  m_compressed_data.resize(offset + ZSTD_compressBound(size));
+
+  size_t compressed_size = ZSTD_compressCCtx(cctx, &m_compressed_data[offset], m_compressed_data.size() - offset, data,
+                                             size, COMPRESSION_LEVEL);
+  if (ZSTD_isError(compressed_size)) [[unlikely]]
+  {
+    ERROR_LOG("ZSTD_compressCCtx() failed: {}", ZSTD_getErrorName(compressed_size));
+    return false;
+  }
+
+  // Audio tracks often don't compress, store them raw so they don't need to go through the decompressor.
+  if (compressed_size >= size)
+  {
+    std::memcpy(&m_compressed_data[offset], data, size);
+    compressed_size = size;
+  }
+
+  m_compressed_data.resize(offset + compressed_size);
+  m_block_offsets.push_back(m_compressed_data.size());
+  return true;
+}
+
+const u8* CDImageCompressedMemory::GetBlock(u32 block_index)
+{
+  const u32 block_size = GetBlockSize(block_index);
+  const size_t compressed_offset = m_block_offsets[block_index];
+  const size_t compressed_size = m_block_offsets[block_index + 1] - compressed_offset;
+  if (compressed_size == block_size)
+    return &m_compressed_data[compressed_offset];
+
+  m_block_cache_counter++;
+
+  // Look for the block in the cache, otherwise replace the least recently used block.
+  u32 slot = 0;
+  for (u32 i = 0; i < BLOCK_CACHE_SIZE; i++)
+  {
+    CachedBlock& cblock = m_block_cache[i];
+    if (cblock.block_index == block_index)
+    {
+      cblock.last_used = m_block_cache_counter;
+      return &m_block_cache_data[i * BLOCK_SIZE];
+    }
+
+    if (cblock.block_index == INVALID_BLOCK ||
+        (m_block_cache[slot].block_index != INVALID_BLOCK && cblock.last_used < m_block_cache[slot].last_used))
+    {
+      slot = i;
+    }
+  }
+
+  u8* const data = &m_block_cache_data[slot * BLOCK_SIZE];
+  const size_t result =
+    ZSTD_decompressDCtx(m_dctx, data, block_size, &m_compressed_data[compressed_offset], compressed_size);
+  if (ZSTD_isError(result) || result != block_size) [[unlikely]]
+  {
+    ERROR_LOG("Failed to decompress block {}: {}", block_index,
+              ZSTD_isError(result) ? ZSTD_getErrorName(result) : "short read");
+    m_block_cache[slot].block_index = INVALID_BLOCK;
+    return nullptr;
+  }
+
+  m_block_cache[slot].block_index = block_index;
+  m_block_cache[slot].last_used = m_block_cache_counter;
+  return data;
+}
+
+bool CDImageCompressedMemory::ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index)
+{
+  DebugAssert(index.file_index == 0);
+
+  const u64 sector_number = index.file_offset + lba_in_index;
+  if (sector_number >= m_memory_sectors)
+    return false;
+
+  const u32 block_index = static_cast<u32>(sector_number / SECTORS_PER_BLOCK);
+  const u8* const block = GetBlock(block_index);
+  if (!block)
+    return false;
+
+  std::memcpy(buffer, &block[static_cast<u32>(sector_number % SECTORS_PER_BLOCK) * RAW_SECTOR_SIZE], RAW_SECTOR_SIZE);
+  return true;
+}
+
+std::unique_ptr<CDImage> CDImage::CreateCompressedMemoryImage(
+  CDImage* image, ProgressCallback* progress /* = ProgressCallback::NullProgressCallback */)
+{
+  std::unique_ptr<CDImageCompressedMemory> memory_image = std::make_unique<CDImageCompressedMemory>();
+  if (!memory_image->CompressImage(image, progress))
+    return {};
+
+  return memory_image;
+}